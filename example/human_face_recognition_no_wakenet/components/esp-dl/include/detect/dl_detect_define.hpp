@@ -1,6 +1,8 @@
 #pragma once
 
+#include <stddef.h>
 #include <vector>
+#include <list>
 
 namespace dl
 {
@@ -13,5 +15,124 @@ namespace dl
             std::vector<int> box;      /*<! [left_up_x, left_up_y, right_down_x, right_down_y] */
             std::vector<int> keypoint; /*<! [x1, y1, x2, y2, ...] */
         } result_t;
+
+        /**
+         * @brief A fixed number of results allocated once and lent to std::list<result_t> by splicing nodes, so the
+         * lists passed to and between detectors are refilled every frame without heap allocation. box and keypoint of
+         * each result are reserved, assigning them stays allocation free as long as they fit.
+         */
+        class ResultPool
+        {
+        private:
+            const int capacity;        /*<! number of results allocated >*/
+            const int keypoint_size;   /*<! reserved size of keypoint >*/
+            std::list<result_t> spare; /*<! results not lent >*/
+
+            void allocate(const int num)
+            {
+                for (int i = 0; i < num; i++)
+                {
+                    this->spare.emplace_back();
+                    this->spare.back().box.reserve(4);
+                    this->spare.back().keypoint.reserve(this->keypoint_size);
+                }
+            }
+
+        public:
+            /**
+             * @brief Construct a new Result Pool object.
+             *
+             * @param capacity      number of results
+             * @param keypoint_size reserved size of keypoint, 10 for five points
+             */
+            ResultPool(const int capacity, const int keypoint_size = 10) : capacity(capacity), keypoint_size(keypoint_size)
+            {
+                this->allocate(capacity);
+            }
+
+            /**
+             * @brief Move a result from pool to the end of list, for filling in place.
+             *
+             * @param list list to append to
+             * @return result_t* the result, content is left from its last use. NULL if pool is empty
+             */
+            result_t *take(std::list<result_t> &list)
+            {
+                if (this->spare.empty())
+                    return NULL;
+
+                list.splice(list.end(), this->spare, this->spare.begin());
+                return &list.back();
+            }
+
+            /**
+             * @brief Append a copy of result to list.
+             *
+             * @param list   list to append to
+             * @param result result to copy
+             * @return true: appended
+             *         false: pool is empty, result is dropped
+             */
+            bool push_back(std::list<result_t> &list, const result_t &result)
+            {
+                result_t *item = this->take(list);
+                if (item == NULL)
+                    return false;
+
+                item->category = result.category;
+                item->score = result.score;
+                item->box.assign(result.box.begin(), result.box.end());
+                item->keypoint.assign(result.keypoint.begin(), result.keypoint.end());
+                return true;
+            }
+
+            /**
+             * @brief Give all results of list back to pool.
+             * NOTE: list must only hold results taken from this pool, never a list owned by a detector.
+             *
+             * @param list list to empty
+             */
+            void clear(std::list<result_t> &list)
+            {
+                this->spare.splice(this->spare.end(), list);
+            }
+
+            /**
+             * @brief Get the number of results not lent.
+             *
+             * @return int number of results
+             */
+            int get_spare_num()
+            {
+                return this->spare.size();
+            }
+
+            /**
+             * @brief Get the number of results allocated at construction.
+             * NOTE: spare results and results lent add up to it, unless a node is erased from a lent list.
+             *
+             * @return int number of results
+             */
+            int get_capacity()
+            {
+                return this->capacity;
+            }
+
+            /**
+             * @brief Allocate again the results lost from lists lent, e.g., erased by a detector given one of them.
+             *
+             * @param lent number of results still lent
+             * @return int number of results allocated, 0 if none is lost
+             */
+            int refill(const int lent)
+            {
+                int lost = this->capacity - (int)this->spare.size() - lent;
+                if (lost <= 0)
+                    return 0;
+
+                this->allocate(lost);
+                return lost;
+            }
+        };
     }
 }
\ No newline at end of file
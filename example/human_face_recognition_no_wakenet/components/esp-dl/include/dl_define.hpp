@@ -9,6 +9,13 @@
                                /*<! - 0: mute */
 #define DL_LOG_LAYER_LATENCY 0 /*<! - 1: print the latency of each parts of layer */
                                /*<! - 0: mute */
+#define DL_PROFILE_LAYER 0     /*<! - 1: record each layer call to dl::layer::Profiler */
+                               /*<! - 0: compiled out */
+#define DL_MULTI_CORE 0        /*<! - 1: Conv2D and DepthwiseConv2D split output rows across both cores by default */
+                               /*<! - 0: run on the calling core by default */
+#ifndef DL_WINOGRAD
+#define DL_WINOGRAD 0          /*<! - 1: Conv2D<int16_t> runs 3x3 stride-1 filters by Winograd F(2x2, 3x3) */
+#endif                         /*<! - 0: always run the direct conv2d, may be set by the build instead */
 
 #if CONFIG_SPIRAM_SUPPORT || CONFIG_ESP32_SPIRAM_SUPPORT || CONFIG_ESP32S2_SPIRAM_SUPPORT || CONFIG_ESP32S3_SPIRAM_SUPPORT
 #define DL_SPIRAM_SUPPORT 1
@@ -16,18 +23,28 @@
 #define DL_SPIRAM_SUPPORT 0
 #endif
 
-#if CONFIG_IDF_TARGET_ESP32
+#if CONFIG_IDF_TARGET_ESP32 && DL_MULTI_CORE && !CONFIG_FREERTOS_UNICORE
 #define CONFIG_DEFAULT_ASSIGN_CORE \
     {                              \
-    } // TODO: 多核 task 完成时，改成默认 0,1
+        0, 1                       \
+    }
+#elif CONFIG_IDF_TARGET_ESP32
+#define CONFIG_DEFAULT_ASSIGN_CORE \
+    {                              \
+    }
 #elif CONFIG_IDF_TARGET_ESP32S2
 #define CONFIG_DEFAULT_ASSIGN_CORE \
     {                              \
     }
+#elif CONFIG_IDF_TARGET_ESP32S3 && DL_MULTI_CORE && !CONFIG_FREERTOS_UNICORE
+#define CONFIG_DEFAULT_ASSIGN_CORE \
+    {                              \
+        0, 1                       \
+    }
 #elif CONFIG_IDF_TARGET_ESP32S3
 #define CONFIG_DEFAULT_ASSIGN_CORE \
     {                              \
-    } // TODO: 多核 task 完成时，改成默认 0,1
+    }
 #elif CONFIG_IDF_TARGET_ESP32C3
 #define CONFIG_DEFAULT_ASSIGN_CORE \
     {                              \
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <limits>
+#include <vector>
+#include "dl_define.hpp"
+#include "dl_variable.hpp"
+#include "dl_math_matrix.hpp"
+#include "dl_image.hpp"
+
+namespace dl
+{
+    namespace image
+    {
+        typedef enum
+        {
+            IMAGE_FORMAT_RGB565 = 0, /*<! 2 bytes per pixel, in the byte order of camera, same as convert_pixel_rgb565_to_rgb888() >*/
+            IMAGE_FORMAT_YUV422 = 1, /*<! 4 bytes per 2 pixels in order of Y0 U Y1 V >*/
+        } image_format_t;
+
+        /**
+         * @brief Camera buffer to model input in one pass.
+         *
+         * Each output element is sampled from the camera buffer at the position of an affine map, converted to BGR888,
+         * then normalized and quantized by a lookup table, i.e.,
+         *         output = round((pixel - mean[c]) / std[c] / 2^exponent), saturated to feature_t.
+         * There is neither an intermediate image nor a Tensor allocated per call. A crop-and-resize is the affine map
+         * without rotation, which is what set_crop() builds. set_warp() takes the inverse matrix same as warp_affine(),
+         * e.g., to align a face by landmarks.
+         *
+         * The channel order of output is BGR, same as convert_pixel_rgb565_to_rgb888().
+         *
+         * @tparam feature_t supports int8_t, int16_t and uint8_t
+         */
+        template <typename feature_t>
+        class ImagePreprocessor
+        {
+        private:
+            image_format_t format;     /*<! format of input >*/
+            resize_type_t resize_type; /*<! IMAGE_RESIZE_NEAREST or IMAGE_RESIZE_BILINEAR >*/
+            feature_t lut[3][256];     /*<! quantized value of each channel and pixel >*/
+            float matrix[6];           /*<! output (x, y, 1) to input (x, y) >*/
+
+            template <image_format_t format>
+            static inline void load_pixel(const uint8_t *input, const int input_width, int x, int y, int *bgr)
+            {
+                if (format == IMAGE_FORMAT_RGB565)
+                {
+                    uint16_t pixel = ((const uint16_t *)input)[y * input_width + x];
+                    convert_pixel_rgb565_to_rgb888(pixel, bgr);
+                }
+                else
+                {
+                    const uint8_t *pair = input + (y * input_width + (x & ~1)) * 2;
+                    int luma = pair[(x & 1) << 1];
+                    int u = pair[1] - 128;
+                    int v = pair[3] - 128;
+                    // BT.601 in 8-bit fixed point
+                    int blue = luma + ((454 * u) >> 8);
+                    int green = luma - ((88 * u + 183 * v) >> 8);
+                    int red = luma + ((359 * v) >> 8);
+                    bgr[0] = DL_CLIP(blue, 0, 255);
+                    bgr[1] = DL_CLIP(green, 0, 255);
+                    bgr[2] = DL_CLIP(red, 0, 255);
+                }
+            }
+
+            /**
+             * @brief Fill one row of output, format and resize_type are resolved at compile time, so the inner loop has
+             * no branch on them.
+             */
+            template <image_format_t format, resize_type_t resize_type>
+            void fill_row(const uint8_t *image, const int input_height, const int input_width, const int y, const int output_width, feature_t *out)
+            {
+                int bgr[4][3];
+
+                // incremental mapping along a row
+                float sx = this->matrix[1] * y + this->matrix[2];
+                float sy = this->matrix[4] * y + this->matrix[5];
+                for (int x = 0; x < output_width; x++, sx += this->matrix[0], sy += this->matrix[3], out += 3)
+                {
+                    if (resize_type == IMAGE_RESIZE_NEAREST)
+                    {
+                        int ix = DL_CLIP((int)(sx + 0.5f), 0, input_width - 1);
+                        int iy = DL_CLIP((int)(sy + 0.5f), 0, input_height - 1);
+                        load_pixel<format>(image, input_width, ix, iy, bgr[0]);
+                        out[0] = this->lut[0][bgr[0][0]];
+                        out[1] = this->lut[1][bgr[0][1]];
+                        out[2] = this->lut[2][bgr[0][2]];
+                        continue;
+                    }
+
+                    int x0 = (int)floorf(sx);
+                    int y0 = (int)floorf(sy);
+                    int wx = (int)((sx - x0) * 256);
+                    int wy = (int)((sy - y0) * 256);
+                    int x1 = DL_CLIP(x0 + 1, 0, input_width - 1);
+                    int y1 = DL_CLIP(y0 + 1, 0, input_height - 1);
+                    x0 = DL_CLIP(x0, 0, input_width - 1);
+                    y0 = DL_CLIP(y0, 0, input_height - 1);
+                    load_pixel<format>(image, input_width, x0, y0, bgr[0]);
+                    load_pixel<format>(image, input_width, x1, y0, bgr[1]);
+                    load_pixel<format>(image, input_width, x0, y1, bgr[2]);
+                    load_pixel<format>(image, input_width, x1, y1, bgr[3]);
+                    for (int c = 0; c < 3; c++)
+                    {
+                        int top = (bgr[0][c] << 8) + (bgr[1][c] - bgr[0][c]) * wx;
+                        int bottom = (bgr[2][c] << 8) + (bgr[3][c] - bgr[2][c]) * wx;
+                        int value = ((top << 8) + (bottom - top) * wy + (1 << 15)) >> 16;
+                        out[c] = this->lut[c][value];
+                    }
+                }
+            }
+
+            typedef void (ImagePreprocessor::*fill_row_t)(const uint8_t *, const int, const int, const int, const int, feature_t *);
+
+        public:
+            /**
+             * @brief Construct a new Image Preprocessor object.
+             *
+             * @param mean        mean of each channel in BGR order
+             * @param std         standard deviation of each channel in BGR order
+             * @param exponent    exponent of output
+             * @param format      format of input
+             * @param resize_type IMAGE_RESIZE_NEAREST or IMAGE_RESIZE_BILINEAR
+             */
+            ImagePreprocessor(const std::vector<float> mean = {0.f, 0.f, 0.f},
+                              const std::vector<float> std = {1.f, 1.f, 1.f},
+                              const int exponent = 0,
+                              const image_format_t format = IMAGE_FORMAT_RGB565,
+                              const resize_type_t resize_type = IMAGE_RESIZE_BILINEAR) : format(format),
+                                                                                         resize_type(resize_type),
+                                                                                         matrix{1.f, 0.f, 0.f, 0.f, 1.f, 0.f}
+            {
+                assert(mean.size() == 3 && std.size() == 3);
+                float scale = DL_SCALE(-exponent);
+                for (int c = 0; c < 3; c++)
+                {
+                    for (int i = 0; i < 256; i++)
+                    {
+                        int value = (int)roundf((i - mean[c]) / std[c] * scale);
+                        this->lut[c][i] = (feature_t)(DL_CLIP(value, std::numeric_limits<feature_t>::min(), std::numeric_limits<feature_t>::max()));
+                    }
+                }
+            }
+
+            /**
+             * @brief Map the whole output to a box of input.
+             *
+             * @param y_start       start y of box in input
+             * @param y_end         end y of box in input
+             * @param x_start       start x of box in input
+             * @param x_end         end x of box in input
+             * @param output_height height of output
+             * @param output_width  width of output
+             */
+            void set_crop(int y_start, int y_end, int x_start, int x_end, int output_height, int output_width)
+            {
+                float scale_x = (float)(x_end - x_start) / output_width;
+                float scale_y = (float)(y_end - y_start) / output_height;
+                // pixel centers are aligned
+                this->matrix[0] = scale_x;
+                this->matrix[1] = 0.f;
+                this->matrix[2] = x_start + 0.5f * scale_x - 0.5f;
+                this->matrix[3] = 0.f;
+                this->matrix[4] = scale_y;
+                this->matrix[5] = y_start + 0.5f * scale_y - 0.5f;
+            }
+
+            /**
+             * @brief Map output to input by an affine transformation.
+             *
+             * @param M_inv the inverse transformation matrix, from output to input, at least 2 x 3
+             */
+            void set_warp(dl::math::Matrix<float> *M_inv)
+            {
+                for (int i = 0; i < 2; i++)
+                    for (int j = 0; j < 3; j++)
+                        this->matrix[i * 3 + j] = M_inv->array[i][j];
+            }
+
+            /**
+             * @brief Fill output from input. Output positions out of input are filled with the edge pixels.
+             *
+             * @param input       camera buffer
+             * @param input_shape shape of input, [height, width, channel]
+             * @param output      model input with shape [height, width, 3], element must be allocated
+             */
+            void operator()(const void *input, const std::vector<int> &input_shape, Tensor<feature_t> &output)
+            {
+                const uint8_t *image = (const uint8_t *)input;
+                const int input_height = input_shape[0];
+                const int input_width = input_shape[1];
+                const int output_height = output.shape[0];
+                const int output_width = output.shape[1];
+
+                // chosen once per call, not per pixel
+                fill_row_t fill;
+                if (this->format == IMAGE_FORMAT_RGB565)
+                    fill = this->resize_type == IMAGE_RESIZE_NEAREST ? &ImagePreprocessor::fill_row<IMAGE_FORMAT_RGB565, IMAGE_RESIZE_NEAREST>
+                                                                     : &ImagePreprocessor::fill_row<IMAGE_FORMAT_RGB565, IMAGE_RESIZE_BILINEAR>;
+                else
+                    fill = this->resize_type == IMAGE_RESIZE_NEAREST ? &ImagePreprocessor::fill_row<IMAGE_FORMAT_YUV422, IMAGE_RESIZE_NEAREST>
+                                                                     : &ImagePreprocessor::fill_row<IMAGE_FORMAT_YUV422, IMAGE_RESIZE_BILINEAR>;
+
+                for (int y = 0; y < output_height; y++)
+                    (this->*fill)(image, input_height, input_width, y, output_width, output.element + y * output_width * 3);
+            }
+        };
+    } // namespace image
+} // namespace dl
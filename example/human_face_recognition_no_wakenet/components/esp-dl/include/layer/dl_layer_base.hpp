@@ -1,6 +1,10 @@
 #pragma once
 #include "dl_tool.hpp"
 #include "dl_tool_cache.hpp"
+#include "esp_memory_utils.h"
+#if DL_PROFILE_LAYER
+#include "dl_layer_profiler.hpp"
+#endif
 #include <iostream>
 
 namespace dl
@@ -54,3 +58,23 @@ namespace dl
 #define DL_LOG_LAYER_LATENCY_START()
 #define DL_LOG_LAYER_LATENCY_END(prefix, key)
 #endif
+
+#if DL_PROFILE_LAYER
+/**
+ * @brief Record the rest of a layer call, i.e., cycles, output bytes and where the inputs are.
+ *
+ * @param key    operation of layer
+ * @param output pointer to output, read at the end of call
+ * @param ...    {elements of inputs} or a std::vector of input pointers
+ */
+#define DL_PROFILE_LAYER_CALL(key, output, ...) \
+    dl::layer::ProfilerScope profiler_scope(this->name, key, output, __VA_ARGS__)
+
+/**
+ * @brief Mark the beginning of a model call.
+ */
+#define DL_PROFILE_MODEL_CALL() dl::layer::Profiler::get_instance().next_call()
+#else
+#define DL_PROFILE_LAYER_CALL(key, output, ...)
+#define DL_PROFILE_MODEL_CALL()
+#endif
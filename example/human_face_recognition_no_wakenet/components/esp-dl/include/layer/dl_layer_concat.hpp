@@ -109,6 +109,7 @@ namespace dl
             Tensor<feature_t> &call(std::vector<Tensor<feature_t> *> inputs, bool free_inputs = false)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("concat", this->output, inputs);
 
                 DL_LOG_LAYER_LATENCY_START();
                 if (this->output->shape != this->output_shape)
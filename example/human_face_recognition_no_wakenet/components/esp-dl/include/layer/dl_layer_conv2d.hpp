@@ -1,6 +1,10 @@
 #pragma once
 
 #include "dl_nn_conv2d.hpp"
+#include "dl_nn_parallel.hpp"
+#if DL_WINOGRAD
+#include "dl_nn_winograd.hpp"
+#endif
 #include "dl_layer_base.hpp"
 
 namespace dl
@@ -31,6 +35,7 @@ namespace dl
             std::vector<int> padding;                /*<! padding size needed in [top, bottom, left, right] of this operation >*/
             Tensor<feature_t> *output;               /*<! output ptr of Conv2D >*/
             std::vector<int> output_shape;           /*<! output shape of Conv2D >*/
+            int32_t *winograd_filter;                /*<! filter transformed in build() if Winograd applies, NULL for direct conv2d >*/
 
         public:
             /**
@@ -70,7 +75,8 @@ namespace dl
                                                   bias(bias),
                                                   activation(activation),
                                                   padding(padding),
-                                                  output_shape({})
+                                                  output_shape({}),
+                                                  winograd_filter(NULL)
             {
                 this->output = new Tensor<feature_t>;
                 if (this->padding_type == PADDING_NOT_SET)
@@ -89,6 +95,10 @@ namespace dl
                 {
                     delete this->output;
                 }
+                if (this->winograd_filter != NULL)
+                {
+                    dl::tool::free_aligned(this->winograd_filter);
+                }
             }
 
             /**
@@ -114,6 +124,15 @@ namespace dl
                     this->padding = nn::get_pad_size(this->output_shape, input.shape, this->filter->shape_with_dilation, this->stride_y, this->stride_x, this->padding_type);
                 }
 
+#if DL_WINOGRAD
+                // the filter is transformed once, the output tiles of Winograd need at least 2 rows and columns to pay off
+                if (this->winograd_filter == NULL && nn::winograd_conv2d_supported(*this->filter, this->stride_y, this->stride_x) &&
+                    this->output_shape[0] > 1 && this->output_shape[1] > 1)
+                {
+                    this->winograd_filter = nn::winograd_transform_filter(*this->filter);
+                }
+#endif
+
                 if (print_shape)
                 {
                     std::cout << this->name << " | ";
@@ -138,12 +157,13 @@ namespace dl
              * @param autoload_enable one of true or false, 
              *                        - true: load input and output from PSRAM to CACHE automatically
              *                        - false: do not
-             * @param assign_core     not effective yet
+             * @param assign_core     cores to split output rows across, e.g., {0, 1}. less than two cores runs on the caller only
              * @return Conv2D result
              */
             Tensor<feature_t> &call(Tensor<feature_t> &input, bool autoload_enable = false, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("conv2d", this->output, {input.element});
 
                 DL_LOG_LAYER_LATENCY_START();
                 if (this->output->shape != this->output_shape)
@@ -160,8 +180,22 @@ namespace dl
                                                    (uint32_t)(input.element), input.get_size() * sizeof(feature_t));
                 }
 
+#if DL_WINOGRAD
+                if (this->winograd_filter)
+                {
+                    DL_LOG_LAYER_LATENCY_START();
+                    nn::parallel_rows(*this->output, input, this->padding, 3, 1, assign_core,
+                                      [this](Tensor<feature_t> &output, Tensor<feature_t> &input, std::vector<int> &padding)
+                                      { nn::conv2d_winograd(output, input, padding, this->winograd_filter, *(this->filter), this->bias, this->activation); });
+                    DL_LOG_LAYER_LATENCY_END(this->name, "conv2d_winograd");
+                    return *this->output;
+                }
+#endif
+
                 DL_LOG_LAYER_LATENCY_START();
-                nn::conv2d(*this->output, input, this->padding, *(this->filter), this->stride_y, this->stride_x, this->bias, this->activation, assign_core);
+                nn::parallel_rows(*this->output, input, this->padding, this->filter->shape_with_dilation[0], this->stride_y, assign_core,
+                                  [this](Tensor<feature_t> &output, Tensor<feature_t> &input, std::vector<int> &padding)
+                                  { nn::conv2d(output, input, padding, *(this->filter), this->stride_y, this->stride_x, this->bias, this->activation); });
                 DL_LOG_LAYER_LATENCY_END(this->name, "conv2d");
                 return *this->output;
             }
@@ -172,6 +206,10 @@ namespace dl
              */
             void preload()
             {
+                // placed in internal RAM, e.g., by WeightPlacement
+                if (esp_ptr_internal(this->filter->element))
+                    return;
+
                 size_t size = sizeof(feature_t);
                 int shape_size = this->filter->shape.size();
                 for (int i = 0; i < shape_size; ++i)
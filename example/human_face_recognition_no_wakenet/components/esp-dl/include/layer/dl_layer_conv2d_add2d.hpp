@@ -0,0 +1,286 @@
+#pragma once
+
+#include "dl_nn_conv2d.hpp"
+#include "dl_nn_add2d.hpp"
+#include "dl_nn_parallel.hpp"
+#include "dl_layer_base.hpp"
+
+namespace dl
+{
+    namespace layer
+    {
+        /**
+         * @brief Activation(Add2D(Conv2D(input, filter) + bias, residual)), i.e., Conv2D -> Add2D -> ReLU/PReLU in one layer.
+         * NOTE: The output is calculated in tiles of rows. Conv2D of each tile is stored in a small scratch which is
+         *       allocated from internal RAM preferentially, then added to the residual and activated into the output.
+         *       The intermediate result of Conv2D never goes through the whole output size, so each output element is
+         *       written once. Each tile starts at a 16-byte aligned row of input and output, see nn::get_aligned_tiles().
+         *
+         * @tparam feature_t supports int16_t and int8_t,
+         *         - int16_t: stands for operation in int16_t quantize
+         *         - int8_t: stands for operation in int8_t quantize
+         * @tparam bias_t supports int16_t and int8_t, must specify when using int8 per-channel quantization
+         *         - int16_t: for int16 quantization and int8 per-channel quantization
+         *         - int8_t: for int8 per-tensor quantization
+         */
+        template <typename feature_t, typename bias_t = feature_t>
+        class Conv2DAdd2D : public Layer
+        {
+        private:
+            const int conv_exponent;                      /*<! exponent of Conv2D result >*/
+            const Filter<feature_t> *filter;              /*<! filter of Conv2D >*/
+            const int stride_y;                           /*<! stride in height >*/
+            const int stride_x;                           /*<! stride in width >*/
+            const padding_type_t padding_type;            /*<! one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN >*/
+            const Bias<bias_t> *bias;                     /*<! bias of Conv2D, if you don't specify anything, no bias is added >*/
+            const Activation<feature_t> *conv_activation; /*<! activation of Conv2D, if you don't specify anything, no activation is applied >*/
+            const int output_exponent;                    /*<! exponent of output >*/
+            const Activation<feature_t> *activation;      /*<! activation after Add2D, if you don't specify anything, no activation is applied >*/
+            const int scratch_size;                       /*<! maximum size in byte of the Conv2D tile >*/
+            bool inplace;                                 /*<! true: the output will store to residual
+                                                               false: the output will store to a separate memory >*/
+            std::vector<int> padding;                     /*<! padding size needed in [top, bottom, left, right] of this operation >*/
+            std::vector<int> tile_borders;                /*<! output rows where tiles start, then the output height >*/
+            int tile_height;                              /*<! number of output rows in the longest tile >*/
+            feature_t *scratch;                           /*<! Conv2D result of a tile >*/
+            Tensor<feature_t> *output;                    /*<! output ptr of Conv2DAdd2D >*/
+            std::vector<int> output_shape;                /*<! output shape of Conv2DAdd2D >*/
+
+        public:
+            /**
+             * @brief Construct a new Conv2DAdd2D object.
+             *
+             * @param conv_exponent   exponent of Conv2D result, i.e., output_exponent of the Conv2D to be fused
+             * @param filter          filter of Conv2D
+             * @param bias            bias of Conv2D, if you don't specify anything, no bias is added
+             * @param conv_activation activation of Conv2D, if you don't specify anything, no activation is applied
+             * @param padding_type    one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN or PADDING_NOT_SET,
+             *                        same as Conv2D
+             * @param padding         if padding_type is PADDING_NOT_SET, this value will be used as padding size.
+             *                        the shape must be 4, the value of each position is: [padding top, padding bottom, padding left, padding right]
+             * @param stride_y        stride in height
+             * @param stride_x        stride in width
+             * @param output_exponent exponent of output, i.e., output_exponent of the Add2D to be fused
+             * @param activation      activation after Add2D, e.g., ReLU or PReLU. if you don't specify anything, no activation is applied
+             * @param name            name of layer
+             * @param inplace         true: the output will store to residual
+             *                        false: the output will store to a separate memory
+             * @param scratch_size    size in byte of the Conv2D tile, at least one row of output is in a tile, more if no row
+             *                        within is 16-byte aligned
+             */
+            Conv2DAdd2D(const int conv_exponent,
+                        const Filter<feature_t> *filter,
+                        const Bias<bias_t> *bias = NULL,
+                        const Activation<feature_t> *conv_activation = NULL,
+                        const padding_type_t padding_type = PADDING_VALID,
+                        std::vector<int> padding = {},
+                        const int stride_y = 1,
+                        const int stride_x = 1,
+                        const int output_exponent = 0,
+                        const Activation<feature_t> *activation = NULL,
+                        const char *name = "Conv2DAdd2D",
+                        bool inplace = false,
+                        const int scratch_size = 8 * 1024) : Layer(name),
+                                                             conv_exponent(conv_exponent),
+                                                             filter(filter),
+                                                             stride_y(stride_y),
+                                                             stride_x(stride_x),
+                                                             padding_type(padding_type),
+                                                             bias(bias),
+                                                             conv_activation(conv_activation),
+                                                             output_exponent(output_exponent),
+                                                             activation(activation),
+                                                             scratch_size(scratch_size),
+                                                             inplace(inplace),
+                                                             padding(padding),
+                                                             tile_borders({}),
+                                                             tile_height(0),
+                                                             scratch(NULL),
+                                                             output(NULL),
+                                                             output_shape({})
+            {
+                if (this->padding_type == PADDING_NOT_SET)
+                {
+                    assert(this->padding.size() == 4);
+                }
+            }
+
+            /**
+             * @brief Destroy the Conv2DAdd2D object.
+             *
+             */
+            ~Conv2DAdd2D()
+            {
+                if ((!this->inplace) && (this->output != NULL))
+                {
+                    delete this->output;
+                }
+                if (this->scratch != NULL)
+                {
+                    tool::free_aligned_prefer(this->scratch);
+                }
+            }
+
+            /**
+             * @brief Update output shape, padding and tile.
+             *
+             * @param input       as an input of Conv2D
+             * @param residual    as another input of Add2D, its shape must equal to the output shape of Conv2D
+             * @param print_shape whether to print the output shape.
+             */
+            void build(Tensor<feature_t> &input, Tensor<feature_t> &residual, bool print_shape = false)
+            {
+                assert(input.shape[0] > 0);
+                assert(input.shape[1] > 0);
+                assert(input.shape.size() == 3);
+                assert(this->filter->shape.size() == 4);
+                assert(input.shape[2] == this->filter->shape[2]);
+
+                this->output_shape = nn::get_output_shape(input.shape, this->filter->shape_with_dilation, this->stride_y, this->stride_x, this->padding_type, true, this->padding);
+                assert(residual.shape == this->output_shape);
+                if (this->padding_type != PADDING_NOT_SET)
+                {
+                    this->padding = nn::get_pad_size(this->output_shape, input.shape, this->filter->shape_with_dilation, this->stride_y, this->stride_x, this->padding_type);
+                }
+
+                if (!this->inplace)
+                {
+                    if (this->output == NULL)
+                    {
+                        this->output = new Tensor<feature_t>;
+                    }
+                    this->output->set_shape(this->output_shape);
+                    this->output->set_exponent(this->output_exponent);
+                    this->output->free_element();
+                }
+                else
+                {
+                    this->output = &residual;
+                }
+
+                int row_size = this->output_shape[1] * this->output_shape[2];
+                int tile_height = DL_MIN(DL_MAX(this->scratch_size / (int)(row_size * sizeof(feature_t)), 1), this->output_shape[0]);
+                tile_height = nn::get_aligned_tiles<feature_t>(this->tile_borders, this->output_shape[0], tile_height, row_size, input.shape[1] * input.shape[2], this->stride_y, this->padding[0]);
+                if (tile_height != this->tile_height)
+                {
+                    if (this->scratch != NULL)
+                    {
+                        tool::free_aligned_prefer(this->scratch);
+                    }
+                    this->tile_height = tile_height;
+                    this->scratch = (feature_t *)tool::malloc_aligned_prefer(tile_height * row_size, sizeof(feature_t), 16);
+                }
+
+                if (print_shape)
+                {
+                    std::cout << this->name << " | ";
+                    this->output->print_shape();
+                }
+            }
+
+            /**
+             * @brief Get the output
+             *
+             * @return Tensor<feature_t>& Conv2DAdd2D result
+             */
+            Tensor<feature_t> &get_output()
+            {
+                return *this->output;
+            }
+
+            /**
+             * @brief Call Conv2DAdd2D operation
+             *
+             * @param input       as an input of Conv2D
+             * @param residual    as another input of Add2D
+             * @param assign_core cores given to nn::conv2d and nn::add2d of each tile
+             * @return Conv2DAdd2D result
+             */
+            Tensor<feature_t> &call(Tensor<feature_t> &input, Tensor<feature_t> &residual, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
+            {
+                DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("conv2d_add2d", this->output, {input.element, residual.element});
+
+                DL_LOG_LAYER_LATENCY_START();
+                if (this->output->shape != this->output_shape)
+                {
+                    this->output->set_shape(this->output_shape);
+                }
+                if (!this->inplace)
+                {
+                    this->output->malloc_element();
+                    this->output->set_exponent(this->output_exponent);
+                }
+                DL_LOG_LAYER_LATENCY_END(this->name, "apply");
+
+                DL_LOG_LAYER_LATENCY_START();
+                const int input_height = input.shape[0];
+                const int input_row_size = input.shape[1] * input.shape[2];
+                const int output_row_size = this->output_shape[1] * this->output_shape[2];
+                const int filter_height = this->filter->shape_with_dilation[0];
+
+                for (int i = 1; i < (int)this->tile_borders.size(); i++)
+                {
+                    int y = this->tile_borders[i - 1];
+                    int rows = this->tile_borders[i] - y;
+
+                    // input rows needed by this tile, rows out of input are covered by padding
+                    int input_begin = y * this->stride_y - this->padding[0];
+                    int input_end = (y + rows - 1) * this->stride_y - this->padding[0] + filter_height;
+                    std::vector<int> tile_padding = {DL_MAX(-input_begin, 0), DL_MAX(input_end - input_height, 0), this->padding[2], this->padding[3]};
+                    input_begin = DL_MAX(input_begin, 0);
+                    input_end = DL_MIN(input_end, input_height);
+
+                    assert(nn::is_aligned_row<feature_t>(y, output_row_size, input_row_size, this->stride_y, this->padding[0]));
+
+                    Tensor<feature_t> input_tile;
+                    input_tile.set_element(input.element + input_begin * input_row_size).set_exponent(input.exponent).set_shape({input_end - input_begin, input.shape[1], input.shape[2]});
+
+                    Tensor<feature_t> conv_tile;
+                    conv_tile.set_element(this->scratch).set_exponent(this->conv_exponent).set_shape({rows, this->output_shape[1], this->output_shape[2]});
+
+                    Tensor<feature_t> residual_tile;
+                    residual_tile.set_element(residual.element + y * output_row_size).set_exponent(residual.exponent).set_shape(conv_tile.shape);
+
+                    nn::conv2d(conv_tile, input_tile, tile_padding, *(this->filter), this->stride_y, this->stride_x, this->bias, this->conv_activation, assign_core);
+
+                    if (this->inplace)
+                    {
+                        nn::add2d(residual_tile, residual_tile, conv_tile, this->activation, assign_core, this->output_exponent);
+                    }
+                    else
+                    {
+                        Tensor<feature_t> output_tile;
+                        output_tile.set_element(this->output->element + y * output_row_size).set_exponent(this->output_exponent).set_shape(conv_tile.shape);
+                        nn::add2d(output_tile, conv_tile, residual_tile, this->activation, assign_core);
+                    }
+                }
+                if (this->inplace)
+                {
+                    this->output->set_exponent(this->output_exponent);
+                }
+                DL_LOG_LAYER_LATENCY_END(this->name, "conv2d_add2d");
+                return *this->output;
+            }
+
+            /**
+             * @brief Preload the filter to Cache.
+             * NOTE: Call this layer's preload() before previous layer's call() such that filter could be loaded while previous layer is doing calculation.
+             */
+            void preload()
+            {
+                // placed in internal RAM, e.g., by WeightPlacement
+                if (esp_ptr_internal(this->filter->element))
+                    return;
+
+                size_t size = sizeof(feature_t);
+                int shape_size = this->filter->shape.size();
+                for (int i = 0; i < shape_size; ++i)
+                {
+                    size *= filter->shape[i];
+                }
+                dl::tool::cache::preload_func((uint32_t)(this->filter->element), size);
+            }
+        };
+    } // namespace layer
+} // namespace dl
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "dl_nn_depthwise_conv2d.hpp"
+#include "dl_nn_parallel.hpp"
 #include "dl_layer_base.hpp"
 
 namespace dl
@@ -139,12 +140,13 @@ namespace dl
              * @param autoload_enable one of true or false,
              *                        - true: load input and output from PSRAM to CACHE automatically
              *                        - false: do not 
-             * @param assign_core     not effective yet
+             * @param assign_core     cores to split output rows across, e.g., {0, 1}. less than two cores runs on the caller only
              * @return DepthwiseConv2D result
              */
             Tensor<feature_t> &call(Tensor<feature_t> &input, bool autoload_enable = false, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("depthwise_conv2d", this->output, {input.element});
 
                 DL_LOG_LAYER_LATENCY_START();
                 if (this->output->shape != this->output_shape)
@@ -163,7 +165,9 @@ namespace dl
                 }
 
                 DL_LOG_LAYER_LATENCY_START();
-                nn::depthwise_conv2d(*this->output, input, this->padding, *(this->filter), this->stride_y, this->stride_x, this->bias, this->activation, assign_core);
+                nn::parallel_rows(*this->output, input, this->padding, this->filter->shape_with_dilation[0], this->stride_y, assign_core,
+                                  [this](Tensor<feature_t> &output, Tensor<feature_t> &input, std::vector<int> &padding)
+                                  { nn::depthwise_conv2d(output, input, padding, *(this->filter), this->stride_y, this->stride_x, this->bias, this->activation); });
                 DL_LOG_LAYER_LATENCY_END(this->name, "depthwise_conv2d");
 
                 return *this->output;
@@ -175,6 +179,10 @@ namespace dl
              */
             void preload()
             {
+                // placed in internal RAM, e.g., by WeightPlacement
+                if (esp_ptr_internal(this->filter->element))
+                    return;
+
                 size_t size = sizeof(feature_t);
                 int shape_size = this->filter->shape.size();
                 for (int i = 0; i < shape_size; ++i)
@@ -0,0 +1,267 @@
+#pragma once
+
+#include "dl_nn_depthwise_conv2d.hpp"
+#include "dl_nn_conv2d.hpp"
+#include "dl_nn_parallel.hpp"
+#include "dl_layer_base.hpp"
+
+namespace dl
+{
+    namespace layer
+    {
+        /**
+         * @brief Activation(Conv2D(Activation(DepthwiseConv2D(input, depthwise_filter) + depthwise_bias), pointwise_filter) + pointwise_bias),
+         *        i.e., DepthwiseConv2D -> 1x1 Conv2D in one layer.
+         * NOTE: The output is calculated in tiles of rows. DepthwiseConv2D of each tile is stored in a small scratch which
+         *       is allocated from internal RAM preferentially, then the pointwise Conv2D reads the scratch and writes the
+         *       output rows. The intermediate result of DepthwiseConv2D never goes through the whole feature map size.
+         *       Each tile starts at a 16-byte aligned row of input and output, see nn::get_aligned_tiles().
+         *
+         * @tparam feature_t supports int16_t and int8_t,
+         *         - int16_t: stands for operation in int16_t quantize
+         *         - int8_t: stands for operation in int8_t quantize
+         * @tparam bias_t supports int16_t and int8_t, must specify when using int8 per-channel quantization
+         *         - int16_t: for int16 quantization and int8 per-channel quantization
+         *         - int8_t: for int8 per-tensor quantization
+         */
+        template <typename feature_t, typename bias_t = feature_t>
+        class DepthwiseSeparableConv2D : public Layer
+        {
+        private:
+            const int depthwise_exponent;                      /*<! exponent of DepthwiseConv2D result >*/
+            const Filter<feature_t> *depthwise_filter;         /*<! filter of DepthwiseConv2D >*/
+            const Bias<bias_t> *depthwise_bias;                /*<! bias of DepthwiseConv2D, if you don't specify anything, no bias is added >*/
+            const Activation<feature_t> *depthwise_activation; /*<! activation of DepthwiseConv2D, if you don't specify anything, no activation is applied >*/
+            const int stride_y;                                /*<! stride in height of DepthwiseConv2D >*/
+            const int stride_x;                                /*<! stride in width of DepthwiseConv2D >*/
+            const padding_type_t padding_type;                 /*<! one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN >*/
+            const int output_exponent;                         /*<! exponent of output >*/
+            const Filter<feature_t> *pointwise_filter;         /*<! 1x1 filter of Conv2D >*/
+            const Bias<bias_t> *pointwise_bias;                /*<! bias of Conv2D, if you don't specify anything, no bias is added >*/
+            const Activation<feature_t> *pointwise_activation; /*<! activation of Conv2D, if you don't specify anything, no activation is applied >*/
+            const int scratch_size;                            /*<! maximum size in byte of the DepthwiseConv2D tile >*/
+            std::vector<int> padding;                          /*<! padding size needed in [top, bottom, left, right] of DepthwiseConv2D >*/
+            std::vector<int> depthwise_shape;                  /*<! output shape of DepthwiseConv2D >*/
+            std::vector<int> tile_borders;                     /*<! output rows where tiles start, then the output height >*/
+            int tile_height;                                   /*<! number of output rows in the longest tile >*/
+            feature_t *scratch;                                /*<! DepthwiseConv2D result of a tile >*/
+            Tensor<feature_t> *output;                         /*<! output ptr of DepthwiseSeparableConv2D >*/
+            std::vector<int> output_shape;                     /*<! output shape of DepthwiseSeparableConv2D >*/
+
+        public:
+            /**
+             * @brief Construct a new DepthwiseSeparableConv2D object.
+             *
+             * @param depthwise_exponent   exponent of DepthwiseConv2D result, i.e., output_exponent of the DepthwiseConv2D to be fused
+             * @param depthwise_filter     filter of DepthwiseConv2D
+             * @param depthwise_bias       bias of DepthwiseConv2D, if you don't specify anything, no bias is added
+             * @param depthwise_activation activation of DepthwiseConv2D, if you don't specify anything, no activation is applied
+             * @param padding_type         one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN or PADDING_NOT_SET,
+             *                             same as DepthwiseConv2D
+             * @param padding              if padding_type is PADDING_NOT_SET, this value will be used as padding size.
+             *                             the shape must be 4, the value of each position is: [padding top, padding bottom, padding left, padding right]
+             * @param stride_y             stride in height of DepthwiseConv2D
+             * @param stride_x             stride in width of DepthwiseConv2D
+             * @param output_exponent      exponent of output, i.e., output_exponent of the Conv2D to be fused
+             * @param pointwise_filter     filter of Conv2D, [1, 1, input_channel, output_channel]
+             * @param pointwise_bias       bias of Conv2D, if you don't specify anything, no bias is added
+             * @param pointwise_activation activation of Conv2D, if you don't specify anything, no activation is applied
+             * @param name                 name of layer
+             * @param scratch_size         size in byte of the DepthwiseConv2D tile, at least one row is in a tile, more if
+             *                             no row within is 16-byte aligned
+             */
+            DepthwiseSeparableConv2D(const int depthwise_exponent,
+                                     const Filter<feature_t> *depthwise_filter,
+                                     const Bias<bias_t> *depthwise_bias,
+                                     const Activation<feature_t> *depthwise_activation,
+                                     const padding_type_t padding_type,
+                                     std::vector<int> padding,
+                                     const int stride_y,
+                                     const int stride_x,
+                                     const int output_exponent,
+                                     const Filter<feature_t> *pointwise_filter,
+                                     const Bias<bias_t> *pointwise_bias = NULL,
+                                     const Activation<feature_t> *pointwise_activation = NULL,
+                                     const char *name = "DepthwiseSeparableConv2D",
+                                     const int scratch_size = 8 * 1024) : Layer(name),
+                                                                          depthwise_exponent(depthwise_exponent),
+                                                                          depthwise_filter(depthwise_filter),
+                                                                          depthwise_bias(depthwise_bias),
+                                                                          depthwise_activation(depthwise_activation),
+                                                                          stride_y(stride_y),
+                                                                          stride_x(stride_x),
+                                                                          padding_type(padding_type),
+                                                                          output_exponent(output_exponent),
+                                                                          pointwise_filter(pointwise_filter),
+                                                                          pointwise_bias(pointwise_bias),
+                                                                          pointwise_activation(pointwise_activation),
+                                                                          scratch_size(scratch_size),
+                                                                          padding(padding),
+                                                                          depthwise_shape({}),
+                                                                          tile_borders({}),
+                                                                          tile_height(0),
+                                                                          scratch(NULL),
+                                                                          output_shape({})
+            {
+                this->output = new Tensor<feature_t>;
+                if (this->padding_type == PADDING_NOT_SET)
+                {
+                    assert(this->padding.size() == 4);
+                }
+                assert(this->pointwise_filter->shape[0] == 1 && this->pointwise_filter->shape[1] == 1);
+            }
+
+            /**
+             * @brief Destroy the DepthwiseSeparableConv2D object.
+             *
+             */
+            ~DepthwiseSeparableConv2D()
+            {
+                if (this->output != NULL)
+                {
+                    delete this->output;
+                }
+                if (this->scratch != NULL)
+                {
+                    tool::free_aligned_prefer(this->scratch);
+                }
+            }
+
+            /**
+             * @brief Update output shape, padding and tile.
+             *
+             * @param input       as an input
+             * @param print_shape whether to print the output shape.
+             */
+            void build(Tensor<feature_t> &input, bool print_shape = false)
+            {
+                assert(input.shape[0] > 0);
+                assert(input.shape[1] > 0);
+                assert(input.shape.size() == 3);
+                assert(this->depthwise_filter->shape.size() == 4);
+                assert(input.shape[2] == this->depthwise_filter->shape[2]);
+                assert(input.shape[2] == this->pointwise_filter->shape[2]);
+
+                this->depthwise_shape = nn::get_output_shape(input.shape, this->depthwise_filter->shape_with_dilation, this->stride_y, this->stride_x, this->padding_type, false, this->padding);
+                if (this->padding_type != PADDING_NOT_SET)
+                {
+                    this->padding = nn::get_pad_size(this->depthwise_shape, input.shape, this->depthwise_filter->shape_with_dilation, this->stride_y, this->stride_x, this->padding_type);
+                }
+                this->output_shape = {this->depthwise_shape[0], this->depthwise_shape[1], this->pointwise_filter->shape[3]};
+                this->output->set_shape(this->output_shape);
+                this->output->set_exponent(this->output_exponent);
+                this->output->free_element();
+
+                int row_size = this->depthwise_shape[1] * this->depthwise_shape[2];
+                int tile_height = DL_MIN(DL_MAX(this->scratch_size / (int)(row_size * sizeof(feature_t)), 1), this->depthwise_shape[0]);
+                tile_height = nn::get_aligned_tiles<feature_t>(this->tile_borders, this->output_shape[0], tile_height, this->output_shape[1] * this->output_shape[2], input.shape[1] * input.shape[2], this->stride_y, this->padding[0]);
+                if (tile_height != this->tile_height)
+                {
+                    if (this->scratch != NULL)
+                    {
+                        tool::free_aligned_prefer(this->scratch);
+                    }
+                    this->tile_height = tile_height;
+                    this->scratch = (feature_t *)tool::malloc_aligned_prefer(tile_height * row_size, sizeof(feature_t), 16);
+                }
+
+                if (print_shape)
+                {
+                    std::cout << this->name << " | ";
+                    this->output->print_shape();
+                }
+            }
+
+            /**
+             * @brief Get the output
+             *
+             * @return Tensor<feature_t>& DepthwiseSeparableConv2D result
+             */
+            Tensor<feature_t> &get_output()
+            {
+                return *this->output;
+            }
+
+            /**
+             * @brief Call DepthwiseSeparableConv2D operation
+             *
+             * @param input       as an input
+             * @param assign_core cores given to nn::depthwise_conv2d and nn::conv2d of each tile
+             * @return DepthwiseSeparableConv2D result
+             */
+            Tensor<feature_t> &call(Tensor<feature_t> &input, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
+            {
+                DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("depthwise_separable_conv2d", this->output, {input.element});
+
+                DL_LOG_LAYER_LATENCY_START();
+                if (this->output->shape != this->output_shape)
+                {
+                    this->output->set_shape(this->output_shape);
+                }
+                this->output->malloc_element();
+                this->output->set_exponent(this->output_exponent);
+                DL_LOG_LAYER_LATENCY_END(this->name, "apply");
+
+                DL_LOG_LAYER_LATENCY_START();
+                const int input_height = input.shape[0];
+                const int input_row_size = input.shape[1] * input.shape[2];
+                const int output_row_size = this->output_shape[1] * this->output_shape[2];
+                const int filter_height = this->depthwise_filter->shape_with_dilation[0];
+                std::vector<int> pointwise_padding = {0, 0, 0, 0};
+
+                for (int i = 1; i < (int)this->tile_borders.size(); i++)
+                {
+                    int y = this->tile_borders[i - 1];
+                    int rows = this->tile_borders[i] - y;
+
+                    // input rows needed by this tile, rows out of input are covered by padding
+                    int input_begin = y * this->stride_y - this->padding[0];
+                    int input_end = (y + rows - 1) * this->stride_y - this->padding[0] + filter_height;
+                    std::vector<int> tile_padding = {DL_MAX(-input_begin, 0), DL_MAX(input_end - input_height, 0), this->padding[2], this->padding[3]};
+                    input_begin = DL_MAX(input_begin, 0);
+                    input_end = DL_MIN(input_end, input_height);
+
+                    assert(nn::is_aligned_row<feature_t>(y, output_row_size, input_row_size, this->stride_y, this->padding[0]));
+
+                    Tensor<feature_t> input_tile;
+                    input_tile.set_element(input.element + input_begin * input_row_size).set_exponent(input.exponent).set_shape({input_end - input_begin, input.shape[1], input.shape[2]});
+
+                    Tensor<feature_t> depthwise_tile;
+                    depthwise_tile.set_element(this->scratch).set_exponent(this->depthwise_exponent).set_shape({rows, this->depthwise_shape[1], this->depthwise_shape[2]});
+
+                    Tensor<feature_t> output_tile;
+                    output_tile.set_element(this->output->element + y * output_row_size).set_exponent(this->output_exponent).set_shape({rows, this->output_shape[1], this->output_shape[2]});
+
+                    nn::depthwise_conv2d(depthwise_tile, input_tile, tile_padding, *(this->depthwise_filter), this->stride_y, this->stride_x, this->depthwise_bias, this->depthwise_activation, assign_core);
+                    nn::conv2d(output_tile, depthwise_tile, pointwise_padding, *(this->pointwise_filter), 1, 1, this->pointwise_bias, this->pointwise_activation, assign_core);
+                }
+                DL_LOG_LAYER_LATENCY_END(this->name, "depthwise_separable_conv2d");
+                return *this->output;
+            }
+
+            /**
+             * @brief Preload the filters to Cache.
+             * NOTE: Call this layer's preload() before previous layer's call() such that filters could be loaded while previous layer is doing calculation.
+             */
+            void preload()
+            {
+                const Filter<feature_t> *filters[2] = {this->depthwise_filter, this->pointwise_filter};
+                for (int n = 0; n < 2; n++)
+                {
+                    // placed in internal RAM, e.g., by WeightPlacement
+                    if (esp_ptr_internal(filters[n]->element))
+                        continue;
+
+                    size_t size = sizeof(feature_t);
+                    int shape_size = filters[n]->shape.size();
+                    for (int i = 0; i < shape_size; ++i)
+                    {
+                        size *= filters[n]->shape[i];
+                    }
+                    dl::tool::cache::preload_func((uint32_t)(filters[n]->element), size);
+                }
+            }
+        };
+    } // namespace layer
+} // namespace dl
@@ -108,6 +108,7 @@ namespace dl
             Tensor<feature_t> &call(Tensor<feature_t> &input)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("expand_dims", this->output, {input.element});
 
                 if (!this->inplace)
                 {
@@ -126,6 +126,7 @@ namespace dl
             Tensor<feature_t> &call(Tensor<feature_t> &input, bool autoload_enable = false, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("fully_connected", this->output, {input.element});
 
                 DL_LOG_LAYER_LATENCY_START();
                 if (this->output->shape != this->output_shape)
@@ -154,6 +155,10 @@ namespace dl
              */
             void preload()
             {
+                // placed in internal RAM, e.g., by WeightPlacement
+                if (esp_ptr_internal(this->filter->element))
+                    return;
+
                 size_t size = sizeof(feature_t);
                 int shape_size = this->filter->shape.size();
                 for (int i = 0; i < shape_size; ++i)
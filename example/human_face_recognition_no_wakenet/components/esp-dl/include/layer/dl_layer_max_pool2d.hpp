@@ -130,6 +130,7 @@ namespace dl
             Tensor<feature_t> &call(Tensor<feature_t> &input, uint8_t autoload_enable = 0)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("max_pool2d", this->output, {input.element});
 
                 DL_LOG_LAYER_LATENCY_START();
                 if (this->output->shape != this->output_shape)
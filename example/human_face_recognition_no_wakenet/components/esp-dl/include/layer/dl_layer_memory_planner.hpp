@@ -0,0 +1,294 @@
+#pragma once
+
+#include <assert.h>
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+#include "dl_variable.hpp"
+#include "dl_tool.hpp"
+
+namespace dl
+{
+    namespace layer
+    {
+        /**
+         * @brief Static memory planner of the activations in a Model.
+         *
+         * Every layer output is recorded in execution order, together with the Tensors it reads. The step a Tensor is
+         * produced and the last step it is read define its lifetime. plan() then places all recorded Tensors into one
+         * arena, and Tensors whose lifetimes do not overlap share the same offset. The peak memory becomes the maximum
+         * live set instead of the sum of all activations.
+         *
+         * Usage in Model.build():
+         *   1. planner.clear() before building any layer,
+         *   2. planner.record(layer.get_output(), {inputs of layer}) after each layer.build(...),
+         *   3. planner.plan() after the last layer.build(...).
+         *
+         * A planned Tensor is not auto freed, so free_element() in Model.call() turns into no-op and malloc_element()
+         * keeps the arena memory.
+         *
+         * @tparam feature_t supports int16_t and int8_t
+         */
+        template <typename feature_t>
+        class MemoryPlanner
+        {
+        private:
+            /**
+             * @brief Lifetime and placement of one recorded Tensor.
+             */
+            typedef struct
+            {
+                Tensor<feature_t> *tensor; /*<! recorded Tensor >*/
+                int first_step;            /*<! step the Tensor is produced >*/
+                int last_step;             /*<! last step the Tensor is read >*/
+                int bytes;                 /*<! size in byte, aligned to 16 >*/
+                int offset;                /*<! offset in arena in byte >*/
+            } block_t;
+
+            std::vector<block_t> blocks; /*<! recorded Tensors in execution order >*/
+            feature_t *arena;            /*<! memory shared by all planned Tensors >*/
+            int arena_size;              /*<! size of arena in byte >*/
+            int step;                    /*<! index of the next recorded layer >*/
+
+            int find(Tensor<feature_t> *tensor)
+            {
+                for (int i = 0; i < this->blocks.size(); i++)
+                {
+                    if (this->blocks[i].tensor == tensor)
+                        return i;
+                }
+                return -1;
+            }
+
+        public:
+            /**
+             * @brief Construct a new MemoryPlanner object.
+             */
+            MemoryPlanner() : arena(NULL), arena_size(0), step(0) {}
+
+            /**
+             * @brief Destroy the MemoryPlanner object. Planned Tensors are unbound from the arena.
+             */
+            ~MemoryPlanner()
+            {
+                this->clear();
+            }
+
+            /**
+             * @brief Unbind all planned Tensors, free the arena and forget all records.
+             */
+            void clear()
+            {
+                if (this->arena)
+                {
+                    for (int i = 0; i < this->blocks.size(); i++)
+                    {
+                        Tensor<feature_t> *tensor = this->blocks[i].tensor;
+                        if (tensor->element == (feature_t *)((uint8_t *)this->arena + this->blocks[i].offset))
+                        {
+                            tensor->element = NULL;
+                            tensor->set_auto_free(true);
+                        }
+                    }
+                    tool::free_aligned_prefer(this->arena);
+                    this->arena = NULL;
+                }
+                this->arena_size = 0;
+                this->step = 0;
+                this->blocks.clear();
+            }
+
+            /**
+             * @brief Record one layer. Must be called in the same order as layers are called in Model.call().
+             *
+             * @param output output of layer, its shape must be built already
+             * @param inputs inputs of layer. Tensors not recorded before, e.g. the input of Model, are not planned
+             */
+            void record(Tensor<feature_t> &output, std::vector<Tensor<feature_t> *> inputs = {})
+            {
+                for (int i = 0; i < inputs.size(); i++)
+                {
+                    int index = this->find(inputs[i]);
+                    if (index >= 0)
+                        this->blocks[index].last_step = this->step;
+                }
+
+                int index = this->find(&output);
+                if (index >= 0)
+                {
+                    // Tensor written inplace, extend its lifetime
+                    this->blocks[index].last_step = this->step;
+                }
+                else
+                {
+                    block_t block;
+                    block.tensor = &output;
+                    block.first_step = this->step;
+                    block.last_step = this->step;
+                    block.bytes = (output.get_size() * sizeof(feature_t) + 15) & ~15;
+                    block.offset = 0;
+                    this->blocks.push_back(block);
+                }
+                this->step++;
+            }
+
+            /**
+             * @brief Assign offsets greedily, biggest Tensor first, then allocate the arena and bind the Tensors.
+             *
+             * @return true: success
+             *         false: fail to allocate arena, Tensors are kept unplanned
+             */
+            bool plan()
+            {
+                assert(this->arena == NULL);
+
+                std::vector<int> order(this->blocks.size());
+                for (int i = 0; i < order.size(); i++)
+                    order[i] = i;
+                std::stable_sort(order.begin(), order.end(), [this](int a, int b)
+                                 { return this->blocks[a].bytes > this->blocks[b].bytes; });
+
+                std::vector<int> placed;
+                this->arena_size = 0;
+                for (int i = 0; i < order.size(); i++)
+                {
+                    block_t &block = this->blocks[order[i]];
+
+                    // placed blocks alive at the same time, sorted by offset
+                    std::vector<int> conflicts;
+                    for (int j = 0; j < placed.size(); j++)
+                    {
+                        block_t &other = this->blocks[placed[j]];
+                        if (other.first_step <= block.last_step && block.first_step <= other.last_step)
+                            conflicts.push_back(placed[j]);
+                    }
+                    std::sort(conflicts.begin(), conflicts.end(), [this](int a, int b)
+                              { return this->blocks[a].offset < this->blocks[b].offset; });
+
+                    // lowest gap which is big enough
+                    int offset = 0;
+                    for (int j = 0; j < conflicts.size(); j++)
+                    {
+                        block_t &other = this->blocks[conflicts[j]];
+                        if (offset + block.bytes <= other.offset)
+                            break;
+                        offset = DL_MAX(offset, other.offset + other.bytes);
+                    }
+                    block.offset = offset;
+                    this->arena_size = DL_MAX(this->arena_size, offset + block.bytes);
+                    placed.push_back(order[i]);
+                }
+
+                if (this->arena_size == 0)
+                    return true;
+
+                this->arena = (feature_t *)tool::malloc_aligned_prefer(this->arena_size, 1, 16);
+                if (this->arena == NULL)
+                {
+                    this->arena_size = 0;
+                    return false;
+                }
+
+                for (int i = 0; i < this->blocks.size(); i++)
+                {
+                    Tensor<feature_t> *tensor = this->blocks[i].tensor;
+                    tensor->free_element();
+                    tensor->element = (feature_t *)((uint8_t *)this->arena + this->blocks[i].offset);
+                    tensor->set_auto_free(false);
+                }
+                return true;
+            }
+
+            /**
+             * @brief Get the memory size without planning, i.e., every activation owns its memory.
+             *
+             * @return size in byte
+             */
+            int get_unplanned_size()
+            {
+                int size = 0;
+                for (int i = 0; i < this->blocks.size(); i++)
+                    size += this->blocks[i].bytes;
+                return size;
+            }
+
+            /**
+             * @brief Get the maximum live set, i.e., the lower bound of arena size.
+             *
+             * @return size in byte
+             */
+            int get_peak_live_size()
+            {
+                int peak = 0;
+                for (int s = 0; s < this->step; s++)
+                {
+                    int live = 0;
+                    for (int i = 0; i < this->blocks.size(); i++)
+                    {
+                        if (this->blocks[i].first_step <= s && s <= this->blocks[i].last_step)
+                            live += this->blocks[i].bytes;
+                    }
+                    peak = DL_MAX(peak, live);
+                }
+                return peak;
+            }
+
+            /**
+             * @brief Get the arena size after planning.
+             *
+             * @return size in byte
+             */
+            int get_planned_size()
+            {
+                return this->arena_size;
+            }
+
+            /**
+             * @brief Get the number of recorded Tensors.
+             *
+             * @return int number of recorded Tensors
+             */
+            int get_block_num()
+            {
+                return this->blocks.size();
+            }
+
+            /**
+             * @brief Get the lifetime and placement of a recorded Tensor, e.g., to check a plan.
+             *
+             * @param index      index of record, in execution order
+             * @param first_step step the Tensor is produced
+             * @param last_step  last step the Tensor is read
+             * @param offset     offset in arena in byte
+             * @param bytes      size in byte, aligned to 16
+             * @return Tensor<feature_t>* recorded Tensor
+             */
+            Tensor<feature_t> *get_block(const int index, int &first_step, int &last_step, int &offset, int &bytes)
+            {
+                block_t &block = this->blocks[index];
+                first_step = block.first_step;
+                last_step = block.last_step;
+                offset = block.offset;
+                bytes = block.bytes;
+                return block.tensor;
+            }
+
+            /**
+             * @brief Print lifetime, offset and size of each Tensor, and the peak memory before and after planning.
+             */
+            void print()
+            {
+                for (int i = 0; i < this->blocks.size(); i++)
+                {
+                    block_t &block = this->blocks[i];
+                    printf("step [%3d, %3d] | offset %8d | %8d bytes\n", block.first_step, block.last_step, block.offset, block.bytes);
+                }
+                printf("unplanned: %d bytes, peak live: %d bytes, planned: %d bytes\n",
+                       this->get_unplanned_size(),
+                       this->get_peak_live_size(),
+                       this->get_planned_size());
+            }
+        };
+    } // namespace layer
+} // namespace dl
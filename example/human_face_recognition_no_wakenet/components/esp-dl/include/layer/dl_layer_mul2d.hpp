@@ -117,6 +117,7 @@ namespace dl
             Tensor<feature_t> &call(Tensor<feature_t> &input0, Tensor<feature_t> &input1, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("mul2d", this->output, {input0.element, input1.element});
 
                 if (!this->inplace)
                 {
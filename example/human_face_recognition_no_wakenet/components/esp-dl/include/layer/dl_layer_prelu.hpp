@@ -111,6 +111,7 @@ namespace dl
             Tensor<feature_t> &call(Tensor<feature_t> &input, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("prelu", this->output, {input.element});
 
                 if (!this->inplace)
                 {
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <initializer_list>
+
+#include "esp_memory_utils.h"
+#include "freertos/FreeRTOS.h"
+#include "dl_tool.hpp"
+#include "dl_variable.hpp"
+
+namespace dl
+{
+    namespace layer
+    {
+        typedef enum
+        {
+            PROFILE_INPUT_NONE = 0,     /*<! no input recorded >*/
+            PROFILE_INPUT_INTERNAL = 1, /*<! all inputs are in internal RAM >*/
+            PROFILE_INPUT_PSRAM = 2,    /*<! all inputs are in PSRAM >*/
+            PROFILE_INPUT_MIXED = 3,    /*<! some inputs are in internal RAM, the others are in PSRAM >*/
+        } profile_input_t;
+
+        /**
+         * @brief Records of layer calls, enabled by DL_PROFILE_LAYER.
+         *
+         * Each Layer::call() appends a record of cycles, output bytes and where the inputs are. Records are kept in a
+         * buffer reserved by start(), no allocation happens while a model is running, records beyond capacity are
+         * counted as dropped. A model marks its call() by DL_PROFILE_MODEL_CALL(), so records of one forward share the
+         * same call index.
+         */
+        class Profiler
+        {
+        public:
+            /**
+             * @brief A layer call.
+             */
+            typedef struct
+            {
+                const char *name;      /*<! name of layer >*/
+                const char *key;       /*<! operation of layer >*/
+                uint32_t call;         /*<! index of model call, 0 for layers called out of a model >*/
+                uint32_t cycle;        /*<! cycles of the layer call >*/
+                uint32_t output_bytes; /*<! size of output in byte >*/
+                uint8_t input;         /*<! one of profile_input_t >*/
+            } record_t;
+
+        private:
+            std::vector<record_t> records; /*<! records since start() >*/
+            size_t capacity;               /*<! maximum number of records >*/
+            uint32_t call;                 /*<! index of current model call >*/
+            uint32_t dropped;              /*<! records dropped for capacity >*/
+            bool enabled;                  /*<! true: recording >*/
+            portMUX_TYPE lock;             /*<! records are appended from any core >*/
+
+            Profiler() : capacity(0), call(0), dropped(0), enabled(false), lock(portMUX_INITIALIZER_UNLOCKED) {}
+
+            static const char *input_to_string(uint8_t input)
+            {
+                switch (input)
+                {
+                case PROFILE_INPUT_INTERNAL:
+                    return "internal";
+                case PROFILE_INPUT_PSRAM:
+                    return "psram";
+                case PROFILE_INPUT_MIXED:
+                    return "mixed";
+                default:
+                    return "none";
+                }
+            }
+
+        public:
+            /**
+             * @brief Get the Profiler shared by all layers.
+             *
+             * @return Profiler&
+             */
+            static Profiler &get_instance()
+            {
+                static Profiler profiler;
+                return profiler;
+            }
+
+            /**
+             * @brief Clear records and start recording.
+             *
+             * @param capacity maximum number of records
+             */
+            void start(const size_t capacity = 512)
+            {
+                this->enabled = false;
+                this->records.clear();
+                this->records.reserve(capacity);
+                this->capacity = capacity;
+                this->call = 0;
+                this->dropped = 0;
+                this->enabled = true;
+            }
+
+            /**
+             * @brief Stop recording, records are kept.
+             */
+            void stop()
+            {
+                this->enabled = false;
+            }
+
+            /**
+             * @brief Mark the beginning of a model call.
+             */
+            void next_call()
+            {
+                if (this->enabled)
+                    this->call++;
+            }
+
+            /**
+             * @brief Append a record.
+             *
+             * @param name         name of layer
+             * @param key          operation of layer
+             * @param cycle        cycles of the layer call
+             * @param output_bytes size of output in byte
+             * @param input        one of profile_input_t
+             */
+            void record(const char *name, const char *key, uint32_t cycle, uint32_t output_bytes, uint8_t input)
+            {
+                if (!this->enabled)
+                    return;
+
+                portENTER_CRITICAL(&this->lock);
+                if (this->records.size() < this->capacity)
+                    this->records.push_back({name, key, this->call, cycle, output_bytes, input});
+                else
+                    this->dropped++;
+                portEXIT_CRITICAL(&this->lock);
+            }
+
+            /**
+             * @brief Get the records.
+             *
+             * @return const std::vector<record_t>& records in order of call
+             */
+            const std::vector<record_t> &get_records()
+            {
+                return this->records;
+            }
+
+            /**
+             * @brief Print a row for each layer call, in format "call,layer,op,cycle,output_bytes,input".
+             *
+             * @param stream where to print
+             */
+            void print_csv(FILE *stream = stdout)
+            {
+                fprintf(stream, "call,layer,op,cycle,output_bytes,input\n");
+                for (auto &record : this->records)
+                    fprintf(stream, "%lu,%s,%s,%lu,%lu,%s\n",
+                            (unsigned long)record.call,
+                            record.name ? record.name : "",
+                            record.key,
+                            (unsigned long)record.cycle,
+                            (unsigned long)record.output_bytes,
+                            input_to_string(record.input));
+            }
+
+            /**
+             * @brief Print a summary of each layer in JSON, layers are in order of first call.
+             *
+             * @param stream where to print
+             */
+            void print_json(FILE *stream = stdout)
+            {
+                // aggregate records of the same layer and operation
+                std::vector<int> first;
+                std::vector<int> layer(this->records.size());
+                for (int i = 0; i < this->records.size(); i++)
+                {
+                    record_t &record = this->records[i];
+                    layer[i] = -1;
+                    for (int j = 0; j < first.size(); j++)
+                    {
+                        record_t &other = this->records[first[j]];
+                        if (other.name == record.name && other.key == record.key)
+                        {
+                            layer[i] = j;
+                            break;
+                        }
+                    }
+                    if (layer[i] < 0)
+                    {
+                        layer[i] = first.size();
+                        first.push_back(i);
+                    }
+                }
+
+                uint64_t total = 0;
+                for (auto &record : this->records)
+                    total += record.cycle;
+
+                fprintf(stream, "{\"calls\":%lu,\"records\":%u,\"dropped\":%lu,\"cycle_total\":%llu,\"layers\":[",
+                        (unsigned long)this->call, (unsigned)this->records.size(), (unsigned long)this->dropped, (unsigned long long)total);
+                for (int j = 0; j < first.size(); j++)
+                {
+                    uint32_t count = 0, cycle_max = 0, psram = 0;
+                    uint64_t cycle_sum = 0;
+                    for (int i = 0; i < this->records.size(); i++)
+                    {
+                        if (layer[i] != j)
+                            continue;
+                        record_t &record = this->records[i];
+                        count++;
+                        cycle_sum += record.cycle;
+                        cycle_max = DL_MAX(cycle_max, record.cycle);
+                        if (record.input & PROFILE_INPUT_PSRAM)
+                            psram++;
+                    }
+
+                    record_t &record = this->records[first[j]];
+                    fprintf(stream, "%s{\"layer\":\"%s\",\"op\":\"%s\",\"count\":%lu,\"cycle_average\":%llu,\"cycle_max\":%lu,\"output_bytes\":%lu,\"psram_inputs\":%lu}",
+                            j ? "," : "",
+                            record.name ? record.name : "",
+                            record.key,
+                            (unsigned long)count,
+                            (unsigned long long)(cycle_sum / count),
+                            (unsigned long)cycle_max,
+                            (unsigned long)record.output_bytes,
+                            (unsigned long)psram);
+                }
+                fprintf(stream, "]}\n");
+            }
+        };
+
+        /**
+         * @brief Record a layer call from construction to destruction, see DL_PROFILE_LAYER_CALL().
+         *
+         * @tparam T element type of output
+         */
+        template <typename T>
+        class ProfilerScope
+        {
+        private:
+            const char *name;         /*<! name of layer >*/
+            const char *key;          /*<! operation of layer >*/
+            Tensor<T> *const *output; /*<! output of layer, read at the end of call >*/
+            uint8_t input;            /*<! one of profile_input_t >*/
+            uint32_t timestamp;       /*<! cycle count at construction >*/
+
+            void add_input(const void *element)
+            {
+                if (element)
+                    this->input |= esp_ptr_internal(element) ? PROFILE_INPUT_INTERNAL : PROFILE_INPUT_PSRAM;
+            }
+
+        public:
+            /**
+             * @brief Construct a new Profiler Scope object.
+             *
+             * @param name   name of layer
+             * @param key    operation of layer
+             * @param output output of layer
+             * @param inputs elements of inputs
+             */
+            ProfilerScope(const char *name, const char *key, Tensor<T> *const &output, std::initializer_list<const void *> inputs) : name(name), key(key), output(&output), input(PROFILE_INPUT_NONE)
+            {
+                for (const void *element : inputs)
+                    this->add_input(element);
+                this->timestamp = dl::tool::get_cycle();
+            }
+
+            /**
+             * @brief Construct a new Profiler Scope object.
+             *
+             * @param name   name of layer
+             * @param key    operation of layer
+             * @param output output of layer
+             * @param inputs inputs of layer
+             */
+            template <typename I>
+            ProfilerScope(const char *name, const char *key, Tensor<T> *const &output, const std::vector<Tensor<I> *> &inputs) : name(name), key(key), output(&output), input(PROFILE_INPUT_NONE)
+            {
+                for (Tensor<I> *tensor : inputs)
+                    this->add_input(tensor->element);
+                this->timestamp = dl::tool::get_cycle();
+            }
+
+            /**
+             * @brief Destroy the Profiler Scope object. Append the record.
+             */
+            ~ProfilerScope()
+            {
+                uint32_t cycle = dl::tool::get_cycle() - this->timestamp;
+                Tensor<T> *tensor = *this->output;
+                uint32_t output_bytes = tensor ? tensor->get_size() * sizeof(T) : 0;
+                Profiler::get_instance().record(this->name, this->key, cycle, output_bytes, this->input);
+            }
+
+            ProfilerScope(const ProfilerScope &) = delete;
+            ProfilerScope &operator=(const ProfilerScope &) = delete;
+        };
+    } // namespace layer
+} // namespace dl
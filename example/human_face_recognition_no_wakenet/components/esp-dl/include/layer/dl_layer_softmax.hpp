@@ -120,6 +120,7 @@ namespace dl
             Tensor<O> &call(Tensor<I> &input, const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
             {
                 DL_LOG_LAYER_LATENCY_INIT();
+                DL_PROFILE_LAYER_CALL("softmax", this->output, {input.element});
 
                 if constexpr (inplace == false || type == QIFO || sizeof(I) != sizeof(O))
                 {
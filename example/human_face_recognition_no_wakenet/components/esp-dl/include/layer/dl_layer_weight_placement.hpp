@@ -0,0 +1,229 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include "esp_heap_caps.h"
+#include "esp_memory_utils.h"
+#include "dl_constant.hpp"
+#include "dl_tool.hpp"
+#include "dl_tool_cache.hpp"
+#if DL_PROFILE_LAYER
+#include "dl_layer_profiler.hpp"
+#endif
+
+namespace dl
+{
+    namespace layer
+    {
+        /**
+         * @brief Placement of model coefficients between internal RAM and flash/PSRAM.
+         *
+         * Coefficients are added in execution order with the name of their layer. place() copies the most valuable
+         * ones into internal RAM until budget is used up and points their element to the copy, so layers read them
+         * without going through cache. The value of a coefficient is the cycles of its layer per byte, set by
+         * set_cycle() or taken from a Profiler. Without any cycles, earlier layers go first. The others stay where they
+         * are and can be prefetched by preload() before their layer runs.
+         *
+         * Usage in Model constructor, after layers are constructed:
+         *   1. placement.add(filter, "layer name") for each filter or bias worth placing,
+         *   2. placement.place().
+         */
+        class WeightPlacement
+        {
+        private:
+            /**
+             * @brief One added coefficient.
+             */
+            typedef struct
+            {
+                const void **element; /*<! element of Constant, pointing to the copy after placed >*/
+                const void *origin;   /*<! element before placed >*/
+                const char *name;     /*<! name of layer >*/
+                int bytes;            /*<! size in byte >*/
+                uint64_t cycle;       /*<! cycles of layer, 0 for unknown >*/
+                bool placed;          /*<! true: element is in internal RAM by place() >*/
+            } entry_t;
+
+            std::vector<entry_t> entries; /*<! added coefficients in execution order >*/
+            int budget;                   /*<! maximum bytes of internal RAM >*/
+            int used;                     /*<! bytes of internal RAM in use >*/
+
+        public:
+            /**
+             * @brief Construct a new WeightPlacement object.
+             *
+             * @param budget maximum bytes of internal RAM for coefficients
+             */
+            WeightPlacement(const int budget = 32 * 1024) : budget(budget), used(0) {}
+
+            /**
+             * @brief Destroy the WeightPlacement object. Placed coefficients are restored.
+             */
+            ~WeightPlacement()
+            {
+                this->restore();
+            }
+
+            /**
+             * @brief Add a coefficient. Constants already in internal RAM are ignored.
+             *
+             * @tparam T       element type of Constant
+             * @param constant Filter or Bias of a layer
+             * @param name     name of layer, to match cycles
+             */
+            template <typename T>
+            void add(const Constant<T> *constant, const char *name = NULL)
+            {
+                if (constant == NULL || constant->element == NULL || esp_ptr_internal(constant->element))
+                    return;
+
+                int size = 1;
+                for (int i = 0; i < constant->shape.size(); i++)
+                    size *= constant->shape[i];
+
+                entry_t entry;
+                entry.element = (const void **)&const_cast<Constant<T> *>(constant)->element;
+                entry.origin = constant->element;
+                entry.name = name;
+                entry.bytes = size * sizeof(T);
+                entry.cycle = 0;
+                entry.placed = false;
+                this->entries.push_back(entry);
+            }
+
+            /**
+             * @brief Set the cycles of a layer, e.g., measured by dl::tool::Latency.
+             *
+             * @param name  name of layer
+             * @param cycle cycles of layer per call
+             */
+            void set_cycle(const char *name, uint64_t cycle)
+            {
+                for (auto &entry : this->entries)
+                {
+                    if (entry.name && name && strcmp(entry.name, name) == 0)
+                        entry.cycle = cycle;
+                }
+            }
+
+#if DL_PROFILE_LAYER
+            /**
+             * @brief Set the cycles of all layers from the records of a Profiler.
+             *
+             * @param profiler Profiler recorded at least one model call
+             */
+            void set_cycle(Profiler &profiler)
+            {
+                for (auto &entry : this->entries)
+                {
+                    if (entry.name == NULL)
+                        continue;
+                    entry.cycle = 0;
+                    for (auto &record : profiler.get_records())
+                    {
+                        if (record.name && strcmp(entry.name, record.name) == 0)
+                            entry.cycle += record.cycle;
+                    }
+                }
+            }
+#endif
+
+            /**
+             * @brief Copy coefficients into internal RAM by value per byte until budget is used up. Placed ones are
+             * restored first, so place() can be called again after cycles are updated.
+             *
+             * @return int bytes placed
+             */
+            int place()
+            {
+                this->restore();
+
+                std::vector<int> order(this->entries.size());
+                for (int i = 0; i < order.size(); i++)
+                    order[i] = i;
+                std::stable_sort(order.begin(), order.end(), [this](int a, int b)
+                                 {
+                                     const entry_t &x = this->entries[a];
+                                     const entry_t &y = this->entries[b];
+                                     // x.cycle / x.bytes > y.cycle / y.bytes
+                                     return x.cycle * y.bytes > y.cycle * x.bytes;
+                                 });
+
+                for (int i : order)
+                {
+                    entry_t &entry = this->entries[i];
+                    if (this->used + entry.bytes > this->budget)
+                        continue;
+
+                    void *copy = heap_caps_aligned_alloc(16, entry.bytes, MALLOC_CAP_8BIT | MALLOC_CAP_INTERNAL);
+                    if (copy == NULL)
+                        continue;
+
+                    memcpy(copy, entry.origin, entry.bytes);
+                    *entry.element = copy;
+                    entry.placed = true;
+                    this->used += entry.bytes;
+                }
+                return this->used;
+            }
+
+            /**
+             * @brief Point all placed coefficients back to their origin and free the copies.
+             */
+            void restore()
+            {
+                for (auto &entry : this->entries)
+                {
+                    if (!entry.placed)
+                        continue;
+                    heap_caps_free((void *)*entry.element);
+                    *entry.element = entry.origin;
+                    entry.placed = false;
+                }
+                this->used = 0;
+            }
+
+            /**
+             * @brief Prefetch coefficients of a layer left out of internal RAM. Call it before the previous layer's call(),
+             * so loading overlaps calculation.
+             *
+             * @param name name of layer
+             */
+            void preload(const char *name)
+            {
+                for (auto &entry : this->entries)
+                {
+                    if (!entry.placed && entry.name && name && strcmp(entry.name, name) == 0)
+                        dl::tool::cache::preload_func((uint32_t)entry.origin, entry.bytes);
+                }
+            }
+
+            /**
+             * @brief Get the bytes of internal RAM in use.
+             *
+             * @return int size in byte
+             */
+            int get_used_size()
+            {
+                return this->used;
+            }
+
+            /**
+             * @brief Print where each coefficient is.
+             */
+            void print()
+            {
+                for (auto &entry : this->entries)
+                    printf("%s: %d bytes, %llu cycles, %s\n",
+                           entry.name ? entry.name : "",
+                           entry.bytes,
+                           (unsigned long long)entry.cycle,
+                           entry.placed ? "internal" : "origin");
+                printf("internal: %d / %d bytes\n", this->used, this->budget);
+            }
+        };
+    } // namespace layer
+} // namespace dl
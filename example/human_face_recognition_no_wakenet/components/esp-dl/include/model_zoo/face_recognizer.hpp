@@ -69,6 +69,18 @@ class FaceRecognizer
          * @return face_info_t      the recognition result.
          */
         face_info_t recognize(uint16_t *image_input, std::vector<int> shape, std::vector<int> &landmarks);
+
+        /**
+         * @brief recognize several faces in one image
+         * 
+         * Note: the same as calling recognize() above on each face in a loop, the backbone runs once per face. Every
+         *       face is aligned into one [H, W, C] scratch allocated once per call and reused by the next face.
+         * @param image_input       the pointer of the input image with format bgr565.
+         * @param shape             the shape of the input image
+         * @param landmarks         face landmarks coordinates of each face
+         * @return std::vector<face_info_t>  the recognition results, in the same order as landmarks.
+         */
+        std::vector<face_info_t> recognize(uint16_t *image_input, std::vector<int> shape, std::vector<std::vector<int>> &landmarks);
         
         /**
          * @brief recognize face
@@ -293,4 +305,26 @@ class FaceRecognizer
          */
         int set_partition(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label);
 
-};
\ No newline at end of file
+};
+
+template <typename feature_t>
+std::vector<face_info_t> FaceRecognizer<feature_t>::recognize(uint16_t *image_input, std::vector<int> shape, std::vector<std::vector<int>> &landmarks)
+{
+    std::vector<face_info_t> results;
+    if (landmarks.empty())
+        return results;
+
+    Tensor<uint8_t> aligned_face;
+    aligned_face.set_shape(this->get_input_shape());
+    aligned_face.malloc_element();
+    if (aligned_face.element == NULL)
+        return results;
+
+    results.reserve(landmarks.size());
+    for (int i = 0; i < landmarks.size(); i++)
+    {
+        face_recognition_tool::align_face(image_input, shape, &aligned_face, landmarks[i]);
+        results.push_back(this->recognize(aligned_face));
+    }
+    return results;
+}
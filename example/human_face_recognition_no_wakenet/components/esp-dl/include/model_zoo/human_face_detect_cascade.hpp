@@ -0,0 +1,197 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include <algorithm>
+#include "dl_detect_define.hpp"
+#include "dl_variable.hpp"
+#include "dl_tool.hpp"
+#include "human_face_detect_msr01.hpp"
+#include "human_face_detect_mnp01.hpp"
+
+/**
+ * @brief Two-stage human face detector, HumanFaceDetectMSR01 followed by HumanFaceDetectMNP01.
+ *
+ * Stage two crops each candidate box from the frame and resizes it to its input by itself, so the frame is resampled
+ * once per candidate and the cost of stage two depends on the number of faces rather than the frame size.
+ *         - candidates are sorted by score and at most max_candidates of them go to stage two,
+ *         - each candidate is refined alone, so top_k2 applies per candidate, and the results of all candidates go
+ *           through one more nms,
+ *         - candidates with score higher than confident_score skip stage two and have no keypoint, the default 1.0
+ *           never skips, so every result comes from stage two and has keypoints to be aligned for recognition.
+ * Results between the stages are kept in a pool allocated at construction, so refining allocates nothing by itself.
+ */
+class HumanFaceDetectCascade
+{
+private:
+    HumanFaceDetectMSR01 stage1;              /*<! candidate generator >*/
+    HumanFaceDetectMNP01 stage2;              /*<! candidate refiner with keypoints >*/
+    const float nms_threshold;                /*<! IoU threshold between results of different regions >*/
+    const int max_candidates;                 /*<! maximum number of candidates going to stage two >*/
+    const float confident_score;              /*<! candidates with higher score skip stage two >*/
+    dl::detect::ResultPool pool;              /*<! results of the lists below, no allocation per inference >*/
+    std::list<dl::detect::result_t> local;    /*<! one candidate, as input of stage two >*/
+    std::list<dl::detect::result_t> refined;  /*<! results of all candidates before nms >*/
+    std::list<dl::detect::result_t> results;  /*<! results of the last inference >*/
+    dl::tool::Latency latency_stage1;         /*<! latency of stage one >*/
+    dl::tool::Latency latency_stage2;         /*<! latency of stage two >*/
+
+    static float iou(const std::vector<int> &a, const std::vector<int> &b)
+    {
+        int w = DL_MIN(a[2], b[2]) - DL_MAX(a[0], b[0]) + 1;
+        int h = DL_MIN(a[3], b[3]) - DL_MAX(a[1], b[1]) + 1;
+        if (w <= 0 || h <= 0)
+            return 0.f;
+
+        float inter = (float)w * h;
+        float area_a = (float)(a[2] - a[0] + 1) * (a[3] - a[1] + 1);
+        float area_b = (float)(b[2] - b[0] + 1) * (b[3] - b[1] + 1);
+        return inter / (area_a + area_b - inter);
+    }
+
+public:
+    /**
+     * @brief Construct a new Human Face Detect Cascade object.
+     *
+     * @param score_threshold1  score threshold of stage one
+     * @param nms_threshold1    nms threshold of stage one
+     * @param top_k1            top k of stage one
+     * @param resize_scale      resize scale of stage one
+     * @param score_threshold2  score threshold of stage two
+     * @param nms_threshold2    nms threshold of stage two, also used between results of different candidates
+     * @param top_k2            top k of stage two for each candidate
+     * @param max_candidates    maximum number of candidates going to stage two
+     * @param confident_score   candidates with higher score skip stage two and have no keypoint, 1.0 for never skipping
+     */
+    HumanFaceDetectCascade(const float score_threshold1 = 0.3F,
+                           const float nms_threshold1 = 0.3F,
+                           const int top_k1 = 10,
+                           const float resize_scale = 0.3F,
+                           const float score_threshold2 = 0.4F,
+                           const float nms_threshold2 = 0.3F,
+                           const int top_k2 = 1,
+                           const int max_candidates = 5,
+                           const float confident_score = 1.0F) : stage1(score_threshold1, nms_threshold1, top_k1, resize_scale),
+                                                                 stage2(score_threshold2, nms_threshold2, top_k2),
+                                                                 nms_threshold(nms_threshold2),
+                                                                 max_candidates(max_candidates),
+                                                                 confident_score(confident_score),
+                                                                 pool(max_candidates * top_k2 + 1),
+                                                                 latency_stage1(16),
+                                                                 latency_stage2(16) {}
+
+    /**
+     * @brief Inference.
+     *
+     * @tparam T supports uint16_t and uint8_t,
+     *         - uint16_t: input image is RGB565
+     *         - uint8_t: input image is RGB888
+     * @param input_element pointer of input image
+     * @param input_shape   shape of input image
+     * @return detection result
+     */
+    template <typename T>
+    std::list<dl::detect::result_t> &infer(T *input_element, const std::vector<int> &input_shape)
+    {
+        this->latency_stage1.start();
+        std::list<dl::detect::result_t> &candidates = this->stage1.infer(input_element, input_shape);
+        this->latency_stage1.end();
+
+        return this->refine(input_element, input_shape, candidates);
+    }
+
+    /**
+     * @brief Run stage two only, e.g., on boxes predicted by a tracker.
+     *
+     * @tparam T supports uint16_t and uint8_t,
+     *         - uint16_t: input image is RGB565
+     *         - uint8_t: input image is RGB888
+     * @param input_element pointer of input image
+     * @param input_shape   shape of input image
+     * @param candidates    candidate boxes on input image, sorted by score in place
+     * @return detection result
+     */
+    template <typename T>
+    std::list<dl::detect::result_t> &refine(T *input_element, const std::vector<int> &input_shape, std::list<dl::detect::result_t> &candidates)
+    {
+        this->latency_stage2.start();
+        this->pool.clear(this->results);
+        candidates.sort([](const dl::detect::result_t &a, const dl::detect::result_t &b)
+                        { return a.score > b.score; });
+
+        int n = 0;
+        for (std::list<dl::detect::result_t>::iterator candidate = candidates.begin(); candidate != candidates.end() && n < this->max_candidates; candidate++, n++)
+        {
+            if (candidate->score > this->confident_score)
+            {
+                this->pool.push_back(this->refined, *candidate);
+                continue;
+            }
+
+            this->pool.clear(this->local);
+            if (!this->pool.push_back(this->local, *candidate))
+                break;
+            std::list<dl::detect::result_t> &local_results = this->stage2.infer(input_element, input_shape, this->local);
+            for (std::list<dl::detect::result_t>::iterator result = local_results.begin(); result != local_results.end(); result++)
+                this->pool.push_back(this->refined, *result);
+        }
+        this->pool.clear(this->local);
+
+        // close candidates may find the same face, kept results are moved instead of copied
+        this->refined.sort([](const dl::detect::result_t &a, const dl::detect::result_t &b)
+                           { return a.score > b.score; });
+        for (std::list<dl::detect::result_t>::iterator refined = this->refined.begin(); refined != this->refined.end();)
+        {
+            bool keep = true;
+            for (std::list<dl::detect::result_t>::iterator result = this->results.begin(); result != this->results.end(); result++)
+            {
+                if (iou(refined->box, result->box) > this->nms_threshold)
+                {
+                    keep = false;
+                    break;
+                }
+            }
+
+            std::list<dl::detect::result_t>::iterator next = std::next(refined);
+            if (keep)
+                this->results.splice(this->results.end(), this->refined, refined);
+            refined = next;
+        }
+        this->pool.clear(this->refined);
+
+        // local is lent to stage two, a node erased there is allocated again rather than shrinking the pool for good
+        this->pool.refill(this->results.size());
+        this->latency_stage2.end();
+
+        return this->results;
+    }
+
+    /**
+     * @brief Get the latency of stage one.
+     *
+     * @return dl::tool::Latency& latency averaged over the last 16 inferences
+     */
+    dl::tool::Latency &get_stage1_latency()
+    {
+        return this->latency_stage1;
+    }
+
+    /**
+     * @brief Get the latency of stage two.
+     *
+     * @return dl::tool::Latency& latency averaged over the last 16 inferences
+     */
+    dl::tool::Latency &get_stage2_latency()
+    {
+        return this->latency_stage2;
+    }
+
+    /**
+     * @brief Print the latency of each stage.
+     */
+    void print_latency()
+    {
+        this->latency_stage1.print("cascade", "stage1");
+        this->latency_stage2.print("cascade", "stage2");
+    }
+};
@@ -74,6 +74,9 @@ namespace dl
          * @tparam feature_t supports int16_t and int8_t,
          *         - int16_t: stands for operation in int16_t quantize
          *         - int8_t: stands for operation in int8_t quantize
+         * @tparam bias_t supports int16_t and int8_t, must specify when using int8 per-channel quantization
+         *         - int16_t: for int16 quantization and int8 per-channel quantization
+         *         - int8_t: for int8 per-tensor quantization
          * @param output_exponent exponent of output
          * @param input           as an input
          * @param filter          Filter of FullyConnected
@@ -84,11 +87,11 @@ namespace dl
          * @param assign_core     not effective yet
          * @return FullyConnected result
          */
-        template <typename feature_t>
+        template <typename feature_t, typename bias_t = feature_t>
         Tensor<feature_t> fully_connected(const int output_exponent,
                                           Tensor<feature_t> &input,
                                           const Filter<feature_t> &filter,
-                                          const Bias<feature_t> *bias,
+                                          const Bias<bias_t> *bias,
                                           const Activation<feature_t> *activation,
                                           const bool flatten,
                                           const std::vector<int> &assign_core = CONFIG_DEFAULT_ASSIGN_CORE)
@@ -108,7 +111,7 @@ namespace dl
             }
             else
             {
-                assert(input.shape.back() == filter->shape[2]);
+                assert(input.shape.back() == filter.shape[2]);
                 output_shape = input.shape;
                 output_shape[output_shape.size() - 1] = filter.shape.back();
             }
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <assert.h>
+#include <vector>
+#include "dl_variable.hpp"
+#include "dl_tool_worker.hpp"
+
+namespace dl
+{
+    namespace nn
+    {
+        /**
+         * @brief Whether a band of output rows of a sliding window operation may start at output row y, i.e., the
+         * output row and the first input row read for it are both 16-byte aligned, as the SIMD kernels need.
+         *
+         * @tparam feature_t       supports int16_t and int8_t
+         * @param y                output row
+         * @param output_row_size  elements in an output row
+         * @param input_row_size   elements in an input row
+         * @param stride_y         stride in height
+         * @param padding_top      padding on top of the whole operation
+         * @return true: aligned
+         */
+        template <typename feature_t>
+        bool is_aligned_row(const int y, const int output_row_size, const int input_row_size, const int stride_y, const int padding_top)
+        {
+            int input_begin = DL_MAX(y * stride_y - padding_top, 0);
+            return (y * output_row_size * sizeof(feature_t)) % 16 == 0 && (input_begin * input_row_size * sizeof(feature_t)) % 16 == 0;
+        }
+
+        /**
+         * @brief Get the last output row in (lower, y] a band may start at, see is_aligned_row().
+         *
+         * @tparam feature_t       supports int16_t and int8_t
+         * @param y                the row wanted
+         * @param lower            row before the range, e.g., the start of the previous band
+         * @param output_row_size  elements in an output row
+         * @param input_row_size   elements in an input row
+         * @param stride_y         stride in height
+         * @param padding_top      padding on top of the whole operation
+         * @return int the row, lower if no row in range is aligned
+         */
+        template <typename feature_t>
+        int get_aligned_row(const int y, const int lower, const int output_row_size, const int input_row_size, const int stride_y, const int padding_top)
+        {
+            for (int row = y; row > lower; row--)
+            {
+                if (is_aligned_row<feature_t>(row, output_row_size, input_row_size, stride_y, padding_top))
+                    return row;
+            }
+            return lower;
+        }
+
+        /**
+         * @brief Split output rows into tiles of at most tile_height rows, each starting at a row a band may start at,
+         * see is_aligned_row(). A tile is longer than tile_height only if none of the rows after its start within
+         * tile_height is aligned.
+         *
+         * @tparam feature_t       supports int16_t and int8_t
+         * @param borders          as an output, tile i is output rows [borders[i], borders[i + 1])
+         * @param output_height    output rows
+         * @param tile_height      rows in a tile
+         * @param output_row_size  elements in an output row
+         * @param input_row_size   elements in an input row
+         * @param stride_y         stride in height
+         * @param padding_top      padding on top of the whole operation
+         * @return int rows of the longest tile
+         */
+        template <typename feature_t>
+        int get_aligned_tiles(std::vector<int> &borders, const int output_height, const int tile_height, const int output_row_size, const int input_row_size, const int stride_y, const int padding_top)
+        {
+            int longest = 0;
+            borders.assign(1, 0);
+            for (int y = 0; y < output_height;)
+            {
+                int next = output_height;
+                if (y + tile_height < output_height)
+                {
+                    next = get_aligned_row<feature_t>(y + tile_height, y, output_row_size, input_row_size, stride_y, padding_top);
+                    if (next == y)
+                    {
+                        // no aligned row within tile_height, the tile runs to the next one
+                        next = y + tile_height + 1;
+                        while (next < output_height && !is_aligned_row<feature_t>(next, output_row_size, input_row_size, stride_y, padding_top))
+                            next++;
+                    }
+                }
+                longest = DL_MAX(longest, next - y);
+                borders.push_back(next);
+                y = next;
+            }
+            return longest;
+        }
+
+        /**
+         * @brief Split a sliding window operation into bands of output rows, one band per core in assign_core.
+         * Each band reads the input rows it needs, padding at the band borders is adjusted, so the bands are
+         * independent and together equal to the whole operation.
+         * NOTE: the SIMD kernels need 16-byte aligned element. A band starts at an output row whose output and input
+         *       rows are both 16-byte aligned, the bands are uneven or fewer if such rows are rare.
+         *
+         * @tparam feature_t     supports int16_t and int8_t
+         * @tparam F             callable as void(Tensor<feature_t> &output, Tensor<feature_t> &input, std::vector<int> &padding)
+         * @param output         as an output, element must be allocated
+         * @param input          as an input
+         * @param padding        padding size needed in [top, bottom, left, right] of the whole operation
+         * @param filter_height  height of filter with dilation
+         * @param stride_y       stride in height
+         * @param assign_core    cores to run on, less than two cores runs the whole operation on the caller
+         * @param kernel         operation on a band
+         * @param min_size       output smaller than min_size elements is not split
+         */
+        template <typename feature_t, typename F>
+        void parallel_rows(Tensor<feature_t> &output,
+                           Tensor<feature_t> &input,
+                           std::vector<int> &padding,
+                           const int filter_height,
+                           const int stride_y,
+                           const std::vector<int> &assign_core,
+                           F kernel,
+                           const int min_size = 4096)
+        {
+            const int output_height = output.shape[0];
+            if (assign_core.size() < 2 || output_height < 2 || output.get_size() < min_size)
+            {
+                kernel(output, input, padding);
+                return;
+            }
+
+            const int input_height = input.shape[0];
+            const int input_row_size = input.shape[1] * input.shape[2];
+            const int output_row_size = output.shape[1] * output.shape[2];
+
+            // the last aligned row not after the even split, the same for both bands sharing the border
+            auto border = [&](int index, int count)
+            {
+                if (index == count)
+                    return output_height;
+                return get_aligned_row<feature_t>(output_height * index / count, 0, output_row_size, input_row_size, stride_y, padding[0]);
+            };
+
+            auto band = [&](int index, int count)
+            {
+                int y = border(index, count);
+                int rows = border(index + 1, count) - y;
+                if (rows <= 0)
+                    return;
+
+                // input rows needed by this band, rows out of input are covered by padding
+                int input_begin = y * stride_y - padding[0];
+                int input_end = (y + rows - 1) * stride_y - padding[0] + filter_height;
+                std::vector<int> band_padding = {DL_MAX(-input_begin, 0), DL_MAX(input_end - input_height, 0), padding[2], padding[3]};
+                input_begin = DL_MAX(input_begin, 0);
+                input_end = DL_MIN(input_end, input_height);
+
+                assert(is_aligned_row<feature_t>(y, output_row_size, input_row_size, stride_y, padding[0]));
+
+                Tensor<feature_t> input_band;
+                input_band.set_element(input.element + input_begin * input_row_size).set_exponent(input.exponent).set_shape({input_end - input_begin, input.shape[1], input.shape[2]});
+
+                Tensor<feature_t> output_band;
+                output_band.set_element(output.element + y * output_row_size).set_exponent(output.exponent).set_shape({rows, output.shape[1], output.shape[2]});
+
+                kernel(output_band, input_band, band_padding);
+            };
+            tool::WorkerPool::get_instance().parallel_for(band, assign_core);
+        }
+    } // namespace nn
+} // namespace dl
@@ -0,0 +1,1222 @@
+#pragma once
+
+#include <stdint.h>
+#include <assert.h>
+#include <cstddef>
+#include <climits>
+#include <limits>
+#include <vector>
+#include <type_traits>
+
+#include "dl_define.hpp"
+#include "dl_variable.hpp"
+#include "dl_constant.hpp"
+
+namespace dl
+{
+    namespace nn
+    {
+        /**
+         * @brief Portable reference implementation of nn operations.
+         *
+         * The functions here are plain C++ and do not depend on the prebuilt libraries, so they can be compiled for the
+         * host, see test/host of the example. They follow the quantization specification of esp-dl, i.e.,
+         * real_value = element * 2^exponent, in the order of the prebuilt kernels:
+         *         - accumulation is done in int64_t with exponent (input_exponent + filter_exponent),
+         *         - the accumulator is shifted to output_exponent by an arithmetic shift, i.e., rounded toward minus
+         *           infinity like DL_RIGHT_SHIFT,
+         *         - bias, in output_exponent as the convert tool generates it, is added after the shift,
+         *         - the result is activated, then saturated.
+         *
+         * Conv2D, DepthwiseConv2D and LeakyReLU in int16_t with per-tensor exponent are bit exact with the prebuilt
+         * kernels: tutorial MNIST gives the scores recorded on esp32, esp32s2, esp32s3 and esp32c3. The results may
+         * differ in 1 LSB only where the prebuilt kernels are not documented and no device output was recorded:
+         *         - a shifted accumulator out of the range of feature_t before bias is added, the reference saturates
+         *           once at the end,
+         *         - Add2D, Sub2D and Mul2D with different exponents, the reference aligns the inputs to the smallest
+         *           exponent exactly and shifts once,
+         *         - AvgPool2D and GlobalAvgPool2D with a window size not a power of 2, the reference divides in 2^-16
+         *           precision before the shift.
+         *
+         * Filter element must be in the original [filter_height, filter_width, input_channel, output_channel] sequence,
+         * i.e., the sequence in the .npy file. The coefficient generated by convert tool for ESP32-S3 is reordered and
+         * can not be used here.
+         *
+         * Feature maps are in [height, width, channel]. Each operation comes in two forms, on raw pointers with the
+         * exponents and shapes as arguments, and on Tensor, Filter, Bias and Activation like the functions of dl::nn.
+         */
+        namespace reference
+        {
+            /**
+             * @brief Saturate to the range of T.
+             *
+             * @tparam T supports int16_t and int8_t
+             * @param value value to saturate
+             * @return saturated value
+             */
+            template <typename T>
+            inline T saturate(int64_t value)
+            {
+                return (T)DL_CLIP(value, (int64_t)std::numeric_limits<T>::min(), (int64_t)std::numeric_limits<T>::max());
+            }
+
+            /**
+             * @brief Convert value from exponent_from to exponent_to, rounded toward minus infinity if precision is lost.
+             *
+             * @param value         value to convert
+             * @param exponent_from exponent of value
+             * @param exponent_to   target exponent
+             * @return converted value
+             */
+            inline int64_t requantize(int64_t value, const int exponent_from, const int exponent_to)
+            {
+                return DL_RIGHT_SHIFT(value, exponent_to - exponent_from);
+            }
+
+            /**
+             * @brief Apply activation on a value in output_exponent.
+             *
+             * @param value           value to activate
+             * @param type            one of Linear, ReLU, LeakyReLU, PReLU
+             * @param alpha           alpha of LeakyReLU or PReLU, ignored by others
+             * @param alpha_exponent  exponent of alpha
+             * @return activated value
+             */
+            inline int64_t activate(int64_t value, const activation_type_t type, const int64_t alpha = 0, const int alpha_exponent = 0)
+            {
+                if (value >= 0 || type == Linear)
+                    return value;
+                if (type == ReLU)
+                    return 0;
+                return requantize(value * alpha, alpha_exponent, 0);
+            }
+
+            /**
+             * @brief Get the output shape and padding of a 2D sliding window operation.
+             *
+             * @param output_shape [output_height, output_width]
+             * @param padding      [top, bottom, left, right]
+             * @param input_height height of input
+             * @param input_width  width of input
+             * @param filter_height height of filter with dilation
+             * @param filter_width  width of filter with dilation
+             * @param stride_y     stride in height
+             * @param stride_x     stride in width
+             * @param padding_type one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN
+             */
+            inline void get_output_shape_and_padding(std::vector<int> &output_shape,
+                                                     std::vector<int> &padding,
+                                                     const int input_height,
+                                                     const int input_width,
+                                                     const int filter_height,
+                                                     const int filter_width,
+                                                     const int stride_y,
+                                                     const int stride_x,
+                                                     const padding_type_t padding_type)
+            {
+                if (padding_type == PADDING_SAME_END || padding_type == PADDING_SAME_BEGIN)
+                {
+                    int output_height = (input_height + stride_y - 1) / stride_y;
+                    int output_width = (input_width + stride_x - 1) / stride_x;
+                    int pad_h = DL_MAX((output_height - 1) * stride_y + filter_height - input_height, 0);
+                    int pad_w = DL_MAX((output_width - 1) * stride_x + filter_width - input_width, 0);
+                    int top = (padding_type == PADDING_SAME_END) ? pad_h / 2 : pad_h - pad_h / 2;
+                    int left = (padding_type == PADDING_SAME_END) ? pad_w / 2 : pad_w - pad_w / 2;
+                    output_shape = {output_height, output_width};
+                    padding = {top, pad_h - top, left, pad_w - left};
+                }
+                else
+                {
+                    output_shape = {(input_height - filter_height) / stride_y + 1, (input_width - filter_width) / stride_x + 1};
+                    padding = {0, 0, 0, 0};
+                }
+            }
+
+            /**
+             * @brief Get the output shape of a 2D sliding window operation with explicit padding.
+             *
+             * @param input_height  height of input
+             * @param input_width   width of input
+             * @param filter_height height of filter with dilation
+             * @param filter_width  width of filter with dilation
+             * @param stride_y      stride in height
+             * @param stride_x      stride in width
+             * @param padding       [top, bottom, left, right]
+             * @return [output_height, output_width]
+             */
+            inline std::vector<int> get_output_shape(const int input_height,
+                                                     const int input_width,
+                                                     const int filter_height,
+                                                     const int filter_width,
+                                                     const int stride_y,
+                                                     const int stride_x,
+                                                     const std::vector<int> &padding)
+            {
+                return {(input_height + padding[0] + padding[1] - filter_height) / stride_y + 1,
+                        (input_width + padding[2] + padding[3] - filter_width) / stride_x + 1};
+            }
+
+            /**
+             * @brief activation(conv2d(input, filter) + bias).
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output           as an output, [output_height, output_width, output_channel]
+             * @param output_exponent  exponent of output
+             * @param input            as an input, [input_height, input_width, input_channel]
+             * @param input_shape      [input_height, input_width, input_channel]
+             * @param input_exponent   exponent of input
+             * @param filter           [filter_height, filter_width, input_channel, output_channel]
+             * @param filter_shape     [filter_height, filter_width, input_channel, output_channel]
+             * @param filter_exponent  exponent of filter, per-tensor
+             * @param channel_exponent exponent of filter per output channel, NULL for per-tensor
+             * @param dilation         [dilation_in_height, dilation_in_width]
+             * @param bias             bias, NULL for no bias
+             * @param bias_exponent    exponent of bias
+             * @param activation_type  one of Linear, ReLU, LeakyReLU, PReLU
+             * @param alpha            alpha of LeakyReLU (1 element) or PReLU (output_channel elements)
+             * @param alpha_exponent   exponent of alpha
+             * @param stride_y         stride in height
+             * @param stride_x         stride in width
+             * @param padding          [top, bottom, left, right]
+             * @return [output_height, output_width, output_channel]
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            std::vector<int> conv2d(feature_t *output,
+                                    const int output_exponent,
+                                    const feature_t *input,
+                                    const std::vector<int> &input_shape,
+                                    const int input_exponent,
+                                    const feature_t *filter,
+                                    const std::vector<int> &filter_shape,
+                                    const int filter_exponent,
+                                    const int8_t *channel_exponent,
+                                    const std::vector<int> &dilation,
+                                    const bias_t *bias,
+                                    const int bias_exponent,
+                                    const activation_type_t activation_type,
+                                    const feature_t *alpha,
+                                    const int alpha_exponent,
+                                    const int stride_y,
+                                    const int stride_x,
+                                    const std::vector<int> &padding)
+            {
+                const int input_height = input_shape[0];
+                const int input_width = input_shape[1];
+                const int input_channel = input_shape[2];
+                const int filter_height = filter_shape[0];
+                const int filter_width = filter_shape[1];
+                const int output_channel = filter_shape[3];
+                const int dilation_y = dilation.size() ? dilation[0] : 1;
+                const int dilation_x = dilation.size() ? dilation[1] : 1;
+
+                std::vector<int> output_hw = get_output_shape(input_height, input_width,
+                                                              (filter_height - 1) * dilation_y + 1, (filter_width - 1) * dilation_x + 1,
+                                                              stride_y, stride_x, padding);
+
+                feature_t *output_ptr = output;
+                for (int y = 0; y < output_hw[0]; y++)
+                {
+                    for (int x = 0; x < output_hw[1]; x++)
+                    {
+                        for (int n = 0; n < output_channel; n++)
+                        {
+                            int accumulate_exponent = input_exponent + (channel_exponent ? channel_exponent[n] : filter_exponent);
+                            int64_t accumulator = 0;
+                            for (int fy = 0; fy < filter_height; fy++)
+                            {
+                                int iy = y * stride_y - padding[0] + fy * dilation_y;
+                                if (iy < 0 || iy >= input_height)
+                                    continue;
+                                for (int fx = 0; fx < filter_width; fx++)
+                                {
+                                    int ix = x * stride_x - padding[2] + fx * dilation_x;
+                                    if (ix < 0 || ix >= input_width)
+                                        continue;
+                                    const feature_t *input_ptr = input + (iy * input_width + ix) * input_channel;
+                                    const feature_t *filter_ptr = filter + ((fy * filter_width + fx) * input_channel) * output_channel + n;
+                                    for (int c = 0; c < input_channel; c++)
+                                        accumulator += (int64_t)input_ptr[c] * filter_ptr[c * output_channel];
+                                }
+                            }
+                            int64_t value = requantize(accumulator, accumulate_exponent, output_exponent);
+                            if (bias)
+                                value += requantize(bias[n], bias_exponent, output_exponent);
+                            if (activation_type == PReLU)
+                                value = activate(value, activation_type, alpha[n], alpha_exponent);
+                            else
+                                value = activate(value, activation_type, alpha ? alpha[0] : 0, alpha_exponent);
+                            *output_ptr++ = saturate<feature_t>(value);
+                        }
+                    }
+                }
+                return {output_hw[0], output_hw[1], output_channel};
+            }
+
+            /**
+             * @brief activation(conv2d(input, filter) + bias), padded by padding_type.
+             *
+             * @param padding_type one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN
+             * @return [output_height, output_width, output_channel]
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            std::vector<int> conv2d(feature_t *output,
+                                    const int output_exponent,
+                                    const feature_t *input,
+                                    const std::vector<int> &input_shape,
+                                    const int input_exponent,
+                                    const feature_t *filter,
+                                    const std::vector<int> &filter_shape,
+                                    const int filter_exponent,
+                                    const int8_t *channel_exponent,
+                                    const std::vector<int> &dilation,
+                                    const bias_t *bias,
+                                    const int bias_exponent,
+                                    const activation_type_t activation_type,
+                                    const feature_t *alpha,
+                                    const int alpha_exponent,
+                                    const int stride_y,
+                                    const int stride_x,
+                                    const padding_type_t padding_type)
+            {
+                const int dilation_y = dilation.size() ? dilation[0] : 1;
+                const int dilation_x = dilation.size() ? dilation[1] : 1;
+                std::vector<int> output_hw, padding;
+                get_output_shape_and_padding(output_hw, padding, input_shape[0], input_shape[1],
+                                             (filter_shape[0] - 1) * dilation_y + 1, (filter_shape[1] - 1) * dilation_x + 1,
+                                             stride_y, stride_x, padding_type);
+                return conv2d<feature_t, bias_t>(output, output_exponent,
+                                                 input, input_shape, input_exponent,
+                                                 filter, filter_shape, filter_exponent, channel_exponent, dilation,
+                                                 bias, bias_exponent,
+                                                 activation_type, alpha, alpha_exponent,
+                                                 stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief activation(depthwise_conv2d(input, filter) + bias).
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output           as an output, [output_height, output_width, channel]
+             * @param output_exponent  exponent of output
+             * @param input            as an input, [input_height, input_width, channel]
+             * @param input_shape      [input_height, input_width, channel]
+             * @param input_exponent   exponent of input
+             * @param filter           [filter_height, filter_width, channel, 1]
+             * @param filter_shape     [filter_height, filter_width, channel, 1]
+             * @param filter_exponent  exponent of filter, per-tensor
+             * @param channel_exponent exponent of filter per channel, NULL for per-tensor
+             * @param dilation         [dilation_in_height, dilation_in_width]
+             * @param bias             bias, NULL for no bias
+             * @param bias_exponent    exponent of bias
+             * @param activation_type  one of Linear, ReLU, LeakyReLU, PReLU
+             * @param alpha            alpha of LeakyReLU (1 element) or PReLU (channel elements)
+             * @param alpha_exponent   exponent of alpha
+             * @param stride_y         stride in height
+             * @param stride_x         stride in width
+             * @param padding          [top, bottom, left, right]
+             * @return [output_height, output_width, channel]
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            std::vector<int> depthwise_conv2d(feature_t *output,
+                                              const int output_exponent,
+                                              const feature_t *input,
+                                              const std::vector<int> &input_shape,
+                                              const int input_exponent,
+                                              const feature_t *filter,
+                                              const std::vector<int> &filter_shape,
+                                              const int filter_exponent,
+                                              const int8_t *channel_exponent,
+                                              const std::vector<int> &dilation,
+                                              const bias_t *bias,
+                                              const int bias_exponent,
+                                              const activation_type_t activation_type,
+                                              const feature_t *alpha,
+                                              const int alpha_exponent,
+                                              const int stride_y,
+                                              const int stride_x,
+                                              const std::vector<int> &padding)
+            {
+                const int input_height = input_shape[0];
+                const int input_width = input_shape[1];
+                const int channel = input_shape[2];
+                const int filter_height = filter_shape[0];
+                const int filter_width = filter_shape[1];
+                const int dilation_y = dilation.size() ? dilation[0] : 1;
+                const int dilation_x = dilation.size() ? dilation[1] : 1;
+
+                std::vector<int> output_hw = get_output_shape(input_height, input_width,
+                                                              (filter_height - 1) * dilation_y + 1, (filter_width - 1) * dilation_x + 1,
+                                                              stride_y, stride_x, padding);
+
+                feature_t *output_ptr = output;
+                for (int y = 0; y < output_hw[0]; y++)
+                {
+                    for (int x = 0; x < output_hw[1]; x++)
+                    {
+                        for (int c = 0; c < channel; c++)
+                        {
+                            int accumulate_exponent = input_exponent + (channel_exponent ? channel_exponent[c] : filter_exponent);
+                            int64_t accumulator = 0;
+                            for (int fy = 0; fy < filter_height; fy++)
+                            {
+                                int iy = y * stride_y - padding[0] + fy * dilation_y;
+                                if (iy < 0 || iy >= input_height)
+                                    continue;
+                                for (int fx = 0; fx < filter_width; fx++)
+                                {
+                                    int ix = x * stride_x - padding[2] + fx * dilation_x;
+                                    if (ix < 0 || ix >= input_width)
+                                        continue;
+                                    accumulator += (int64_t)input[(iy * input_width + ix) * channel + c] * filter[(fy * filter_width + fx) * channel + c];
+                                }
+                            }
+                            int64_t value = requantize(accumulator, accumulate_exponent, output_exponent);
+                            if (bias)
+                                value += requantize(bias[c], bias_exponent, output_exponent);
+                            if (activation_type == PReLU)
+                                value = activate(value, activation_type, alpha[c], alpha_exponent);
+                            else
+                                value = activate(value, activation_type, alpha ? alpha[0] : 0, alpha_exponent);
+                            *output_ptr++ = saturate<feature_t>(value);
+                        }
+                    }
+                }
+                return {output_hw[0], output_hw[1], channel};
+            }
+
+            /**
+             * @brief activation(depthwise_conv2d(input, filter) + bias), padded by padding_type.
+             *
+             * @param padding_type one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN
+             * @return [output_height, output_width, channel]
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            std::vector<int> depthwise_conv2d(feature_t *output,
+                                              const int output_exponent,
+                                              const feature_t *input,
+                                              const std::vector<int> &input_shape,
+                                              const int input_exponent,
+                                              const feature_t *filter,
+                                              const std::vector<int> &filter_shape,
+                                              const int filter_exponent,
+                                              const int8_t *channel_exponent,
+                                              const std::vector<int> &dilation,
+                                              const bias_t *bias,
+                                              const int bias_exponent,
+                                              const activation_type_t activation_type,
+                                              const feature_t *alpha,
+                                              const int alpha_exponent,
+                                              const int stride_y,
+                                              const int stride_x,
+                                              const padding_type_t padding_type)
+            {
+                const int dilation_y = dilation.size() ? dilation[0] : 1;
+                const int dilation_x = dilation.size() ? dilation[1] : 1;
+                std::vector<int> output_hw, padding;
+                get_output_shape_and_padding(output_hw, padding, input_shape[0], input_shape[1],
+                                             (filter_shape[0] - 1) * dilation_y + 1, (filter_shape[1] - 1) * dilation_x + 1,
+                                             stride_y, stride_x, padding_type);
+                return depthwise_conv2d<feature_t, bias_t>(output, output_exponent,
+                                                           input, input_shape, input_exponent,
+                                                           filter, filter_shape, filter_exponent, channel_exponent, dilation,
+                                                           bias, bias_exponent,
+                                                           activation_type, alpha, alpha_exponent,
+                                                           stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief activation(fully_connected(input, filter) + bias).
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output           as an output, [output_len]
+             * @param output_exponent  exponent of output
+             * @param input            as an input, [input_len]
+             * @param input_len        length of input
+             * @param input_exponent   exponent of input
+             * @param filter           [1, 1, input_len, output_len]
+             * @param output_len       length of output
+             * @param filter_exponent  exponent of filter, per-tensor
+             * @param channel_exponent exponent of filter per output, NULL for per-tensor
+             * @param bias             bias, NULL for no bias
+             * @param bias_exponent    exponent of bias
+             * @param activation_type  one of Linear, ReLU, LeakyReLU, PReLU
+             * @param alpha            alpha of LeakyReLU (1 element) or PReLU (output_len elements)
+             * @param alpha_exponent   exponent of alpha
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            void fully_connected(feature_t *output,
+                                 const int output_exponent,
+                                 const feature_t *input,
+                                 const int input_len,
+                                 const int input_exponent,
+                                 const feature_t *filter,
+                                 const int output_len,
+                                 const int filter_exponent,
+                                 const int8_t *channel_exponent,
+                                 const bias_t *bias,
+                                 const int bias_exponent,
+                                 const activation_type_t activation_type,
+                                 const feature_t *alpha,
+                                 const int alpha_exponent)
+            {
+                conv2d<feature_t, bias_t>(output, output_exponent,
+                                          input, {1, 1, input_len}, input_exponent,
+                                          filter, {1, 1, input_len, output_len}, filter_exponent, channel_exponent, {1, 1},
+                                          bias, bias_exponent,
+                                          activation_type, alpha, alpha_exponent,
+                                          1, 1, PADDING_VALID);
+            }
+
+            /**
+             * @brief activation(input0 + input1), element-wise, inplace operation is allowed.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output          as an output
+             * @param output_exponent exponent of output
+             * @param input0          as one input
+             * @param input0_exponent exponent of input0
+             * @param input1          as another input
+             * @param input1_exponent exponent of input1
+             * @param size            number of elements
+             * @param activation_type one of Linear, ReLU, LeakyReLU, PReLU
+             * @param alpha           alpha of LeakyReLU (1 element) or PReLU (channel elements)
+             * @param alpha_exponent  exponent of alpha
+             * @param channel         number of channel, used by PReLU only
+             */
+            template <typename feature_t>
+            void add2d(feature_t *output,
+                       const int output_exponent,
+                       const feature_t *input0,
+                       const int input0_exponent,
+                       const feature_t *input1,
+                       const int input1_exponent,
+                       const int size,
+                       const activation_type_t activation_type = Linear,
+                       const feature_t *alpha = NULL,
+                       const int alpha_exponent = 0,
+                       const int channel = 1)
+            {
+                int exponent = DL_MIN(DL_MIN(input0_exponent, input1_exponent), output_exponent);
+                for (int i = 0; i < size; i++)
+                {
+                    int64_t sum = requantize(input0[i], input0_exponent, exponent) + requantize(input1[i], input1_exponent, exponent);
+                    int64_t value = requantize(sum, exponent, output_exponent);
+                    value = activate(value, activation_type, alpha ? alpha[(activation_type == PReLU) ? i % channel : 0] : 0, alpha_exponent);
+                    output[i] = saturate<feature_t>(value);
+                }
+            }
+
+            /**
+             * @brief activation(input0 - input1), element-wise, inplace operation is allowed.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output          as an output
+             * @param output_exponent exponent of output
+             * @param input0          as one input
+             * @param input0_exponent exponent of input0
+             * @param input1          as another input
+             * @param input1_exponent exponent of input1
+             * @param size            number of elements
+             * @param activation_type one of Linear, ReLU, LeakyReLU, PReLU
+             * @param alpha           alpha of LeakyReLU (1 element) or PReLU (channel elements)
+             * @param alpha_exponent  exponent of alpha
+             * @param channel         number of channel, used by PReLU only
+             */
+            template <typename feature_t>
+            void sub2d(feature_t *output,
+                       const int output_exponent,
+                       const feature_t *input0,
+                       const int input0_exponent,
+                       const feature_t *input1,
+                       const int input1_exponent,
+                       const int size,
+                       const activation_type_t activation_type = Linear,
+                       const feature_t *alpha = NULL,
+                       const int alpha_exponent = 0,
+                       const int channel = 1)
+            {
+                int exponent = DL_MIN(DL_MIN(input0_exponent, input1_exponent), output_exponent);
+                for (int i = 0; i < size; i++)
+                {
+                    int64_t difference = requantize(input0[i], input0_exponent, exponent) - requantize(input1[i], input1_exponent, exponent);
+                    int64_t value = requantize(difference, exponent, output_exponent);
+                    value = activate(value, activation_type, alpha ? alpha[(activation_type == PReLU) ? i % channel : 0] : 0, alpha_exponent);
+                    output[i] = saturate<feature_t>(value);
+                }
+            }
+
+            /**
+             * @brief activation(input0 * input1), element-wise, inplace operation is allowed.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output          as an output
+             * @param output_exponent exponent of output
+             * @param input0          as one input
+             * @param input0_exponent exponent of input0
+             * @param input1          as another input
+             * @param input1_exponent exponent of input1
+             * @param size            number of elements
+             * @param activation_type one of Linear, ReLU, LeakyReLU, PReLU
+             * @param alpha           alpha of LeakyReLU (1 element) or PReLU (channel elements)
+             * @param alpha_exponent  exponent of alpha
+             * @param channel         number of channel, used by PReLU only
+             */
+            template <typename feature_t>
+            void mul2d(feature_t *output,
+                       const int output_exponent,
+                       const feature_t *input0,
+                       const int input0_exponent,
+                       const feature_t *input1,
+                       const int input1_exponent,
+                       const int size,
+                       const activation_type_t activation_type = Linear,
+                       const feature_t *alpha = NULL,
+                       const int alpha_exponent = 0,
+                       const int channel = 1)
+            {
+                for (int i = 0; i < size; i++)
+                {
+                    int64_t value = requantize((int64_t)input0[i] * input1[i], input0_exponent + input1_exponent, output_exponent);
+                    value = activate(value, activation_type, alpha ? alpha[(activation_type == PReLU) ? i % channel : 0] : 0, alpha_exponent);
+                    output[i] = saturate<feature_t>(value);
+                }
+            }
+
+            /**
+             * @brief relu(input), element-wise, inplace operation is allowed.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output as an output, in the exponent of input
+             * @param input  as an input
+             * @param size   number of elements
+             */
+            template <typename feature_t>
+            void relu(feature_t *output, const feature_t *input, const int size)
+            {
+                for (int i = 0; i < size; i++)
+                    output[i] = DL_MAX(input[i], 0);
+            }
+
+            /**
+             * @brief leakyrelu(input) or prelu(input), element-wise, inplace operation is allowed.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output          as an output
+             * @param output_exponent exponent of output
+             * @param input           as an input
+             * @param input_exponent  exponent of input
+             * @param size            number of elements
+             * @param alpha           alpha, 1 element for LeakyReLU, channel elements for PReLU
+             * @param alpha_exponent  exponent of alpha
+             * @param channel         1 for LeakyReLU, number of channel for PReLU
+             */
+            template <typename feature_t>
+            void prelu(feature_t *output,
+                       const int output_exponent,
+                       const feature_t *input,
+                       const int input_exponent,
+                       const int size,
+                       const feature_t *alpha,
+                       const int alpha_exponent,
+                       const int channel = 1)
+            {
+                for (int i = 0; i < size; i++)
+                {
+                    int64_t value = requantize(input[i], input_exponent, output_exponent);
+                    output[i] = saturate<feature_t>(activate(value, PReLU, alpha[i % channel], alpha_exponent));
+                }
+            }
+
+            /**
+             * @brief max_pool2d(input), output is in the exponent of input.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output        as an output, [output_height, output_width, channel]
+             * @param input         as an input, [input_height, input_width, channel]
+             * @param input_shape   [input_height, input_width, channel]
+             * @param filter_height height of pooling window
+             * @param filter_width  width of pooling window
+             * @param stride_y      stride in height
+             * @param stride_x      stride in width
+             * @param padding       [top, bottom, left, right]
+             * @return [output_height, output_width, channel]
+             */
+            template <typename feature_t>
+            std::vector<int> max_pool2d(feature_t *output,
+                                        const feature_t *input,
+                                        const std::vector<int> &input_shape,
+                                        const int filter_height,
+                                        const int filter_width,
+                                        const int stride_y,
+                                        const int stride_x,
+                                        const std::vector<int> &padding)
+            {
+                const int input_height = input_shape[0];
+                const int input_width = input_shape[1];
+                const int channel = input_shape[2];
+
+                std::vector<int> output_hw = get_output_shape(input_height, input_width, filter_height, filter_width, stride_y, stride_x, padding);
+
+                feature_t *output_ptr = output;
+                for (int y = 0; y < output_hw[0]; y++)
+                {
+                    for (int x = 0; x < output_hw[1]; x++)
+                    {
+                        for (int c = 0; c < channel; c++)
+                        {
+                            feature_t max = std::numeric_limits<feature_t>::min();
+                            for (int fy = 0; fy < filter_height; fy++)
+                            {
+                                int iy = y * stride_y - padding[0] + fy;
+                                if (iy < 0 || iy >= input_height)
+                                    continue;
+                                for (int fx = 0; fx < filter_width; fx++)
+                                {
+                                    int ix = x * stride_x - padding[2] + fx;
+                                    if (ix < 0 || ix >= input_width)
+                                        continue;
+                                    max = DL_MAX(max, input[(iy * input_width + ix) * channel + c]);
+                                }
+                            }
+                            *output_ptr++ = max;
+                        }
+                    }
+                }
+                return {output_hw[0], output_hw[1], channel};
+            }
+
+            /**
+             * @brief max_pool2d(input), padded by padding_type.
+             *
+             * @param padding_type one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN
+             * @return [output_height, output_width, channel]
+             */
+            template <typename feature_t>
+            std::vector<int> max_pool2d(feature_t *output,
+                                        const feature_t *input,
+                                        const std::vector<int> &input_shape,
+                                        const int filter_height,
+                                        const int filter_width,
+                                        const int stride_y,
+                                        const int stride_x,
+                                        const padding_type_t padding_type)
+            {
+                std::vector<int> output_hw, padding;
+                get_output_shape_and_padding(output_hw, padding, input_shape[0], input_shape[1], filter_height, filter_width, stride_y, stride_x, padding_type);
+                return max_pool2d(output, input, input_shape, filter_height, filter_width, stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief avg_pool2d(input), padding is excluded from the average.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output          as an output, [output_height, output_width, channel]
+             * @param output_exponent exponent of output
+             * @param input           as an input, [input_height, input_width, channel]
+             * @param input_shape     [input_height, input_width, channel]
+             * @param input_exponent  exponent of input
+             * @param filter_height   height of pooling window
+             * @param filter_width    width of pooling window
+             * @param stride_y        stride in height
+             * @param stride_x        stride in width
+             * @param padding         [top, bottom, left, right]
+             * @return [output_height, output_width, channel]
+             */
+            template <typename feature_t>
+            std::vector<int> avg_pool2d(feature_t *output,
+                                        const int output_exponent,
+                                        const feature_t *input,
+                                        const std::vector<int> &input_shape,
+                                        const int input_exponent,
+                                        const int filter_height,
+                                        const int filter_width,
+                                        const int stride_y,
+                                        const int stride_x,
+                                        const std::vector<int> &padding)
+            {
+                const int input_height = input_shape[0];
+                const int input_width = input_shape[1];
+                const int channel = input_shape[2];
+
+                std::vector<int> output_hw = get_output_shape(input_height, input_width, filter_height, filter_width, stride_y, stride_x, padding);
+
+                feature_t *output_ptr = output;
+                for (int y = 0; y < output_hw[0]; y++)
+                {
+                    for (int x = 0; x < output_hw[1]; x++)
+                    {
+                        for (int c = 0; c < channel; c++)
+                        {
+                            int64_t sum = 0;
+                            int count = 0;
+                            for (int fy = 0; fy < filter_height; fy++)
+                            {
+                                int iy = y * stride_y - padding[0] + fy;
+                                if (iy < 0 || iy >= input_height)
+                                    continue;
+                                for (int fx = 0; fx < filter_width; fx++)
+                                {
+                                    int ix = x * stride_x - padding[2] + fx;
+                                    if (ix < 0 || ix >= input_width)
+                                        continue;
+                                    sum += input[(iy * input_width + ix) * channel + c];
+                                    count++;
+                                }
+                            }
+                            // average in 2^-16 precision, then shift to output_exponent
+                            int64_t average = count ? ((sum << 16) + count / 2) / count : 0;
+                            *output_ptr++ = saturate<feature_t>(requantize(average, input_exponent - 16, output_exponent));
+                        }
+                    }
+                }
+                return {output_hw[0], output_hw[1], channel};
+            }
+
+            /**
+             * @brief avg_pool2d(input), padded by padding_type.
+             *
+             * @param padding_type one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN
+             * @return [output_height, output_width, channel]
+             */
+            template <typename feature_t>
+            std::vector<int> avg_pool2d(feature_t *output,
+                                        const int output_exponent,
+                                        const feature_t *input,
+                                        const std::vector<int> &input_shape,
+                                        const int input_exponent,
+                                        const int filter_height,
+                                        const int filter_width,
+                                        const int stride_y,
+                                        const int stride_x,
+                                        const padding_type_t padding_type)
+            {
+                std::vector<int> output_hw, padding;
+                get_output_shape_and_padding(output_hw, padding, input_shape[0], input_shape[1], filter_height, filter_width, stride_y, stride_x, padding_type);
+                return avg_pool2d(output, output_exponent, input, input_shape, input_exponent, filter_height, filter_width, stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief global_max_pool2d(input), output is in the exponent of input.
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output      as an output, [1, 1, channel]
+             * @param input       as an input, [input_height, input_width, channel]
+             * @param input_shape [input_height, input_width, channel]
+             */
+            template <typename feature_t>
+            void global_max_pool2d(feature_t *output, const feature_t *input, const std::vector<int> &input_shape)
+            {
+                max_pool2d(output, input, input_shape, input_shape[0], input_shape[1], 1, 1, PADDING_VALID);
+            }
+
+            /**
+             * @brief global_avg_pool2d(input).
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output          as an output, [1, 1, channel]
+             * @param output_exponent exponent of output
+             * @param input           as an input, [input_height, input_width, channel]
+             * @param input_shape     [input_height, input_width, channel]
+             * @param input_exponent  exponent of input
+             */
+            template <typename feature_t>
+            void global_avg_pool2d(feature_t *output, const int output_exponent, const feature_t *input, const std::vector<int> &input_shape, const int input_exponent)
+            {
+                avg_pool2d(output, output_exponent, input, input_shape, input_exponent, input_shape[0], input_shape[1], 1, 1, PADDING_VALID);
+            }
+
+            /**
+             * @brief activation(conv2d(input, filter) + bias), the same as dl::nn::conv2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output     as an output, element, exponent and shape are set by caller
+             * @param input      as an input
+             * @param padding    padding size needed in [top, bottom, left, right] of this operation
+             * @param filter     filter of conv2d, element in [filter_height, filter_width, input_channel, output_channel]
+             * @param stride_y   stride in height
+             * @param stride_x   stride in width
+             * @param bias       bias of conv2d, if you don't specify anything, no bias is added
+             * @param activation activation of conv2d, if you don't specify anything, no activation is applied
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            void conv2d(Tensor<feature_t> &output,
+                        Tensor<feature_t> &input,
+                        std::vector<int> &padding,
+                        const Filter<feature_t> &filter,
+                        const int stride_y,
+                        const int stride_x,
+                        const Bias<bias_t> *const bias = NULL,
+                        const Activation<feature_t> *const activation = NULL)
+            {
+                std::vector<int> output_hw = get_output_shape(input.shape[0], input.shape[1],
+                                                              filter.shape_with_dilation[0], filter.shape_with_dilation[1],
+                                                              stride_y, stride_x, padding);
+                assert(output.element);
+                assert(output.shape == std::vector<int>({output_hw[0], output_hw[1], filter.shape[3]}));
+
+                conv2d<feature_t, bias_t>(output.element, output.exponent,
+                                          input.element, input.shape, input.exponent,
+                                          filter.element, filter.shape, filter.exponent,
+                                          filter.channel_exponent_size ? filter.channel_exponent : NULL, filter.dilation,
+                                          bias ? bias->element : NULL, bias ? bias->exponent : 0,
+                                          activation ? activation->type : Linear,
+                                          activation ? activation->element : NULL,
+                                          activation ? activation->exponent : 0,
+                                          stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief activation(conv2d(input, filter) + bias), the same as dl::nn::conv2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output          as an output, shape is set and element is allocated here
+             * @param output_exponent exponent of output
+             * @param input           as an input
+             * @param filter          filter of conv2d, element in [filter_height, filter_width, input_channel, output_channel]
+             * @param stride_y        stride in height
+             * @param stride_x        stride in width
+             * @param padding_type    one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN
+             * @param bias            bias of conv2d, NULL for no bias
+             * @param activation      activation of conv2d, NULL for no activation
+             */
+            template <typename feature_t, typename bias_t>
+            void conv2d(Tensor<feature_t> &output,
+                        const int output_exponent,
+                        Tensor<feature_t> &input,
+                        const Filter<feature_t> &filter,
+                        const int stride_y,
+                        const int stride_x,
+                        const padding_type_t padding_type,
+                        const Bias<bias_t> *bias,
+                        const Activation<feature_t> *activation)
+            {
+                std::vector<int> output_hw, padding;
+                get_output_shape_and_padding(output_hw, padding, input.shape[0], input.shape[1],
+                                             filter.shape_with_dilation[0], filter.shape_with_dilation[1],
+                                             stride_y, stride_x, padding_type);
+                output.set_exponent(output_exponent).set_shape({output_hw[0], output_hw[1], filter.shape[3]}).malloc_element();
+                conv2d(output, input, padding, filter, stride_y, stride_x, bias, activation);
+            }
+
+            /**
+             * @brief activation(depthwise_conv2d(input, filter) + bias), the same as dl::nn::depthwise_conv2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output     as an output, element, exponent and shape are set by caller
+             * @param input      as an input
+             * @param padding    padding size needed in [top, bottom, left, right] of this operation
+             * @param filter     filter of depthwise_conv2d, element in [filter_height, filter_width, channel, 1]
+             * @param stride_y   stride in height
+             * @param stride_x   stride in width
+             * @param bias       bias of depthwise_conv2d, if you don't specify anything, no bias is added
+             * @param activation activation of depthwise_conv2d, if you don't specify anything, no activation is applied
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            void depthwise_conv2d(Tensor<feature_t> &output,
+                                  Tensor<feature_t> &input,
+                                  std::vector<int> &padding,
+                                  const Filter<feature_t> &filter,
+                                  const int stride_y,
+                                  const int stride_x,
+                                  const Bias<bias_t> *const bias = NULL,
+                                  const Activation<feature_t> *const activation = NULL)
+            {
+                std::vector<int> output_hw = get_output_shape(input.shape[0], input.shape[1],
+                                                              filter.shape_with_dilation[0], filter.shape_with_dilation[1],
+                                                              stride_y, stride_x, padding);
+                assert(output.element);
+                assert(output.shape == std::vector<int>({output_hw[0], output_hw[1], input.shape[2]}));
+
+                depthwise_conv2d<feature_t, bias_t>(output.element, output.exponent,
+                                                    input.element, input.shape, input.exponent,
+                                                    filter.element, filter.shape, filter.exponent,
+                                                    filter.channel_exponent_size ? filter.channel_exponent : NULL, filter.dilation,
+                                                    bias ? bias->element : NULL, bias ? bias->exponent : 0,
+                                                    activation ? activation->type : Linear,
+                                                    activation ? activation->element : NULL,
+                                                    activation ? activation->exponent : 0,
+                                                    stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief activation(depthwise_conv2d(input, filter) + bias), the same as dl::nn::depthwise_conv2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output          as an output, shape is set and element is allocated here
+             * @param output_exponent exponent of output
+             * @param input           as an input
+             * @param filter          filter of depthwise_conv2d, element in [filter_height, filter_width, channel, 1]
+             * @param stride_y        stride in height
+             * @param stride_x        stride in width
+             * @param padding_type    one of PADDING_VALID or PADDING_SAME_END or PADDING_SAME_BEGIN
+             * @param bias            bias of depthwise_conv2d, NULL for no bias
+             * @param activation      activation of depthwise_conv2d, NULL for no activation
+             */
+            template <typename feature_t, typename bias_t>
+            void depthwise_conv2d(Tensor<feature_t> &output,
+                                  const int output_exponent,
+                                  Tensor<feature_t> &input,
+                                  const Filter<feature_t> &filter,
+                                  const int stride_y,
+                                  const int stride_x,
+                                  const padding_type_t padding_type,
+                                  const Bias<bias_t> *bias,
+                                  const Activation<feature_t> *activation)
+            {
+                std::vector<int> output_hw, padding;
+                get_output_shape_and_padding(output_hw, padding, input.shape[0], input.shape[1],
+                                             filter.shape_with_dilation[0], filter.shape_with_dilation[1],
+                                             stride_y, stride_x, padding_type);
+                output.set_exponent(output_exponent).set_shape({output_hw[0], output_hw[1], input.shape[2]}).malloc_element();
+                depthwise_conv2d(output, input, padding, filter, stride_y, stride_x, bias, activation);
+            }
+
+            /**
+             * @brief activation(fully_connected(input, filter) + bias), the same as dl::nn::fully_connected().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @tparam bias_t    supports int16_t and int8_t, int16_t is used by int8_t per-channel quantization
+             * @param output     as an output, element, exponent and shape are set by caller
+             * @param input      as an input, taken as flattened
+             * @param filter     filter of fully_connected, element in [1, 1, input_len, output_len]
+             * @param bias       bias of fully_connected, if you don't specify anything, no bias is added
+             * @param activation activation of fully_connected, if you don't specify anything, no activation is applied
+             */
+            template <typename feature_t, typename bias_t = feature_t>
+            void fully_connected(Tensor<feature_t> &output,
+                                 Tensor<feature_t> &input,
+                                 const Filter<feature_t> &filter,
+                                 const Bias<bias_t> *const bias = NULL,
+                                 const Activation<feature_t> *const activation = NULL)
+            {
+                assert(output.element);
+                assert(input.get_size() == filter.shape[2]);
+                assert(output.get_size() == filter.shape[3]);
+
+                fully_connected<feature_t, bias_t>(output.element, output.exponent,
+                                                   input.element, input.get_size(), input.exponent,
+                                                   filter.element, filter.shape[3], filter.exponent,
+                                                   filter.channel_exponent_size ? filter.channel_exponent : NULL,
+                                                   bias ? bias->element : NULL, bias ? bias->exponent : 0,
+                                                   activation ? activation->type : Linear,
+                                                   activation ? activation->element : NULL,
+                                                   activation ? activation->exponent : 0);
+            }
+
+            /**
+             * @brief activation(input0 + input1), the same as dl::nn::add2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output     as an output, element, exponent and shape are set by caller
+             * @param input0     as one input
+             * @param input1     as another input, of the same shape as input0
+             * @param activation activation of add2d, if you don't specify anything, no activation is applied
+             */
+            template <typename feature_t>
+            void add2d(Tensor<feature_t> &output,
+                       Tensor<feature_t> &input0,
+                       Tensor<feature_t> &input1,
+                       const Activation<feature_t> *const activation = NULL)
+            {
+                assert(output.element);
+                assert(input0.shape == input1.shape && output.shape == input0.shape);
+
+                add2d(output.element, output.exponent, input0.element, input0.exponent, input1.element, input1.exponent, output.get_size(),
+                      activation ? activation->type : Linear, activation ? activation->element : (const feature_t *)NULL,
+                      activation ? activation->exponent : 0, output.shape.back());
+            }
+
+            /**
+             * @brief activation(input0 - input1), the same as dl::nn::sub2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output     as an output, element, exponent and shape are set by caller
+             * @param input0     as one input
+             * @param input1     as another input, of the same shape as input0
+             * @param activation activation of sub2d, if you don't specify anything, no activation is applied
+             */
+            template <typename feature_t>
+            void sub2d(Tensor<feature_t> &output,
+                       Tensor<feature_t> &input0,
+                       Tensor<feature_t> &input1,
+                       const Activation<feature_t> *const activation = NULL)
+            {
+                assert(output.element);
+                assert(input0.shape == input1.shape && output.shape == input0.shape);
+
+                sub2d(output.element, output.exponent, input0.element, input0.exponent, input1.element, input1.exponent, output.get_size(),
+                      activation ? activation->type : Linear, activation ? activation->element : (const feature_t *)NULL,
+                      activation ? activation->exponent : 0, output.shape.back());
+            }
+
+            /**
+             * @brief activation(input0 * input1), the same as dl::nn::mul2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output     as an output, element, exponent and shape are set by caller
+             * @param input0     as one input
+             * @param input1     as another input, of the same shape as input0
+             * @param activation activation of mul2d, if you don't specify anything, no activation is applied
+             */
+            template <typename feature_t>
+            void mul2d(Tensor<feature_t> &output,
+                       Tensor<feature_t> &input0,
+                       Tensor<feature_t> &input1,
+                       const Activation<feature_t> *const activation = NULL)
+            {
+                assert(output.element);
+                assert(input0.shape == input1.shape && output.shape == input0.shape);
+
+                mul2d(output.element, output.exponent, input0.element, input0.exponent, input1.element, input1.exponent, output.get_size(),
+                      activation ? activation->type : Linear, activation ? activation->element : (const feature_t *)NULL,
+                      activation ? activation->exponent : 0, output.shape.back());
+            }
+
+            /**
+             * @brief relu(input), the same as dl::nn::relu().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output as an output, element and shape are set by caller, exponent is the one of input
+             * @param input  as an input
+             */
+            template <typename feature_t>
+            void relu(Tensor<feature_t> &output, Tensor<feature_t> &input)
+            {
+                assert(output.element);
+                assert(output.shape == input.shape);
+
+                output.set_exponent(input.exponent);
+                relu(output.element, input.element, input.get_size());
+            }
+
+            /**
+             * @brief leakyrelu(input), the same as dl::nn::leakyrelu().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output              as an output, element, exponent and shape are set by caller
+             * @param input               as an input
+             * @param activation_alpha    alpha of leakyrelu
+             * @param activation_exponent exponent of alpha
+             */
+            template <typename feature_t>
+            void leakyrelu(Tensor<feature_t> &output, Tensor<feature_t> &input, const feature_t activation_alpha, const int activation_exponent)
+            {
+                assert(output.element);
+                assert(output.shape == input.shape);
+
+                prelu(output.element, output.exponent, input.element, input.exponent, input.get_size(), &activation_alpha, activation_exponent, 1);
+            }
+
+            /**
+             * @brief prelu(input), the same as dl::nn::prelu().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output              as an output, element, exponent and shape are set by caller
+             * @param input               as an input
+             * @param activation_element  alpha of prelu, one per channel
+             * @param activation_exponent exponent of alpha
+             */
+            template <typename feature_t>
+            void prelu(Tensor<feature_t> &output, Tensor<feature_t> &input, const feature_t *activation_element, const int activation_exponent)
+            {
+                assert(output.element);
+                assert(output.shape == input.shape);
+
+                prelu(output.element, output.exponent, input.element, input.exponent, input.get_size(), activation_element, activation_exponent, input.shape.back());
+            }
+
+            /**
+             * @brief max_pool2d(input), the same as dl::nn::max_pool2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output       as an output, element and shape are set by caller, exponent is the one of input
+             * @param input        as an input
+             * @param padding      padding size needed in [top, bottom, left, right] of this operation
+             * @param filter_shape [filter_height, filter_width]
+             * @param stride_y     stride in height
+             * @param stride_x     stride in width
+             */
+            template <typename feature_t>
+            void max_pool2d(Tensor<feature_t> &output,
+                            Tensor<feature_t> &input,
+                            std::vector<int> &padding,
+                            std::vector<int> &filter_shape,
+                            const int stride_y,
+                            const int stride_x)
+            {
+                std::vector<int> output_hw = get_output_shape(input.shape[0], input.shape[1], filter_shape[0], filter_shape[1], stride_y, stride_x, padding);
+                assert(output.element);
+                assert(output.shape == std::vector<int>({output_hw[0], output_hw[1], input.shape[2]}));
+
+                output.set_exponent(input.exponent);
+                max_pool2d(output.element, input.element, input.shape, filter_shape[0], filter_shape[1], stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief avg_pool2d(input), the same as dl::nn::avg_pool2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output       as an output, element, exponent and shape are set by caller
+             * @param input        as an input
+             * @param padding      padding size needed in [top, bottom, left, right] of this operation
+             * @param filter_shape [filter_height, filter_width]
+             * @param stride_y     stride in height
+             * @param stride_x     stride in width
+             */
+            template <typename feature_t>
+            void avg_pool2d(Tensor<feature_t> &output,
+                            Tensor<feature_t> &input,
+                            std::vector<int> &padding,
+                            std::vector<int> &filter_shape,
+                            const int stride_y,
+                            const int stride_x)
+            {
+                std::vector<int> output_hw = get_output_shape(input.shape[0], input.shape[1], filter_shape[0], filter_shape[1], stride_y, stride_x, padding);
+                assert(output.element);
+                assert(output.shape == std::vector<int>({output_hw[0], output_hw[1], input.shape[2]}));
+
+                avg_pool2d(output.element, output.exponent, input.element, input.shape, input.exponent, filter_shape[0], filter_shape[1], stride_y, stride_x, padding);
+            }
+
+            /**
+             * @brief global_max_pool2d(input), the same as dl::nn::global_max_pool2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output as an output, element and shape are set by caller, exponent is the one of input
+             * @param input  as an input
+             */
+            template <typename feature_t>
+            void global_max_pool2d(Tensor<feature_t> &output, Tensor<feature_t> &input)
+            {
+                assert(output.element);
+                assert(output.get_size() == input.shape[2]);
+
+                output.set_exponent(input.exponent);
+                global_max_pool2d(output.element, input.element, input.shape);
+            }
+
+            /**
+             * @brief global_avg_pool2d(input), the same as dl::nn::global_avg_pool2d().
+             *
+             * @tparam feature_t supports int16_t and int8_t
+             * @param output as an output, element, exponent and shape are set by caller
+             * @param input  as an input
+             */
+            template <typename feature_t>
+            void global_avg_pool2d(Tensor<feature_t> &output, Tensor<feature_t> &input)
+            {
+                assert(output.element);
+                assert(output.get_size() == input.shape[2]);
+
+                global_avg_pool2d(output.element, output.exponent, input.element, input.shape, input.exponent);
+            }
+        } // namespace reference
+    } // namespace nn
+} // namespace dl
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <type_traits>
+
+#include "dl_constant.hpp"
+#include "dl_variable.hpp"
+#include "dl_tool.hpp"
+#include "dl_nn_reference.hpp"
+
+namespace dl
+{
+    namespace nn
+    {
+        /**
+         * @brief Whether conv2d_winograd() can run a filter, i.e., int16_t, 3x3 without dilation and stride 1.
+         *
+         * @tparam feature_t supports int16_t and int8_t, always false for int8_t
+         * @param filter   filter of conv2d
+         * @param stride_y stride in height
+         * @param stride_x stride in width
+         * @return true: supported
+         *         false: use conv2d()
+         */
+        template <typename feature_t>
+        inline bool winograd_conv2d_supported(const Filter<feature_t> &filter, const int stride_y, const int stride_x)
+        {
+            return std::is_same<feature_t, int16_t>::value &&
+                   filter.shape.size() == 4 && filter.shape[0] == 3 && filter.shape[1] == 3 &&
+                   filter.shape_with_dilation[0] == 3 && filter.shape_with_dilation[1] == 3 &&
+                   filter.channel_exponent == NULL &&
+                   stride_y == 1 && stride_x == 1;
+        }
+
+        /**
+         * @brief Index of filter element [y, x, c, n] in the element of an int16_t filter.
+         *
+         * The convert tool generates the filter for ESP32-S3 in blocks of 8 output channels, one 16-byte vector each,
+         * every block in [filter_height, filter_width, input_channel, 8], then the output_channel % 8 channels left
+         * one by one in [filter_height, filter_width, input_channel]. The other targets keep the original
+         * [filter_height, filter_width, input_channel, output_channel].
+         *
+         * @param shape          shape of filter, [filter_height, filter_width, input_channel, output_channel]
+         * @param y              row of filter
+         * @param x              column of filter
+         * @param c              input channel
+         * @param n              output channel
+         * @param esp32s3_order  true: in the sequence of ESP32-S3, false: in the original sequence
+         * @return index in element
+         */
+        inline int winograd_filter_index(const std::vector<int> &shape, const int y, const int x, const int c, const int n, const bool esp32s3_order)
+        {
+            const int kernel_index = (y * shape[1] + x) * shape[2] + c;
+            if (!esp32s3_order)
+                return kernel_index * shape[3] + n;
+
+            const int kernel_size = shape[0] * shape[1] * shape[2];
+            const int blocked = shape[3] & ~7;
+            if (n < blocked)
+                return (n & ~7) * kernel_size + kernel_index * 8 + (n & 7);
+            return n * kernel_size + kernel_index;
+        }
+
+        /**
+         * @brief Transform a 3x3 filter for conv2d_winograd(), once when a model is built.
+         *
+         * Each [3, 3] kernel g becomes U = (2G) g (2G)^T, G being the filter transform of F(2x2, 3x3). The factor 2
+         * keeps U in integer, so the result of conv2d_winograd() is 4 times of the direct accumulation exactly and
+         * nothing is lost before requantization.
+         *
+         * @tparam feature_t supports int16_t and int8_t
+         * @param filter        filter of conv2d, [3, 3, input_channel, output_channel]
+         * @param esp32s3_order true: element in the sequence of ESP32-S3, false: in the original sequence,
+         *                      see winograd_filter_index()
+         * @return int32_t * [16, output_channel, input_channel], free by tool::free_aligned(). NULL for failed
+         */
+        template <typename feature_t>
+        int32_t *winograd_transform_filter(const Filter<feature_t> &filter, const bool esp32s3_order)
+        {
+            const int input_channel = filter.shape[2];
+            const int output_channel = filter.shape[3];
+            const int size = output_channel * input_channel;
+            int32_t *transformed = (int32_t *)tool::malloc_aligned(16 * size, sizeof(int32_t), 16);
+            if (transformed == NULL)
+                return NULL;
+
+            for (int n = 0; n < output_channel; n++)
+            {
+                for (int c = 0; c < input_channel; c++)
+                {
+                    int32_t g[3][3];
+                    for (int fy = 0; fy < 3; fy++)
+                        for (int fx = 0; fx < 3; fx++)
+                            g[fy][fx] = filter.element[winograd_filter_index(filter.shape, fy, fx, c, n, esp32s3_order)];
+
+                    // 2G = [[2, 0, 0], [1, 1, 1], [1, -1, 1], [0, 0, 2]]
+                    int32_t t[4][3];
+                    for (int x = 0; x < 3; x++)
+                    {
+                        t[0][x] = 2 * g[0][x];
+                        t[1][x] = g[0][x] + g[1][x] + g[2][x];
+                        t[2][x] = g[0][x] - g[1][x] + g[2][x];
+                        t[3][x] = 2 * g[2][x];
+                    }
+                    for (int y = 0; y < 4; y++)
+                    {
+                        int32_t *u = transformed + (y * 4) * size + n * input_channel + c;
+                        u[0 * size] = 2 * t[y][0];
+                        u[1 * size] = t[y][0] + t[y][1] + t[y][2];
+                        u[2 * size] = t[y][0] - t[y][1] + t[y][2];
+                        u[3 * size] = 2 * t[y][2];
+                    }
+                }
+            }
+            return transformed;
+        }
+
+        /**
+         * @brief Transform a 3x3 filter generated by the convert tool for the target compiled for.
+         *
+         * @tparam feature_t supports int16_t and int8_t
+         * @param filter filter of conv2d, [3, 3, input_channel, output_channel]
+         * @return int32_t * [16, output_channel, input_channel], free by tool::free_aligned(). NULL for failed
+         */
+        template <typename feature_t>
+        int32_t *winograd_transform_filter(const Filter<feature_t> &filter)
+        {
+#if CONFIG_IDF_TARGET_ESP32S3
+            return winograd_transform_filter(filter, true);
+#else
+            return winograd_transform_filter(filter, false);
+#endif
+        }
+
+        /**
+         * @brief activation(conv2d(input, filter) + bias) of a 3x3 stride-1 filter by Winograd F(2x2, 3x3).
+         *
+         * Every 2x2 output tile takes 16 multiplications per input channel and output channel instead of 36. The
+         * accumulation is exact, then bias, requantization and activation follow the quantization specification in
+         * dl_nn_reference.hpp, so the output equals reference::conv2d() and may differ from conv2d() in 1 LSB.
+         *
+         * @tparam feature_t supports int16_t and int8_t
+         * @tparam bias_t    supports int16_t and int8_t
+         * @param output      as an output, element must be allocated
+         * @param input       as an input
+         * @param padding     padding size needed in [top, bottom, left, right] of this operation
+         * @param transformed filter transformed by winograd_transform_filter()
+         * @param filter      filter of conv2d, for shape and exponent
+         * @param bias        bias of conv2d, if you don't specify anything, no bias is added
+         * @param activation  activation of conv2d, if you don't specify anything, no activation is applied
+         */
+        template <typename feature_t, typename bias_t = feature_t>
+        void conv2d_winograd(Tensor<feature_t> &output,
+                             Tensor<feature_t> &input,
+                             std::vector<int> &padding,
+                             const int32_t *transformed,
+                             const Filter<feature_t> &filter,
+                             const Bias<bias_t> *const bias = NULL,
+                             const Activation<feature_t> *const activation = NULL)
+        {
+            const int input_height = input.shape[0];
+            const int input_width = input.shape[1];
+            const int input_channel = input.shape[2];
+            const int output_height = output.shape[0];
+            const int output_width = output.shape[1];
+            const int output_channel = output.shape[2];
+            const int size = output_channel * input_channel;
+
+            const int accumulate_exponent = input.exponent + filter.exponent;
+            const activation_type_t activation_type = activation ? activation->type : Linear;
+            const feature_t *alpha = activation ? activation->element : NULL;
+            const int alpha_exponent = activation ? activation->exponent : 0;
+
+            // transformed input tiles of all input channels, [16, input_channel]
+            std::vector<int32_t> v(16 * input_channel);
+
+            for (int oy = 0; oy < output_height; oy += 2)
+            {
+                for (int ox = 0; ox < output_width; ox += 2)
+                {
+                    const int iy = oy - padding[0];
+                    const int ix = ox - padding[2];
+                    for (int c = 0; c < input_channel; c++)
+                    {
+                        int32_t d[4][4];
+                        for (int y = 0; y < 4; y++)
+                        {
+                            for (int x = 0; x < 4; x++)
+                            {
+                                bool inside = (iy + y >= 0 && iy + y < input_height && ix + x >= 0 && ix + x < input_width);
+                                d[y][x] = inside ? input.element[((iy + y) * input_width + ix + x) * input_channel + c] : 0;
+                            }
+                        }
+
+                        // B^T = [[1, 0, -1, 0], [0, 1, 1, 0], [0, -1, 1, 0], [0, 1, 0, -1]]
+                        int32_t t[4][4];
+                        for (int x = 0; x < 4; x++)
+                        {
+                            t[0][x] = d[0][x] - d[2][x];
+                            t[1][x] = d[1][x] + d[2][x];
+                            t[2][x] = d[2][x] - d[1][x];
+                            t[3][x] = d[1][x] - d[3][x];
+                        }
+                        for (int y = 0; y < 4; y++)
+                        {
+                            int32_t *v_ptr = v.data() + (y * 4) * input_channel + c;
+                            v_ptr[0 * input_channel] = t[y][0] - t[y][2];
+                            v_ptr[1 * input_channel] = t[y][1] + t[y][2];
+                            v_ptr[2 * input_channel] = t[y][2] - t[y][1];
+                            v_ptr[3 * input_channel] = t[y][1] - t[y][3];
+                        }
+                    }
+
+                    for (int n = 0; n < output_channel; n++)
+                    {
+                        int64_t m[4][4];
+                        for (int k = 0; k < 16; k++)
+                        {
+                            const int32_t *u_ptr = transformed + k * size + n * input_channel;
+                            const int32_t *v_ptr = v.data() + k * input_channel;
+                            int64_t accumulator = 0;
+                            for (int c = 0; c < input_channel; c++)
+                                accumulator += (int64_t)u_ptr[c] * v_ptr[c];
+                            m[k / 4][k % 4] = accumulator;
+                        }
+
+                        // A^T = [[1, 1, 1, 0], [0, 1, -1, -1]]
+                        int64_t s[2][4];
+                        for (int x = 0; x < 4; x++)
+                        {
+                            s[0][x] = m[0][x] + m[1][x] + m[2][x];
+                            s[1][x] = m[1][x] - m[2][x] - m[3][x];
+                        }
+                        int64_t result[2][2];
+                        for (int y = 0; y < 2; y++)
+                        {
+                            result[y][0] = s[y][0] + s[y][1] + s[y][2];
+                            result[y][1] = s[y][1] - s[y][2] - s[y][3];
+                        }
+
+                        int64_t bias_value = bias ? reference::requantize(bias->element[n], bias->exponent, output.exponent) : 0;
+                        int64_t alpha_value = alpha ? alpha[activation_type == PReLU ? n : 0] : 0;
+                        for (int y = 0; y < 2 && oy + y < output_height; y++)
+                        {
+                            for (int x = 0; x < 2 && ox + x < output_width; x++)
+                            {
+                                // the filter is scaled by 4, the division is exact
+                                int64_t value = reference::requantize(result[y][x] / 4, accumulate_exponent, output.exponent) + bias_value;
+                                value = reference::activate(value, activation_type, alpha_value, alpha_exponent);
+                                output.element[((oy + y) * output_width + ox + x) * output_channel + n] = reference::saturate<feature_t>(value);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    } // namespace nn
+} // namespace dl
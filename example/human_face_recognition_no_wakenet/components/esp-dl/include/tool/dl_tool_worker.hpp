@@ -0,0 +1,279 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#else
+#include <pthread.h>
+#endif
+
+namespace dl
+{
+    namespace tool
+    {
+        /**
+         * @brief Workers pinned to cores for intra-op parallelism.
+         *
+         * parallel_for() splits a job into one part per core in assign_core. The caller runs part 0 on its own core, a
+         * worker on each other core runs one of the rest, and the caller returns after all parts are done. Workers are
+         * created on first use and stay blocked between jobs, so a job costs one wake-up and one completion signal per
+         * worker. One job runs at a time; a caller finding the pool busy runs the whole job by itself.
+         *
+         * On ESP-IDF, workers are FreeRTOS tasks pinned to cores, signalled by semaphores of the pool, so the task
+         * notifications of the caller are left to the application. Elsewhere they are pthreads and the core id is only an
+         * index, so the same code can be tested on host.
+         */
+        class WorkerPool
+        {
+        private:
+            typedef void (*job_t)(void *arg, int index, int count);
+
+            /**
+             * @brief A worker bound to a core.
+             */
+            typedef struct
+            {
+                WorkerPool *pool; /*<! pool of worker >*/
+                int core;         /*<! core of worker >*/
+                int index;        /*<! part of current job >*/
+#if defined(ESP_PLATFORM)
+                TaskHandle_t task;       /*<! worker task >*/
+                SemaphoreHandle_t start; /*<! given when a part is assigned >*/
+#else
+                pthread_t thread; /*<! worker thread >*/
+                bool start;       /*<! a part is assigned >*/
+#endif
+            } worker_t;
+
+            std::vector<worker_t *> workers; /*<! created workers >*/
+            job_t job;                       /*<! current job >*/
+            void *arg;                       /*<! argument of current job >*/
+            int count;                       /*<! number of parts of current job >*/
+            int stack_size;                  /*<! stack size of worker in byte >*/
+            int priority;                    /*<! priority of worker task >*/
+#if defined(ESP_PLATFORM)
+            SemaphoreHandle_t busy; /*<! held while a job runs >*/
+            SemaphoreHandle_t done; /*<! given by a worker when its part is finished >*/
+#else
+            pthread_mutex_t busy;   /*<! held while a job runs >*/
+            pthread_mutex_t mutex;  /*<! guards start and pending >*/
+            pthread_cond_t started; /*<! signals workers >*/
+            pthread_cond_t done;    /*<! signals caller >*/
+            int pending;            /*<! parts not finished by workers >*/
+#endif
+
+            WorkerPool() : job(NULL), arg(NULL), count(0), stack_size(4 * 1024), priority(5)
+            {
+#if defined(ESP_PLATFORM)
+                this->busy = xSemaphoreCreateMutex();
+                this->done = xSemaphoreCreateCounting(portNUM_PROCESSORS, 0);
+#else
+                pthread_mutex_init(&this->busy, NULL);
+                pthread_mutex_init(&this->mutex, NULL);
+                pthread_cond_init(&this->started, NULL);
+                pthread_cond_init(&this->done, NULL);
+                this->pending = 0;
+#endif
+            }
+
+            static int get_core()
+            {
+#if defined(ESP_PLATFORM)
+                return xPortGetCoreID();
+#else
+                return 0;
+#endif
+            }
+
+#if defined(ESP_PLATFORM)
+            static void worker_loop(void *arg)
+            {
+                worker_t *worker = (worker_t *)arg;
+                WorkerPool *pool = worker->pool;
+                while (true)
+                {
+                    xSemaphoreTake(worker->start, portMAX_DELAY);
+                    pool->job(pool->arg, worker->index, pool->count);
+                    xSemaphoreGive(pool->done);
+                }
+            }
+#else
+            static void *worker_loop(void *arg)
+            {
+                worker_t *worker = (worker_t *)arg;
+                WorkerPool *pool = worker->pool;
+                while (true)
+                {
+                    pthread_mutex_lock(&pool->mutex);
+                    while (!worker->start)
+                        pthread_cond_wait(&pool->started, &pool->mutex);
+                    worker->start = false;
+                    pthread_mutex_unlock(&pool->mutex);
+
+                    pool->job(pool->arg, worker->index, pool->count);
+
+                    pthread_mutex_lock(&pool->mutex);
+                    if (--pool->pending == 0)
+                        pthread_cond_signal(&pool->done);
+                    pthread_mutex_unlock(&pool->mutex);
+                }
+                return NULL;
+            }
+#endif
+
+            worker_t *get_worker(const int core)
+            {
+                for (worker_t *worker : this->workers)
+                {
+                    if (worker->core == core)
+                        return worker;
+                }
+
+                worker_t *worker = new worker_t;
+                worker->pool = this;
+                worker->core = core;
+                worker->index = 0;
+#if defined(ESP_PLATFORM)
+                worker->start = xSemaphoreCreateBinary();
+                if (worker->start == NULL)
+                {
+                    delete worker;
+                    return NULL;
+                }
+                if (xTaskCreatePinnedToCore(worker_loop, "dl_worker", this->stack_size, worker, this->priority, &worker->task, core) != pdPASS)
+                {
+                    vSemaphoreDelete(worker->start);
+                    delete worker;
+                    return NULL;
+                }
+#else
+                worker->start = false;
+                if (pthread_create(&worker->thread, NULL, worker_loop, worker) != 0)
+                {
+                    delete worker;
+                    return NULL;
+                }
+#endif
+                this->workers.push_back(worker);
+                return worker;
+            }
+
+            void run(job_t job, void *arg, const std::vector<int> &assign_core)
+            {
+                const int self = get_core();
+                std::vector<worker_t *> helpers;
+                for (int core : assign_core)
+                {
+                    if (core == self)
+                        continue;
+                    bool duplicated = false;
+                    for (worker_t *helper : helpers)
+                        duplicated |= helper->core == core;
+                    if (duplicated)
+                        continue;
+                    worker_t *worker = this->get_worker(core);
+                    if (worker)
+                        helpers.push_back(worker);
+                }
+
+                this->job = job;
+                this->arg = arg;
+                this->count = helpers.size() + 1;
+#if defined(ESP_PLATFORM)
+                for (int i = 0; i < helpers.size(); i++)
+                {
+                    helpers[i]->index = i + 1;
+                    xSemaphoreGive(helpers[i]->start);
+                }
+                job(arg, 0, this->count);
+                for (int i = 0; i < helpers.size(); i++)
+                    xSemaphoreTake(this->done, portMAX_DELAY);
+#else
+                pthread_mutex_lock(&this->mutex);
+                this->pending = helpers.size();
+                for (int i = 0; i < helpers.size(); i++)
+                {
+                    helpers[i]->index = i + 1;
+                    helpers[i]->start = true;
+                }
+                pthread_cond_broadcast(&this->started);
+                pthread_mutex_unlock(&this->mutex);
+
+                job(arg, 0, this->count);
+
+                pthread_mutex_lock(&this->mutex);
+                while (this->pending)
+                    pthread_cond_wait(&this->done, &this->mutex);
+                pthread_mutex_unlock(&this->mutex);
+#endif
+            }
+
+            template <typename F>
+            static void call(void *arg, int index, int count)
+            {
+                (*(F *)arg)(index, count);
+            }
+
+        public:
+            /**
+             * @brief Get the WorkerPool shared by all layers.
+             *
+             * @return WorkerPool&
+             */
+            static WorkerPool &get_instance()
+            {
+                static WorkerPool pool;
+                return pool;
+            }
+
+            /**
+             * @brief Set the stack size and priority of workers created after.
+             *
+             * @param stack_size stack size in byte
+             * @param priority   priority of worker task, should be the same as the tasks calling models
+             */
+            void config(const int stack_size, const int priority)
+            {
+                this->stack_size = stack_size;
+                this->priority = priority;
+            }
+
+            /**
+             * @brief Run function(index, count) for index in [0, count) on the cores in assign_core.
+             *
+             * @tparam F         callable as void(int index, int count)
+             * @param function   part of job, index 0 runs on the caller
+             * @param assign_core cores to run on, the core of caller is always used
+             * @return int number of parts, 1 for running by the caller only
+             */
+            template <typename F>
+            int parallel_for(F &function, const std::vector<int> &assign_core)
+            {
+                bool acquired;
+#if defined(ESP_PLATFORM)
+                acquired = assign_core.size() > 1 && xSemaphoreTake(this->busy, 0) == pdTRUE;
+#else
+                acquired = assign_core.size() > 1 && pthread_mutex_trylock(&this->busy) == 0;
+#endif
+                if (!acquired)
+                {
+                    function(0, 1);
+                    return 1;
+                }
+
+                this->run(call<F>, &function, assign_core);
+                int count = this->count;
+#if defined(ESP_PLATFORM)
+                xSemaphoreGive(this->busy);
+#else
+                pthread_mutex_unlock(&this->busy);
+#endif
+                return count;
+            }
+        };
+    } // namespace tool
+} // namespace dl
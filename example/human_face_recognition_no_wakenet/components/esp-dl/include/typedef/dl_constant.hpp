@@ -3,6 +3,7 @@
 #include "dl_define.hpp"
 #include <vector>
 #include <stdint.h>
+#include <stddef.h>
 
 namespace dl
 {
@@ -20,6 +20,8 @@ if os.path.exists(path):
     parser.add_argument('-o', '--output_root', help="generated source files root")
     parser.add_argument('-q', '--quant', help="quantization granularity: 0(default) for per-tensor, 1 for per-channel",
                         type=int, default=0)
+    parser.add_argument('-g', '--graph', help="graph json file, also generates a model fixed at compile time as "
+                                              "<name>_model.hpp, see static_model.py")
     args = parser.parse_args()
 
     if args.input_root is None or args.name is None or args.output_root is None:
@@ -34,6 +36,9 @@ if os.path.exists(path):
                       name=args.name,
                       quant=args.quant)
     convert()
+    if args.graph is not None:
+        import static_model
+        static_model.generate(args.json_file_name, args.graph, args.input_root, args.output_root, args.name)
     print(' Finish\n')
 
 else:
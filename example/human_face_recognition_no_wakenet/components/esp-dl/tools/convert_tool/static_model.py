@@ -0,0 +1,296 @@
+"""Generate a model whose graph is fixed at compile time.
+
+The coefficients are generated by Convert as usual. This adds <name>_model.hpp, a model in which shapes, paddings,
+strides and exponents are constants, and all activations are placed in one statically sized arena by their
+lifetimes. There is no build(), and call() only runs the nn functions on tensors set up in the constructor, so no heap
+is used at inference.
+
+The graph is described by a json file in execution order:
+
+    {
+        "input": [28, 28, 3],
+        "layers": [
+            {"name": "l1", "stride": [2, 2], "padding": "valid"},
+            {"name": "l2_depth", "stride": [2, 2], "padding": "same_end", "output_exponent": -1},
+            {"name": "l3_concat", "operation": "concat", "input": ["l3_a_compress", "l3_c_compress"]},
+            ...
+        ]
+    }
+
+Each layer takes the output of the previous one unless "input" is given, "model_input" stands for the input of model.
+Keys of the layer in config.json, e.g., operation and output_exponent, can be given or overridden here. Supported
+operations are conv2d, depthwise_conv2d and concat in channel.
+"""
+import ast
+import json
+import os
+
+PADDING_TYPES = {
+    'valid': 'PADDING_VALID',
+    'same_end': 'PADDING_SAME_END',
+    'same_begin': 'PADDING_SAME_BEGIN',
+}
+
+FEATURE_TYPES = {
+    's16': 'int16_t',
+    's8': 'int8_t',
+}
+
+MODEL_INPUT = 'model_input'
+
+
+def read_npy_shape(path):
+    """Read the shape in the header of a .npy file."""
+    with open(path, 'rb') as file:
+        if file.read(6) != b'\x93NUMPY':
+            raise ValueError(f'{path} is not a .npy file')
+        major = file.read(2)[0]
+        size = file.read(4 if major >= 2 else 2)
+        header = file.read(int.from_bytes(size, 'little')).decode('latin1')
+    return list(ast.literal_eval(header)['shape'])
+
+
+def get_output_shape_and_padding(input_shape, filter_height, filter_width, stride_y, stride_x, padding_type):
+    """Same as dl::nn::reference::get_output_shape_and_padding()."""
+    input_height, input_width = input_shape[0], input_shape[1]
+    if padding_type == 'valid':
+        output_shape = [(input_height - filter_height) // stride_y + 1, (input_width - filter_width) // stride_x + 1]
+        return output_shape, [0, 0, 0, 0]
+
+    output_height = (input_height + stride_y - 1) // stride_y
+    output_width = (input_width + stride_x - 1) // stride_x
+    pad_h = max((output_height - 1) * stride_y + filter_height - input_height, 0)
+    pad_w = max((output_width - 1) * stride_x + filter_width - input_width, 0)
+    top = pad_h // 2 if padding_type == 'same_end' else pad_h - pad_h // 2
+    left = pad_w // 2 if padding_type == 'same_end' else pad_w - pad_w // 2
+    return [output_height, output_width], [top, pad_h - top, left, pad_w - left]
+
+
+class StaticModel(object):
+    def __init__(self, config, graph, input_root, name, align=16):
+        self.config = config
+        self.graph = graph
+        self.input_root = input_root
+        self.name = name
+        self.align = align
+        self.feature_type = None
+        self.layers = []
+        self.arena_size = 0
+
+    def infer(self):
+        """Get operation, shape, padding and exponent of each layer."""
+        if not self.graph.get('layers'):
+            raise ValueError('graph has no layer')
+
+        outputs = {MODEL_INPUT: {'shape': list(self.graph['input']), 'exponent': None}}
+        previous = MODEL_INPUT
+        for node in self.graph['layers']:
+            name = node['name']
+            layer = dict(self.config.get(name, {}))
+            layer.update(node)
+            layer['input'] = layer.get('input', previous)
+            operation = layer.get('operation')
+
+            feature_type = FEATURE_TYPES.get(layer.get('feature_type', 's16'))
+            if feature_type is None:
+                raise ValueError(f'feature_type of {name} is not supported')
+            if self.feature_type is None:
+                self.feature_type = feature_type
+            elif self.feature_type != feature_type:
+                raise ValueError(f'{name} is in {feature_type}, but the model is in {self.feature_type}')
+
+            if operation in ('conv2d', 'depthwise_conv2d'):
+                if layer['input'] not in outputs:
+                    raise ValueError(f'input of {name} is not found before it')
+                input_shape = outputs[layer['input']]['shape']
+                filter_shape = read_npy_shape(os.path.join(self.input_root, f'{name}_filter.npy'))
+                stride = layer.get('stride', [1, 1])
+                padding_type = layer.get('padding', 'valid')
+                if padding_type not in PADDING_TYPES:
+                    raise ValueError(f'padding of {name} should be one of {list(PADDING_TYPES)}')
+                output_hw, padding = get_output_shape_and_padding(input_shape, filter_shape[0], filter_shape[1],
+                                                                  stride[0], stride[1], padding_type)
+                channel = filter_shape[3] if operation == 'conv2d' else input_shape[2]
+                layer['shape'] = output_hw + [channel]
+                layer['stride'] = stride
+                layer['padding'] = padding
+                layer['bias'] = str(layer.get('bias', 'False')) == 'True'
+                layer['activation'] = 'activation' in layer
+            elif operation == 'concat':
+                inputs = layer['input']
+                if not isinstance(inputs, list) or len(inputs) < 2:
+                    raise ValueError(f'concat {name} needs a list of inputs')
+                shapes = []
+                exponents = set()
+                for input_name in inputs:
+                    if input_name not in outputs:
+                        raise ValueError(f'input {input_name} of {name} is not found before it')
+                    shapes.append(outputs[input_name]['shape'])
+                    exponents.add(outputs[input_name]['exponent'])
+                if any(shape[:2] != shapes[0][:2] for shape in shapes) or len(exponents) != 1:
+                    raise ValueError(f'inputs of concat {name} should have the same height, width and exponent')
+                layer['shape'] = shapes[0][:2] + [sum(shape[2] for shape in shapes)]
+                layer['output_exponent'] = exponents.pop()
+            else:
+                raise ValueError(f'operation {operation} of {name} is not supported')
+
+            if layer.get('output_exponent') is None:
+                raise ValueError(f'output_exponent of {name} is missing')
+
+            layer['size'] = layer['shape'][0] * layer['shape'][1] * layer['shape'][2]
+            outputs[name] = {'shape': layer['shape'], 'exponent': layer['output_exponent']}
+            self.layers.append(layer)
+            previous = name
+
+    def plan(self):
+        """Place outputs in one arena, outputs alive at the same time never overlap."""
+        last_use = {}
+        for step, layer in enumerate(self.layers):
+            inputs = layer['input'] if isinstance(layer['input'], list) else [layer['input']]
+            for input_name in inputs:
+                last_use[input_name] = step
+        last_use[self.layers[-1]['name']] = len(self.layers)
+
+        # larger tensors are placed first, each goes to the lowest offset free during its lifetime
+        placed = []
+        order = sorted(range(len(self.layers)), key=lambda i: (-self.layers[i]['size'], i))
+        for i in order:
+            layer = self.layers[i]
+            begin, end = i, last_use.get(layer['name'], i)
+            size = (layer['size'] + self.align - 1) // self.align * self.align
+            conflicts = sorted((other['offset'], other['offset'] + other['aligned_size'])
+                               for other in placed if not (other['end'] < begin or end < other['begin']))
+            offset = 0
+            for low, high in conflicts:
+                if offset + size <= low:
+                    break
+                offset = max(offset, high)
+            layer.update({'offset': offset, 'aligned_size': size, 'begin': begin, 'end': end})
+            placed.append(layer)
+            self.arena_size = max(self.arena_size, offset + size)
+
+    def emit(self):
+        """Get the source of <name>_model.hpp."""
+        class_name = ''.join(word.capitalize() for word in self.name.split('_')) + 'Model'
+        feature_t = self.feature_type
+        lines = []
+        add = lines.append
+
+        add('#pragma once')
+        add('')
+        add('#include <stdint.h>')
+        add('#include <vector>')
+        add('#include "dl_variable.hpp"')
+        add('#include "dl_nn_conv2d.hpp"')
+        add('#include "dl_nn_depthwise_conv2d.hpp"')
+        add('#include "dl_nn_concat.hpp"')
+        add(f'#include "{self.name}.hpp"')
+        add('')
+        add(f'namespace {self.name}')
+        add('{')
+        add('    /**')
+        add('     * @brief Model generated by convert tool with the graph fixed at compile time.')
+        add('     *')
+        add('     * Shapes, paddings and exponents are constants, activations are placed in a static arena by their')
+        add('     * lifetimes. call() uses no heap and needs no build(). Only one object should run at a time, since all')
+        add('     * objects share the arena.')
+        add('     *')
+        add('     * The header is C++11: the arena is a static local of an inline function rather than an inline variable,')
+        add('     * so there is one arena however many files include it, and no constant is odr-used.')
+        add('     */')
+        add(f'    class {class_name}')
+        add('    {')
+        add('    public:')
+        add(f'        static constexpr int input_height = {self.graph["input"][0]};')
+        add(f'        static constexpr int input_width = {self.graph["input"][1]};')
+        add(f'        static constexpr int input_channel = {self.graph["input"][2]};')
+        add(f'        static constexpr int arena_size = {self.arena_size}; /*<! elements of arena >*/')
+        add('')
+        add('        /*<! outputs of the layers in the arena, each valid until a later layer is placed over it >*/')
+        for layer in self.layers:
+            add(f'        dl::Tensor<{feature_t}> {layer["name"]};')
+        add('')
+        add('    private:')
+        for layer in self.layers:
+            add(f'        static constexpr int {layer["name"]}_offset = {layer["offset"]};')
+        add('')
+        for layer in self.layers:
+            if layer['operation'] == 'concat':
+                add(f'        std::vector<dl::Tensor<{feature_t}> *> {layer["name"]}_inputs;')
+            else:
+                add(f'        std::vector<int> {layer["name"]}_padding;')
+        add('        std::vector<int> assign_core; /*<! kept, or the default argument would be constructed in each call >*/')
+        add('')
+        add('    public:')
+        add('        /**')
+        add('         * @brief Get the arena of all activations.')
+        add('         *')
+        add(f'         * @return {feature_t}* arena_size elements aligned to 16 bytes')
+        add('         */')
+        add(f'        static {feature_t} *get_arena()')
+        add('        {')
+        add(f'            alignas(16) static {feature_t} arena[arena_size];')
+        add('            return arena;')
+        add('        }')
+        add('')
+        add(f'        {class_name}() : assign_core(CONFIG_DEFAULT_ASSIGN_CORE)')
+        add('        {')
+        add(f'            {feature_t} *arena = get_arena();')
+        for layer in self.layers:
+            name = layer['name']
+            shape = layer['shape']
+            add(f'            this->{name}.set_element(arena + {name}_offset).set_exponent({layer["output_exponent"]})'
+                f'.set_shape({{{shape[0]}, {shape[1]}, {shape[2]}}}).set_auto_free(false);')
+            if layer['operation'] == 'concat':
+                inputs = ', '.join(f'&this->{input_name}' for input_name in layer['input'])
+                add(f'            this->{name}_inputs = {{{inputs}}};')
+            else:
+                padding = ', '.join(str(value) for value in layer['padding'])
+                add(f'            this->{name}_padding = {{{padding}}};')
+        add('        }')
+        add('')
+        add('        /**')
+        add('         * @brief Run the model.')
+        add('         *')
+        add(f'         * @param input [{self.graph["input"][0]}, {self.graph["input"][1]}, {self.graph["input"][2]}]')
+        add(f'         * @return dl::Tensor<{feature_t}>& output of {self.layers[-1]["name"]}, valid until the next call')
+        add('         */')
+        add(f'        dl::Tensor<{feature_t}> &call(dl::Tensor<{feature_t}> &input)')
+        add('        {')
+        for layer in self.layers:
+            name = layer['name']
+            operation = layer['operation']
+            if operation == 'concat':
+                add(f'            dl::nn::concat(this->{name}, this->{name}_inputs, -1);')
+                continue
+            source = 'input' if layer['input'] == MODEL_INPUT else f'this->{layer["input"]}'
+            # NULL alone is ambiguous between the overloads of int8_t
+            bias = f'get_{name}_bias()' if layer['bias'] else f'(const dl::Bias<{feature_t}> *)NULL'
+            activation = f'get_{name}_activation()' if layer['activation'] else 'NULL'
+            stride_y, stride_x = layer['stride']
+            if operation == 'conv2d':
+                add(f'            dl::nn::conv2d(this->{name}, {source}, this->{name}_padding, *get_{name}_filter(), '
+                    f'{stride_y}, {stride_x}, {bias}, {activation}, this->assign_core);')
+            else:
+                add(f'            dl::nn::depthwise_conv2d(this->{name}, {source}, this->{name}_padding, *get_{name}_filter(), '
+                    f'{stride_y}, {stride_x}, {bias}, {activation}, this->assign_core);')
+        add(f'            return this->{self.layers[-1]["name"]};')
+        add('        }')
+        add('    };')
+        add(f'}} // namespace {self.name}')
+        return '\n'.join(lines) + '\n'
+
+
+def generate(json_file, graph_file, input_root, output_root, name):
+    """Write <output_root>/<name>_model.hpp."""
+    with open(os.path.join(input_root, json_file)) as file:
+        config = json.load(file)
+    with open(graph_file if os.path.isabs(graph_file) else os.path.join(input_root, graph_file)) as file:
+        graph = json.load(file)
+
+    model = StaticModel(config, graph, input_root, name)
+    model.infer()
+    model.plan()
+    with open(os.path.join(output_root, f'{name}_model.hpp'), 'w') as file:
+        file.write(model.emit())
+    return model
@@ -7,6 +7,12 @@
 
 #include "dl_tool.hpp"
 #include "mnist_model.hpp"
+#include "dl_layer_add2d.hpp"
+#include "dl_layer_relu.hpp"
+#include "dl_layer_conv2d_add2d.hpp"
+#include "dl_layer_depthwise_separable_conv2d.hpp"
+#include "mnist_coefficient_model.hpp"
+#include "dl_nn_winograd.hpp"
 
 /**
  * @brief Samples in MNIST dataset are repeated in channel to mimic RGB image. 
@@ -323,6 +329,27 @@ extern "C" void app_main(void)
     latency.end();
     latency.print("MNIST", "forward");
 
+#if DL_PROFILE_LAYER
+    // per layer profile of a few more calls
+    dl::layer::Profiler &profiler = dl::layer::Profiler::get_instance();
+    profiler.start();
+    for (int i = 0; i < 3; i++)
+        model.forward(input);
+    profiler.stop();
+    profiler.print_csv();
+    profiler.print_json();
+
+    // place filters by measured cycles instead of layer order
+    model.placement.set_cycle(profiler);
+    model.placement.place();
+#endif
+
+    // activation memory, before and after planning
+    model.planner.print();
+
+    // filters in internal RAM
+    model.placement.print();
+
     // parse
     int16_t *score = model.l5_compress.get_output().get_element_ptr();
     int16_t max_score = score[0];
@@ -339,6 +366,96 @@ extern "C" void app_main(void)
         }
     }
     printf("\nPrediction Result: %d\n", max_index);
+
+    // Conv2D -> Add2D -> Relu v.s. Conv2DAdd2D, l1 coefficient is reused and output of l1 is the residual
+    Conv2D<int16_t> conv(-2, get_l1_filter(), get_l1_bias(), NULL, PADDING_VALID, {}, 2, 2, "conv");
+    Add2D<int16_t> add(-2, NULL, "add");
+    Relu<int16_t> relu("relu");
+    Conv2DAdd2D<int16_t> fused(-2, get_l1_filter(), get_l1_bias(), NULL, PADDING_VALID, {}, 2, 2, -2, get_l1_activation(), "fused", false, 4 * 13 * 16 * sizeof(int16_t));
+    Conv2D<int16_t> residual(-2, get_l1_filter(), get_l1_bias(), get_l1_activation(), PADDING_VALID, {}, 2, 2, "residual");
+
+    residual.build(input);
+    residual.call(input);
+    conv.build(input);
+    add.build(conv.get_output(), residual.get_output());
+    relu.build(add.get_output());
+    fused.build(input, residual.get_output());
+
+    latency.start();
+    conv.call(input);
+    add.call(conv.get_output(), residual.get_output());
+    relu.call(add.get_output());
+    latency.end();
+    latency.print("Conv2D + Add2D + Relu", "call");
+
+    latency.start();
+    fused.call(input, residual.get_output());
+    latency.end();
+    latency.print("Conv2DAdd2D", "call");
+
+    printf("Fusion Result: %s\n", fused.get_output().check_element(relu.get_output().get_element_ptr(), 0, false) ? "pass" : "fail");
+
+    // DepthwiseConv2D -> Conv2D v.s. DepthwiseSeparableConv2D, l2 coefficient is reused on the output of l1
+    DepthwiseConv2D<int16_t> depthwise(-1, get_l2_depth_filter(), NULL, get_l2_depth_activation(), PADDING_SAME_END, {}, 2, 2, "depthwise");
+    Conv2D<int16_t> pointwise(-3, get_l2_compress_filter(), get_l2_compress_bias(), NULL, PADDING_SAME_END, {}, 1, 1, "pointwise");
+    DepthwiseSeparableConv2D<int16_t> separable(-1, get_l2_depth_filter(), NULL, get_l2_depth_activation(), PADDING_SAME_END, {}, 2, 2,
+                                                -3, get_l2_compress_filter(), get_l2_compress_bias(), NULL, "separable", 2 * 7 * 16 * sizeof(int16_t));
+
+    depthwise.build(residual.get_output());
+    pointwise.build(depthwise.get_output());
+    separable.build(residual.get_output());
+
+    latency.start();
+    depthwise.call(residual.get_output());
+    pointwise.call(depthwise.get_output());
+    latency.end();
+    latency.print("DepthwiseConv2D + Conv2D", "call");
+
+    latency.start();
+    separable.call(residual.get_output());
+    latency.end();
+    latency.print("DepthwiseSeparableConv2D", "call");
+
+    printf("Separable Result: %s\n", separable.get_output().check_element(pointwise.get_output().get_element_ptr(), 0, false) ? "pass" : "fail");
+
+    // MNIST v.s. the model generated by convert tool with graph.json, which runs without build() and heap
+    mnist_coefficient::MnistCoefficientModel static_model;
+
+    latency.start();
+    Tensor<int16_t> &static_output = static_model.call(input);
+    latency.end();
+    latency.print("MnistCoefficientModel", "call");
+
+    printf("Static Result: %s\n", static_output.check_element(model.l5_compress.get_output().get_element_ptr(), 0, false) ? "pass" : "fail");
+
+    // direct conv2d v.s. Winograd F(2x2, 3x3), l1 coefficient with stride 1, cycles are per MAC of the direct one
+    if (nn::winograd_conv2d_supported(*get_l1_filter(), 1, 1))
+    {
+        std::vector<int> output_shape = nn::get_output_shape(input.shape, get_l1_filter()->shape_with_dilation, 1, 1, PADDING_SAME_END, true);
+        std::vector<int> padding = nn::get_pad_size(output_shape, input.shape, get_l1_filter()->shape_with_dilation, 1, 1, PADDING_SAME_END);
+        Tensor<int16_t> direct, winograd;
+        direct.set_exponent(-2).set_shape(output_shape).malloc_element();
+        winograd.set_exponent(-2).set_shape(output_shape).malloc_element();
+        int32_t *transformed = nn::winograd_transform_filter(*get_l1_filter());
+
+        uint32_t cycle = dl::tool::get_cycle();
+        nn::conv2d(direct, input, padding, *get_l1_filter(), 1, 1, get_l1_bias(), get_l1_activation());
+        uint32_t direct_cycle = dl::tool::get_cycle() - cycle;
+
+        cycle = dl::tool::get_cycle();
+        nn::conv2d_winograd(winograd, input, padding, transformed, *get_l1_filter(), get_l1_bias(), get_l1_activation());
+        uint32_t winograd_cycle = dl::tool::get_cycle() - cycle;
+
+        // drift against the direct kernel in LSB
+        int drift = 0;
+        for (int i = 0; i < direct.get_size(); i++)
+            drift = DL_MAX(drift, DL_ABS(direct.element[i] - winograd.element[i]));
+
+        float mac = (float)direct.get_size() * 9 * input.shape[2];
+        printf("Winograd Result: %d LSB at most, direct %.2f cycles/MAC, winograd %.2f cycles/MAC\n", drift, direct_cycle / mac, winograd_cycle / mac);
+        dl::tool::free_aligned(transformed);
+    }
+
     // PC
     // -7175, -9797, -12315, -11419, -12361, -1369, -11728, -113, -11453, 7859
     // Prediction Result: 9
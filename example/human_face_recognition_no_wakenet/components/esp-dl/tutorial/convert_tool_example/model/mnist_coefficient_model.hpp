@@ -0,0 +1,173 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "dl_variable.hpp"
+#include "dl_nn_conv2d.hpp"
+#include "dl_nn_depthwise_conv2d.hpp"
+#include "dl_nn_concat.hpp"
+#include "mnist_coefficient.hpp"
+
+namespace mnist_coefficient
+{
+    /**
+     * @brief Model generated by convert tool with the graph fixed at compile time.
+     *
+     * Shapes, paddings and exponents are constants, activations are placed in a static arena by their
+     * lifetimes. call() uses no heap and needs no build(). Only one object should run at a time, since all
+     * objects share the arena.
+     *
+     * The header is C++11: the arena is a static local of an inline function rather than an inline variable,
+     * so there is one arena however many files include it, and no constant is odr-used.
+     */
+    class MnistCoefficientModel
+    {
+    public:
+        static constexpr int input_height = 28;
+        static constexpr int input_width = 28;
+        static constexpr int input_channel = 3;
+        static constexpr int arena_size = 7136; /*<! elements of arena >*/
+
+        /*<! outputs of the layers in the arena, each valid until a later layer is placed over it >*/
+        dl::Tensor<int16_t> l1;
+        dl::Tensor<int16_t> l2_depth;
+        dl::Tensor<int16_t> l2_compress;
+        dl::Tensor<int16_t> l3_a_depth;
+        dl::Tensor<int16_t> l3_a_compress;
+        dl::Tensor<int16_t> l3_b_depth;
+        dl::Tensor<int16_t> l3_b_compress;
+        dl::Tensor<int16_t> l3_c_depth;
+        dl::Tensor<int16_t> l3_c_compress;
+        dl::Tensor<int16_t> l3_d_depth;
+        dl::Tensor<int16_t> l3_d_compress;
+        dl::Tensor<int16_t> l3_e_depth;
+        dl::Tensor<int16_t> l3_e_compress;
+        dl::Tensor<int16_t> l3_concat;
+        dl::Tensor<int16_t> l4_depth;
+        dl::Tensor<int16_t> l4_compress;
+        dl::Tensor<int16_t> l5_depth;
+        dl::Tensor<int16_t> l5_compress;
+
+    private:
+        static constexpr int l1_offset = 0;
+        static constexpr int l2_depth_offset = 3136;
+        static constexpr int l2_compress_offset = 0;
+        static constexpr int l3_a_depth_offset = 3136;
+        static constexpr int l3_a_compress_offset = 4736;
+        static constexpr int l3_b_depth_offset = 3136;
+        static constexpr int l3_b_compress_offset = 0;
+        static constexpr int l3_c_depth_offset = 800;
+        static constexpr int l3_c_compress_offset = 3200;
+        static constexpr int l3_d_depth_offset = 800;
+        static constexpr int l3_d_compress_offset = 0;
+        static constexpr int l3_e_depth_offset = 800;
+        static constexpr int l3_e_compress_offset = 6336;
+        static constexpr int l3_concat_offset = 0;
+        static constexpr int l4_depth_offset = 3200;
+        static constexpr int l4_compress_offset = 0;
+        static constexpr int l5_depth_offset = 576;
+        static constexpr int l5_compress_offset = 0;
+
+        std::vector<int> l1_padding;
+        std::vector<int> l2_depth_padding;
+        std::vector<int> l2_compress_padding;
+        std::vector<int> l3_a_depth_padding;
+        std::vector<int> l3_a_compress_padding;
+        std::vector<int> l3_b_depth_padding;
+        std::vector<int> l3_b_compress_padding;
+        std::vector<int> l3_c_depth_padding;
+        std::vector<int> l3_c_compress_padding;
+        std::vector<int> l3_d_depth_padding;
+        std::vector<int> l3_d_compress_padding;
+        std::vector<int> l3_e_depth_padding;
+        std::vector<int> l3_e_compress_padding;
+        std::vector<dl::Tensor<int16_t> *> l3_concat_inputs;
+        std::vector<int> l4_depth_padding;
+        std::vector<int> l4_compress_padding;
+        std::vector<int> l5_depth_padding;
+        std::vector<int> l5_compress_padding;
+        std::vector<int> assign_core; /*<! kept, or the default argument would be constructed in each call >*/
+
+    public:
+        /**
+         * @brief Get the arena of all activations.
+         *
+         * @return int16_t* arena_size elements aligned to 16 bytes
+         */
+        static int16_t *get_arena()
+        {
+            alignas(16) static int16_t arena[arena_size];
+            return arena;
+        }
+
+        MnistCoefficientModel() : assign_core(CONFIG_DEFAULT_ASSIGN_CORE)
+        {
+            int16_t *arena = get_arena();
+            this->l1.set_element(arena + l1_offset).set_exponent(-2).set_shape({13, 13, 16}).set_auto_free(false);
+            this->l1_padding = {0, 0, 0, 0};
+            this->l2_depth.set_element(arena + l2_depth_offset).set_exponent(-1).set_shape({7, 7, 16}).set_auto_free(false);
+            this->l2_depth_padding = {1, 1, 1, 1};
+            this->l2_compress.set_element(arena + l2_compress_offset).set_exponent(-3).set_shape({7, 7, 64}).set_auto_free(false);
+            this->l2_compress_padding = {0, 0, 0, 0};
+            this->l3_a_depth.set_element(arena + l3_a_depth_offset).set_exponent(-1).set_shape({5, 5, 64}).set_auto_free(false);
+            this->l3_a_depth_padding = {0, 0, 0, 0};
+            this->l3_a_compress.set_element(arena + l3_a_compress_offset).set_exponent(-12).set_shape({5, 5, 64}).set_auto_free(false);
+            this->l3_a_compress_padding = {0, 0, 0, 0};
+            this->l3_b_depth.set_element(arena + l3_b_depth_offset).set_exponent(-2).set_shape({5, 5, 64}).set_auto_free(false);
+            this->l3_b_depth_padding = {0, 0, 0, 0};
+            this->l3_b_compress.set_element(arena + l3_b_compress_offset).set_exponent(-12).set_shape({5, 5, 32}).set_auto_free(false);
+            this->l3_b_compress_padding = {0, 0, 0, 0};
+            this->l3_c_depth.set_element(arena + l3_c_depth_offset).set_exponent(-12).set_shape({5, 5, 32}).set_auto_free(false);
+            this->l3_c_depth_padding = {1, 1, 1, 1};
+            this->l3_c_compress.set_element(arena + l3_c_compress_offset).set_exponent(-12).set_shape({5, 5, 32}).set_auto_free(false);
+            this->l3_c_compress_padding = {0, 0, 0, 0};
+            this->l3_d_depth.set_element(arena + l3_d_depth_offset).set_exponent(-12).set_shape({5, 5, 32}).set_auto_free(false);
+            this->l3_d_depth_padding = {1, 1, 1, 1};
+            this->l3_d_compress.set_element(arena + l3_d_compress_offset).set_exponent(-11).set_shape({5, 5, 32}).set_auto_free(false);
+            this->l3_d_compress_padding = {0, 0, 0, 0};
+            this->l3_e_depth.set_element(arena + l3_e_depth_offset).set_exponent(-11).set_shape({5, 5, 32}).set_auto_free(false);
+            this->l3_e_depth_padding = {1, 1, 1, 1};
+            this->l3_e_compress.set_element(arena + l3_e_compress_offset).set_exponent(-12).set_shape({5, 5, 32}).set_auto_free(false);
+            this->l3_e_compress_padding = {0, 0, 0, 0};
+            this->l3_concat.set_element(arena + l3_concat_offset).set_exponent(-12).set_shape({5, 5, 128}).set_auto_free(false);
+            this->l3_concat_inputs = {&this->l3_a_compress, &this->l3_c_compress, &this->l3_e_compress};
+            this->l4_depth.set_element(arena + l4_depth_offset).set_exponent(-12).set_shape({3, 3, 128}).set_auto_free(false);
+            this->l4_depth_padding = {0, 0, 0, 0};
+            this->l4_compress.set_element(arena + l4_compress_offset).set_exponent(-11).set_shape({3, 3, 64}).set_auto_free(false);
+            this->l4_compress_padding = {0, 0, 0, 0};
+            this->l5_depth.set_element(arena + l5_depth_offset).set_exponent(-10).set_shape({1, 1, 64}).set_auto_free(false);
+            this->l5_depth_padding = {0, 0, 0, 0};
+            this->l5_compress.set_element(arena + l5_compress_offset).set_exponent(-9).set_shape({1, 1, 10}).set_auto_free(false);
+            this->l5_compress_padding = {0, 0, 0, 0};
+        }
+
+        /**
+         * @brief Run the model.
+         *
+         * @param input [28, 28, 3]
+         * @return dl::Tensor<int16_t>& output of l5_compress, valid until the next call
+         */
+        dl::Tensor<int16_t> &call(dl::Tensor<int16_t> &input)
+        {
+            dl::nn::conv2d(this->l1, input, this->l1_padding, *get_l1_filter(), 2, 2, get_l1_bias(), get_l1_activation(), this->assign_core);
+            dl::nn::depthwise_conv2d(this->l2_depth, this->l1, this->l2_depth_padding, *get_l2_depth_filter(), 2, 2, (const dl::Bias<int16_t> *)NULL, get_l2_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l2_compress, this->l2_depth, this->l2_compress_padding, *get_l2_compress_filter(), 1, 1, get_l2_compress_bias(), NULL, this->assign_core);
+            dl::nn::depthwise_conv2d(this->l3_a_depth, this->l2_compress, this->l3_a_depth_padding, *get_l3_a_depth_filter(), 1, 1, (const dl::Bias<int16_t> *)NULL, get_l3_a_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l3_a_compress, this->l3_a_depth, this->l3_a_compress_padding, *get_l3_a_compress_filter(), 1, 1, get_l3_a_compress_bias(), NULL, this->assign_core);
+            dl::nn::depthwise_conv2d(this->l3_b_depth, this->l2_compress, this->l3_b_depth_padding, *get_l3_b_depth_filter(), 1, 1, (const dl::Bias<int16_t> *)NULL, get_l3_b_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l3_b_compress, this->l3_b_depth, this->l3_b_compress_padding, *get_l3_b_compress_filter(), 1, 1, get_l3_b_compress_bias(), NULL, this->assign_core);
+            dl::nn::depthwise_conv2d(this->l3_c_depth, this->l3_b_compress, this->l3_c_depth_padding, *get_l3_c_depth_filter(), 1, 1, (const dl::Bias<int16_t> *)NULL, get_l3_c_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l3_c_compress, this->l3_c_depth, this->l3_c_compress_padding, *get_l3_c_compress_filter(), 1, 1, get_l3_c_compress_bias(), NULL, this->assign_core);
+            dl::nn::depthwise_conv2d(this->l3_d_depth, this->l3_b_compress, this->l3_d_depth_padding, *get_l3_d_depth_filter(), 1, 1, (const dl::Bias<int16_t> *)NULL, get_l3_d_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l3_d_compress, this->l3_d_depth, this->l3_d_compress_padding, *get_l3_d_compress_filter(), 1, 1, get_l3_d_compress_bias(), NULL, this->assign_core);
+            dl::nn::depthwise_conv2d(this->l3_e_depth, this->l3_d_compress, this->l3_e_depth_padding, *get_l3_e_depth_filter(), 1, 1, (const dl::Bias<int16_t> *)NULL, get_l3_e_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l3_e_compress, this->l3_e_depth, this->l3_e_compress_padding, *get_l3_e_compress_filter(), 1, 1, get_l3_e_compress_bias(), NULL, this->assign_core);
+            dl::nn::concat(this->l3_concat, this->l3_concat_inputs, -1);
+            dl::nn::depthwise_conv2d(this->l4_depth, this->l3_concat, this->l4_depth_padding, *get_l4_depth_filter(), 1, 1, (const dl::Bias<int16_t> *)NULL, get_l4_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l4_compress, this->l4_depth, this->l4_compress_padding, *get_l4_compress_filter(), 1, 1, get_l4_compress_bias(), NULL, this->assign_core);
+            dl::nn::depthwise_conv2d(this->l5_depth, this->l4_compress, this->l5_depth_padding, *get_l5_depth_filter(), 1, 1, (const dl::Bias<int16_t> *)NULL, get_l5_depth_activation(), this->assign_core);
+            dl::nn::conv2d(this->l5_compress, this->l5_depth, this->l5_compress_padding, *get_l5_compress_filter(), 1, 1, get_l5_compress_bias(), NULL, this->assign_core);
+            return this->l5_compress;
+        }
+    };
+} // namespace mnist_coefficient
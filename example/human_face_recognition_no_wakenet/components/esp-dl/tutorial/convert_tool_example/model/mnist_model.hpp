@@ -3,6 +3,8 @@
 #include "dl_layer_conv2d.hpp"
 #include "dl_layer_depthwise_conv2d.hpp"
 #include "dl_layer_concat.hpp"
+#include "dl_layer_memory_planner.hpp"
+#include "dl_layer_weight_placement.hpp"
 #include "mnist_coefficient.hpp"
 #include <stdint.h>
 
@@ -34,6 +36,8 @@ private:
 
 public:
     Conv2D<int16_t> l5_compress; // a layer named l5_compress
+    MemoryPlanner<int16_t> planner; // places all activations into one arena
+    WeightPlacement placement;      // copies filters of the first layers into internal RAM
 
     /**
      * @brief Initialize layers in constructor function
@@ -56,7 +60,27 @@ public:
               l4_depth(DepthwiseConv2D<int16_t>(-12, get_l4_depth_filter(), NULL, get_l4_depth_activation(), PADDING_VALID, {}, 1, 1, "l4_depth")),
               l4_compress(Conv2D<int16_t>(-11, get_l4_compress_filter(), get_l4_compress_bias(), NULL, PADDING_VALID, {}, 1, 1, "l4_compress")),
               l5_depth(DepthwiseConv2D<int16_t>(-10, get_l5_depth_filter(), NULL, get_l5_depth_activation(), PADDING_VALID, {}, 1, 1, "l5_depth")),
-              l5_compress(Conv2D<int16_t>(-9, get_l5_compress_filter(), get_l5_compress_bias(), NULL, PADDING_VALID, {}, 1, 1, "l5_compress")) {}
+              l5_compress(Conv2D<int16_t>(-9, get_l5_compress_filter(), get_l5_compress_bias(), NULL, PADDING_VALID, {}, 1, 1, "l5_compress"))
+    {
+        this->placement.add(get_l1_filter(), "l1");
+        this->placement.add(get_l2_depth_filter(), "l2_depth");
+        this->placement.add(get_l2_compress_filter(), "l2_compress");
+        this->placement.add(get_l3_a_depth_filter(), "l3_a_depth");
+        this->placement.add(get_l3_a_compress_filter(), "l3_a_compress");
+        this->placement.add(get_l3_b_depth_filter(), "l3_b_depth");
+        this->placement.add(get_l3_b_compress_filter(), "l3_b_compress");
+        this->placement.add(get_l3_c_depth_filter(), "l3_c_depth");
+        this->placement.add(get_l3_c_compress_filter(), "l3_c_compress");
+        this->placement.add(get_l3_d_depth_filter(), "l3_d_depth");
+        this->placement.add(get_l3_d_compress_filter(), "l3_d_compress");
+        this->placement.add(get_l3_e_depth_filter(), "l3_e_depth");
+        this->placement.add(get_l3_e_compress_filter(), "l3_e_compress");
+        this->placement.add(get_l4_depth_filter(), "l4_depth");
+        this->placement.add(get_l4_compress_filter(), "l4_compress");
+        this->placement.add(get_l5_depth_filter(), "l5_depth");
+        this->placement.add(get_l5_compress_filter(), "l5_compress");
+        this->placement.place();
+    }
 
     /**
      * @brief call each layers' build(...) function in sequence
@@ -65,24 +89,44 @@ public:
      */
     void build(Tensor<int16_t> &input)
     {
+        this->planner.clear();
         this->l1.build(input);
+        this->planner.record(this->l1.get_output(), {&input});
         this->l2_depth.build(this->l1.get_output());
+        this->planner.record(this->l2_depth.get_output(), {&this->l1.get_output()});
         this->l2_compress.build(this->l2_depth.get_output());
+        this->planner.record(this->l2_compress.get_output(), {&this->l2_depth.get_output()});
         this->l3_a_depth.build(this->l2_compress.get_output());
+        this->planner.record(this->l3_a_depth.get_output(), {&this->l2_compress.get_output()});
         this->l3_a_compress.build(this->l3_a_depth.get_output());
+        this->planner.record(this->l3_a_compress.get_output(), {&this->l3_a_depth.get_output()});
         this->l3_b_depth.build(this->l2_compress.get_output());
+        this->planner.record(this->l3_b_depth.get_output(), {&this->l2_compress.get_output()});
         this->l3_b_compress.build(this->l3_b_depth.get_output());
+        this->planner.record(this->l3_b_compress.get_output(), {&this->l3_b_depth.get_output()});
         this->l3_c_depth.build(this->l3_b_compress.get_output());
+        this->planner.record(this->l3_c_depth.get_output(), {&this->l3_b_compress.get_output()});
         this->l3_c_compress.build(this->l3_c_depth.get_output());
+        this->planner.record(this->l3_c_compress.get_output(), {&this->l3_c_depth.get_output()});
         this->l3_d_depth.build(this->l3_b_compress.get_output());
+        this->planner.record(this->l3_d_depth.get_output(), {&this->l3_b_compress.get_output()});
         this->l3_d_compress.build(this->l3_d_depth.get_output());
+        this->planner.record(this->l3_d_compress.get_output(), {&this->l3_d_depth.get_output()});
         this->l3_e_depth.build(this->l3_d_compress.get_output());
+        this->planner.record(this->l3_e_depth.get_output(), {&this->l3_d_compress.get_output()});
         this->l3_e_compress.build(this->l3_e_depth.get_output());
+        this->planner.record(this->l3_e_compress.get_output(), {&this->l3_e_depth.get_output()});
         this->l3_concat.build({&this->l3_a_compress.get_output(), &this->l3_c_compress.get_output(), &this->l3_e_compress.get_output()});
+        this->planner.record(this->l3_concat.get_output(), {&this->l3_a_compress.get_output(), &this->l3_c_compress.get_output(), &this->l3_e_compress.get_output()});
         this->l4_depth.build(this->l3_concat.get_output());
+        this->planner.record(this->l4_depth.get_output(), {&this->l3_concat.get_output()});
         this->l4_compress.build(this->l4_depth.get_output());
+        this->planner.record(this->l4_compress.get_output(), {&this->l4_depth.get_output()});
         this->l5_depth.build(this->l4_compress.get_output());
+        this->planner.record(this->l5_depth.get_output(), {&this->l4_compress.get_output()});
         this->l5_compress.build(this->l5_depth.get_output());
+        this->planner.record(this->l5_compress.get_output(), {&this->l5_depth.get_output()});
+        this->planner.plan();
     }
 
     /**
@@ -92,53 +136,71 @@ public:
      */
     void call(Tensor<int16_t> &input)
     {
+        DL_PROFILE_MODEL_CALL();
+
+        this->l2_depth.preload();
         this->l1.call(input);
         input.free_element();
 
+        this->l2_compress.preload();
         this->l2_depth.call(this->l1.get_output());
         this->l1.get_output().free_element();
 
+        this->l3_a_depth.preload();
         this->l2_compress.call(this->l2_depth.get_output());
         this->l2_depth.get_output().free_element();
 
+        this->l3_a_compress.preload();
         this->l3_a_depth.call(this->l2_compress.get_output());
         // this->l2_compress.get_output().free_element();
 
+        this->l3_b_depth.preload();
         this->l3_a_compress.call(this->l3_a_depth.get_output());
         this->l3_a_depth.get_output().free_element();
 
+        this->l3_b_compress.preload();
         this->l3_b_depth.call(this->l2_compress.get_output());
         this->l2_compress.get_output().free_element();
 
+        this->l3_c_depth.preload();
         this->l3_b_compress.call(this->l3_b_depth.get_output());
         this->l3_b_depth.get_output().free_element();
 
+        this->l3_c_compress.preload();
         this->l3_c_depth.call(this->l3_b_compress.get_output());
         // this->l3_b_compress.get_output().free_element();
 
+        this->l3_d_depth.preload();
         this->l3_c_compress.call(this->l3_c_depth.get_output());
         this->l3_c_depth.get_output().free_element();
 
+        this->l3_d_compress.preload();
         this->l3_d_depth.call(this->l3_b_compress.get_output());
         this->l3_b_compress.get_output().free_element();
 
+        this->l3_e_depth.preload();
         this->l3_d_compress.call(this->l3_d_depth.get_output());
         this->l3_d_depth.get_output().free_element();
 
+        this->l3_e_compress.preload();
         this->l3_e_depth.call(this->l3_d_compress.get_output());
         this->l3_d_compress.get_output().free_element();
 
+        this->l4_depth.preload();
         this->l3_e_compress.call(this->l3_e_depth.get_output());
         this->l3_e_depth.get_output().free_element();
 
         this->l3_concat.call({&this->l3_a_compress.get_output(), &this->l3_c_compress.get_output(), &this->l3_e_compress.get_output()}, true);
                 
+        this->l4_compress.preload();
         this->l4_depth.call(this->l3_concat.get_output());
         this->l3_concat.get_output().free_element();
 
+        this->l5_depth.preload();
         this->l4_compress.call(this->l4_depth.get_output());
         this->l4_depth.get_output().free_element();
 
+        this->l5_compress.preload();
         this->l5_depth.call(this->l4_compress.get_output());
         this->l4_compress.get_output().free_element();
 
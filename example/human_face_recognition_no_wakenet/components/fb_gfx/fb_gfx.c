@@ -16,6 +16,7 @@
 #include "string.h"
 #include "stdio.h"
 #include "stdlib.h"
+#include "stdbool.h"
 #include "fb_gfx.h"
 
 typedef struct
@@ -51,10 +52,11 @@ void fb_gfx_fillRect(camera_fb_t *fb, int32_t x, int32_t y, int32_t w, int32_t h
         break;
     case PIXFORMAT_RGB888:
         bytes_per_pixel = 3;
+        break;
     default:
         break;
     }
-    int32_t line_step = (fb->width - w) * 3;
+    int32_t line_step = (fb->width - w) * bytes_per_pixel;
     uint8_t *data = fb->buf + ((x + (y * fb->width)) * bytes_per_pixel);
     uint8_t c0 = color >> 16;
     uint8_t c1 = color >> 8;
@@ -97,8 +99,105 @@ void fb_gfx_drawFastVLine(camera_fb_t *fb, int32_t x, int32_t y, int32_t h, uint
     fb_gfx_fillRect(fb, x, y, 1, h, color);
 }
 
+static fb_gfx_span_t *glyph_spans = NULL;
+static uint16_t glyph_span_start[0x100];
+
+// runs of set bits of each glyph, relative to the cursor, found once instead of per drawn character
+static bool build_glyph_spans(void)
+{
+    fb_gfx_span_t *spans = NULL;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        int n = 0;
+        for (int c = gfxFont->first; c <= gfxFont->last + 1; c++)
+        {
+            glyph_span_start[c] = n;
+            if (c > gfxFont->last)
+                break;
+
+            GFXglyph *glyph = &(gfxFont->glyph[c - gfxFont->first]);
+            uint8_t *bitmap = gfxFont->bitmap + glyph->bitmapOffset;
+            uint8_t bit = 0, bits = 0;
+            for (int yy = 0; yy < glyph->height; yy++)
+            {
+                int start = -1;
+                for (int xx = 0; xx <= glyph->width; xx++)
+                {
+                    bool set = false;
+                    if (xx < glyph->width)
+                    {
+                        if (bit == 0)
+                        {
+                            bits = *bitmap++;
+                            bit = 0x80;
+                        }
+                        set = bits & bit;
+                        bit >>= 1;
+                    }
+                    if (set && start < 0)
+                    {
+                        start = xx;
+                    }
+                    else if (!set && start >= 0)
+                    {
+                        if (spans)
+                        {
+                            spans[n].x = glyph->xOffset + start;
+                            spans[n].y = glyph->yOffset + gfxFont->yOffset + yy;
+                            spans[n].width = xx - start;
+                        }
+                        n++;
+                        start = -1;
+                    }
+                }
+            }
+        }
+
+        if (pass == 0)
+        {
+            spans = (fb_gfx_span_t *)malloc(n * sizeof(fb_gfx_span_t));
+            if (spans == NULL)
+                return false;
+        }
+    }
+
+    // published only when complete
+    glyph_spans = spans;
+    return true;
+}
+
+const fb_gfx_span_t *fb_gfx_get_spans(unsigned char c, uint16_t *num, uint8_t *advance)
+{
+    *num = 0;
+    *advance = 0;
+    if ((c < 32) || (c < gfxFont->first) || (c > gfxFont->last))
+        return NULL;
+
+    if (glyph_spans == NULL && !build_glyph_spans())
+        return NULL;
+
+    *num = glyph_span_start[c + 1] - glyph_span_start[c];
+    *advance = gfxFont->glyph[c - gfxFont->first].xAdvance;
+    return glyph_spans + glyph_span_start[c];
+}
+
+uint8_t fb_gfx_get_line_height(void)
+{
+    return gfxFont->yAdvance;
+}
+
 uint8_t fb_gfx_putc(camera_fb_t *fb, int32_t x, int32_t y, uint32_t color, unsigned char c)
 {
+    uint16_t num;
+    uint8_t advance;
+    const fb_gfx_span_t *spans = fb_gfx_get_spans(c, &num, &advance);
+    if (spans)
+    {
+        for (int i = 0; i < num; i++)
+            fb_gfx_drawFastHLine(fb, x + spans[i].x, y + spans[i].y, spans[i].width, color);
+        return advance;
+    }
+
     uint16_t line_width;
     uint8_t xa = 0, bit = 0, bits = 0, xx, yy;
     uint8_t *bitmap;
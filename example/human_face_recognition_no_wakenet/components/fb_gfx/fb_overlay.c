@@ -0,0 +1,378 @@
+// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "stdint.h"
+#include "stdarg.h"
+#include "string.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "freertos/FreeRTOS.h"
+#include "fb_gfx.h"
+#include "fb_overlay.h"
+
+#define OVERLAY_FILL 0
+#define OVERLAY_TEXT 1
+
+typedef struct
+{
+    uint8_t type;
+    uint16_t color;
+    int16_t x1, y1, x2, y2; // pixels covered, inclusive
+    int16_t x, y;           // cursor of text
+    uint16_t text, length;  // text in pool
+} overlay_op_t;
+
+typedef struct
+{
+    overlay_op_t *ops;
+    int num;
+    char *text;
+    int text_len;
+    int16_t y1, y2; // rows covered by all ops, y1 > y2 if empty
+} overlay_list_t;
+
+struct fb_overlay
+{
+    overlay_list_t lists[3];
+    int max_ops;
+    int max_text;
+    int writing; // filled by producer
+    int ready;   // latest committed
+    int reading; // drawn by consumer
+    bool fresh;  // ready is newer than reading
+    portMUX_TYPE lock;
+};
+
+static inline int16_t clamp16(int32_t value)
+{
+    return value < INT16_MIN ? INT16_MIN : (value > INT16_MAX ? INT16_MAX : value);
+}
+
+static void list_reset(overlay_list_t *list)
+{
+    list->num = 0;
+    list->text_len = 0;
+    list->y1 = INT16_MAX;
+    list->y2 = INT16_MIN;
+}
+
+static overlay_op_t *list_add(fb_overlay_t *overlay, uint8_t type, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color)
+{
+    if (overlay == NULL)
+        return NULL;
+
+    overlay_list_t *list = &overlay->lists[overlay->writing];
+    if (list->num >= overlay->max_ops || x1 > x2 || y1 > y2)
+        return NULL;
+
+    overlay_op_t *op = &list->ops[list->num++];
+    op->type = type;
+    op->color = color;
+    op->x1 = clamp16(x1);
+    op->y1 = clamp16(y1);
+    op->x2 = clamp16(x2);
+    op->y2 = clamp16(y2);
+    if (op->y1 < list->y1)
+        list->y1 = op->y1;
+    if (op->y2 > list->y2)
+        list->y2 = op->y2;
+    return op;
+}
+
+fb_overlay_t *fb_overlay_create(int max_ops, int max_text)
+{
+    fb_overlay_t *overlay = (fb_overlay_t *)calloc(1, sizeof(fb_overlay_t));
+    if (overlay == NULL)
+        return NULL;
+
+    overlay->max_ops = max_ops;
+    overlay->max_text = max_text;
+    for (int i = 0; i < 3; i++)
+    {
+        overlay->lists[i].ops = (overlay_op_t *)malloc(max_ops * sizeof(overlay_op_t));
+        overlay->lists[i].text = (char *)malloc(max_text > 0 ? max_text : 1); // malloc(0) may give NULL
+        if (overlay->lists[i].ops == NULL || overlay->lists[i].text == NULL)
+        {
+            fb_overlay_destroy(overlay);
+            return NULL;
+        }
+        list_reset(&overlay->lists[i]);
+    }
+    overlay->writing = 0;
+    overlay->ready = 1;
+    overlay->reading = 2;
+    overlay->fresh = false;
+    portMUX_INITIALIZE(&overlay->lock);
+
+    // glyph runs are built here rather than by the first text drawn
+    uint16_t num;
+    uint8_t advance;
+    fb_gfx_get_spans(' ', &num, &advance);
+    return overlay;
+}
+
+void fb_overlay_destroy(fb_overlay_t *overlay)
+{
+    if (overlay == NULL)
+        return;
+
+    for (int i = 0; i < 3; i++)
+    {
+        free(overlay->lists[i].ops);
+        free(overlay->lists[i].text);
+    }
+    free(overlay);
+}
+
+void fb_overlay_begin(fb_overlay_t *overlay)
+{
+    if (overlay == NULL)
+        return;
+    list_reset(&overlay->lists[overlay->writing]);
+}
+
+void fb_overlay_fill(fb_overlay_t *overlay, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color)
+{
+    list_add(overlay, OVERLAY_FILL, x1, y1, x2, y2, color);
+}
+
+void fb_overlay_box(fb_overlay_t *overlay, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color, uint8_t thickness)
+{
+    // a hollow box is four filled bars, the sides are left out of the rows of top and bottom
+    int32_t t = thickness ? thickness : 1;
+    if (x2 - x1 + 1 <= 2 * t || y2 - y1 + 1 <= 2 * t)
+    {
+        list_add(overlay, OVERLAY_FILL, x1, y1, x2, y2, color);
+        return;
+    }
+    list_add(overlay, OVERLAY_FILL, x1, y1, x2, y1 + t - 1, color);
+    list_add(overlay, OVERLAY_FILL, x1, y2 - t + 1, x2, y2, color);
+    list_add(overlay, OVERLAY_FILL, x1, y1 + t, x1 + t - 1, y2 - t, color);
+    list_add(overlay, OVERLAY_FILL, x2 - t + 1, y1 + t, x2, y2 - t, color);
+}
+
+void fb_overlay_point(fb_overlay_t *overlay, int32_t x, int32_t y, uint8_t size, uint16_t color)
+{
+    int32_t half = size >> 1;
+    list_add(overlay, OVERLAY_FILL, x - half, y - half, x - half + size - 1, y - half + size - 1, color);
+}
+
+// bounds of text drawn from cursor (x, y), the same layout as draw_text()
+static bool text_bounds(const char *str, int length, int32_t x, int32_t y, int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2)
+{
+    int32_t cx = x, cy = y;
+    uint8_t line_height = fb_gfx_get_line_height();
+    *x1 = *y1 = INT32_MAX;
+    *x2 = *y2 = INT32_MIN;
+    for (int i = 0; i < length; i++)
+    {
+        if (str[i] == '\n')
+        {
+            cx = x;
+            cy += line_height;
+            continue;
+        }
+
+        uint16_t num;
+        uint8_t advance;
+        const fb_gfx_span_t *spans = fb_gfx_get_spans(str[i], &num, &advance);
+        for (int j = 0; j < num; j++)
+        {
+            int32_t sx = cx + spans[j].x, sy = cy + spans[j].y;
+            if (sx < *x1)
+                *x1 = sx;
+            if (sx + spans[j].width - 1 > *x2)
+                *x2 = sx + spans[j].width - 1;
+            if (sy < *y1)
+                *y1 = sy;
+            if (sy > *y2)
+                *y2 = sy;
+        }
+        cx += advance;
+    }
+    return *x1 <= *x2;
+}
+
+static uint32_t add_text(fb_overlay_t *overlay, int32_t x, int32_t y, uint16_t color, int start, int length)
+{
+    overlay_list_t *list = &overlay->lists[overlay->writing];
+    int32_t x1, y1, x2, y2;
+    if (text_bounds(list->text + start, length, x, y, &x1, &y1, &x2, &y2))
+    {
+        overlay_op_t *op = list_add(overlay, OVERLAY_TEXT, x1, y1, x2, y2, color);
+        if (op)
+        {
+            op->x = clamp16(x);
+            op->y = clamp16(y);
+            op->text = start;
+            op->length = length;
+            list->text_len = start + length;
+            return length;
+        }
+    }
+    return 0;
+}
+
+uint32_t fb_overlay_print(fb_overlay_t *overlay, int32_t x, int32_t y, uint16_t color, const char *str)
+{
+    // text beyond the pool is cut
+    if (overlay == NULL)
+        return 0;
+    overlay_list_t *list = &overlay->lists[overlay->writing];
+    int start = list->text_len;
+    int length = strlen(str);
+    if (length > overlay->max_text - start)
+        length = overlay->max_text - start;
+    memcpy(list->text + start, str, length);
+    return add_text(overlay, x, y, color, start, length);
+}
+
+uint32_t fb_overlay_printf(fb_overlay_t *overlay, int32_t x, int32_t y, uint16_t color, const char *format, ...)
+{
+    // formatted into the pool at once, text beyond it is cut
+    if (overlay == NULL)
+        return 0;
+    overlay_list_t *list = &overlay->lists[overlay->writing];
+    int start = list->text_len;
+    int space = overlay->max_text - start;
+    if (space <= 0)
+        return 0;
+
+    va_list arg;
+    va_start(arg, format);
+    int length = vsnprintf(list->text + start, space, format, arg);
+    va_end(arg);
+    if (length < 0)
+        return 0;
+    if (length > space - 1)
+        length = space - 1;
+    return add_text(overlay, x, y, color, start, length);
+}
+
+void fb_overlay_commit(fb_overlay_t *overlay)
+{
+    if (overlay == NULL)
+        return;
+
+    portENTER_CRITICAL(&overlay->lock);
+    int ready = overlay->ready;
+    overlay->ready = overlay->writing;
+    overlay->writing = ready;
+    overlay->fresh = true;
+    portEXIT_CRITICAL(&overlay->lock);
+}
+
+bool fb_overlay_latch(fb_overlay_t *overlay)
+{
+    if (overlay == NULL)
+        return false;
+
+    bool fresh;
+    portENTER_CRITICAL(&overlay->lock);
+    fresh = overlay->fresh;
+    if (fresh)
+    {
+        int ready = overlay->ready;
+        overlay->ready = overlay->reading;
+        overlay->reading = ready;
+        overlay->fresh = false;
+    }
+    portEXIT_CRITICAL(&overlay->lock);
+    return fresh;
+}
+
+bool fb_overlay_touches(const fb_overlay_t *overlay, int32_t y1, int32_t y2)
+{
+    if (overlay == NULL)
+        return false;
+
+    const overlay_list_t *list = &overlay->lists[overlay->reading];
+    return list->num && list->y1 <= y2 && list->y2 >= y1;
+}
+
+static inline void fill_run(uint16_t *pixel, int32_t n, uint16_t color)
+{
+    while (n--)
+        *pixel++ = color;
+}
+
+static void draw_text(const overlay_list_t *list, const overlay_op_t *op, uint16_t *rows, int32_t width, int32_t y1, int32_t y2)
+{
+    int32_t cx = op->x, cy = op->y;
+    uint8_t line_height = fb_gfx_get_line_height();
+    const char *str = list->text + op->text;
+    for (int i = 0; i < op->length; i++)
+    {
+        if (str[i] == '\n')
+        {
+            cx = op->x;
+            cy += line_height;
+            continue;
+        }
+
+        uint16_t num;
+        uint8_t advance;
+        const fb_gfx_span_t *spans = fb_gfx_get_spans(str[i], &num, &advance);
+        for (int j = 0; j < num; j++)
+        {
+            int32_t sy = cy + spans[j].y;
+            if (sy < y1 || sy > y2)
+                continue;
+
+            int32_t sx1 = cx + spans[j].x;
+            int32_t sx2 = sx1 + spans[j].width - 1;
+            if (sx1 < 0)
+                sx1 = 0;
+            if (sx2 > width - 1)
+                sx2 = width - 1;
+            if (sx1 <= sx2)
+                fill_run(rows + (sy - y1) * width + sx1, sx2 - sx1 + 1, op->color);
+        }
+        cx += advance;
+    }
+}
+
+// rows holds the rows [y1, y2] of a frame of width, ops are clipped to them
+void fb_overlay_draw(const fb_overlay_t *overlay, uint16_t *rows, int32_t width, int32_t y1, int32_t y2)
+{
+    if (overlay == NULL)
+        return;
+
+    const overlay_list_t *list = &overlay->lists[overlay->reading];
+    for (int i = 0; i < list->num; i++)
+    {
+        const overlay_op_t *op = &list->ops[i];
+        if (op->y2 < y1 || op->y1 > y2 || op->x2 < 0 || op->x1 >= width)
+            continue;
+
+        if (op->type == OVERLAY_TEXT)
+        {
+            draw_text(list, op, rows, width, y1, y2);
+            continue;
+        }
+
+        int32_t ry1 = op->y1 > y1 ? op->y1 : y1;
+        int32_t ry2 = op->y2 < y2 ? op->y2 : y2;
+        int32_t rx1 = op->x1 > 0 ? op->x1 : 0;
+        int32_t rx2 = op->x2 < width - 1 ? op->x2 : width - 1;
+        for (int32_t y = ry1; y <= ry2; y++)
+            fill_run(rows + (y - y1) * width + rx1, rx2 - rx1 + 1, op->color);
+    }
+}
+
+void fb_overlay_apply(const fb_overlay_t *overlay, camera_fb_t *fb)
+{
+    if (overlay == NULL || fb->format != PIXFORMAT_RGB565)
+        return;
+    fb_overlay_draw(overlay, (uint16_t *)fb->buf, fb->width, 0, fb->height - 1);
+}
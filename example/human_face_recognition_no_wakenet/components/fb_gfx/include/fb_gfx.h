@@ -31,6 +31,12 @@ extern "C" {
     //         uint8_t * data;
     // } fb_data_t;
 
+    typedef struct {
+            int8_t x;      // from cursor to the first pixel
+            int8_t y;      // from cursor to the row
+            uint8_t width; // pixels in the run
+    } fb_gfx_span_t;
+
     void     fb_gfx_fillRect     (camera_fb_t *fb, int32_t x, int32_t y, int32_t w, int32_t h, uint32_t color);
     void     fb_gfx_drawFastHLine(camera_fb_t *fb, int32_t x, int32_t y, int32_t w, uint32_t color);
     void     fb_gfx_drawFastVLine(camera_fb_t *fb, int32_t x, int32_t y, int32_t h, uint32_t color);
@@ -38,6 +44,10 @@ extern "C" {
     uint32_t fb_gfx_print        (camera_fb_t *fb, int32_t x, int32_t y, uint32_t color, const char * str);
     uint32_t fb_gfx_printf       (camera_fb_t *fb, int32_t x, int32_t y, uint32_t color, const char *format, ...);
 
+    // horizontal runs of a glyph, built once from the font. NULL for characters out of the font
+    const fb_gfx_span_t *fb_gfx_get_spans(unsigned char c, uint16_t *num, uint8_t *advance);
+    uint8_t  fb_gfx_get_line_height(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,60 @@
+// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef _FB_OVERLAY_H_
+#define _FB_OVERLAY_H_
+#include <stdbool.h>
+#include "esp_camera.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    // A deferred draw list for RGB565 frames.
+    //
+    // The producer, e.g., an AI task, records boxes, points and text between fb_overlay_begin() and
+    // fb_overlay_commit() instead of drawing into the camera buffer. The consumer, e.g., the display, calls
+    // fb_overlay_latch() once per frame to take the latest committed list, then draws it into its own copy of any rows
+    // by fb_overlay_draw(). Lists are triple buffered, so neither side waits for the other, and a list stays shown
+    // until the next commit. One producer and one consumer per overlay.
+    //
+    // Colors are RGB565 as stored in the frame, the same as dl::image::draw_*(). Text uses the font of fb_gfx from
+    // pre-rasterised horizontal runs, nothing is allocated while recording or drawing.
+    //
+    // max_text may be 0 for an overlay without text. Every call takes a NULL overlay, e.g., one whose creation failed,
+    // and does nothing.
+    typedef struct fb_overlay fb_overlay_t;
+
+    fb_overlay_t *fb_overlay_create  (int max_ops, int max_text);
+    void          fb_overlay_destroy (fb_overlay_t *overlay);
+
+    // producer
+    void     fb_overlay_begin    (fb_overlay_t *overlay);
+    void     fb_overlay_fill     (fb_overlay_t *overlay, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color);
+    void     fb_overlay_box      (fb_overlay_t *overlay, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t color, uint8_t thickness);
+    void     fb_overlay_point    (fb_overlay_t *overlay, int32_t x, int32_t y, uint8_t size, uint16_t color);
+    uint32_t fb_overlay_print    (fb_overlay_t *overlay, int32_t x, int32_t y, uint16_t color, const char *str);
+    uint32_t fb_overlay_printf   (fb_overlay_t *overlay, int32_t x, int32_t y, uint16_t color, const char *format, ...);
+    void     fb_overlay_commit   (fb_overlay_t *overlay);
+
+    // consumer
+    bool     fb_overlay_latch    (fb_overlay_t *overlay);
+    bool     fb_overlay_touches  (const fb_overlay_t *overlay, int32_t y1, int32_t y2);
+    void     fb_overlay_draw     (const fb_overlay_t *overlay, uint16_t *rows, int32_t width, int32_t y1, int32_t y2);
+    void     fb_overlay_apply    (const fb_overlay_t *overlay, camera_fb_t *fb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FB_OVERLAY_H_ */
@@ -40,6 +40,28 @@ void draw_detection_result(uint16_t *image_ptr, int image_height, int image_widt
     }
 }
 
+void draw_detection_result(fb_overlay_t *overlay, std::list<dl::detect::result_t> &results)
+{
+    for (auto &prediction : results)
+    {
+        fb_overlay_box(overlay,
+                       DL_MAX(prediction.box[0], 0),
+                       DL_MAX(prediction.box[1], 0),
+                       DL_MAX(prediction.box[2], 0),
+                       DL_MAX(prediction.box[3], 0),
+                       0b1110000000000111, 2);
+
+        if (prediction.keypoint.size() == 10)
+        {
+            fb_overlay_point(overlay, DL_MAX(prediction.keypoint[0], 0), DL_MAX(prediction.keypoint[1], 0), 4, 0b0000000011111000); // left eye
+            fb_overlay_point(overlay, DL_MAX(prediction.keypoint[2], 0), DL_MAX(prediction.keypoint[3], 0), 4, 0b0000000011111000); // mouth left corner
+            fb_overlay_point(overlay, DL_MAX(prediction.keypoint[4], 0), DL_MAX(prediction.keypoint[5], 0), 4, 0b1110000000000111); // nose
+            fb_overlay_point(overlay, DL_MAX(prediction.keypoint[6], 0), DL_MAX(prediction.keypoint[7], 0), 4, 0b0001111100000000); // right eye
+            fb_overlay_point(overlay, DL_MAX(prediction.keypoint[8], 0), DL_MAX(prediction.keypoint[9], 0), 4, 0b0001111100000000); // mouth right corner
+        }
+    }
+}
+
 void draw_detection_result(uint8_t *image_ptr, int image_height, int image_width, std::list<dl::detect::result_t> &results)
 {
     int i = 0;
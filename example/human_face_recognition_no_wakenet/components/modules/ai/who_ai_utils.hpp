@@ -3,6 +3,7 @@
 #include <list>
 #include "dl_detect_define.hpp"
 #include "esp_camera.h"
+#include "fb_overlay.h"
 
 /**
  * @brief Draw detection result on RGB565 image.
@@ -25,6 +26,14 @@ void draw_detection_result(uint16_t *image_ptr, int image_height, int image_widt
 
 void draw_detection_result(uint8_t *image_ptr, int image_height, int image_width, std::list<dl::detect::result_t> &results);
 
+/**
+ * @brief Record detection result in an overlay, drawn later on RGB565 image by its consumer.
+ * 
+ * @param overlay       overlay between fb_overlay_begin() and fb_overlay_commit()
+ * @param results       detection results
+ */
+void draw_detection_result(fb_overlay_t *overlay, std::list<dl::detect::result_t> &results);
+
 /**
  * @brief Print detection result in terminal
  * 
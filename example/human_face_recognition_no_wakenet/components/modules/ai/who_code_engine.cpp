@@ -0,0 +1,348 @@
+#include "who_code_engine.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "dl_image.hpp"
+
+#define FRAME_SCAN_RATIO 0.6f // regions covering more of the frame are scanned as the whole frame
+
+CodeEngine::CodeEngine(const int height,
+                       const int width,
+                       const int block_size,
+                       const int contrast_threshold,
+                       const int edge_threshold,
+                       const int edge_count,
+                       const int motion_threshold,
+                       const int rescan_frames,
+                       const int hold_frames,
+                       const int max_regions) : height(height),
+                                                width(width),
+                                                block_size(block_size),
+                                                contrast_threshold(contrast_threshold),
+                                                edge_threshold(edge_threshold),
+                                                edge_count(edge_count),
+                                                motion_threshold(motion_threshold),
+                                                rescan_frames(rescan_frames),
+                                                hold_frames(hold_frames),
+                                                max_regions(max_regions),
+                                                frame_index(0)
+{
+    this->map_height = (height + block_size - 1) / block_size;
+    this->map_width = (width + block_size - 1) / block_size;
+
+    this->luma = (uint8_t *)malloc(height * width);
+    this->crop = (uint8_t *)malloc(height * width);
+    this->scanner = esp_code_scanner_create();
+
+    int size = this->map_height * this->map_width;
+    this->minimum.resize(size);
+    this->maximum.resize(size);
+    this->edges.resize(size);
+    this->mean.resize(size);
+    this->reference.resize(size, 0);
+    this->scanned.resize(size, (uint32_t)0 - rescan_frames); // every block is due on the first frame
+    this->candidate.resize(size);
+    this->stack.reserve(size);
+
+    memset(&this->stats, 0, sizeof(code_stats_t));
+}
+
+CodeEngine::~CodeEngine()
+{
+    if (this->scanner)
+        esp_code_scanner_destroy(this->scanner);
+    free(this->luma);
+    free(this->crop);
+}
+
+int CodeEngine::load(uint16_t *frame)
+{
+    this->frame_index++;
+    this->stats.frames++;
+
+    std::fill(this->minimum.begin(), this->minimum.end(), 255);
+    std::fill(this->maximum.begin(), this->maximum.end(), 0);
+    std::fill(this->edges.begin(), this->edges.end(), 0);
+
+    // luma and block statistics in one pass, sums of a row of blocks are kept until its last row
+    std::vector<int> sum(this->map_width);
+    for (int by = 0; by < this->map_height; by++)
+    {
+        int y1 = by * this->block_size;
+        int y2 = DL_MIN(y1 + this->block_size, this->height);
+        int map_row = by * this->map_width;
+        std::fill(sum.begin(), sum.end(), 0);
+
+        for (int y = y1; y < y2; y++)
+        {
+            uint16_t *pixel = frame + y * this->width;
+            uint8_t *l = this->luma + y * this->width;
+            int previous = dl::image::convert_pixel_rgb565_to_gray(pixel[0]);
+            for (int bx = 0; bx < this->map_width; bx++)
+            {
+                int x1 = bx * this->block_size;
+                int x2 = DL_MIN(x1 + this->block_size, this->width);
+                int low = this->minimum[map_row + bx];
+                int high = this->maximum[map_row + bx];
+                int edge = 0;
+                int total = 0;
+                for (int x = x1; x < x2; x++)
+                {
+                    int value = dl::image::convert_pixel_rgb565_to_gray(pixel[x]);
+                    l[x] = value;
+                    total += value;
+                    low = DL_MIN(low, value);
+                    high = DL_MAX(high, value);
+                    if (DL_ABS(value - previous) > this->edge_threshold)
+                        edge++;
+                    previous = value;
+                }
+                this->minimum[map_row + bx] = low;
+                this->maximum[map_row + bx] = high;
+                this->edges[map_row + bx] += edge;
+                sum[bx] += total;
+            }
+        }
+
+        for (int bx = 0; bx < this->map_width; bx++)
+        {
+            int x1 = bx * this->block_size;
+            int x2 = DL_MIN(x1 + this->block_size, this->width);
+            int i = map_row + bx;
+            this->mean[i] = sum[bx] / ((y2 - y1) * (x2 - x1));
+
+            // modules of a code are sharp dark and light bars, flat or smooth blocks are skipped
+            this->candidate[i] = (this->maximum[i] - this->minimum[i] >= this->contrast_threshold) && (this->edges[i] >= this->edge_count);
+        }
+    }
+
+    this->label_regions();
+    return this->regions.size();
+}
+
+void CodeEngine::label_regions()
+{
+    this->blocks.clear();
+    this->regions.clear();
+
+    // connected candidates, 8 neighbors, labeled by flood fill and cleared on the way
+    std::vector<uint8_t> &map = this->candidate;
+    for (int start = 0; start < this->map_height * this->map_width; start++)
+    {
+        if (!map[start])
+            continue;
+
+        std::vector<int> block = {this->map_width, this->map_height, -1, -1, 0};
+        map[start] = 0;
+        this->stack.clear();
+        this->stack.push_back(start);
+        while (!this->stack.empty())
+        {
+            int i = this->stack.back();
+            this->stack.pop_back();
+            int x = i % this->map_width, y = i / this->map_width;
+            block[0] = DL_MIN(block[0], x);
+            block[1] = DL_MIN(block[1], y);
+            block[2] = DL_MAX(block[2], x);
+            block[3] = DL_MAX(block[3], y);
+            block[4]++;
+
+            for (int ny = DL_MAX(y - 1, 0); ny <= DL_MIN(y + 1, this->map_height - 1); ny++)
+            {
+                for (int nx = DL_MAX(x - 1, 0); nx <= DL_MIN(x + 1, this->map_width - 1); nx++)
+                {
+                    int n = ny * this->map_width + nx;
+                    if (map[n])
+                    {
+                        map[n] = 0;
+                        this->stack.push_back(n);
+                    }
+                }
+            }
+        }
+
+        // a lone block is an edge or text rather than a code
+        if (block[4] < 2)
+            continue;
+
+        // the quiet zone around a code
+        block[0] = DL_MAX(block[0] - 1, 0);
+        block[1] = DL_MAX(block[1] - 1, 0);
+        block[2] = DL_MIN(block[2] + 1, this->map_width - 1);
+        block[3] = DL_MIN(block[3] + 1, this->map_height - 1);
+        this->blocks.push_back(block);
+    }
+
+    // grown regions overlapping each other are one code cut by a smooth part
+    for (bool merged = true; merged;)
+    {
+        merged = false;
+        for (int i = 0; i < this->blocks.size() && !merged; i++)
+        {
+            for (int j = i + 1; j < this->blocks.size(); j++)
+            {
+                std::vector<int> &a = this->blocks[i], &b = this->blocks[j];
+                if (a[0] > b[2] || b[0] > a[2] || a[1] > b[3] || b[1] > a[3])
+                    continue;
+
+                a[0] = DL_MIN(a[0], b[0]);
+                a[1] = DL_MIN(a[1], b[1]);
+                a[2] = DL_MAX(a[2], b[2]);
+                a[3] = DL_MAX(a[3], b[3]);
+                a[4] += b[4];
+                this->blocks.erase(this->blocks.begin() + j);
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    std::sort(this->blocks.begin(), this->blocks.end(), [](const std::vector<int> &a, const std::vector<int> &b)
+              { return a[4] > b[4]; });
+
+    int area = 0;
+    std::vector<std::vector<int>> selected;
+    for (auto &block : this->blocks)
+    {
+        if (selected.size() >= this->max_regions)
+            break;
+        if (!this->select_region(block))
+            continue;
+
+        selected.push_back(block);
+        area += (block[2] - block[0] + 1) * (block[3] - block[1] + 1);
+    }
+    this->blocks.swap(selected);
+
+    // one scan of the frame is cheaper than crops covering most of it
+    if (area > FRAME_SCAN_RATIO * this->map_height * this->map_width)
+        this->blocks = {{0, 0, this->map_width - 1, this->map_height - 1, area}};
+
+    for (auto &block : this->blocks)
+    {
+        this->regions.push_back({block[0] * this->block_size,
+                                 block[1] * this->block_size,
+                                 DL_MIN((block[2] + 1) * this->block_size, this->width) - 1,
+                                 DL_MIN((block[3] + 1) * this->block_size, this->height) - 1});
+    }
+}
+
+bool CodeEngine::select_region(const std::vector<int> &block)
+{
+    // a still region is scanned again only once in a while, it gave the same result last time
+    for (int y = block[1]; y <= block[3]; y++)
+    {
+        for (int x = block[0]; x <= block[2]; x++)
+        {
+            int i = y * this->map_width + x;
+            if (DL_ABS(this->mean[i] - this->reference[i]) > this->motion_threshold)
+                return true;
+            if (this->frame_index - this->scanned[i] >= this->rescan_frames)
+                return true;
+        }
+    }
+    return false;
+}
+
+std::vector<code_result_t> &CodeEngine::scan()
+{
+    this->results.clear();
+
+    for (int r = 0; r < this->regions.size(); r++)
+    {
+        std::vector<int> &block = this->blocks[r];
+        for (int y = block[1]; y <= block[3]; y++)
+        {
+            for (int x = block[0]; x <= block[2]; x++)
+            {
+                int i = y * this->map_width + x;
+                this->reference[i] = this->mean[i];
+                this->scanned[i] = this->frame_index;
+            }
+        }
+
+        this->scan_region(this->regions[r]);
+    }
+
+    // forget data not seen for hold_frames
+    this->seen.erase(std::remove_if(this->seen.begin(), this->seen.end(), [this](const seen_t &item)
+                                    { return this->frame_index - item.last_frame > this->hold_frames; }),
+                     this->seen.end());
+
+    return this->results;
+}
+
+void CodeEngine::scan_region(const std::vector<int> &region)
+{
+    if (this->scanner == NULL || this->luma == NULL || this->crop == NULL)
+        return;
+
+    int crop_width = region[2] - region[0] + 1;
+    int crop_height = region[3] - region[1] + 1;
+
+    // rows of the full width are already contiguous
+    uint8_t *image = this->luma + region[1] * this->width;
+    if (crop_width < this->width)
+    {
+        image = this->crop;
+        for (int y = 0; y < crop_height; y++)
+            memcpy(image + y * crop_width, this->luma + (region[1] + y) * this->width + region[0], crop_width);
+    }
+
+    esp_code_scanner_config_t config = {ESP_CODE_SCANNER_MODE_FAST, ESP_CODE_SCANNER_IMAGE_GRAY, (uint32_t)crop_width, (uint32_t)crop_height};
+    if (esp_code_scanner_set_config(this->scanner, config) != ESP_OK)
+        return;
+
+    int decoded = esp_code_scanner_scan_image(this->scanner, image);
+    this->stats.scans++;
+    this->stats.pixels += crop_width * crop_height;
+    if (decoded <= 0)
+        return;
+
+    esp_code_scanner_symbol_t symbol = esp_code_scanner_result(this->scanner);
+    for (int i = 0; i < decoded; i++)
+    {
+        if (symbol.data)
+        {
+            code_result_t result;
+            result.type = symbol.type_name ? symbol.type_name : "";
+            result.data.assign(symbol.data, symbol.datalen);
+            memcpy(result.box, region.data(), sizeof(result.box));
+            result.repeated = false;
+
+            auto item = std::find_if(this->seen.begin(), this->seen.end(), [&result](const seen_t &item)
+                                     { return item.data == result.data; });
+            if (item == this->seen.end())
+                this->seen.push_back({result.data, this->frame_index});
+            else
+            {
+                result.repeated = true;
+                item->last_frame = this->frame_index;
+            }
+
+            this->results.push_back(result);
+            this->stats.decoded++;
+        }
+
+        if (symbol.next == NULL)
+            break;
+        symbol = *symbol.next;
+    }
+}
+
+std::vector<code_result_t> &CodeEngine::get_results()
+{
+    return this->results;
+}
+
+std::vector<std::vector<int>> &CodeEngine::get_regions()
+{
+    return this->regions;
+}
+
+code_stats_t CodeEngine::get_stats()
+{
+    return this->stats;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "esp_code_scanner.h"
+
+/**
+ * @brief A code decoded by CodeEngine.
+ */
+typedef struct
+{
+    std::string type; /*<! symbol type, e.g., QR-Code >*/
+    std::string data; /*<! decoded data >*/
+    int box[4];       /*<! region scanned, [left_up_x, left_up_y, right_down_x, right_down_y] in frame >*/
+    bool repeated;    /*<! the same data was decoded within hold_frames >*/
+} code_result_t;
+
+/**
+ * @brief Counters of CodeEngine since construction.
+ */
+typedef struct
+{
+    uint32_t frames;  /*<! frames loaded >*/
+    uint32_t scans;   /*<! calls of esp_code_scanner_scan_image() >*/
+    uint64_t pixels;  /*<! pixels scanned >*/
+    uint32_t decoded; /*<! codes decoded, repeated included >*/
+} code_stats_t;
+
+/**
+ * @brief QR code and barcode scanning of the regions of a frame likely to hold one.
+ *
+ * load() converts an RGB565 frame to luma once, so the frame can be released right after. Meanwhile each block of
+ * block_size x block_size pixels gets its luma range, its mean and the number of strong horizontal edges. A block with
+ * enough contrast and edges is a candidate. Connected candidates grown by one block for the quiet zone make the
+ * regions, the largest first. A region whose blocks did not change since they were last scanned is skipped, unless it
+ * has not been scanned for rescan_frames. scan() crops each region and scans only the crops, or the whole frame when
+ * the regions cover most of it. Data decoded again within hold_frames is marked repeated.
+ *
+ * Frame shape = (240, 240), block_size = 16: luma takes 56KB, the block statistics less than 1KB.
+ */
+class CodeEngine
+{
+private:
+    const int height;             /*<! frame height >*/
+    const int width;              /*<! frame width >*/
+    const int block_size;         /*<! block size in pixel >*/
+    const int contrast_threshold; /*<! luma range of a candidate block >*/
+    const int edge_threshold;     /*<! luma step of a strong edge >*/
+    const int edge_count;         /*<! strong edges in a candidate block >*/
+    const int motion_threshold;   /*<! change of block mean to scan a region again >*/
+    const int rescan_frames;      /*<! frames before a still region is scanned again >*/
+    const int hold_frames;        /*<! frames before the same data is reported again >*/
+    const int max_regions;        /*<! regions scanned per frame >*/
+    int map_height;               /*<! blocks in height >*/
+    int map_width;                /*<! blocks in width >*/
+    uint8_t *luma;                /*<! [height, width] luma of the last frame >*/
+    uint8_t *crop;                /*<! scratch of a region >*/
+    esp_image_scanner_t *scanner; /*<! reused for every region >*/
+    uint32_t frame_index;         /*<! index of the last frame >*/
+
+    std::vector<uint8_t> minimum;          /*<! [map_height, map_width] minimum luma of blocks >*/
+    std::vector<uint8_t> maximum;          /*<! [map_height, map_width] maximum luma of blocks >*/
+    std::vector<uint16_t> edges;           /*<! [map_height, map_width] strong edges of blocks >*/
+    std::vector<uint8_t> mean;             /*<! [map_height, map_width] mean luma of blocks >*/
+    std::vector<uint8_t> reference;        /*<! [map_height, map_width] mean luma when last scanned >*/
+    std::vector<uint32_t> scanned;         /*<! [map_height, map_width] frame index when last scanned >*/
+    std::vector<uint8_t> candidate;        /*<! [map_height, map_width] candidate blocks >*/
+    std::vector<int> stack;                /*<! scratch of region labeling >*/
+    std::vector<std::vector<int>> blocks;  /*<! regions to scan in blocks, [x1, y1, x2, y2, candidates] >*/
+    std::vector<std::vector<int>> regions; /*<! regions to scan in pixel, [x1, y1, x2, y2] >*/
+    std::vector<code_result_t> results;    /*<! codes decoded in the last scan >*/
+
+    typedef struct
+    {
+        std::string data;    /*<! decoded data >*/
+        uint32_t last_frame; /*<! frame index when last decoded >*/
+    } seen_t;
+    std::vector<seen_t> seen; /*<! data decoded within hold_frames >*/
+
+    code_stats_t stats;
+
+    void label_regions();
+    bool select_region(const std::vector<int> &block);
+    void scan_region(const std::vector<int> &region);
+
+public:
+    /**
+     * @brief Construct a new Code Engine object
+     *
+     * @param height             frame height
+     * @param width              frame width
+     * @param block_size         block size in pixel
+     * @param contrast_threshold luma range of a candidate block
+     * @param edge_threshold     luma step of a strong edge
+     * @param edge_count         strong edges in a candidate block
+     * @param motion_threshold   change of block mean to scan a region again
+     * @param rescan_frames      frames before a still region is scanned again
+     * @param hold_frames        frames before the same data is reported again
+     * @param max_regions        regions scanned per frame
+     */
+    CodeEngine(const int height,
+               const int width,
+               const int block_size = 16,
+               const int contrast_threshold = 80,
+               const int edge_threshold = 40,
+               const int edge_count = 12,
+               const int motion_threshold = 6,
+               const int rescan_frames = 15,
+               const int hold_frames = 60,
+               const int max_regions = 3);
+
+    /**
+     * @brief Destroy the Code Engine object
+     */
+    ~CodeEngine();
+
+    /**
+     * @brief Convert a frame to luma and find the regions to scan. The frame is not used after.
+     *
+     * @param frame RGB565 frame of the constructed shape
+     * @return int number of regions to scan
+     */
+    int load(uint16_t *frame);
+
+    /**
+     * @brief Scan the regions found by load().
+     *
+     * @return std::vector<code_result_t>& codes decoded
+     */
+    std::vector<code_result_t> &scan();
+
+    /**
+     * @brief Get the codes decoded by the last scan().
+     *
+     * @return std::vector<code_result_t>& codes decoded
+     */
+    std::vector<code_result_t> &get_results();
+
+    /**
+     * @brief Get the regions found by the last load().
+     *
+     * @return std::vector<std::vector<int>>& boxes in [left_up_x, left_up_y, right_down_x, right_down_y] of frame
+     */
+    std::vector<std::vector<int>> &get_regions();
+
+    /**
+     * @brief Get the counters.
+     *
+     * @return code_stats_t counters since construction
+     */
+    code_stats_t get_stats();
+};
@@ -5,7 +5,7 @@
 
 #include "dl_image.hpp"
 #include "fb_gfx.h"
-#include "color_detector.hpp"
+#include "who_color_engine.hpp"
 
 #include "who_ai_utils.hpp"
 
@@ -85,16 +85,16 @@ static int rgb_printf(camera_fb_t *fb, uint32_t color, const char *format, ...)
     return len;
 }
 
-static void draw_color_detection_result(uint16_t *image_ptr, int image_height, int image_width, vector<color_detect_result_t> &results, uint16_t color)
+static void draw_color_detection_result(uint16_t *image_ptr, int image_height, int image_width, vector<color_blob_t> &blobs, vector<uint16_t> &colors)
 {
-    for (int i = 0; i < results.size(); ++i)
+    for (int i = 0; i < blobs.size(); ++i)
     {
         dl::image::draw_hollow_rectangle(image_ptr, image_height, image_width,
-                                         results[i].box[0],
-                                         results[i].box[1],
-                                         results[i].box[2],
-                                         results[i].box[3],
-                                         color);
+                                         blobs[i].box[0],
+                                         blobs[i].box[1],
+                                         blobs[i].box[2],
+                                         blobs[i].box[3],
+                                         colors[blobs[i].color % colors.size()]);
     }
 }
 
@@ -102,12 +102,7 @@ static void task_process_handler(void *arg)
 {
     camera_fb_t *frame = NULL;
 
-    ColorDetector detector;
-    detector.set_detection_shape({80, 80, 1});
-    for (int i = 0; i < std_color_info.size(); ++i)
-    {
-        detector.register_color(std_color_info[i].color_thresh, std_color_info[i].area_thresh, std_color_info[i].name);
-    }
+    ColorEngine *engine = NULL;
 
     vector<vector<int>> color_thresh_boxes = {{110, 110, 130, 130}, {100, 100, 140, 140}, {90, 90, 150, 150}, {80, 80, 160, 160}, {60, 60, 180, 180}, {40, 40, 200, 200}, {20, 20, 220, 220}};
     int color_thresh_boxes_num = color_thresh_boxes.size();
@@ -115,8 +110,6 @@ static void task_process_handler(void *arg)
     vector<int> color_area_threshes = {1, 4, 16, 32, 64, 128, 256, 512, 1024};
     int color_area_thresh_num = color_area_threshes.size();
     int color_area_thresh_index = color_area_thresh_num / 2;
-    
-    detector.set_area_thresh({color_area_threshes[color_area_thresh_index]});
 
 
     vector<uint16_t> draw_lcd_colors = {RGB565_LCD_RED, 
@@ -130,7 +123,6 @@ static void task_process_handler(void *arg)
                                         RGB565_LCD_GRAY, 
                                         // RGB565_LCD_BLACK
                                         };
-    int draw_colors_num = draw_lcd_colors.size();
 
     color_detection_state_t _gEvent;
     vector<uint8_t> color_thresh;
@@ -144,6 +136,17 @@ static void task_process_handler(void *arg)
 
         if (xQueueReceive(xQueueFrameI, &frame, portMAX_DELAY))
         {
+            // all colors are found in one pass over samples of 80 x 80 at most
+            if (engine == NULL)
+            {
+                engine = new ColorEngine(frame->height, frame->width, max(1, max((int)frame->height, (int)frame->width) / 80));
+                for (int i = 0; i < std_color_info.size(); ++i)
+                {
+                    engine->register_color(std_color_info[i].color_thresh, std_color_info[i].area_thresh, std_color_info[i].name);
+                }
+                engine->set_area_thresh(color_area_threshes[color_area_thresh_index]);
+            }
+
             if (register_mode)
             {
                 switch (_gEvent)
@@ -171,8 +174,8 @@ static void task_process_handler(void *arg)
                     break;
 
                 case REGISTER_COLOR:
-                    color_thresh = detector.cal_color_thresh((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, color_thresh_boxes[color_thresh_boxes_index]);
-                    detector.register_color(color_thresh);
+                    color_thresh = engine->cal_color_thresh((uint16_t *)frame->buf, color_thresh_boxes[color_thresh_boxes_index]);
+                    engine->register_color(color_thresh, color_area_threshes[color_area_thresh_index]);
                     printf("register color, color_thresh: %d, %d, %d, %d, %d, %d\n", color_thresh[0], color_thresh[1], color_thresh[2], color_thresh[3], color_thresh[4], color_thresh[5]);
                     xSemaphoreTake(xMutex, portMAX_DELAY);
                     register_mode = false;
@@ -202,33 +205,30 @@ static void task_process_handler(void *arg)
                 {
                 case INCREASE_COLOR_AREA:
                     color_area_thresh_index = min(color_area_thresh_num - 1, color_area_thresh_index + 1);
-                    detector.set_area_thresh({color_area_threshes[color_area_thresh_index]});
+                    engine->set_area_thresh(color_area_threshes[color_area_thresh_index]);
                     printf("increase color area thresh to %d\n", color_area_threshes[color_area_thresh_index]);
                     break;
 
                 case DECREASE_COLOR_AREA:
                     color_area_thresh_index = max(0, color_area_thresh_index - 1);
-                    detector.set_area_thresh({color_area_threshes[color_area_thresh_index]});
+                    engine->set_area_thresh(color_area_threshes[color_area_thresh_index]);
                     printf("decrease color area thresh to %d\n", color_area_threshes[color_area_thresh_index]);
                     break;
 
                 case DELETE_COLOR:
-                    detector.delete_color();
+                    engine->delete_color();
                     printf("delete color \n");
                     break;
 
                 default:
-                    std::vector<std::vector<color_detect_result_t>> &results = detector.detect((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3});
+                    std::vector<color_blob_t> &blobs = engine->detect((uint16_t *)frame->buf);
                     if (draw_box)
                     {
-                        for (int i = 0; i < results.size(); ++i)
-                        {
-                            draw_color_detection_result((uint16_t *)frame->buf, (int)frame->height, (int)frame->width, results[i], draw_lcd_colors[i % draw_colors_num]);
-                        }
+                        draw_color_detection_result((uint16_t *)frame->buf, (int)frame->height, (int)frame->width, blobs, draw_lcd_colors);
                     }
                     else
                     {
-                        detector.draw_segmentation_results((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, draw_lcd_colors, true, 0x0000);
+                        engine->draw_segmentation((uint16_t *)frame->buf, draw_lcd_colors, true, 0x0000);
                     }
                     break;
                 }
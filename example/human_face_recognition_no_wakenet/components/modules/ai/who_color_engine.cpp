@@ -0,0 +1,386 @@
+#include "who_color_engine.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "dl_image.hpp"
+
+#define HUE_NUM 181 // H in [0, 180]
+
+static const char *TAG = "color_engine";
+
+static inline void convert_pixel_rgb565_to_hsv(uint16_t input, int &h, int &s, int &v)
+{
+    int bgr[3];
+    dl::image::convert_pixel_rgb565_to_rgb888(input, bgr);
+    int blue = bgr[0], green = bgr[1], red = bgr[2];
+
+    int max = DL_MAX(red, DL_MAX(green, blue));
+    int delta = max - DL_MIN(red, DL_MIN(green, blue));
+    v = max;
+    s = max ? delta * 255 / max : 0;
+    if (delta == 0)
+        h = 0;
+    else if (max == red)
+        h = 30 * (green - blue) / delta;
+    else if (max == green)
+        h = 60 + 30 * (blue - red) / delta;
+    else
+        h = 120 + 30 * (red - green) / delta;
+    if (h < 0)
+        h += 180;
+}
+
+// smallest value with more than rank samples up to it
+static int get_percentile(const int *histogram, int size, int rank)
+{
+    int sum = 0;
+    for (int i = 0; i < size; i++)
+    {
+        sum += histogram[i];
+        if (sum > rank)
+            return i;
+    }
+    return size - 1;
+}
+
+ColorEngine::ColorEngine(const int height, const int width, const int scale) : height(height),
+                                                                               width(width),
+                                                                               scale(scale)
+{
+    this->grid_height = height / scale;
+    this->grid_width = width / scale;
+
+    // looked up per sample, kept in internal RAM if it fits
+    this->channel_mask = (uint32_t *)heap_caps_calloc(HUE_NUM + 256 + 256, sizeof(uint32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (this->channel_mask == NULL)
+        this->channel_mask = (uint32_t *)heap_caps_calloc(HUE_NUM + 256 + 256, sizeof(uint32_t), MALLOC_CAP_8BIT);
+
+    this->sample_mask = (uint32_t *)heap_caps_calloc(this->grid_height * this->grid_width, sizeof(uint32_t), MALLOC_CAP_8BIT);
+    if (this->channel_mask == NULL || this->sample_mask == NULL)
+        ESP_LOGE(TAG, "malloc memory for masks failed, no color will be detected");
+
+    this->open.resize(COLOR_ENGINE_COLOR_MAX);
+    this->runs.reserve(this->grid_height * 4);
+    this->sums.reserve(this->grid_height * 4);
+    this->blobs.reserve(COLOR_ENGINE_COLOR_MAX);
+}
+
+ColorEngine::~ColorEngine()
+{
+    if (this->channel_mask)
+        heap_caps_free(this->channel_mask);
+    if (this->sample_mask)
+        heap_caps_free(this->sample_mask);
+}
+
+void ColorEngine::update_channel_mask()
+{
+    if (this->channel_mask == NULL)
+        return;
+
+    uint32_t *h_mask = this->channel_mask;
+    uint32_t *s_mask = h_mask + HUE_NUM;
+    uint32_t *v_mask = s_mask + 256;
+    memset(this->channel_mask, 0, (HUE_NUM + 256 + 256) * sizeof(uint32_t));
+
+    for (int i = 0; i < this->colors.size(); i++)
+    {
+        const std::vector<uint8_t> &thresh = this->colors[i].color_thresh;
+        uint32_t bit = 1u << i;
+        for (int h = 0; h < HUE_NUM; h++)
+        {
+            bool inside = thresh[0] <= thresh[1] ? (h >= thresh[0] && h <= thresh[1]) : (h >= thresh[0] || h <= thresh[1]);
+            if (inside)
+                h_mask[h] |= bit;
+        }
+        for (int s = thresh[2]; s <= thresh[3]; s++)
+            s_mask[s] |= bit;
+        for (int v = thresh[4]; v <= thresh[5]; v++)
+            v_mask[v] |= bit;
+    }
+}
+
+int ColorEngine::register_color(const std::vector<uint8_t> &color_thresh, int area_thresh, const std::string &color_name)
+{
+    assert(color_thresh.size() == 6);
+    if (this->colors.size() >= COLOR_ENGINE_COLOR_MAX)
+        return -1;
+
+    this->colors.push_back({color_thresh, area_thresh, color_name});
+    this->update_channel_mask();
+    return this->colors.size() - 1;
+}
+
+int ColorEngine::register_color(uint16_t *frame, const std::vector<int> &box, int area_thresh, const std::string &color_name)
+{
+    return this->register_color(this->cal_color_thresh(frame, box), area_thresh, color_name);
+}
+
+std::vector<uint8_t> ColorEngine::cal_color_thresh(uint16_t *frame, const std::vector<int> &box, const std::vector<int> &offset)
+{
+    int h_histogram[HUE_NUM] = {0};
+    int s_histogram[256] = {0};
+    int v_histogram[256] = {0};
+
+    int x1 = DL_MAX(box[0], 0);
+    int y1 = DL_MAX(box[1], 0);
+    int x2 = DL_MIN(box[2], this->width - 1);
+    int y2 = DL_MIN(box[3], this->height - 1);
+    int n = 0;
+    for (int y = y1; y <= y2; y++)
+    {
+        for (int x = x1; x <= x2; x++, n++)
+        {
+            int h, s, v;
+            convert_pixel_rgb565_to_hsv(frame[y * this->width + x], h, s, v);
+            h_histogram[h]++;
+            s_histogram[s]++;
+            v_histogram[v]++;
+        }
+    }
+    if (n == 0)
+        return {0, 180, 0, 255, 0, 255};
+
+    int s_min = DL_MAX(get_percentile(s_histogram, 256, n * 5 / 100) - offset[1], 0);
+    int s_max = DL_MIN(get_percentile(s_histogram, 256, n * 95 / 100) + offset[1], 255);
+    int v_min = DL_MAX(get_percentile(v_histogram, 256, n * 5 / 100) - offset[2], 0);
+    int v_max = DL_MIN(get_percentile(v_histogram, 256, n * 95 / 100) + offset[2], 255);
+
+    // hue of gray is noise
+    if (s_max < 64)
+        return {0, 180, (uint8_t)s_min, (uint8_t)s_max, (uint8_t)v_min, (uint8_t)v_max};
+
+    // the narrowest range holding 90% of samples, it may wrap around 180
+    int need = (n * 9 + 9) / 10;
+    int best_start = 0;
+    int best_width = 180;
+    for (int start = 0; start < 180; start++)
+    {
+        int sum = 0;
+        for (int width = 1; width < best_width; width++)
+        {
+            sum += h_histogram[(start + width - 1) % 180];
+            if (sum >= need)
+            {
+                best_start = start;
+                best_width = width;
+                break;
+            }
+        }
+    }
+    if (best_width + 2 * offset[0] >= 180)
+        return {0, 180, (uint8_t)s_min, (uint8_t)s_max, (uint8_t)v_min, (uint8_t)v_max};
+
+    int h_min = (best_start - offset[0] + 180) % 180;
+    int h_max = (best_start + best_width - 1 + offset[0]) % 180;
+    return {(uint8_t)h_min, (uint8_t)h_max, (uint8_t)s_min, (uint8_t)s_max, (uint8_t)v_min, (uint8_t)v_max};
+}
+
+int ColorEngine::delete_color(int id)
+{
+    if (id == -1)
+        id = this->colors.size() - 1;
+    if (id < 0 || id >= this->colors.size())
+        return -1;
+
+    this->colors.erase(this->colors.begin() + id);
+    this->update_channel_mask();
+    this->blobs.clear();
+    return this->colors.size();
+}
+
+void ColorEngine::set_area_thresh(int area_thresh, int id)
+{
+    for (int i = 0; i < this->colors.size(); i++)
+    {
+        if (id == -1 || id == i)
+            this->colors[i].area_thresh = area_thresh;
+    }
+}
+
+const std::vector<color_info_t> &ColorEngine::get_colors()
+{
+    return this->colors;
+}
+
+int ColorEngine::find(int run)
+{
+    while (this->runs[run].parent != run)
+    {
+        this->runs[run].parent = this->runs[this->runs[run].parent].parent;
+        run = this->runs[run].parent;
+    }
+    return run;
+}
+
+void ColorEngine::link_row(int row_start, int previous_start)
+{
+    const int row_end = this->runs.size();
+    std::sort(this->runs.begin() + row_start, this->runs.end(), [](const color_run_t &a, const color_run_t &b) {
+        return a.color != b.color ? a.color < b.color : a.x1 < b.x1;
+    });
+    for (int j = row_start; j < row_end; j++)
+        this->runs[j].parent = j;
+
+    if (previous_start < 0)
+        return;
+
+    // both rows are in (color, x1), the overlapping runs of the same color are met in one sweep
+    int i = previous_start;
+    int j = row_start;
+    while (i < row_start && j < row_end)
+    {
+        const color_run_t &above = this->runs[i];
+        const color_run_t &below = this->runs[j];
+        if (above.color != below.color)
+        {
+            if (above.color < below.color)
+                i++;
+            else
+                j++;
+            continue;
+        }
+
+        if (above.x1 <= below.x2 && below.x1 <= above.x2)
+        {
+            int a = this->find(i);
+            int b = this->find(j);
+            if (a != b)
+                this->runs[DL_MAX(a, b)].parent = DL_MIN(a, b);
+        }
+
+        if (above.x2 < below.x2)
+            i++;
+        else
+            j++;
+    }
+}
+
+std::vector<color_blob_t> &ColorEngine::detect(uint16_t *frame)
+{
+    this->runs.clear();
+    this->blobs.clear();
+    if (this->channel_mask == NULL || this->sample_mask == NULL)
+        return this->blobs;
+
+    if (this->colors.empty())
+    {
+        memset(this->sample_mask, 0, this->grid_height * this->grid_width * sizeof(uint32_t));
+        return this->blobs;
+    }
+
+    const uint32_t *h_mask = this->channel_mask;
+    const uint32_t *s_mask = h_mask + HUE_NUM;
+    const uint32_t *v_mask = s_mask + 256;
+    const int offset = this->scale / 2;
+
+    // sample the center of each scale x scale cell, a run is closed where its color bit turns off
+    int previous_start = -1;
+    uint32_t *mask = this->sample_mask;
+    for (int y = 0; y < this->grid_height; y++, mask += this->grid_width)
+    {
+        uint16_t *row = frame + (y * this->scale + offset) * this->width + offset;
+        const int row_start = this->runs.size();
+        uint32_t previous = 0;
+        for (int x = 0; x <= this->grid_width; x++)
+        {
+            uint32_t current = 0;
+            if (x < this->grid_width)
+            {
+                int h, s, v;
+                convert_pixel_rgb565_to_hsv(row[x * this->scale], h, s, v);
+                current = h_mask[h] & s_mask[s] & v_mask[v];
+                mask[x] = current;
+            }
+
+            uint32_t changed = current ^ previous;
+            while (changed)
+            {
+                int color = __builtin_ctz(changed);
+                changed &= changed - 1;
+                if (current & (1u << color))
+                    this->open[color] = x;
+                else
+                    this->runs.push_back({(int16_t)y, (int16_t)this->open[color], (int16_t)(x - 1), (int16_t)color, 0});
+            }
+            previous = current;
+        }
+        this->link_row(row_start, previous_start);
+        previous_start = row_start;
+    }
+
+    // a root has the smallest index of its blob, so it is met before the other runs
+    this->sums.resize(this->runs.size());
+    for (int i = 0; i < this->runs.size(); i++)
+    {
+        const color_run_t &run = this->runs[i];
+        int root = this->find(i);
+        color_sum_t &sum = this->sums[root];
+        if (root == i)
+            sum = {0, 0, 0, run.x1, run.y, run.x2, run.y};
+
+        int length = run.x2 - run.x1 + 1;
+        sum.area += length;
+        sum.sum_x += length * (run.x1 + run.x2);
+        sum.sum_y += length * run.y;
+        sum.x1 = DL_MIN(sum.x1, (int)run.x1);
+        sum.x2 = DL_MAX(sum.x2, (int)run.x2);
+        sum.y2 = DL_MAX(sum.y2, (int)run.y);
+    }
+
+    for (int i = 0; i < this->runs.size(); i++)
+    {
+        const color_run_t &run = this->runs[i];
+        const color_sum_t &sum = this->sums[i];
+        if (run.parent != i || sum.area < this->colors[run.color].area_thresh)
+            continue;
+
+        color_blob_t blob;
+        blob.color = run.color;
+        blob.area = sum.area;
+        blob.center[0] = sum.sum_x * this->scale / (2 * sum.area) + offset;
+        blob.center[1] = sum.sum_y * this->scale / sum.area + offset;
+        blob.box[0] = sum.x1 * this->scale;
+        blob.box[1] = sum.y1 * this->scale;
+        blob.box[2] = DL_MIN((sum.x2 + 1) * this->scale, this->width) - 1;
+        blob.box[3] = DL_MIN((sum.y2 + 1) * this->scale, this->height) - 1;
+        this->blobs.push_back(blob);
+    }
+    std::sort(this->blobs.begin(), this->blobs.end(), [](const color_blob_t &a, const color_blob_t &b) {
+        return a.color != b.color ? a.color < b.color : a.area > b.area;
+    });
+    return this->blobs;
+}
+
+std::vector<color_blob_t> &ColorEngine::get_blobs()
+{
+    return this->blobs;
+}
+
+void ColorEngine::draw_segmentation(uint16_t *frame, const std::vector<uint16_t> &draw_colors, bool draw_background, uint16_t background_color)
+{
+    if (this->sample_mask == NULL)
+        return;
+
+    uint32_t *mask = this->sample_mask;
+    for (int y = 0; y < this->grid_height; y++)
+    {
+        for (int x = 0; x < this->grid_width; x++, mask++)
+        {
+            if (*mask == 0 && !draw_background)
+                continue;
+
+            uint16_t color = *mask ? draw_colors[__builtin_ctz(*mask) % draw_colors.size()] : background_color;
+            for (int cy = 0; cy < this->scale; cy++)
+            {
+                uint16_t *pixel = frame + (y * this->scale + cy) * this->width + x * this->scale;
+                for (int cx = 0; cx < this->scale; cx++)
+                    pixel[cx] = color;
+            }
+        }
+    }
+}
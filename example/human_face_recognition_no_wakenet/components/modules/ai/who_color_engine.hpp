@@ -0,0 +1,178 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "color_detector.hpp"
+
+#define COLOR_ENGINE_COLOR_MAX 32 /*<! maximum number of registered colors, one bit each in a sample mask >*/
+
+/**
+ * @brief A connected area of a registered color.
+ */
+typedef struct
+{
+    int color;     /*<! index of registered color >*/
+    int area;      /*<! sample points in the blob >*/
+    int center[2]; /*<! centroid [x, y] in frame >*/
+    int box[4];    /*<! [left_up_x, left_up_y, right_down_x, right_down_y] in frame >*/
+} color_blob_t;
+
+/**
+ * @brief Color blob detection of many colors in one pass.
+ *
+ * The frame is sampled once at the center of each scale x scale cell and each sample is converted to HSV. Every
+ * channel value indexes a table of the colors accepting it, so the colors of a sample are the AND of three bit masks,
+ * whatever the number of registered colors. Runs of the same color in a row are linked to the overlapping runs of the
+ * row above, and connected runs are merged into blobs with their area, centroid and box. The labeling cost follows the
+ * edges of colored areas instead of the number of colors.
+ *
+ * Thresholds are {h_min, h_max, s_min, s_max, v_min, v_max} with H in [0, 180] and S, V in [0, 255], the same as
+ * ColorDetector. A hue range with h_min > h_max wraps around 180, e.g., red in {156, 10}.
+ *
+ * Frame shape = (240, 240), scale = 3: 6400 samples are read from PSRAM per frame, the masks take 25KB.
+ */
+class ColorEngine
+{
+private:
+    const int height;       /*<! frame height >*/
+    const int width;        /*<! frame width >*/
+    const int scale;        /*<! distance between sample points in pixel >*/
+    int grid_height;        /*<! sample points in height >*/
+    int grid_width;         /*<! sample points in width >*/
+    uint32_t *channel_mask; /*<! [181 + 256 + 256] colors accepting each H, S and V value >*/
+    uint32_t *sample_mask;  /*<! [grid_height, grid_width] colors of each sample in the last frame >*/
+
+    /**
+     * @brief A horizontal run of one color, linked to the runs of its blob.
+     */
+    typedef struct
+    {
+        int16_t y;     /*<! row in samples >*/
+        int16_t x1;    /*<! first column in samples >*/
+        int16_t x2;    /*<! last column in samples >*/
+        int16_t color; /*<! index of registered color >*/
+        int parent;    /*<! index of parent run, itself for the root of a blob >*/
+    } color_run_t;
+
+    /**
+     * @brief Sums of a blob, kept at its root run.
+     */
+    typedef struct
+    {
+        int area;  /*<! sample points >*/
+        int sum_x; /*<! sum of 2 * x >*/
+        int sum_y; /*<! sum of y >*/
+        int x1;    /*<! box in samples >*/
+        int y1;
+        int x2;
+        int y2;
+    } color_sum_t;
+
+    std::vector<color_info_t> colors; /*<! registered colors >*/
+    std::vector<color_run_t> runs;    /*<! runs of the last frame, in rows >*/
+    std::vector<color_sum_t> sums;    /*<! scratch indexed by run >*/
+    std::vector<int> open;            /*<! [COLOR_ENGINE_COLOR_MAX] first column of the run open in each color >*/
+    std::vector<color_blob_t> blobs;  /*<! blobs of the last frame >*/
+
+    void update_channel_mask();
+    void link_row(int row_start, int previous_start);
+    int find(int run);
+
+public:
+    /**
+     * @brief Construct a new Color Engine object. If memory of the masks runs out, an error is logged and detect()
+     * finds no blob.
+     *
+     * @param height frame height
+     * @param width  frame width
+     * @param scale  distance between sample points in pixel
+     */
+    ColorEngine(const int height, const int width, const int scale = 3);
+
+    /**
+     * @brief Destroy the Color Engine object
+     */
+    ~ColorEngine();
+
+    /**
+     * @brief Register a color.
+     *
+     * @param color_thresh {h_min, h_max, s_min, s_max, v_min, v_max}
+     * @param area_thresh  blobs with less sample points are filtered
+     * @param color_name   name of the color
+     * @return int index of the color, -1 if COLOR_ENGINE_COLOR_MAX colors are registered
+     */
+    int register_color(const std::vector<uint8_t> &color_thresh, int area_thresh = 64, const std::string &color_name = "");
+
+    /**
+     * @brief Register the color of a region in a frame.
+     *
+     * @param frame       RGB565 frame of the constructed shape
+     * @param box         [left_up_x, left_up_y, right_down_x, right_down_y] in frame
+     * @param area_thresh blobs with less sample points are filtered
+     * @param color_name  name of the color
+     * @return int index of the color, -1 if COLOR_ENGINE_COLOR_MAX colors are registered
+     */
+    int register_color(uint16_t *frame, const std::vector<int> &box, int area_thresh = 64, const std::string &color_name = "");
+
+    /**
+     * @brief Get the threshold of the color of a region in a frame. The hue is the narrowest range holding 90% of the
+     *        samples, and is ignored for unsaturated regions. S and V are from the 5th to the 95th percentile.
+     *
+     * @param frame  RGB565 frame of the constructed shape
+     * @param box    [left_up_x, left_up_y, right_down_x, right_down_y] in frame
+     * @param offset margin added to {H, S, V} ranges
+     * @return std::vector<uint8_t> {h_min, h_max, s_min, s_max, v_min, v_max}
+     */
+    std::vector<uint8_t> cal_color_thresh(uint16_t *frame, const std::vector<int> &box, const std::vector<int> &offset = {4, 20, 20});
+
+    /**
+     * @brief Delete a registered color, the colors after it move forward.
+     *
+     * @param id index of the color, -1 for the last registered
+     * @return int number of registered colors, -1 if the id is not valid
+     */
+    int delete_color(int id = -1);
+
+    /**
+     * @brief Set the area threshold of a color.
+     *
+     * @param area_thresh blobs with less sample points are filtered
+     * @param id          index of the color, -1 for all colors
+     */
+    void set_area_thresh(int area_thresh, int id = -1);
+
+    /**
+     * @brief Get the registered colors.
+     *
+     * @return const std::vector<color_info_t>& registered colors
+     */
+    const std::vector<color_info_t> &get_colors();
+
+    /**
+     * @brief Find the blobs of all registered colors in a frame.
+     *
+     * @param frame RGB565 frame of the constructed shape
+     * @return std::vector<color_blob_t>& blobs ordered by color, then by area from the largest
+     */
+    std::vector<color_blob_t> &detect(uint16_t *frame);
+
+    /**
+     * @brief Get the blobs of the last frame.
+     *
+     * @return std::vector<color_blob_t>& blobs ordered by color, then by area from the largest
+     */
+    std::vector<color_blob_t> &get_blobs();
+
+    /**
+     * @brief Paint the cells of the last frame in the color they matched, the first registered wins.
+     *
+     * @param frame            RGB565 frame of the constructed shape
+     * @param draw_colors      RGB565 value of each registered color, reused in turn if shorter
+     * @param draw_background  paint the cells matching no color
+     * @param background_color RGB565 value of background
+     */
+    void draw_segmentation(uint16_t *frame, const std::vector<uint16_t> &draw_colors, bool draw_background = true, uint16_t background_color = 0x0000);
+};
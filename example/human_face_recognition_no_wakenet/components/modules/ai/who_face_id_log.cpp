@@ -0,0 +1,462 @@
+#include "who_face_id_log.hpp"
+
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+static const char *TAG = "face_id_log";
+
+#define JOB_TIMEOUT_MS 100 // longest wait of the caller for a slot in the job queue
+
+#define LOG_MAGIC 0x474C5246 // "FRLG"
+#define LOG_COMMITTED 0x00000000
+#define RECORD_ENROLL 0x01
+#define RECORD_DELETE 0x02
+#define RECORD_FREE 0xFF
+#define ALIGN_4(x) (((x) + 3) & ~3)
+
+typedef struct
+{
+    uint32_t magic;     /*<! LOG_MAGIC >*/
+    uint32_t sequence;  /*<! the committed area with the biggest sequence is active >*/
+    uint32_t emb_size;  /*<! number of elements in an embedding >*/
+    uint32_t committed; /*<! LOG_COMMITTED after all live records are copied, written last >*/
+} log_header_t;
+
+typedef struct
+{
+    uint8_t type;        /*<! RECORD_ENROLL or RECORD_DELETE, RECORD_FREE for end of log >*/
+    uint8_t name_length; /*<! length of name >*/
+    uint16_t reserved;   /*<! 0xFFFF >*/
+    int32_t id;          /*<! id index >*/
+    uint32_t crc;        /*<! crc32 of header with crc = 0, embedding and name >*/
+} record_header_t;
+
+static uint32_t crc32(uint32_t crc, const void *data, int size)
+{
+    const uint8_t *ptr = (const uint8_t *)data;
+    crc = ~crc;
+    for (int i = 0; i < size; i++)
+    {
+        crc ^= ptr[i];
+        for (int j = 0; j < 8; j++)
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static uint32_t record_crc(record_header_t header, const void *payload, int payload_size)
+{
+    header.crc = 0;
+    uint32_t crc = crc32(0, &header, sizeof(header));
+    return crc32(crc, payload, payload_size);
+}
+
+FaceIDLogPartition::FaceIDLogPartition(const char *label)
+{
+    this->partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (this->partition == NULL)
+        ESP_LOGE(TAG, "partition \"%s\" is not found", label);
+}
+
+int FaceIDLogPartition::size()
+{
+    return ((const esp_partition_t *)this->partition)->size;
+}
+
+int FaceIDLogPartition::sector_size()
+{
+    return ((const esp_partition_t *)this->partition)->erase_size;
+}
+
+bool FaceIDLogPartition::read(int offset, void *data, int size)
+{
+    return esp_partition_read((const esp_partition_t *)this->partition, offset, data, size) == ESP_OK;
+}
+
+bool FaceIDLogPartition::write(int offset, const void *data, int size)
+{
+    return esp_partition_write((const esp_partition_t *)this->partition, offset, data, size) == ESP_OK;
+}
+
+bool FaceIDLogPartition::erase(int offset, int size)
+{
+    return esp_partition_erase_range((const esp_partition_t *)this->partition, offset, size) == ESP_OK;
+}
+
+FaceIDLog::FaceIDLog(FaceIDLogStorage *storage, const int emb_size) : storage(storage),
+                                                                      emb_size(emb_size),
+                                                                      active(-1),
+                                                                      sequence(0),
+                                                                      tail(0),
+                                                                      dead_size(0),
+                                                                      broken(false)
+{
+    int sector_size = this->storage->sector_size();
+    this->area_size = this->storage->size() / 2 / sector_size * sector_size;
+}
+
+int FaceIDLog::record_size(int name_length)
+{
+    return sizeof(record_header_t) + this->emb_size * sizeof(float) + ALIGN_4(name_length);
+}
+
+bool FaceIDLog::load(std::vector<face_record_t> &records)
+{
+    records.clear();
+    this->index.clear();
+    this->active = -1;
+
+    for (int area = 0; area < 2; area++)
+    {
+        log_header_t header;
+        if (!this->storage->read(area * this->area_size, &header, sizeof(header)))
+            continue;
+        if (header.magic != LOG_MAGIC || header.committed != LOG_COMMITTED || header.emb_size != this->emb_size)
+            continue;
+        if (this->active < 0 || header.sequence > this->sequence)
+        {
+            this->active = area;
+            this->sequence = header.sequence;
+        }
+    }
+    if (this->active < 0)
+        return false;
+
+    int base = this->active * this->area_size;
+    int offset = sizeof(log_header_t);
+    this->dead_size = 0;
+    this->broken = false;
+
+    // the embedding is read into its record, the name into a buffer of the longest one, so nothing else is allocated
+    std::vector<float> emb;
+    char name[ALIGN_4(255)];
+    while (offset + (int)sizeof(record_header_t) <= this->area_size)
+    {
+        record_header_t header;
+        if (!this->storage->read(base + offset, &header, sizeof(header)) || header.type == RECORD_FREE)
+            break;
+
+        int size = (header.type == RECORD_ENROLL) ? this->record_size(header.name_length) : sizeof(record_header_t);
+        bool valid = (header.type == RECORD_ENROLL || header.type == RECORD_DELETE) && offset + size <= this->area_size;
+        uint32_t crc = valid ? record_crc(header, NULL, 0) : 0;
+        if (valid && header.type == RECORD_ENROLL)
+        {
+            int emb_offset = base + offset + sizeof(record_header_t);
+            int name_offset = emb_offset + this->emb_size * sizeof(float);
+            emb.resize(this->emb_size);
+            valid = this->storage->read(emb_offset, emb.data(), this->emb_size * sizeof(float)) &&
+                    this->storage->read(name_offset, name, ALIGN_4(header.name_length));
+            crc = crc32(crc, emb.data(), this->emb_size * sizeof(float));
+            crc = crc32(crc, name, ALIGN_4(header.name_length));
+        }
+        if (!valid || crc != header.crc)
+        {
+            // torn by power loss, the rest of area is unusable until compaction
+            ESP_LOGW(TAG, "broken record at %d", offset);
+            this->broken = true;
+            break;
+        }
+
+        for (int i = 0; i < this->index.size(); i++)
+        {
+            if (this->index[i].id == header.id)
+            {
+                this->dead_size += this->index[i].size;
+                this->index.erase(this->index.begin() + i);
+                records.erase(records.begin() + i);
+                break;
+            }
+        }
+
+        if (header.type == RECORD_ENROLL)
+        {
+            this->index.push_back({header.id, offset, size});
+            records.push_back({header.id, std::string(name, header.name_length), std::vector<float>()});
+            records.back().emb.swap(emb);
+        }
+        else
+        {
+            this->dead_size += size;
+        }
+        offset += size;
+    }
+
+    this->tail = offset;
+    ESP_LOGI(TAG, "%d ids loaded from area %d, %d/%d bytes used, %d bytes dead", this->index.size(), this->active, this->tail, this->area_size, this->dead_size);
+    return true;
+}
+
+bool FaceIDLog::append_record(uint8_t type, int id, const float *emb, const std::string &name)
+{
+    int name_length = DL_MIN(name.length(), 255);
+    int size = (type == RECORD_ENROLL) ? this->record_size(name_length) : sizeof(record_header_t);
+
+    if (this->active < 0 || this->broken || this->tail + size > this->area_size)
+    {
+        if (!this->compact() || this->tail + size > this->area_size)
+            return false;
+    }
+
+    uint8_t *buffer = (uint8_t *)malloc(size);
+    if (buffer == NULL)
+        return false;
+    memset(buffer, 0xFF, size);
+
+    record_header_t *header = (record_header_t *)buffer;
+    header->type = type;
+    header->name_length = (type == RECORD_ENROLL) ? name_length : 0;
+    header->id = id;
+    if (type == RECORD_ENROLL)
+    {
+        memcpy(buffer + sizeof(record_header_t), emb, this->emb_size * sizeof(float));
+        memcpy(buffer + sizeof(record_header_t) + this->emb_size * sizeof(float), name.c_str(), name_length);
+    }
+    header->crc = record_crc(*header, buffer + sizeof(record_header_t), size - sizeof(record_header_t));
+
+    bool ret = this->storage->write(this->active * this->area_size + this->tail, buffer, size);
+    free(buffer);
+    if (!ret)
+    {
+        this->broken = true;
+        return false;
+    }
+
+    for (int i = 0; i < this->index.size(); i++)
+    {
+        if (this->index[i].id == id)
+        {
+            this->dead_size += this->index[i].size;
+            this->index.erase(this->index.begin() + i);
+            break;
+        }
+    }
+    if (type == RECORD_ENROLL)
+        this->index.push_back({id, this->tail, size});
+    else
+        this->dead_size += size;
+    this->tail += size;
+    return true;
+}
+
+bool FaceIDLog::switch_area(std::vector<face_record_t> *records)
+{
+    // with no log yet, area 1 goes first, area 0 may hold the ids of FaceRecognizer::write_ids_to_flash() being migrated
+    int target = (this->active == 1) ? 0 : 1;
+    int base = target * this->area_size;
+    if (!this->storage->erase(base, this->area_size))
+        return false;
+
+    log_header_t header = {LOG_MAGIC, this->sequence + 1, (uint32_t)this->emb_size, 0xFFFFFFFF};
+    if (!this->storage->write(base, &header, sizeof(header)))
+        return false;
+
+    std::vector<entry_t> index;
+    int offset = sizeof(log_header_t);
+    uint8_t *buffer = (uint8_t *)malloc(this->record_size(255));
+    if (buffer == NULL)
+        return false;
+
+    int count = records ? records->size() : this->index.size();
+    for (int i = 0; i < count; i++)
+    {
+        int size;
+        int id;
+        if (records)
+        {
+            face_record_t &record = (*records)[i];
+            int name_length = DL_MIN(record.name.length(), 255);
+            size = this->record_size(name_length);
+            id = record.id;
+
+            memset(buffer, 0xFF, size);
+            record_header_t *record_header = (record_header_t *)buffer;
+            record_header->type = RECORD_ENROLL;
+            record_header->name_length = name_length;
+            record_header->id = id;
+            memcpy(buffer + sizeof(record_header_t), record.emb.data(), this->emb_size * sizeof(float));
+            memcpy(buffer + sizeof(record_header_t) + this->emb_size * sizeof(float), record.name.c_str(), name_length);
+            record_header->crc = record_crc(*record_header, buffer + sizeof(record_header_t), size - sizeof(record_header_t));
+        }
+        else
+        {
+            size = this->index[i].size;
+            id = this->index[i].id;
+            if (!this->storage->read(this->active * this->area_size + this->index[i].offset, buffer, size))
+            {
+                free(buffer);
+                return false;
+            }
+        }
+
+        if (offset + size > this->area_size || !this->storage->write(base + offset, buffer, size))
+        {
+            free(buffer);
+            return false;
+        }
+        index.push_back({id, offset, size});
+        offset += size;
+    }
+    free(buffer);
+
+    // switch by committing the header of target, the old area is kept until next compaction
+    uint32_t committed = LOG_COMMITTED;
+    if (!this->storage->write(base + offsetof(log_header_t, committed), &committed, sizeof(committed)))
+        return false;
+
+    this->active = target;
+    this->sequence++;
+    this->index = index;
+    this->tail = offset;
+    this->dead_size = 0;
+    this->broken = false;
+    ESP_LOGI(TAG, "%d ids compacted to area %d, %d/%d bytes used", this->index.size(), this->active, this->tail, this->area_size);
+    return true;
+}
+
+bool FaceIDLog::reset(std::vector<face_record_t> &records)
+{
+    return this->switch_area(&records);
+}
+
+bool FaceIDLog::append(int id, const float *emb, const std::string &name)
+{
+    return this->append_record(RECORD_ENROLL, id, emb, name);
+}
+
+bool FaceIDLog::remove(int id)
+{
+    return this->append_record(RECORD_DELETE, id, NULL, "");
+}
+
+bool FaceIDLog::need_compaction()
+{
+    if (this->broken)
+        return true;
+    if (this->tail > this->area_size * 3 / 4)
+        return true;
+    return (this->dead_size * 2 > this->tail) && (this->tail > this->area_size / 4);
+}
+
+bool FaceIDLog::compact()
+{
+    if (this->active < 0)
+    {
+        std::vector<face_record_t> records;
+        return this->switch_area(&records);
+    }
+    return this->switch_area(NULL);
+}
+
+typedef struct
+{
+    uint8_t type; /*<! RECORD_ENROLL or RECORD_DELETE >*/
+    int id;       /*<! id index >*/
+    float *emb;   /*<! embedding, freed by task >*/
+    char *name;   /*<! name, freed by task >*/
+} job_t;
+
+static FaceIDLogPartition *storage = NULL;
+static FaceIDLog *face_id_log = NULL;
+static QueueHandle_t xQueueJob = NULL;
+static SemaphoreHandle_t xMutex = NULL;
+
+static void task_log_handler(void *arg)
+{
+    job_t job;
+    while (true)
+    {
+        xQueueReceive(xQueueJob, &job, portMAX_DELAY);
+
+        xSemaphoreTake(xMutex, portMAX_DELAY);
+        bool ret = (job.type == RECORD_ENROLL) ? face_id_log->append(job.id, job.emb, job.name ? job.name : "") : face_id_log->remove(job.id);
+        if (!ret)
+            ESP_LOGE(TAG, "fail to write id %d", job.id);
+        if (face_id_log->need_compaction())
+            face_id_log->compact();
+        xSemaphoreGive(xMutex);
+
+        free(job.emb);
+        free(job.name);
+    }
+}
+
+bool register_face_id_log(const char *label, const int emb_size, const int core)
+{
+    storage = new FaceIDLogPartition(label);
+    if (!storage->valid())
+        return false;
+
+    face_id_log = new FaceIDLog(storage, emb_size);
+    xQueueJob = xQueueCreate(8, sizeof(job_t));
+    xMutex = xSemaphoreCreateMutex();
+    xTaskCreatePinnedToCore(task_log_handler, TAG, 4 * 1024, NULL, 2, NULL, core);
+    return true;
+}
+
+bool face_id_log_read(std::vector<FaceIDLog::face_record_t> &records)
+{
+    if (face_id_log == NULL)
+        return false;
+
+    xSemaphoreTake(xMutex, portMAX_DELAY);
+    bool ret = face_id_log->load(records);
+    xSemaphoreGive(xMutex);
+    return ret;
+}
+
+bool face_id_log_reset(std::vector<FaceIDLog::face_record_t> &records)
+{
+    if (face_id_log == NULL)
+        return false;
+
+    xSemaphoreTake(xMutex, portMAX_DELAY);
+    bool ret = face_id_log->reset(records);
+    xSemaphoreGive(xMutex);
+    return ret;
+}
+
+bool face_id_log_append(int id, dl::Tensor<float> &emb, const std::string &name)
+{
+    if (xQueueJob == NULL)
+        return false;
+
+    job_t job = {RECORD_ENROLL, id, (float *)malloc(emb.get_size() * sizeof(float)), name.length() ? strdup(name.c_str()) : NULL};
+    if (job.emb == NULL || (name.length() && job.name == NULL))
+    {
+        ESP_LOGE(TAG, "no memory to log id %d", id);
+        free(job.emb);
+        free(job.name);
+        return false;
+    }
+    memcpy(job.emb, emb.element, emb.get_size() * sizeof(float));
+    if (xQueueSend(xQueueJob, &job, pdMS_TO_TICKS(JOB_TIMEOUT_MS)) != pdTRUE)
+    {
+        ESP_LOGE(TAG, "log is busy, id %d is not logged", id);
+        free(job.emb);
+        free(job.name);
+        return false;
+    }
+    return true;
+}
+
+bool face_id_log_remove(int id)
+{
+    if (xQueueJob == NULL)
+        return false;
+
+    job_t job = {RECORD_DELETE, id, NULL, NULL};
+    if (xQueueSend(xQueueJob, &job, pdMS_TO_TICKS(JOB_TIMEOUT_MS)) != pdTRUE)
+    {
+        ESP_LOGE(TAG, "log is busy, deletion of id %d is not logged", id);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#include "esp_log.h"
+#include "face_recognizer.hpp"
+
+/**
+ * @brief Raw storage of FaceIDLog, e.g., a flash partition or a file standing in for it.
+ * NOTE: like NOR flash, write() may only clear bits, and an erased byte reads 0xFF.
+ */
+class FaceIDLogStorage
+{
+public:
+    virtual ~FaceIDLogStorage() {}
+
+    /**
+     * @brief Get the size of storage in byte.
+     */
+    virtual int size() = 0;
+
+    /**
+     * @brief Get the erase unit in byte.
+     */
+    virtual int sector_size() = 0;
+
+    virtual bool read(int offset, void *data, int size) = 0;
+    virtual bool write(int offset, const void *data, int size) = 0;
+    virtual bool erase(int offset, int size) = 0;
+};
+
+/**
+ * @brief Face ID storage on flash partition.
+ */
+class FaceIDLogPartition : public FaceIDLogStorage
+{
+private:
+    const void *partition; /*<! esp_partition_t >*/
+
+public:
+    /**
+     * @brief Construct a new FaceIDLogPartition object
+     *
+     * @param label the partition label, e.g., "fr"
+     */
+    FaceIDLogPartition(const char *label);
+
+    /**
+     * @brief Whether the partition is found.
+     */
+    bool valid() { return this->partition != NULL; }
+
+    int size();
+    int sector_size();
+    bool read(int offset, void *data, int size);
+    bool write(int offset, const void *data, int size);
+    bool erase(int offset, int size);
+};
+
+/**
+ * @brief Append-only log of enrolled face ids.
+ *
+ * The storage is split into two areas. The active area starts with a header and is followed by records:
+ *         - enroll record: id, name and embedding,
+ *         - delete record: id only, i.e., a tombstone.
+ * Enrolling or deleting one id appends one record, no matter how many ids are enrolled. When the active area is
+ * full or mostly dead, compact() copies the live records to the other area and switches to it by committing its
+ * header, so a power loss at any time leaves one complete area. A new log starts in area 1, so the ids written at
+ * the start of the partition by FaceRecognizer::write_ids_to_flash() are kept until the migrated log is committed.
+ */
+class FaceIDLog
+{
+public:
+    /**
+     * @brief A live face id.
+     */
+    typedef struct
+    {
+        int id;                 /*<! id index >*/
+        std::string name;       /*<! id name >*/
+        std::vector<float> emb; /*<! normalized embedding >*/
+    } face_record_t;
+
+private:
+    typedef struct
+    {
+        int id;     /*<! id index >*/
+        int offset; /*<! offset of the enroll record in the active area >*/
+        int size;   /*<! size of the enroll record >*/
+    } entry_t;
+
+    FaceIDLogStorage *storage;  /*<! raw storage >*/
+    const int emb_size;         /*<! number of elements in an embedding >*/
+    int area_size;              /*<! size of each area, aligned to sector >*/
+    int active;                 /*<! index of active area, -1 for none >*/
+    uint32_t sequence;          /*<! sequence of active area >*/
+    int tail;                   /*<! offset in active area to append >*/
+    int dead_size;              /*<! bytes of deleted records and tombstones >*/
+    bool broken;                /*<! a torn record is found, compact before appending >*/
+    std::vector<entry_t> index; /*<! live ids >*/
+
+    int record_size(int name_length);
+    bool append_record(uint8_t type, int id, const float *emb, const std::string &name);
+    bool switch_area(std::vector<face_record_t> *records);
+
+public:
+    /**
+     * @brief Construct a new FaceIDLog object
+     *
+     * @param storage   raw storage
+     * @param emb_size  number of elements in an embedding
+     */
+    FaceIDLog(FaceIDLogStorage *storage, const int emb_size = 512);
+
+    /**
+     * @brief Scan the storage and read all live ids.
+     *
+     * @param records   the live ids in the order of enrollment
+     * @return true: a valid log is found
+     *         false: no valid log, call reset() to start a new one
+     */
+    bool load(std::vector<face_record_t> &records);
+
+    /**
+     * @brief Start a new log with the given ids. Used to migrate from another format, without a valid log the ids are
+     * written to area 1 and area 0 is left as it is.
+     *
+     * @param records the ids to write
+     * @return true: success
+     */
+    bool reset(std::vector<face_record_t> &records);
+
+    /**
+     * @brief Append an enroll record.
+     *
+     * @param id    id index
+     * @param emb   normalized embedding with emb_size elements
+     * @param name  id name
+     * @return true: success
+     */
+    bool append(int id, const float *emb, const std::string &name = "");
+
+    /**
+     * @brief Append a tombstone of id.
+     *
+     * @param id id index
+     * @return true: success
+     */
+    bool remove(int id);
+
+    /**
+     * @brief Whether compact() is worth doing, i.e., the area is nearly full or half dead.
+     */
+    bool need_compaction();
+
+    /**
+     * @brief Copy the live records to the other area and switch to it.
+     *
+     * @return true: success
+     */
+    bool compact();
+
+    /**
+     * @brief Get the number of live ids.
+     */
+    int size() { return this->index.size(); }
+};
+
+/**
+ * @brief Keep the enrolled ids in partition by FaceIDLog. Flash is written in a background task, so enroll and delete
+ *        do not block the caller.
+ *
+ * @param label    the partition label, e.g., "fr"
+ * @param emb_size number of elements in an embedding
+ * @param core     core to run the background task
+ * @return true: success
+ */
+bool register_face_id_log(const char *label, const int emb_size = 512, const int core = 1);
+
+/**
+ * @brief Read the live ids from log.
+ *
+ * @param records the live ids in the order of enrollment
+ * @return true: success
+ *         false: there is no valid log in partition
+ */
+bool face_id_log_read(std::vector<FaceIDLog::face_record_t> &records);
+
+/**
+ * @brief Rewrite the log with the given ids, blocks until flash is written.
+ *
+ * @param records the ids to write
+ * @return true: success
+ */
+bool face_id_log_reset(std::vector<FaceIDLog::face_record_t> &records);
+
+/**
+ * @brief Queue an enroll record. Waits at most 100 ms if the queue is full, e.g., while the log is being compacted.
+ *
+ * @param id    id index
+ * @param emb   normalized embedding, copied
+ * @param name  id name
+ * @return true: queued
+ *         false: the record is dropped for no memory or full queue, the id is kept in RAM only
+ */
+bool face_id_log_append(int id, dl::Tensor<float> &emb, const std::string &name = "");
+
+/**
+ * @brief Queue a tombstone. Waits at most 100 ms if the queue is full.
+ *
+ * @param id id index
+ * @return true: queued
+ *         false: the tombstone is dropped for full queue, the id comes back at next boot
+ */
+bool face_id_log_remove(int id);
+
+/**
+ * @brief Queue the enroll records of ids kept in RAM only, i.e., the ones face_id_log_append() failed to queue.
+ * NOTE: call it before queueing a tombstone, so that records stay in order.
+ *
+ * @tparam feature_t int16_t or int8_t
+ * @param recognizer the recognizer holding the embeddings
+ * @param unsaved    ids not logged yet, the ones queued or no longer enrolled are removed
+ * @return int number of ids still unsaved
+ */
+template <typename feature_t>
+int face_id_log_flush(FaceRecognizer<feature_t> *recognizer, std::vector<int> &unsaved)
+{
+    if (unsaved.empty())
+        return 0;
+
+    std::vector<face_info_t> ids = recognizer->get_enrolled_ids();
+    for (std::vector<int>::iterator id = unsaved.begin(); id != unsaved.end();)
+    {
+        bool enrolled = false;
+        for (int i = 0; i < ids.size() && !enrolled; i++)
+            enrolled = ids[i].id == *id;
+        if (enrolled && !face_id_log_append(*id, recognizer->get_face_emb(*id)))
+            break; // still busy, keep the order
+        id = unsaved.erase(id);
+    }
+    return unsaved.size();
+}
+
+/**
+ * @brief Enroll the ids in log to recognizer. If there is no valid log, the ids written by
+ *        FaceRecognizer::write_ids_to_flash() are read and rewritten as a new log.
+ * NOTE: the ids are renumbered if the recognizer assigns different id indexes, and the log is rewritten accordingly.
+ *       If the log can not be written, an error is logged and the ids are kept in RAM only.
+ *
+ * @tparam feature_t int16_t or int8_t
+ * @param recognizer the recognizer, whose partition must have been set
+ * @return int number of enrolled ids
+ */
+template <typename feature_t>
+int face_id_log_load(FaceRecognizer<feature_t> *recognizer)
+{
+    std::vector<FaceIDLog::face_record_t> records;
+    if (!face_id_log_read(records))
+    {
+        if (recognizer->set_ids_from_flash() > 0)
+        {
+            std::vector<face_info_t> ids = recognizer->get_enrolled_ids();
+            for (int i = 0; i < ids.size(); i++)
+            {
+                dl::Tensor<float> &emb = recognizer->get_face_emb(ids[i].id);
+                records.push_back({ids[i].id, ids[i].name, std::vector<float>(emb.element, emb.element + emb.get_size())});
+            }
+        }
+        if (!face_id_log_reset(records))
+            ESP_LOGE("face_id_log", "fail to write %d migrated ids to log", (int)records.size());
+        return recognizer->get_enrolled_id_num();
+    }
+
+    bool renumbered = false;
+    for (int i = 0; i < records.size(); i++)
+    {
+        dl::Tensor<float> emb;
+        emb.set_element(records[i].emb.data()).set_shape({(int)records[i].emb.size()});
+        int id = recognizer->enroll_id(emb, records[i].name, false);
+        if (id != records[i].id)
+        {
+            records[i].id = id;
+            renumbered = true;
+        }
+    }
+    if (renumbered && !face_id_log_reset(records))
+        ESP_LOGE("face_id_log", "fail to rewrite renumbered ids, they are renumbered again at next boot");
+    return recognizer->get_enrolled_id_num();
+}
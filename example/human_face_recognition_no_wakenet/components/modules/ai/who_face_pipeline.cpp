@@ -0,0 +1,247 @@
+#include "who_face_pipeline.hpp"
+
+#include "esp_log.h"
+
+static const char *TAG = "face_pipeline";
+
+template <typename feature_t>
+FacePipeline<feature_t>::FacePipeline(FaceRecognizer<feature_t> *recognizer,
+                                      QueueHandle_t input,
+                                      const int depth,
+                                      const int core,
+                                      const int stack_size,
+                                      const int priority) : recognizer(recognizer),
+                                                            input(input),
+                                                            task(NULL),
+                                                            epoch(0),
+                                                            pending(0),
+                                                            spinlock(portMUX_INITIALIZER_UNLOCKED)
+{
+    for (int i = 0; i < 2; i++)
+        this->stats[i] = {0, 0, 0, 0};
+
+    // a job in the queue, one in recognition and one finished, so the recognition stage never waits for results
+    this->jobs = xQueueCreate(depth, sizeof(job_t *));
+    this->results = xQueueCreate(depth + 2, sizeof(job_t *));
+    this->mutex = xSemaphoreCreateMutex();
+    if (xTaskCreatePinnedToCore(task_loop, TAG, stack_size, this, priority, &this->task, core) != pdPASS)
+    {
+        this->task = NULL;
+        ESP_LOGE(TAG, "fail to create recognition stage");
+    }
+}
+
+template <typename feature_t>
+FacePipeline<feature_t>::~FacePipeline()
+{
+    // the recognition stage only holds mutex while recognizing
+    this->lock();
+    if (this->task)
+        vTaskDelete(this->task);
+    this->unlock();
+
+    job_t *job = NULL;
+    while (xQueueReceive(this->jobs, &job, 0) == pdTRUE)
+        delete job;
+    while (xQueueReceive(this->results, &job, 0) == pdTRUE)
+        delete job;
+
+    vQueueDelete(this->jobs);
+    vQueueDelete(this->results);
+    vSemaphoreDelete(this->mutex);
+}
+
+template <typename feature_t>
+void FacePipeline<feature_t>::task_loop(void *arg)
+{
+    FacePipeline<feature_t> *self = (FacePipeline<feature_t> *)arg;
+    job_t *job = NULL;
+    while (true)
+    {
+        if (xQueueReceive(self->jobs, &job, portMAX_DELAY) != pdTRUE)
+            continue;
+
+        if (job->epoch != self->epoch)
+        {
+            self->finish(job, true);
+            continue;
+        }
+
+        std::vector<int> face_shape = {job->faces.shape[1], job->faces.shape[2], job->faces.shape[3]};
+        int face_size = face_shape[0] * face_shape[1] * face_shape[2];
+        job->results.reserve(job->ids.size());
+
+        xSemaphoreTake(self->mutex, portMAX_DELAY);
+        for (int i = 0; i < job->ids.size(); i++)
+        {
+            Tensor<uint8_t> aligned_face;
+            aligned_face.set_element(job->faces.element + i * face_size).set_shape(face_shape);
+            job->results.push_back({job->ids[i], self->recognizer->recognize(aligned_face)});
+        }
+        xSemaphoreGive(self->mutex);
+
+        portENTER_CRITICAL(&self->spinlock);
+        self->stats[FACE_STAGE_RECOGNITION].processed++;
+        portEXIT_CRITICAL(&self->spinlock);
+
+        if (xQueueSend(self->results, &job, 0) != pdTRUE)
+            self->finish(job, true);
+    }
+}
+
+template <typename feature_t>
+void FacePipeline<feature_t>::finish(job_t *job, bool dropped)
+{
+    portENTER_CRITICAL(&this->spinlock);
+    this->pending--;
+    if (dropped)
+        this->stats[FACE_STAGE_RECOGNITION].dropped++;
+    portEXIT_CRITICAL(&this->spinlock);
+    delete job;
+}
+
+template <typename feature_t>
+bool FacePipeline<feature_t>::submit(uint16_t *image, const std::vector<int> &shape, std::vector<int> &ids, std::vector<std::vector<int>> &landmarks)
+{
+    int input_depth = this->input ? uxQueueMessagesWaiting(this->input) : 0;
+    stage_stats_t &detection = this->stats[FACE_STAGE_DETECTION];
+    portENTER_CRITICAL(&this->spinlock);
+    detection.processed++;
+    if (input_depth > detection.max_depth)
+        detection.max_depth = input_depth;
+    portEXIT_CRITICAL(&this->spinlock);
+
+    if (ids.empty())
+        return true;
+
+    // drop before aligning, the faces will be submitted again with a later frame
+    if (this->task == NULL || uxQueueSpacesAvailable(this->jobs) == 0)
+    {
+        portENTER_CRITICAL(&this->spinlock);
+        detection.dropped++;
+        portEXIT_CRITICAL(&this->spinlock);
+        return false;
+    }
+
+    std::vector<int> face_shape = this->recognizer->get_input_shape();
+    int face_size = face_shape[0] * face_shape[1] * face_shape[2];
+
+    job_t *job = new job_t;
+    job->epoch = this->epoch;
+    job->ids = ids;
+    job->faces.set_shape({(int)ids.size(), face_shape[0], face_shape[1], face_shape[2]});
+    job->faces.malloc_element();
+    if (job->faces.element == NULL)
+    {
+        delete job;
+        portENTER_CRITICAL(&this->spinlock);
+        detection.dropped++;
+        portEXIT_CRITICAL(&this->spinlock);
+        return false;
+    }
+
+    // the frame is only read here, so it can be drawn on and released once submit() returns
+    for (int i = 0; i < ids.size(); i++)
+    {
+        Tensor<uint8_t> aligned_face;
+        aligned_face.set_element(job->faces.element + i * face_size).set_shape(face_shape);
+        face_recognition_tool::align_face(image, shape, &aligned_face, landmarks[i]);
+    }
+
+    // counted before sending, the recognition stage may finish it at once
+    portENTER_CRITICAL(&this->spinlock);
+    this->pending++;
+    portEXIT_CRITICAL(&this->spinlock);
+
+    if (xQueueSend(this->jobs, &job, 0) != pdTRUE)
+    {
+        delete job;
+        portENTER_CRITICAL(&this->spinlock);
+        this->pending--;
+        detection.dropped++;
+        portEXIT_CRITICAL(&this->spinlock);
+        return false;
+    }
+
+    int depth = uxQueueMessagesWaiting(this->jobs);
+    stage_stats_t &recognition = this->stats[FACE_STAGE_RECOGNITION];
+    portENTER_CRITICAL(&this->spinlock);
+    if (depth > recognition.max_depth)
+        recognition.max_depth = depth;
+    portEXIT_CRITICAL(&this->spinlock);
+    return true;
+}
+
+template <typename feature_t>
+int FacePipeline<feature_t>::collect(std::vector<face_pipeline_result_t> &results)
+{
+    int count = 0;
+    job_t *job = NULL;
+    while (xQueueReceive(this->results, &job, 0) == pdTRUE)
+    {
+        bool valid = (job->epoch == this->epoch);
+        if (valid)
+        {
+            results.insert(results.end(), job->results.begin(), job->results.end());
+            count += job->results.size();
+        }
+        this->finish(job, !valid);
+    }
+    return count;
+}
+
+template <typename feature_t>
+void FacePipeline<feature_t>::invalidate()
+{
+    this->epoch++;
+}
+
+template <typename feature_t>
+int FacePipeline<feature_t>::get_pending()
+{
+    portENTER_CRITICAL(&this->spinlock);
+    int pending = this->pending;
+    portEXIT_CRITICAL(&this->spinlock);
+    return pending;
+}
+
+template <typename feature_t>
+typename FacePipeline<feature_t>::stage_stats_t FacePipeline<feature_t>::get_stats(face_stage_t stage)
+{
+    portENTER_CRITICAL(&this->spinlock);
+    stage_stats_t stats = this->stats[stage];
+    portEXIT_CRITICAL(&this->spinlock);
+
+    if (stage == FACE_STAGE_DETECTION)
+        stats.depth = this->input ? uxQueueMessagesWaiting(this->input) : 0;
+    else
+        stats.depth = uxQueueMessagesWaiting(this->jobs);
+    return stats;
+}
+
+template <typename feature_t>
+void FacePipeline<feature_t>::print_stats()
+{
+    const char *names[] = {"detection", "recognition"};
+    for (int i = 0; i < 2; i++)
+    {
+        stage_stats_t stats = this->get_stats((face_stage_t)i);
+        ESP_LOGI(TAG, "%s: processed %u, dropped %u, depth %d, max depth %d",
+                 names[i], (unsigned)stats.processed, (unsigned)stats.dropped, stats.depth, stats.max_depth);
+    }
+}
+
+template <typename feature_t>
+void FacePipeline<feature_t>::lock()
+{
+    xSemaphoreTake(this->mutex, portMAX_DELAY);
+}
+
+template <typename feature_t>
+void FacePipeline<feature_t>::unlock()
+{
+    xSemaphoreGive(this->mutex);
+}
+
+template class FacePipeline<int8_t>;
+template class FacePipeline<int16_t>;
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "face_recognizer.hpp"
+
+typedef enum
+{
+    FACE_STAGE_DETECTION = 0,   /*<! detection, tracking and alignment, on the task calling submit() >*/
+    FACE_STAGE_RECOGNITION = 1, /*<! recognition of aligned faces, on the task of pipeline >*/
+} face_stage_t;
+
+/**
+ * @brief Recognition result of a face.
+ */
+typedef struct
+{
+    int id;             /*<! track id given to submit() >*/
+    face_info_t result; /*<! recognition result >*/
+} face_pipeline_result_t;
+
+/**
+ * @brief Detection and recognition of faces as two stages on different cores.
+ *
+ * The detection stage is the task that owns the frames. For each frame it calls submit() with the faces to recognize,
+ * which are aligned at once into a job, so the frame can be drawn on and released right after. Jobs go through a
+ * bounded queue to the recognition stage, a task pinned to another core, and come back by collect() as results of
+ * the track ids they were submitted with. While the recognition of frame N runs, the detection of frame N + 1 goes
+ * on, so throughput is bound by the slower stage instead of the sum of both.
+ *
+ * A job is dropped when the queue is full. Each stage counts what it processed and dropped, and the depth of its
+ * input queue.
+ *
+ * @tparam feature_t int16_t or int8_t
+ */
+template <typename feature_t>
+class FacePipeline
+{
+public:
+    /**
+     * @brief Counters of a stage.
+     */
+    typedef struct
+    {
+        uint32_t processed; /*<! frames detected or jobs recognized >*/
+        uint32_t dropped;   /*<! jobs not accepted by the next stage, or results out of date >*/
+        int depth;          /*<! items waiting in the input queue now >*/
+        int max_depth;      /*<! maximum depth seen >*/
+    } stage_stats_t;
+
+private:
+    /**
+     * @brief Faces of a frame to recognize.
+     */
+    typedef struct
+    {
+        uint32_t epoch;                              /*<! epoch at submit() >*/
+        std::vector<int> ids;                        /*<! track ids >*/
+        Tensor<uint8_t> faces;                       /*<! [N, H, W, C] aligned faces >*/
+        std::vector<face_pipeline_result_t> results; /*<! filled by the recognition stage >*/
+    } job_t;
+
+    FaceRecognizer<feature_t> *recognizer; /*<! shared by both stages under mutex >*/
+    QueueHandle_t input;                   /*<! frame queue of the detection stage, may be NULL >*/
+    QueueHandle_t jobs;                    /*<! job_t * to the recognition stage >*/
+    QueueHandle_t results;                 /*<! job_t * back to the detection stage >*/
+    SemaphoreHandle_t mutex;               /*<! guards recognizer >*/
+    TaskHandle_t task;                     /*<! task of the recognition stage >*/
+    volatile uint32_t epoch;               /*<! increased by invalidate() >*/
+    int pending;                           /*<! jobs submitted and not collected or dropped >*/
+    stage_stats_t stats[2];                /*<! indexed by face_stage_t >*/
+    portMUX_TYPE spinlock;                 /*<! guards pending and stats >*/
+
+    static void task_loop(void *arg);
+    void finish(job_t *job, bool dropped);
+
+public:
+    /**
+     * @brief Construct a new Face Pipeline object and start the recognition stage.
+     *
+     * @param recognizer recognizer used by both stages
+     * @param input      frame queue of the detection stage, only to report its depth, may be NULL
+     * @param depth      maximum number of jobs waiting for recognition
+     * @param core       core of the recognition stage, should differ from the detection stage
+     * @param stack_size stack size of the recognition task in byte
+     * @param priority   priority of the recognition task
+     */
+    FacePipeline(FaceRecognizer<feature_t> *recognizer,
+                 QueueHandle_t input = NULL,
+                 const int depth = 2,
+                 const int core = 0,
+                 const int stack_size = 4 * 1024,
+                 const int priority = 5);
+
+    /**
+     * @brief Destroy the Face Pipeline object. Jobs not collected are dropped.
+     */
+    ~FacePipeline();
+
+    /**
+     * @brief Hand the faces of a frame to the recognition stage, never blocks. Call it once per frame, with no face
+     *        if nothing is to be recognized, so the detection stage is counted.
+     *
+     * @param image     RGB565 frame
+     * @param shape     shape of frame
+     * @param ids       track ids of faces
+     * @param landmarks landmarks of faces, in the same order as ids, entries beyond ids are ignored
+     * @return true: the faces are queued, or there is no face
+     *         false: the job is dropped because the recognition stage is full
+     */
+    bool submit(uint16_t *image, const std::vector<int> &shape, std::vector<int> &ids, std::vector<std::vector<int>> &landmarks);
+
+    /**
+     * @brief Take the results finished since the last call, never blocks. Results submitted before invalidate() are
+     *        dropped.
+     *
+     * @param results results are appended here
+     * @return int number of results appended
+     */
+    int collect(std::vector<face_pipeline_result_t> &results);
+
+    /**
+     * @brief Drop the jobs in flight, e.g., after the enrolled ids changed.
+     */
+    void invalidate();
+
+    /**
+     * @brief Get the number of jobs submitted and not collected yet.
+     */
+    int get_pending();
+
+    /**
+     * @brief Get the counters of a stage.
+     *
+     * @param stage stage
+     * @return stage_stats_t counters
+     */
+    stage_stats_t get_stats(face_stage_t stage);
+
+    /**
+     * @brief Print the counters of both stages.
+     */
+    void print_stats();
+
+    /**
+     * @brief Take the recognizer from the recognition stage, e.g., for enrolling or deleting ids. Pair with unlock().
+     */
+    void lock();
+
+    /**
+     * @brief Give the recognizer back to the recognition stage.
+     */
+    void unlock();
+};
@@ -0,0 +1,222 @@
+#include "who_face_tracker.hpp"
+
+#include "dl_define.hpp"
+
+static float iou(const int *a, const int *b)
+{
+    int w = DL_MIN(a[2], b[2]) - DL_MAX(a[0], b[0]) + 1;
+    int h = DL_MIN(a[3], b[3]) - DL_MAX(a[1], b[1]) + 1;
+    if (w <= 0 || h <= 0)
+        return 0.f;
+
+    float inter = (float)w * h;
+    float area_a = (float)(a[2] - a[0] + 1) * (a[3] - a[1] + 1);
+    float area_b = (float)(b[2] - b[0] + 1) * (b[3] - b[1] + 1);
+    return inter / (area_a + area_b - inter);
+}
+
+static void state_to_box(const float *state, int *box)
+{
+    box[0] = (int)(state[0] - state[2] / 2);
+    box[1] = (int)(state[1] - state[3] / 2);
+    box[2] = (int)(state[0] + state[2] / 2);
+    box[3] = (int)(state[1] + state[3] / 2);
+}
+
+static void box_to_state(const std::vector<int> &box, float *state)
+{
+    state[0] = (box[0] + box[2]) / 2.f;
+    state[1] = (box[1] + box[3]) / 2.f;
+    state[2] = box[2] - box[0];
+    state[3] = box[3] - box[1];
+}
+
+FaceTracker::FaceTracker(const int detect_interval,
+                         const float iou_threshold,
+                         const int max_missed,
+                         const float alpha,
+                         const float beta,
+                         const float smoothing,
+                         const int max_tracks) : detect_interval(detect_interval),
+                                                  iou_threshold(iou_threshold),
+                                                  max_missed(max_missed),
+                                                  alpha(alpha),
+                                                  beta(beta),
+                                                  smoothing(smoothing),
+                                                  max_tracks(max_tracks),
+                                                  frame_count(0),
+                                                  next_id(1),
+                                                  lost(false),
+                                                  pool(2 * max_tracks)
+{
+    this->unmatched.reserve(2 * max_tracks);
+}
+
+bool FaceTracker::need_detection()
+{
+    return this->lost || this->frame_count % this->detect_interval == 0;
+}
+
+std::list<dl::detect::result_t> &FaceTracker::predict()
+{
+    this->pool.clear(this->candidates);
+    for (auto &track : this->tracks)
+    {
+        for (int i = 0; i < 4; i++)
+            track.state[i] += track.velocity[i];
+        for (int i = 0; i < track.keypoint.size(); i += 2)
+        {
+            track.keypoint[i] += track.velocity[0];
+            track.keypoint[i + 1] += track.velocity[1];
+        }
+
+        dl::detect::result_t *candidate = this->pool.take(this->candidates);
+        if (candidate == NULL)
+            continue;
+        candidate->category = 0;
+        candidate->score = track.score;
+        candidate->box.resize(4);
+        state_to_box(track.state, candidate->box.data());
+        candidate->keypoint.clear();
+    }
+    return this->candidates;
+}
+
+std::list<dl::detect::result_t> &FaceTracker::update(std::list<dl::detect::result_t> &detections, bool full_detection)
+{
+    if (full_detection)
+    {
+        this->frame_count = 0;
+        this->lost = false;
+    }
+    this->frame_count++;
+
+    std::vector<dl::detect::result_t *> &unmatched = this->unmatched;
+    unmatched.clear();
+    for (auto &detection : detections)
+        unmatched.push_back(&detection);
+
+    // greedy association, tracks are in order of creation so older tracks win
+    for (auto &track : this->tracks)
+    {
+        int box[4];
+        state_to_box(track.state, box);
+        int best = -1;
+        float best_iou = this->iou_threshold;
+        for (int i = 0; i < unmatched.size(); i++)
+        {
+            float value = iou(box, unmatched[i]->box.data());
+            if (value > best_iou)
+            {
+                best_iou = value;
+                best = i;
+            }
+        }
+
+        track.age++;
+        if (best < 0)
+        {
+            track.missed++;
+            continue;
+        }
+
+        dl::detect::result_t *detection = unmatched[best];
+        unmatched.erase(unmatched.begin() + best);
+
+        float measurement[4];
+        box_to_state(detection->box, measurement);
+        for (int i = 0; i < 4; i++)
+        {
+            float residual = measurement[i] - track.state[i];
+            track.state[i] += this->alpha * residual;
+            track.velocity[i] += this->beta * residual;
+        }
+
+        if (track.keypoint.size() != detection->keypoint.size())
+            track.keypoint.assign(detection->keypoint.begin(), detection->keypoint.end());
+        else
+            for (int i = 0; i < track.keypoint.size(); i++)
+                track.keypoint[i] = this->smoothing * track.keypoint[i] + (1.f - this->smoothing) * detection->keypoint[i];
+
+        track.score = detection->score;
+        track.missed = 0;
+    }
+
+    for (auto track = this->tracks.begin(); track != this->tracks.end();)
+    {
+        if (track->missed > this->max_missed)
+        {
+            track = this->tracks.erase(track);
+            this->lost = true;
+        }
+        else
+            track++;
+    }
+
+    // faces never seen before only come from full detection
+    if (full_detection)
+    {
+        for (auto detection : unmatched)
+        {
+            if (this->tracks.size() >= this->max_tracks)
+                break;
+
+            track_t track;
+            track.id = this->next_id++;
+            box_to_state(detection->box, track.state);
+            for (int i = 0; i < 4; i++)
+                track.velocity[i] = 0.f;
+            track.keypoint.assign(detection->keypoint.begin(), detection->keypoint.end());
+            track.score = detection->score;
+            track.age = 0;
+            track.missed = 0;
+            track.recognized = false;
+            track.result = {-1, "", -1.f};
+            this->tracks.push_back(track);
+        }
+    }
+    else if (unmatched.size())
+    {
+        this->lost = true;
+    }
+
+    this->pool.clear(this->results);
+    for (auto &track : this->tracks)
+    {
+        if (track.missed)
+            continue;
+
+        dl::detect::result_t *result = this->pool.take(this->results);
+        if (result == NULL)
+            break;
+        result->category = track.id;
+        result->score = track.score;
+        result->box.resize(4);
+        state_to_box(track.state, result->box.data());
+        result->keypoint.resize(track.keypoint.size());
+        for (int i = 0; i < track.keypoint.size(); i++)
+            result->keypoint[i] = (int)track.keypoint[i];
+    }
+    return this->results;
+}
+
+std::list<FaceTracker::track_t> &FaceTracker::get_tracks()
+{
+    return this->tracks;
+}
+
+void FaceTracker::clear_recognition()
+{
+    for (auto &track : this->tracks)
+    {
+        track.recognized = false;
+        track.result = {-1, "", -1.f};
+    }
+}
+
+void FaceTracker::clear()
+{
+    this->tracks.clear();
+    this->frame_count = 0;
+    this->lost = false;
+}
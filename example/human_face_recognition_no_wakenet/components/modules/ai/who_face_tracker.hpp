@@ -0,0 +1,115 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include "dl_detect_define.hpp"
+#include "face_recognition_tool.hpp"
+
+/**
+ * @brief Track faces over frames, so the full detection is only needed every few frames.
+ *
+ * Each track keeps its box as center, width and height with a constant velocity, filtered by an alpha-beta filter,
+ * i.e., a steady-state Kalman filter. Between full detections, predict() gives the boxes expected in the next frame,
+ * which only need the second stage of detection to be confirmed. Detections are associated with tracks greedily by
+ * IoU. A track missed for more than max_missed frames is dropped and the next frame falls back to full detection.
+ * Lists given out are refilled from a pool of max_tracks results, so tracking known faces allocates nothing per frame.
+ */
+class FaceTracker
+{
+public:
+    /**
+     * @brief A tracked face.
+     */
+    typedef struct
+    {
+        int id;                      /*<! track id, unique since construction >*/
+        float state[4];              /*<! center x, center y, width, height >*/
+        float velocity[4];           /*<! change of state per frame >*/
+        std::vector<float> keypoint; /*<! smoothed keypoints >*/
+        float score;                 /*<! score of the last detection >*/
+        int age;                     /*<! number of frames since created >*/
+        int missed;                  /*<! number of frames since last detected >*/
+        bool recognized;             /*<! whether result is valid >*/
+        face_info_t result;          /*<! recognition result of this track >*/
+    } track_t;
+
+private:
+    const int detect_interval; /*<! run full detection every detect_interval frames >*/
+    const float iou_threshold; /*<! minimum IoU to associate a detection with a track >*/
+    const int max_missed;      /*<! drop a track missed for more than max_missed frames >*/
+    const float alpha;         /*<! gain of position >*/
+    const float beta;          /*<! gain of velocity >*/
+    const float smoothing;     /*<! weight of history keypoints, in [0, 1) >*/
+    const int max_tracks;      /*<! maximum number of live tracks >*/
+    int frame_count;           /*<! frames since last full detection >*/
+    int next_id;               /*<! id of next track >*/
+    bool lost;                 /*<! a track is dropped since last full detection >*/
+    std::list<track_t> tracks; /*<! live tracks >*/
+
+    dl::detect::ResultPool pool;                   /*<! results of candidates and results >*/
+    std::list<dl::detect::result_t> candidates;    /*<! predicted boxes of tracks >*/
+    std::list<dl::detect::result_t> results;       /*<! smoothed results of tracks >*/
+    std::vector<dl::detect::result_t *> unmatched; /*<! detections not associated yet, kept for its capacity >*/
+
+public:
+    /**
+     * @brief Construct a new Face Tracker object
+     *
+     * @param detect_interval run full detection every detect_interval frames
+     * @param iou_threshold   minimum IoU to associate a detection with a track
+     * @param max_missed      drop a track missed for more than max_missed frames
+     * @param alpha           gain of position in alpha-beta filter
+     * @param beta            gain of velocity in alpha-beta filter
+     * @param smoothing       weight of history keypoints, 0 for no smoothing
+     * @param max_tracks      maximum number of live tracks, faces beyond are not tracked
+     */
+    FaceTracker(const int detect_interval = 5,
+                const float iou_threshold = 0.3F,
+                const int max_missed = 1,
+                const float alpha = 0.7F,
+                const float beta = 0.3F,
+                const float smoothing = 0.5F,
+                const int max_tracks = 8);
+
+    /**
+     * @brief Whether the next frame needs full detection.
+     *
+     * @return true: every detect_interval frames or a track is lost
+     *         false: refining the boxes of predict() is enough
+     */
+    bool need_detection();
+
+    /**
+     * @brief Advance tracks to the next frame.
+     *
+     * @return std::list<dl::detect::result_t>& predicted boxes as detection candidates, valid until the next call
+     */
+    std::list<dl::detect::result_t> &predict();
+
+    /**
+     * @brief Update tracks with the detections of the frame predicted last.
+     *
+     * @param detections     detection results
+     * @param full_detection true: detections come from full detection, unmatched ones start new tracks
+     *                       false: detections come from refining the predicted boxes
+     * @return std::list<dl::detect::result_t>& smoothed results of tracks detected in this frame, category is track id
+     */
+    std::list<dl::detect::result_t> &update(std::list<dl::detect::result_t> &detections, bool full_detection);
+
+    /**
+     * @brief Get the live tracks, including the ones missed in this frame.
+     *
+     * @return std::list<track_t>& tracks
+     */
+    std::list<track_t> &get_tracks();
+
+    /**
+     * @brief Forget recognition results of all tracks, e.g., after the enrolled ids changed.
+     */
+    void clear_recognition();
+
+    /**
+     * @brief Drop all tracks.
+     */
+    void clear();
+};
@@ -6,10 +6,12 @@
 #include "dl_image.hpp"
 #include "human_face_detect_msr01.hpp"
 #include "human_face_detect_mnp01.hpp"
+#include "human_face_detect_cascade.hpp"
 
 #include "who_ai_utils.hpp"
 
 #define TWO_STAGE_ON 1
+#define LATENCY_PRINT_INTERVAL 16 // detections between latency logs, the window latency is averaged over
 
 static const char *TAG = "human_face_detection";
 
@@ -24,9 +26,11 @@ static bool gReturnFB = true;
 static void task_process_handler(void *arg)
 {
     camera_fb_t *frame = NULL;
-    HumanFaceDetectMSR01 detector(0.3F, 0.3F, 10, 0.3F);
 #if TWO_STAGE_ON
-    HumanFaceDetectMNP01 detector2(0.4F, 0.3F, 10);
+    HumanFaceDetectCascade detector(0.3F, 0.3F, 10, 0.3F, 0.4F, 0.3F, 1, 5);
+    uint32_t detections = 0;
+#else
+    HumanFaceDetectMSR01 detector(0.3F, 0.3F, 10, 0.3F);
 #endif
 
     while (true)
@@ -36,17 +40,18 @@ static void task_process_handler(void *arg)
             bool is_detected = false;
             if (xQueueReceive(xQueueFrameI, &frame, portMAX_DELAY))
             {
-#if TWO_STAGE_ON
-                std::list<dl::detect::result_t> &detect_candidates = detector.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3});
-                std::list<dl::detect::result_t> &detect_results = detector2.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_candidates);
-#else
                 std::list<dl::detect::result_t> &detect_results = detector.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3});
-#endif
 
                 if (detect_results.size() > 0)
                 {
                     draw_detection_result((uint16_t *)frame->buf, frame->height, frame->width, detect_results);
                     print_detection_result(detect_results);
+#if TWO_STAGE_ON
+                    if (++detections % LATENCY_PRINT_INTERVAL == 0)
+                        ESP_LOGI(TAG, "latency of stage 1: %lu %s, stage 2: %lu %s",
+                                 (unsigned long)detector.get_stage1_latency().get_average_period(), DL_LOG_LATENCY_UNIT ? "cycle" : "us",
+                                 (unsigned long)detector.get_stage2_latency().get_average_period(), DL_LOG_LATENCY_UNIT ? "cycle" : "us");
+#endif
                     is_detected = true;
                 }
             }
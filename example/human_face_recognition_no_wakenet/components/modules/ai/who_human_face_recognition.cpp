@@ -8,6 +8,7 @@
 
 #include "human_face_detect_msr01.hpp"
 #include "human_face_detect_mnp01.hpp"
+#include "human_face_detect_cascade.hpp"
 #include "face_recognition_tool.hpp"
 
 #if CONFIG_MFN_V1
@@ -19,6 +20,7 @@
 #endif
 
 #include "who_ai_utils.hpp"
+#include "who_face_id_log.hpp"
 
 using namespace std;
 using namespace dl;
@@ -33,6 +35,7 @@ static QueueHandle_t xQueueResult = NULL;
 static recognizer_state_t gEvent = DETECT;
 static bool gReturnFB = true;
 static face_info_t recognize_result;
+static std::vector<face_info_t> recognize_results;
 
 SemaphoreHandle_t xMutex;
 
@@ -86,8 +89,7 @@ static int rgb_printf(camera_fb_t *fb, uint32_t color, const char *format, ...)
 static void task_process_handler(void *arg)
 {
     camera_fb_t *frame = NULL;
-    HumanFaceDetectMSR01 detector(0.3F, 0.3F, 10, 0.3F);
-    HumanFaceDetectMNP01 detector2(0.4F, 0.3F, 10);
+    HumanFaceDetectCascade detector(0.3F, 0.3F, 10, 0.3F, 0.4F, 0.3F, 1, 5);
 
 #if CONFIG_MFN_V1
 #if CONFIG_S8
@@ -99,7 +101,10 @@ static void task_process_handler(void *arg)
     show_state_t frame_show_state = SHOW_STATE_IDLE;
     recognizer_state_t _gEvent;
     recognizer->set_partition(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "fr");
-    int partition_result = recognizer->set_ids_from_flash();
+    // ids are kept in an append-only log, flash is written in background instead of stalling the frames
+    register_face_id_log("fr", 512);
+    face_id_log_load(recognizer);
+    std::vector<int> unsaved_ids; // enrolled ids the log did not take yet
 
     while (true)
     {
@@ -114,35 +119,62 @@ static void task_process_handler(void *arg)
 
             if (xQueueReceive(xQueueFrameI, &frame, portMAX_DELAY))
             {
-                std::list<dl::detect::result_t> &detect_candidates = detector.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3});
-                std::list<dl::detect::result_t> &detect_results = detector2.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_candidates);
+                std::list<dl::detect::result_t> &detect_results = detector.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3});
 
                 if (detect_results.size() == 1)
                     is_detected = true;
+                else if (detect_results.size() > 1 && _gEvent == RECOGNIZE)
+                    is_detected = true; // every face in a group is recognized in one call
 
                 if (is_detected)
                 {
                     switch (_gEvent)
                     {
                     case ENROLL:
-                        recognizer->enroll_id((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_results.front().keypoint, "", true);
-                        ESP_LOGW("ENROLL", "ID %d is enrolled", recognizer->get_enrolled_ids().back().id);
+                    {
+                        int id = recognizer->enroll_id((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_results.front().keypoint, "", false);
+                        if (face_id_log_flush(recognizer, unsaved_ids) || !face_id_log_append(id, recognizer->get_face_emb(id)))
+                        {
+                            unsaved_ids.push_back(id);
+                            ESP_LOGE(TAG, "ID %d is not saved yet, it is retried at next enrollment or deletion", id);
+                        }
+                        ESP_LOGW("ENROLL", "ID %d is enrolled", id);
                         frame_show_state = SHOW_STATE_ENROLL;
                         break;
+                    }
 
                     case RECOGNIZE:
-                        recognize_result = recognizer->recognize((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_results.front().keypoint);
+                    {
+                        std::vector<std::vector<int>> landmarks;
+                        for (auto &result : detect_results)
+                            landmarks.push_back(result.keypoint);
+                        recognize_results = recognizer->recognize((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, landmarks);
                         print_detection_result(detect_results);
-                        if (recognize_result.id > 0)
-                            ESP_LOGI("RECOGNIZE", "Similarity: %f, Match ID: %d", recognize_result.similarity, recognize_result.id);
-                        else
-                            ESP_LOGE("RECOGNIZE", "Similarity: %f, Match ID: %d", recognize_result.similarity, recognize_result.id);
+                        for (auto &result : recognize_results)
+                        {
+                            if (result.id > 0)
+                                ESP_LOGI("RECOGNIZE", "Similarity: %f, Match ID: %d", result.similarity, result.id);
+                            else
+                                ESP_LOGE("RECOGNIZE", "Similarity: %f, Match ID: %d", result.similarity, result.id);
+                        }
+                        if (recognize_results.empty())
+                        {
+                            // the aligned face scratch could not be allocated
+                            ESP_LOGE(TAG, "recognition of %d faces failed", (int)landmarks.size());
+                            break;
+                        }
+                        recognize_result = recognize_results.front();
                         frame_show_state = SHOW_STATE_RECOGNIZE;
                         break;
+                    }
 
                     case DELETE:
-                        vTaskDelay(10);
-                        recognizer->delete_id(true);
+                        if (recognizer->get_enrolled_id_num() > 0)
+                        {
+                            face_id_log_flush(recognizer, unsaved_ids);
+                            face_id_log_remove(recognizer->get_enrolled_ids().back().id);
+                            recognizer->delete_id(false);
+                        }
                         ESP_LOGE("DELETE", "% d IDs left", recognizer->get_enrolled_id_num());
                         frame_show_state = SHOW_STATE_DELETE;
                         break;
@@ -162,7 +194,20 @@ static void task_process_handler(void *arg)
                         break;
 
                     case SHOW_STATE_RECOGNIZE:
-                        if (recognize_result.id > 0)
+                        if (recognize_results.size() > 1)
+                        {
+                            char ids[64] = "";
+                            int len = 0;
+                            for (int i = 0; i < recognize_results.size() && len < sizeof(ids); i++)
+                            {
+                                if (recognize_results[i].id > 0)
+                                    len += snprintf(ids + len, sizeof(ids) - len, i ? " %d" : "ID %d", recognize_results[i].id);
+                                else
+                                    len += snprintf(ids + len, sizeof(ids) - len, i ? " ?" : "ID ?");
+                            }
+                            rgb_print(frame, RGB565_MASK_GREEN, ids);
+                        }
+                        else if (recognize_result.id > 0)
                             rgb_printf(frame, RGB565_MASK_GREEN, "ID %d", recognize_result.id);
                         else
                             rgb_print(frame, RGB565_MASK_RED, "who ?");
@@ -208,7 +253,15 @@ static void task_process_handler(void *arg)
 
             if (xQueueResult && is_detected)
             {
-                xQueueSend(xQueueResult, &recognize_result, portMAX_DELAY);
+                if (_gEvent == RECOGNIZE)
+                {
+                    for (auto &result : recognize_results)
+                        xQueueSend(xQueueResult, &result, portMAX_DELAY);
+                }
+                else
+                {
+                    xQueueSend(xQueueResult, &recognize_result, portMAX_DELAY);
+                }
             }
         }
     }
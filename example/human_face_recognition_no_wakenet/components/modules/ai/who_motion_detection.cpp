@@ -4,6 +4,7 @@
 #include "esp_camera.h"
 
 #include "dl_image.hpp"
+#include "who_motion_engine.hpp"
 
 static const char *TAG = "motion_detection";
 
@@ -16,37 +17,36 @@ static bool gEvent = true;
 
 static void task_process_handler(void *arg)
 {
-    camera_fb_t *frame1 = NULL;
-    camera_fb_t *frame2 = NULL;
+    camera_fb_t *frame = NULL;
+    MotionEngine *engine = NULL;
 
     while (true)
     {
         if (gEvent)
         {
             bool is_moved = false;
-            if (xQueueReceive(xQueueFrameI, &(frame1), portMAX_DELAY))
+            if (xQueueReceive(xQueueFrameI, &(frame), portMAX_DELAY))
             {
-                if (xQueueReceive(xQueueFrameI, &(frame2), portMAX_DELAY))
+                // one frame per decision, the background is kept by engine
+                if (engine == NULL)
+                    engine = new MotionEngine(frame->height, frame->width);
+
+                if (engine->detect((uint16_t *)frame->buf) > 0)
                 {
-                    uint32_t moving_point_number = dl::image::get_moving_point_number((uint16_t *)frame1->buf, (uint16_t *)frame2->buf, frame1->height, frame1->width, 8, 15);
-                    if (moving_point_number > 50)
-                    {
-                        ESP_LOGI(TAG, "Something moved!");
-                        dl::image::draw_filled_rectangle((uint16_t *)frame2->buf, frame2->height, frame2->width, 0, 0, 20, 20);
-                        is_moved = true;
-                    }
+                    ESP_LOGI(TAG, "Something moved!");
+                    for (auto &region : engine->get_regions())
+                        dl::image::draw_hollow_rectangle((uint16_t *)frame->buf, frame->height, frame->width, region[0], region[1], region[2], region[3]);
+                    is_moved = true;
                 }
             }
 
             if (xQueueFrameO)
             {
-                esp_camera_fb_return(frame1);
-                xQueueSend(xQueueFrameO, &frame2, portMAX_DELAY);
+                xQueueSend(xQueueFrameO, &frame, portMAX_DELAY);
             }
             else
             {
-                esp_camera_fb_return(frame1);
-                esp_camera_fb_return(frame2);
+                esp_camera_fb_return(frame);
             }
 
             if (xQueueResult)
@@ -0,0 +1,180 @@
+#include "who_motion_engine.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "dl_image.hpp"
+
+static const char *TAG = "motion_engine";
+
+MotionEngine::MotionEngine(const int height,
+                           const int width,
+                           const int scale,
+                           const int block_size,
+                           const int pixel_threshold,
+                           const int block_threshold,
+                           const int learning_shift) : height(height),
+                                                       width(width),
+                                                       scale(scale),
+                                                       block_size(block_size),
+                                                       pixel_threshold(pixel_threshold),
+                                                       block_threshold(block_threshold),
+                                                       learning_shift(learning_shift),
+                                                       initialized(false)
+{
+    this->grid_height = height / scale;
+    this->grid_width = width / scale;
+    this->map_height = (this->grid_height + block_size - 1) / block_size;
+    this->map_width = (this->grid_width + block_size - 1) / block_size;
+
+    this->reference = (uint8_t *)heap_caps_malloc(this->grid_height * this->grid_width, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (this->reference == NULL)
+        this->reference = (uint8_t *)heap_caps_malloc(this->grid_height * this->grid_width, MALLOC_CAP_8BIT);
+    if (this->reference == NULL)
+        ESP_LOGE(TAG, "malloc memory for reference failed, no motion will be detected");
+
+    this->map.resize(this->map_height * this->map_width);
+    this->visited.resize(this->map.size());
+    this->stack.reserve(this->map.size());
+}
+
+MotionEngine::~MotionEngine()
+{
+    if (this->reference)
+        heap_caps_free(this->reference);
+}
+
+void MotionEngine::reset()
+{
+    this->initialized = false;
+    memset(this->map.data(), 0, this->map.size());
+    this->regions.clear();
+}
+
+int MotionEngine::detect(uint16_t *frame)
+{
+    memset(this->map.data(), 0, this->map.size());
+    this->regions.clear();
+    if (this->reference == NULL)
+        return 0;
+
+    // sample the center of each scale x scale cell
+    const int offset = this->scale / 2;
+    uint8_t *reference = this->reference;
+    for (int y = 0; y < this->grid_height; y++)
+    {
+        uint16_t *row = frame + (y * this->scale + offset) * this->width + offset;
+        uint8_t *map_row = this->map.data() + (y / this->block_size) * this->map_width;
+        for (int x = 0; x < this->grid_width; x++, reference++)
+        {
+            int luma = dl::image::convert_pixel_rgb565_to_gray(row[x * this->scale]);
+            if (!this->initialized)
+            {
+                *reference = luma;
+                continue;
+            }
+
+            int diff = luma - *reference;
+            if (DL_ABS(diff) > this->pixel_threshold)
+            {
+                uint8_t &count = map_row[x / this->block_size];
+                if (count < 255)
+                    count++;
+            }
+            *reference += diff / (1 << this->learning_shift);
+        }
+    }
+    if (!this->initialized)
+    {
+        this->initialized = true;
+        return 0;
+    }
+
+    int moving = 0;
+    for (int i = 0; i < this->map.size(); i++)
+    {
+        if (this->map[i] < this->block_threshold)
+            this->map[i] = 0;
+        else
+            moving++;
+    }
+    if (moving)
+        this->label_regions();
+    return moving;
+}
+
+void MotionEngine::label_regions()
+{
+    // flood fill of 4-connected moving blocks
+    memset(this->visited.data(), 0, this->visited.size());
+    const int block_pixel = this->block_size * this->scale;
+
+    for (int start = 0; start < this->map.size(); start++)
+    {
+        if (this->map[start] == 0 || this->visited[start])
+            continue;
+
+        int x1 = this->map_width, y1 = this->map_height, x2 = -1, y2 = -1;
+        this->stack.clear();
+        this->stack.push_back(start);
+        this->visited[start] = 1;
+        while (!this->stack.empty())
+        {
+            int i = this->stack.back();
+            this->stack.pop_back();
+            int y = i / this->map_width;
+            int x = i % this->map_width;
+            x1 = DL_MIN(x1, x);
+            y1 = DL_MIN(y1, y);
+            x2 = DL_MAX(x2, x);
+            y2 = DL_MAX(y2, y);
+
+            int neighbors[4] = {x > 0 ? i - 1 : -1,
+                                x < this->map_width - 1 ? i + 1 : -1,
+                                y > 0 ? i - this->map_width : -1,
+                                y < this->map_height - 1 ? i + this->map_width : -1};
+            for (int n = 0; n < 4; n++)
+            {
+                int j = neighbors[n];
+                if (j >= 0 && this->map[j] && !this->visited[j])
+                {
+                    this->visited[j] = 1;
+                    this->stack.push_back(j);
+                }
+            }
+        }
+
+        this->regions.push_back({x1 * block_pixel,
+                                 y1 * block_pixel,
+                                 DL_MIN((x2 + 1) * block_pixel, this->width) - 1,
+                                 DL_MIN((y2 + 1) * block_pixel, this->height) - 1});
+    }
+}
+
+const std::vector<uint8_t> &MotionEngine::get_map(int &map_height, int &map_width)
+{
+    map_height = this->map_height;
+    map_width = this->map_width;
+    return this->map;
+}
+
+std::vector<std::vector<int>> &MotionEngine::get_regions()
+{
+    return this->regions;
+}
+
+bool MotionEngine::is_moving(const std::vector<int> &box)
+{
+    const int block_pixel = this->block_size * this->scale;
+    int x1 = DL_MAX(box[0], 0) / block_pixel;
+    int y1 = DL_MAX(box[1], 0) / block_pixel;
+    int x2 = DL_MIN(box[2] / block_pixel, this->map_width - 1);
+    int y2 = DL_MIN(box[3] / block_pixel, this->map_height - 1);
+    for (int y = y1; y <= y2; y++)
+        for (int x = x1; x <= x2; x++)
+            if (this->map[y * this->map_width + x])
+                return true;
+    return false;
+}
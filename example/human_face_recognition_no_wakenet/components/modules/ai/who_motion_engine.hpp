@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * @brief Motion detection against a persistent background.
+ *
+ * The engine keeps a luma reference downscaled by scale in internal RAM. Each frame is sampled once on the same grid,
+ * compared with the reference and blended into it, so one frame is enough for a decision. Points changed more than
+ * pixel_threshold are counted in blocks of block_size x block_size points, a block with at least block_threshold
+ * changed points is moving. Connected moving blocks are merged into regions.
+ *
+ * Frame shape = (240, 240), scale = 4: 3600 points are read from PSRAM per frame, the reference takes 3.5KB.
+ */
+class MotionEngine
+{
+private:
+    const int height;          /*<! frame height >*/
+    const int width;           /*<! frame width >*/
+    const int scale;           /*<! distance between sample points in pixel >*/
+    const int block_size;      /*<! block size in sample points >*/
+    const int pixel_threshold; /*<! luma change of a changed point >*/
+    const int block_threshold; /*<! changed points in a moving block >*/
+    const int learning_shift;  /*<! reference += (luma - reference) / 2^learning_shift >*/
+    int grid_height;           /*<! sample points in height >*/
+    int grid_width;            /*<! sample points in width >*/
+    int map_height;            /*<! blocks in height >*/
+    int map_width;             /*<! blocks in width >*/
+    uint8_t *reference;        /*<! [grid_height, grid_width] downscaled luma >*/
+    bool initialized;          /*<! reference holds a frame >*/
+
+    std::vector<uint8_t> map;                  /*<! [map_height, map_width] changed points per block, 0 for still >*/
+    std::vector<std::vector<int>> regions;     /*<! [left_up_x, left_up_y, right_down_x, right_down_y] of moving regions >*/
+    std::vector<uint8_t> visited;              /*<! [map_height, map_width] scratch of region labeling >*/
+    std::vector<int> stack;                    /*<! scratch of region labeling >*/
+
+    void label_regions();
+
+public:
+    /**
+     * @brief Construct a new Motion Engine object. If memory of the reference runs out, an error is logged and
+     * detect() finds no motion.
+     *
+     * @param height          frame height
+     * @param width           frame width
+     * @param scale           distance between sample points in pixel
+     * @param block_size      block size in sample points
+     * @param pixel_threshold luma change of a changed point
+     * @param block_threshold changed points in a moving block
+     * @param learning_shift  speed of reference following the frame, bigger is slower
+     */
+    MotionEngine(const int height,
+                 const int width,
+                 const int scale = 4,
+                 const int block_size = 4,
+                 const int pixel_threshold = 15,
+                 const int block_threshold = 3,
+                 const int learning_shift = 2);
+
+    /**
+     * @brief Destroy the Motion Engine object
+     */
+    ~MotionEngine();
+
+    /**
+     * @brief Compare a frame with reference and update the motion map and regions.
+     *
+     * @param frame RGB565 frame of the constructed shape
+     * @return int number of moving blocks, 0 for the first frame
+     */
+    int detect(uint16_t *frame);
+
+    /**
+     * @brief Reset reference, the next frame becomes the new background.
+     */
+    void reset();
+
+    /**
+     * @brief Get the motion map.
+     *
+     * @param map_height blocks in height
+     * @param map_width  blocks in width
+     * @return const std::vector<uint8_t>& [map_height, map_width] changed points per moving block, 0 for still
+     */
+    const std::vector<uint8_t> &get_map(int &map_height, int &map_width);
+
+    /**
+     * @brief Get the moving regions of the last frame.
+     *
+     * @return std::vector<std::vector<int>>& boxes in [left_up_x, left_up_y, right_down_x, right_down_y]
+     */
+    std::vector<std::vector<int>> &get_regions();
+
+    /**
+     * @brief Whether a box overlaps a moving block, e.g., to skip detection in still area.
+     *
+     * @param box [left_up_x, left_up_y, right_down_x, right_down_y] in frame
+     * @return true: moving
+     */
+    bool is_moving(const std::vector<int> &box);
+};
@@ -23,6 +23,7 @@
 #include "sdkconfig.h"
 
 #include "who_camera.h"
+#include "app_jpeg_cache.hpp"
 
 #if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
 #include "esp32-hal-log.h"
@@ -32,178 +33,190 @@
 static const char *TAG = "camera_httpd";
 #endif
 
-static QueueHandle_t xQueueFrameI = NULL;
-static QueueHandle_t xQueueFrameO = NULL;
-static bool gReturnFB = true;
-
 static int8_t detection_enabled = 0;
 static int8_t recognition_enabled = 0;
 static int8_t is_enrolling = 0;
 
-typedef struct
-{
-    httpd_req_t *req;
-    size_t len;
-} jpg_chunking_t;
-
 #define PART_BOUNDARY "123456789000000000000987654321"
 static const char *_STREAM_CONTENT_TYPE = "multipart/x-mixed-replace;boundary=" PART_BOUNDARY;
 static const char *_STREAM_BOUNDARY = "\r\n--" PART_BOUNDARY "\r\n";
-static const char *_STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %d.%06d\r\n\r\n";
-
-httpd_handle_t stream_httpd = NULL;
-httpd_handle_t camera_httpd = NULL;
-
-static size_t jpg_encode_stream(void *arg, size_t index, const void *data, size_t len)
-{
-    jpg_chunking_t *j = (jpg_chunking_t *)arg;
-    if (!index)
-    {
-        j->len = 0;
-    }
-    if (httpd_resp_send_chunk(j->req, (const char *)data, len) != ESP_OK)
-    {
-        return 0;
-    }
-    j->len += len;
-    return len;
-}
+static const char *_STREAM_PART = "Content-Type: image/jpeg\r\nContent-Length: %u\r\nX-Timestamp: %lld.%06ld\r\nX-Framerate: %.1f\r\n\r\n";
 
-static esp_err_t capture_handler(httpd_req_t *req)
+typedef struct
 {
-    camera_fb_t *frame = NULL;
-    esp_err_t res = ESP_OK;
+    int quality;
+    int scale;
+} stream_level_t;
 
-    if (xQueueReceive(xQueueFrameI, &frame, portMAX_DELAY))
-    {
-        httpd_resp_set_type(req, "image/jpeg");
-        httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=capture.jpg");
-        httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
+// from the best to the cheapest, streams on the same level share their encoded frames
+static const stream_level_t stream_levels[] = {{80, 1}, {60, 1}, {40, 1}, {60, 2}, {40, 2}, {30, 4}};
+#define STREAM_LEVEL_NUM (int)(sizeof(stream_levels) / sizeof(stream_levels[0]))
+#define STREAM_LEVEL_HOLD 8 // frames sent between changes of level
 
-        char ts[32];
-        snprintf(ts, 32, "%lld.%06ld", frame->timestamp.tv_sec, frame->timestamp.tv_usec);
-        httpd_resp_set_hdr(req, "X-Timestamp", (const char *)ts);
+typedef struct
+{
+    httpd_req_t *req;
+    jpeg_client_t *client;
+} stream_t;
 
-        // size_t fb_len = 0;
-        if (frame->format == PIXFORMAT_JPEG)
-        {
-                // fb_len = frame->len;
-            res = httpd_resp_send(req, (const char *)frame->buf, frame->len);
-        }
-        else
-        {
-            jpg_chunking_t jchunk = {req, 0};
-            res = frame2jpg_cb(frame, 80, jpg_encode_stream, &jchunk) ? ESP_OK : ESP_FAIL;
-            httpd_resp_send_chunk(req, NULL, 0);
-            // fb_len = jchunk.len;
-        }
+httpd_handle_t stream_httpd = NULL;
+httpd_handle_t camera_httpd = NULL;
 
-        if (xQueueFrameO)
-        {
-            xQueueSend(xQueueFrameO, &frame, portMAX_DELAY);
-        }
-        else if (gReturnFB)
-        {
-            esp_camera_fb_return(frame);
-        }
-        else
-        {
-            free(frame);
-        }
-    }
-    else
+static esp_err_t capture_handler(httpd_req_t *req)
+{
+    // the frame encoded for streams at the same quality is reused
+    jpeg_client_t *client = jpeg_cache_open(80);
+    jpeg_frame_t *jpeg = client ? jpeg_cache_take(client, portMAX_DELAY) : NULL;
+    if (jpeg == NULL)
     {
+        if (client)
+            jpeg_cache_close(client);
         ESP_LOGE(TAG, "Camera capture failed");
         httpd_resp_send_500(req);
         return ESP_FAIL;
     }
+    jpeg_cache_close(client);
+
+    httpd_resp_set_type(req, "image/jpeg");
+    httpd_resp_set_hdr(req, "Content-Disposition", "inline; filename=capture.jpg");
+    httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
 
+    char ts[32];
+    snprintf(ts, 32, "%lld.%06ld", (long long)jpeg->timestamp.tv_sec, (long)jpeg->timestamp.tv_usec);
+    httpd_resp_set_hdr(req, "X-Timestamp", (const char *)ts);
+
+    esp_err_t res = httpd_resp_send(req, (const char *)jpeg->buf, jpeg->len);
+    jpeg_cache_release(jpeg);
     return res;
 }
 
-static esp_err_t stream_handler(httpd_req_t *req)
+static void stream_task(void *arg)
 {
-    camera_fb_t *frame = NULL;
-    struct timeval _timestamp;
+    stream_t *stream = (stream_t *)arg;
+    httpd_req_t *req = stream->req;
     esp_err_t res = ESP_OK;
-    size_t _jpg_buf_len = 0;
-    uint8_t *_jpg_buf = NULL;
-    char *part_buf[128];
+    char part_buf[128];
 
-    res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
-    if (res != ESP_OK)
-    {
-        return res;
-    }
+    int level = 0;
+    int hold = 0;
+    float interval = 0; // camera frame interval in us, averaged
+    float send = 0;     // time to send a frame in us, averaged
+    float fps = 0;      // frames sent per second, averaged
+    int64_t last_send = 0;
+    int64_t last_log = esp_timer_get_time();
+    jpeg_frame_t last = {};
 
+    res = httpd_resp_set_type(req, _STREAM_CONTENT_TYPE);
     httpd_resp_set_hdr(req, "Access-Control-Allow-Origin", "*");
-    httpd_resp_set_hdr(req, "X-Framerate", "60");
 
-    while (true)
+    while (res == ESP_OK)
     {
-        if (xQueueReceive(xQueueFrameI, &frame, portMAX_DELAY))
-        {
-            _timestamp.tv_sec = frame->timestamp.tv_sec;
-            _timestamp.tv_usec = frame->timestamp.tv_usec;
-
-            if (frame->format == PIXFORMAT_JPEG)
-            {
-                _jpg_buf = frame->buf;
-                _jpg_buf_len = frame->len;
-            }
-            else if (!frame2jpg(frame, 80, &_jpg_buf, &_jpg_buf_len))
-            {
-                ESP_LOGE(TAG, "JPEG compression failed");
-                res = ESP_FAIL;
-            }
-        }
-        else
+        jpeg_frame_t *jpeg = jpeg_cache_take(stream->client, portMAX_DELAY);
+        if (jpeg == NULL)
         {
-            res = ESP_FAIL;
+            continue;
         }
 
-        if (res == ESP_OK)
+        // frames skipped by this stream are counted in sequence
+        if (last.sequence && jpeg->sequence > last.sequence)
         {
-            res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
+            int64_t elapsed = (jpeg->timestamp.tv_sec - last.timestamp.tv_sec) * 1000000LL + (jpeg->timestamp.tv_usec - last.timestamp.tv_usec);
+            float value = (float)elapsed / (jpeg->sequence - last.sequence);
+            interval = interval ? 0.9f * interval + 0.1f * value : value;
         }
+        last.sequence = jpeg->sequence;
+        last.timestamp = jpeg->timestamp;
+
+        int64_t start = esp_timer_get_time();
+        res = httpd_resp_send_chunk(req, _STREAM_BOUNDARY, strlen(_STREAM_BOUNDARY));
 
         if (res == ESP_OK)
         {
-            size_t hlen = snprintf((char *)part_buf, 128, _STREAM_PART, _jpg_buf_len, _timestamp.tv_sec, _timestamp.tv_usec);
-            res = httpd_resp_send_chunk(req, (const char *)part_buf, hlen);
+            size_t hlen = snprintf(part_buf, sizeof(part_buf), _STREAM_PART, (unsigned)jpeg->len, (long long)jpeg->timestamp.tv_sec, (long)jpeg->timestamp.tv_usec, fps);
+            res = httpd_resp_send_chunk(req, part_buf, hlen);
         }
 
         if (res == ESP_OK)
         {
-            res = httpd_resp_send_chunk(req, (const char *)_jpg_buf, _jpg_buf_len);
+            res = httpd_resp_send_chunk(req, (const char *)jpeg->buf, jpeg->len);
         }
 
-        if (frame->format != PIXFORMAT_JPEG)
-        {
-            free(_jpg_buf);
-            _jpg_buf = NULL;
-        }
+        jpeg_cache_release(jpeg);
 
-        if (xQueueFrameO)
+        int64_t end = esp_timer_get_time();
+        send = send ? 0.8f * send + 0.2f * (end - start) : (end - start);
+        if (last_send)
         {
-            xQueueSend(xQueueFrameO, &frame, portMAX_DELAY);
+            float value = 1000000.f / (end - last_send);
+            fps = fps ? 0.9f * fps + 0.1f * value : value;
         }
-        else if (gReturnFB)
-        {
-            esp_camera_fb_return(frame);
-        }
-        else
+        last_send = end;
+
+        // a client that cannot take frames as fast as the camera goes to a cheaper level, and back when it can
+        if (++hold >= STREAM_LEVEL_HOLD && interval > 0)
         {
-            free(frame);
+            int next = level;
+            if (send > 1.25f * interval && level < STREAM_LEVEL_NUM - 1)
+                next = level + 1;
+            else if (send < 0.5f * interval && level > 0)
+                next = level - 1;
+
+            if (next != level)
+            {
+                level = next;
+                hold = 0;
+                jpeg_cache_set(stream->client, stream_levels[level].quality, stream_levels[level].scale);
+            }
         }
 
-        if (res != ESP_OK)
+        if (end - last_log > 5000000)
         {
-            break;
+            ESP_LOGI(TAG, "stream %d: %.1f fps, send %.1f ms, camera %.1f ms, quality %d, 1/%d",
+                     httpd_req_to_sockfd(req), fps, send / 1000, interval / 1000, stream_levels[level].quality, stream_levels[level].scale);
+            last_log = end;
         }
     }
 
-    return res;
+    jpeg_cache_close(stream->client);
+    httpd_req_async_handler_complete(req);
+    free(stream);
+    vTaskDelete(NULL);
+}
+
+static esp_err_t stream_handler(httpd_req_t *req)
+{
+    // each stream runs on its own task, so a slow client neither blocks the server nor the other clients
+    stream_t *stream = (stream_t *)calloc(1, sizeof(stream_t));
+    if (stream == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    stream->client = jpeg_cache_open(stream_levels[0].quality, stream_levels[0].scale);
+    if (stream->client == NULL)
+    {
+        free(stream);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Too many streams");
+        return ESP_FAIL;
+    }
+
+    if (httpd_req_async_handler_begin(req, &stream->req) != ESP_OK)
+    {
+        jpeg_cache_close(stream->client);
+        free(stream);
+        return ESP_FAIL;
+    }
+
+    if (xTaskCreatePinnedToCore(stream_task, "stream", 4 * 1024, stream, 4, NULL, tskNO_AFFINITY) != pdPASS)
+    {
+        ESP_LOGE(TAG, "fail to create stream task");
+        httpd_req_async_handler_complete(stream->req);
+        jpeg_cache_close(stream->client);
+        free(stream);
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
 }
 
 static esp_err_t parse_get(httpd_req_t *req, char **obuf)
@@ -671,9 +684,8 @@ static esp_err_t monitor_handler(httpd_req_t *req)
 
 void register_httpd(const QueueHandle_t frame_i, const QueueHandle_t frame_o, const bool return_fb)
 {
-    xQueueFrameI = frame_i;
-    xQueueFrameO = frame_o;
-    gReturnFB = return_fb;
+    // frames go through the cache, which encodes each of them once for all clients
+    jpeg_cache_init(frame_i, frame_o, return_fb);
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.max_uri_handlers = 12;
@@ -0,0 +1,332 @@
+#include "app_jpeg_cache.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_camera.h"
+#include "esp_log.h"
+#include "img_converters.h"
+
+static const char *TAG = "jpeg_cache";
+
+static QueueHandle_t xQueueFrameI = NULL;
+static QueueHandle_t xQueueFrameO = NULL;
+static bool gReturnFB = true;
+
+static jpeg_client_t clients[JPEG_CACHE_CLIENT_MAX] = {};
+static SemaphoreHandle_t clients_mutex = NULL; // guards clients, never held while encoding
+static portMUX_TYPE count_lock = portMUX_INITIALIZER_UNLOCKED;
+static int client_num = 0;
+
+// the copy of a camera frame passes between intake and encoder, it is in idle while the encoder waits
+static QueueHandle_t idle_queue = NULL;
+static QueueHandle_t work_queue = NULL;
+static camera_fb_t scratch = {};
+static size_t scratch_capacity = 0;
+static camera_fb_t scaled = {};
+static size_t scaled_capacity = 0;
+
+typedef struct
+{
+    int quality;
+    int scale;
+} jpeg_key_t;
+
+typedef struct
+{
+    camera_fb_t *frame; // copy of camera frame
+    uint32_t sequence;  // index of camera frame
+} work_t;
+
+static bool reserve(camera_fb_t *frame, size_t *capacity, size_t len)
+{
+    if (len > *capacity)
+    {
+        free(frame->buf);
+        frame->buf = (uint8_t *)malloc(len);
+        *capacity = frame->buf ? len : 0;
+    }
+    return frame->buf != NULL;
+}
+
+// nearest sampling, for any uncompressed format
+static camera_fb_t *downscale(camera_fb_t *frame, int scale)
+{
+    if (scale <= 1 || frame->format == PIXFORMAT_JPEG)
+        return frame;
+
+    int width = frame->width / scale;
+    int height = frame->height / scale;
+    int pixel = frame->len / (frame->width * frame->height);
+    if (!reserve(&scaled, &scaled_capacity, width * height * pixel))
+        return NULL;
+
+    for (int y = 0; y < height; y++)
+    {
+        uint8_t *dst = scaled.buf + y * width * pixel;
+        uint8_t *src = frame->buf + y * scale * frame->width * pixel;
+        for (int x = 0; x < width; x++, dst += pixel, src += scale * pixel)
+            memcpy(dst, src, pixel);
+    }
+    scaled.width = width;
+    scaled.height = height;
+    scaled.len = width * height * pixel;
+    scaled.format = frame->format;
+    scaled.timestamp = frame->timestamp;
+    return &scaled;
+}
+
+static jpeg_frame_t *encode(camera_fb_t *frame, uint32_t sequence, jpeg_key_t key)
+{
+    camera_fb_t *source = downscale(frame, key.scale);
+    if (source == NULL)
+        return NULL;
+
+    jpeg_frame_t *jpeg = (jpeg_frame_t *)calloc(1, sizeof(jpeg_frame_t));
+    if (jpeg == NULL)
+        return NULL;
+
+    if (source->format == PIXFORMAT_JPEG)
+    {
+        // the copy is reused for the next frame, so the data is copied again
+        jpeg->buf = (uint8_t *)malloc(source->len);
+        if (jpeg->buf)
+        {
+            memcpy(jpeg->buf, source->buf, source->len);
+            jpeg->len = source->len;
+        }
+    }
+    else if (!frame2jpg(source, key.quality, &jpeg->buf, &jpeg->len))
+    {
+        jpeg->buf = NULL;
+    }
+
+    if (jpeg->buf == NULL)
+    {
+        ESP_LOGE(TAG, "JPEG compression failed");
+        free(jpeg);
+        return NULL;
+    }
+
+    jpeg->timestamp = frame->timestamp;
+    jpeg->sequence = sequence;
+    jpeg->quality = key.quality;
+    jpeg->scale = key.scale;
+    jpeg->count = 1;
+    return jpeg;
+}
+
+static jpeg_key_t get_key(camera_fb_t *frame, jpeg_client_t *client)
+{
+    if (frame->format == PIXFORMAT_JPEG)
+        return {-1, 1};
+    return {client->quality, client->scale};
+}
+
+static void forward(camera_fb_t *frame)
+{
+    if (xQueueFrameO)
+        xQueueSend(xQueueFrameO, &frame, portMAX_DELAY);
+    else if (gReturnFB)
+        esp_camera_fb_return(frame);
+    else
+        free(frame);
+}
+
+static void intake_task(void *arg)
+{
+    camera_fb_t *frame = NULL;
+    camera_fb_t *copy = NULL;
+    uint32_t sequence = 0;
+
+    while (true)
+    {
+        if (xQueueReceive(xQueueFrameI, &frame, portMAX_DELAY) != pdTRUE)
+            continue;
+        sequence++;
+
+        // the frame goes on at once, clients get a copy if the encoder is idle, or skip it
+        if (client_num && xQueueReceive(idle_queue, &copy, 0) == pdTRUE)
+        {
+            if (reserve(copy, &scratch_capacity, frame->len))
+            {
+                memcpy(copy->buf, frame->buf, frame->len);
+                copy->len = frame->len;
+                copy->width = frame->width;
+                copy->height = frame->height;
+                copy->format = frame->format;
+                copy->timestamp = frame->timestamp;
+                work_t work = {copy, sequence};
+                xQueueSend(work_queue, &work, portMAX_DELAY);
+            }
+            else
+            {
+                xQueueSend(idle_queue, &copy, portMAX_DELAY);
+            }
+        }
+        forward(frame);
+    }
+}
+
+static void encoder_task(void *arg)
+{
+    work_t work;
+    jpeg_key_t keys[JPEG_CACHE_CLIENT_MAX];
+    jpeg_frame_t *encoded[JPEG_CACHE_CLIENT_MAX];
+
+    while (true)
+    {
+        if (xQueueReceive(work_queue, &work, portMAX_DELAY) != pdTRUE)
+            continue;
+        camera_fb_t *copy = work.frame;
+
+        // each quality and scale asked by any client is encoded once, however many clients ask for it
+        int n = 0;
+        xSemaphoreTake(clients_mutex, portMAX_DELAY);
+        for (int i = 0; i < JPEG_CACHE_CLIENT_MAX; i++)
+        {
+            if (!clients[i].used)
+                continue;
+
+            jpeg_key_t key = get_key(copy, &clients[i]);
+            int j = 0;
+            while (j < n && (keys[j].quality != key.quality || keys[j].scale != key.scale))
+                j++;
+            if (j == n)
+                keys[n++] = key;
+        }
+        xSemaphoreGive(clients_mutex);
+
+        for (int j = 0; j < n; j++)
+            encoded[j] = encode(copy, work.sequence, keys[j]);
+
+        xSemaphoreTake(clients_mutex, portMAX_DELAY);
+        for (int i = 0; i < JPEG_CACHE_CLIENT_MAX; i++)
+        {
+            if (!clients[i].used)
+                continue;
+
+            jpeg_key_t key = get_key(copy, &clients[i]);
+            jpeg_frame_t *jpeg = NULL;
+            for (int j = 0; j < n; j++)
+            {
+                if (encoded[j] && encoded[j]->quality == key.quality && encoded[j]->scale == key.scale)
+                {
+                    jpeg = encoded[j];
+                    break;
+                }
+            }
+            if (jpeg == NULL)
+                continue;
+
+            // a client still busy with an older frame gets this one instead of both
+            jpeg_frame_t *stale = NULL;
+            if (xQueueReceive(clients[i].queue, &stale, 0) == pdTRUE)
+                jpeg_cache_release(stale);
+
+            jpeg_cache_retain(jpeg);
+            if (xQueueSend(clients[i].queue, &jpeg, 0) != pdTRUE)
+                jpeg_cache_release(jpeg);
+        }
+        xSemaphoreGive(clients_mutex);
+
+        for (int j = 0; j < n; j++)
+        {
+            if (encoded[j])
+                jpeg_cache_release(encoded[j]);
+        }
+        xQueueSend(idle_queue, &copy, portMAX_DELAY);
+    }
+}
+
+void jpeg_cache_init(const QueueHandle_t frame_i, const QueueHandle_t frame_o, const bool return_fb, const int encoder_core)
+{
+    xQueueFrameI = frame_i;
+    xQueueFrameO = frame_o;
+    gReturnFB = return_fb;
+
+    clients_mutex = xSemaphoreCreateMutex();
+    idle_queue = xQueueCreate(1, sizeof(camera_fb_t *));
+    work_queue = xQueueCreate(1, sizeof(work_t));
+    camera_fb_t *copy = &scratch;
+    xQueueSend(idle_queue, &copy, 0);
+
+    xTaskCreatePinnedToCore(intake_task, "jpeg_intake", 3 * 1024, NULL, 5, NULL, 1);
+    xTaskCreatePinnedToCore(encoder_task, "jpeg_encoder", 4 * 1024, NULL, 2, NULL, encoder_core);
+}
+
+jpeg_client_t *jpeg_cache_open(int quality, int scale)
+{
+    jpeg_client_t *client = NULL;
+    xSemaphoreTake(clients_mutex, portMAX_DELAY);
+    for (int i = 0; i < JPEG_CACHE_CLIENT_MAX; i++)
+    {
+        if (clients[i].used)
+            continue;
+
+        if (clients[i].queue == NULL)
+            clients[i].queue = xQueueCreate(1, sizeof(jpeg_frame_t *));
+        if (clients[i].queue == NULL)
+            break;
+
+        clients[i].quality = quality;
+        clients[i].scale = scale;
+        clients[i].used = true;
+        client_num++;
+        client = &clients[i];
+        break;
+    }
+    xSemaphoreGive(clients_mutex);
+
+    if (client == NULL)
+        ESP_LOGW(TAG, "no free client");
+    return client;
+}
+
+void jpeg_cache_set(jpeg_client_t *client, int quality, int scale)
+{
+    xSemaphoreTake(clients_mutex, portMAX_DELAY);
+    client->quality = quality;
+    client->scale = scale;
+    xSemaphoreGive(clients_mutex);
+}
+
+void jpeg_cache_close(jpeg_client_t *client)
+{
+    // the queue is kept for the next client of this slot
+    xSemaphoreTake(clients_mutex, portMAX_DELAY);
+    client->used = false;
+    client_num--;
+    jpeg_frame_t *jpeg = NULL;
+    if (xQueueReceive(client->queue, &jpeg, 0) == pdTRUE)
+        jpeg_cache_release(jpeg);
+    xSemaphoreGive(clients_mutex);
+}
+
+jpeg_frame_t *jpeg_cache_take(jpeg_client_t *client, TickType_t timeout)
+{
+    jpeg_frame_t *jpeg = NULL;
+    if (xQueueReceive(client->queue, &jpeg, timeout) != pdTRUE)
+        return NULL;
+    return jpeg;
+}
+
+void jpeg_cache_retain(jpeg_frame_t *frame)
+{
+    portENTER_CRITICAL(&count_lock);
+    frame->count++;
+    portEXIT_CRITICAL(&count_lock);
+}
+
+void jpeg_cache_release(jpeg_frame_t *frame)
+{
+    portENTER_CRITICAL(&count_lock);
+    bool last = (--frame->count == 0);
+    portEXIT_CRITICAL(&count_lock);
+
+    if (last)
+    {
+        free(frame->buf);
+        free(frame);
+    }
+}
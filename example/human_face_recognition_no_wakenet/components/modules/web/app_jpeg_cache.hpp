@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/time.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define JPEG_CACHE_CLIENT_MAX 8 /*<! maximum number of clients open at the same time */
+
+/**
+ * @brief A camera frame encoded in JPEG, shared by all clients asking for the same quality and scale.
+ */
+typedef struct
+{
+    uint8_t *buf;             /*<! JPEG data */
+    size_t len;               /*<! length of buf in byte */
+    struct timeval timestamp; /*<! timestamp of camera frame */
+    uint32_t sequence;        /*<! index of camera frame since jpeg_cache_init(), skipped frames are counted */
+    int quality;              /*<! JPEG quality, -1 for frames already in JPEG from camera */
+    int scale;                /*<! width and height are 1 / scale of camera frame */
+    int count;                /*<! number of holders, the frame is freed when it drops to 0 */
+} jpeg_frame_t;
+
+/**
+ * @brief A consumer of encoded frames, e.g., a stream, a capture or a WebSocket.
+ */
+typedef struct
+{
+    QueueHandle_t queue; /*<! 1-deep queue of jpeg_frame_t *, only the latest frame is kept */
+    int quality;         /*<! JPEG quality wanted */
+    int scale;           /*<! downscale wanted, 1, 2 or 4 */
+    bool used;           /*<! whether the slot is open */
+} jpeg_client_t;
+
+/**
+ * @brief Start the cache. The intake task takes every camera frame from frame_i and sends it on to frame_o, or back
+ *        to the camera driver, without waiting for encoding. While clients are open, a copy of the frame goes to the
+ *        encoder task, which encodes it at most once per quality and scale asked by them. A frame arriving while the
+ *        encoder is busy is skipped for clients only, so slow encoding or slow clients never hold up the frames.
+ *
+ * @param frame_i      queue of camera_fb_t *
+ * @param frame_o      queue of camera_fb_t * to the next stage, may be NULL
+ * @param return_fb    true: frames are returned by esp_camera_fb_return() if frame_o is NULL
+ *                     false: frames are freed
+ * @param encoder_core core of the encoder task, tskNO_AFFINITY for any. It runs at a priority below the AI tasks
+ */
+void jpeg_cache_init(const QueueHandle_t frame_i, const QueueHandle_t frame_o, const bool return_fb, const int encoder_core = tskNO_AFFINITY);
+
+/**
+ * @brief Open a client. Clients with the same quality and scale share the same encoded frames.
+ *
+ * @param quality JPEG quality in [1, 100]
+ * @param scale   downscale of width and height, 1, 2 or 4. Only uncompressed camera frames are downscaled
+ * @return jpeg_client_t * client, NULL if JPEG_CACHE_CLIENT_MAX clients are open
+ */
+jpeg_client_t *jpeg_cache_open(int quality, int scale = 1);
+
+/**
+ * @brief Change the quality and scale of a client, from the next frame encoded.
+ *
+ * @param client  client from jpeg_cache_open()
+ * @param quality JPEG quality in [1, 100]
+ * @param scale   downscale of width and height, 1, 2 or 4
+ */
+void jpeg_cache_set(jpeg_client_t *client, int quality, int scale);
+
+/**
+ * @brief Close a client, the frame waiting in it is released.
+ *
+ * @param client client from jpeg_cache_open()
+ */
+void jpeg_cache_close(jpeg_client_t *client);
+
+/**
+ * @brief Wait for the next frame of a client. A client slower than the camera skips frames instead of queuing them.
+ *
+ * @param client  client from jpeg_cache_open()
+ * @param timeout ticks to wait
+ * @return jpeg_frame_t * frame held by the caller until jpeg_cache_release(), NULL if timeout
+ */
+jpeg_frame_t *jpeg_cache_take(jpeg_client_t *client, TickType_t timeout);
+
+/**
+ * @brief Hold a frame once more, e.g., before handing it to another task.
+ *
+ * @param frame frame
+ */
+void jpeg_cache_retain(jpeg_frame_t *frame);
+
+/**
+ * @brief Release a frame by one holder. The frame is freed when the last holder releases it.
+ *
+ * @param frame frame
+ */
+void jpeg_cache_release(jpeg_frame_t *frame);
@@ -4,36 +4,48 @@
 #include "app_camera.hpp"
 #include "app_lcd.hpp"
 #include "app_led.hpp"
+#include "app_code.hpp"
 #include "app_motion.hpp"
 #include "app_speech.hpp"
 #include "app_face.hpp"
 
 extern "C" void app_main()
 {
-    QueueHandle_t xQueueFrame_0 = xQueueCreate(2, sizeof(camera_fb_t *));
-    QueueHandle_t xQueueFrame_1 = xQueueCreate(2, sizeof(camera_fb_t *));
-    QueueHandle_t xQueueFrame_2 = xQueueCreate(2, sizeof(camera_fb_t *));
-
     AppButton *key = new AppButton();
     AppSpeech *speech = new AppSpeech();
-    AppCamera *camera = new AppCamera(PIXFORMAT_RGB565, FRAMESIZE_240X240, 2, xQueueFrame_0);
-    AppFace *face = new AppFace(key, speech, xQueueFrame_0, xQueueFrame_1);
-    AppMotion *motion = new AppMotion(key, speech, xQueueFrame_1, xQueueFrame_2);
-    AppLCD *lcd = new AppLCD(key, speech, xQueueFrame_2);
+    AppCamera *camera = new AppCamera(PIXFORMAT_RGB565, FRAMESIZE_240X240, 3);
+    AppFace *face = new AppFace(key, speech);
+    AppMotion *motion = new AppMotion(key, speech);
+    AppCode *code = new AppCode(key, speech);
+    AppLCD *lcd = new AppLCD(key, speech);
     AppLED *led = new AppLED(GPIO_NUM_3, key, speech);
 
+    // every frame is shared by all consumers, the display does not wait for AI
+    camera->subscribe(face);
+    camera->subscribe(motion);
+    camera->subscribe(code);
+    camera->subscribe(lcd);
+
+    // results are drawn by the display on its own copy of rows, AI tasks never draw into the shared frames
+    lcd->add_overlay(face->overlay);
+    lcd->add_overlay(motion->overlay);
+    lcd->add_overlay(code->overlay);
+
     key->attach(face);
     key->attach(motion);
+    key->attach(code);
     key->attach(led);
     key->attach(lcd);
 
     speech->attach(face);
     speech->attach(motion);
+    speech->attach(code);
     speech->attach(led);
     speech->attach(lcd);
 
     lcd->run();
     motion->run();
+    code->run();
     face->run();
     camera->run();
     speech->run();
@@ -9,6 +9,8 @@
 
 #include "esp_camera.h"
 
+#define FRAME_REF_MAX 8 /*<! maximum number of frames in flight, must not be less than fb_count of camera */
+
 typedef enum
 {
     COMMAND_TIMEOUT = -2,
@@ -58,12 +60,88 @@ public:
     }
 };
 
+typedef struct
+{
+    camera_fb_t *frame; /*<! frame in flight, nullptr for free slot */
+    int count;          /*<! number of consumers not released yet */
+} frame_ref_t;
+
+/**
+ * @brief Reference counts of frames in flight, shared by all translation units.
+ */
+inline frame_ref_t *frame_refs()
+{
+    static frame_ref_t refs[FRAME_REF_MAX] = {};
+    return refs;
+}
+
+inline portMUX_TYPE *frame_refs_lock()
+{
+    static portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    return &lock;
+}
+
+/**
+ * @brief Hold a frame for count consumers.
+ *
+ * @param frame frame got from esp_camera_fb_get()
+ * @param count number of consumers
+ * @return true: success
+ *         false: too many frames in flight
+ */
+inline bool frame_retain(camera_fb_t *frame, int count)
+{
+    bool ret = false;
+    frame_ref_t *refs = frame_refs();
+    portENTER_CRITICAL(frame_refs_lock());
+    for (int i = 0; i < FRAME_REF_MAX; i++)
+    {
+        if (refs[i].frame == nullptr)
+        {
+            refs[i].frame = frame;
+            refs[i].count = count;
+            ret = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(frame_refs_lock());
+    return ret;
+}
+
+/**
+ * @brief Release a frame by one consumer. The frame is returned to camera driver when the last consumer releases it.
+ *        Frames not retained are returned at once, so this works as the callback of any Frame.
+ *
+ * @param frame frame to release
+ */
+inline void frame_release(camera_fb_t *frame)
+{
+    bool last = true;
+    frame_ref_t *refs = frame_refs();
+    portENTER_CRITICAL(frame_refs_lock());
+    for (int i = 0; i < FRAME_REF_MAX; i++)
+    {
+        if (refs[i].frame == frame)
+        {
+            last = (--refs[i].count == 0);
+            if (last)
+                refs[i].frame = nullptr;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(frame_refs_lock());
+
+    if (last)
+        esp_camera_fb_return(frame);
+}
+
 class Frame
 {
 public:
     QueueHandle_t queue_i;
     QueueHandle_t queue_o;
     void (*callback)(camera_fb_t *);
+    std::list<QueueHandle_t> subscribers; /*<! queues of consumers running in parallel */
 
     Frame(QueueHandle_t queue_i = nullptr,
           QueueHandle_t queue_o = nullptr,
@@ -76,4 +154,65 @@ public:
         this->queue_i = queue_i;
         this->queue_o = queue_o;
     }
+
+    /**
+     * @brief Subscribe a consumer to the frames published by this. The consumer gets a 1-deep input queue if it has
+     *        none, stops forwarding and releases every frame by frame_release().
+     *
+     * @param consumer consumer, must be subscribed before its run()
+     */
+    void subscribe(Frame *consumer)
+    {
+        if (consumer->queue_i == nullptr)
+            consumer->queue_i = xQueueCreate(1, sizeof(camera_fb_t *));
+        consumer->queue_o = nullptr;
+        consumer->callback = frame_release;
+        this->subscribers.push_back(consumer->queue_i);
+    }
+
+    /**
+     * @brief Subscribe a queue of camera_fb_t *, e.g., the frame queue of a module. The receiver must release every
+     *        frame by frame_release().
+     *
+     * @param queue queue of consumer
+     */
+    void subscribe(QueueHandle_t queue)
+    {
+        this->subscribers.push_back(queue);
+    }
+
+    /**
+     * @brief Send a frame to the next stage. If there are subscribers, the same frame is shared by all of them
+     *        without copy. A subscriber whose queue is still full gets the new frame in place of the stale one, which
+     *        is released at once, so a slow subscriber pins at most the frame it is working on and the newest one.
+     *
+     * @param frame frame got from esp_camera_fb_get()
+     */
+    void publish(camera_fb_t *frame)
+    {
+        if (this->subscribers.empty())
+        {
+            if (this->queue_o)
+                xQueueSend(this->queue_o, &frame, portMAX_DELAY);
+            else if (this->callback)
+                this->callback(frame);
+            return;
+        }
+
+        if (!frame_retain(frame, this->subscribers.size()))
+        {
+            esp_camera_fb_return(frame);
+            return;
+        }
+        for (auto queue : this->subscribers)
+        {
+            // the subscriber may take the stale frame meanwhile, then the queue has room
+            while (xQueueSend(queue, &frame, 0) != pdTRUE)
+            {
+                camera_fb_t *stale = nullptr;
+                if (xQueueReceive(queue, &stale, 0) == pdTRUE)
+                    frame_release(stale);
+            }
+        }
+    }
 };
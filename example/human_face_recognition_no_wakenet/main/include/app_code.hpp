@@ -0,0 +1,31 @@
+#pragma once
+
+#include "__base__.hpp"
+#include "app_camera.hpp"
+#include "app_button.hpp"
+#include "app_speech.hpp"
+#include "who_code_engine.hpp"
+#include "fb_overlay.h"
+
+class AppCode : public Observer, public Frame
+{
+private:
+    AppButton *key;
+    AppSpeech *speech;
+
+public:
+    bool switch_on;
+    CodeEngine *engine;
+    fb_overlay_t *overlay; /*<! codes decoded to show, drawn by the display */
+    uint8_t frame_count;   /*<! frames to keep showing the last codes */
+
+    AppCode(AppButton *key,
+            AppSpeech *speech,
+            QueueHandle_t queue_i = nullptr,
+            QueueHandle_t queue_o = nullptr,
+            void (*callback)(camera_fb_t *) = esp_camera_fb_return);
+
+    void update();
+
+    void run();
+};
@@ -4,6 +4,9 @@
 
 #include "human_face_detect_msr01.hpp"
 #include "human_face_detect_mnp01.hpp"
+#include "human_face_detect_cascade.hpp"
+#include "who_face_tracker.hpp"
+#include "who_face_pipeline.hpp"
 #include "face_recognition_tool.hpp"
 #if CONFIG_MFN_V1
 #if CONFIG_S8
@@ -13,6 +16,8 @@
 #endif
 #endif
 
+#include "fb_overlay.h"
+
 #include "__base__.hpp"
 #include "app_camera.hpp"
 #include "app_button.hpp"
@@ -34,17 +39,21 @@ private:
 
 public:
     // AppSpeech *speech;
-    HumanFaceDetectMSR01 detector;
-    HumanFaceDetectMNP01 detector2;
+    HumanFaceDetectCascade detector;
+    FaceTracker tracker;
 
 #if CONFIG_MFN_V1
 #if CONFIG_S8
     FaceRecognition112V1S8 *recognizer;
+    FacePipeline<int8_t> *pipeline;
 #elif CONFIG_S16
     FaceRecognition112V1S16 *recognizer;
+    FacePipeline<int16_t> *pipeline;
 #endif
 #endif
 
+    fb_overlay_t *overlay; /*<! results to show, drawn by the display */
+
     face_info_t recognize_result;
     face_action_t state;
     face_action_t state_previous;
@@ -6,6 +6,8 @@
 #include "esp_lcd_panel_vendor.h"
 #include "esp_lcd_panel_ops.h"
 
+#include "fb_overlay.h"
+
 #include "__base__.hpp"
 #include "app_camera.hpp"
 #include "app_button.hpp"
@@ -25,6 +27,7 @@
 #define BOARD_LCD_V_RES 240
 #define BOARD_LCD_CMD_BITS 8
 #define BOARD_LCD_PARAM_BITS 8
+#define LCD_BAND_HEIGHT 16 // rows composed with overlays at a time
 // #define LCD_HOST SPI2_HOST
 
 class AppLCD : public Observer, public Frame
@@ -37,6 +40,8 @@ public:
     esp_lcd_panel_handle_t panel_handle;
     bool switch_on;
     bool paper_drawn;
+    std::list<fb_overlay_t *> overlays; /*<! drawn on every frame shown, never into the frame */
+    uint16_t *band;                     /*<! rows of frame with overlays drawn on */
 
     AppLCD(AppButton *key,
            AppSpeech *speech,
@@ -46,6 +51,9 @@ public:
 
     void draw_wallpaper();
     void draw_color(int color);
+    void draw_frame(camera_fb_t *frame);
+
+    void add_overlay(fb_overlay_t *overlay);
 
     void update();
 
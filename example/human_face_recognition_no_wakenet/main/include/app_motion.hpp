@@ -4,6 +4,8 @@
 #include "app_camera.hpp"
 #include "app_button.hpp"
 #include "app_speech.hpp"
+#include "who_motion_engine.hpp"
+#include "fb_overlay.h"
 
 class AppMotion : public Observer, public Frame
 {
@@ -13,6 +15,8 @@ private:
 
 public:
     bool switch_on;
+    MotionEngine *engine;
+    fb_overlay_t *overlay; /*<! moving regions to show, drawn by the display */
 
     AppMotion(AppButton *key,
               AppSpeech *speech,
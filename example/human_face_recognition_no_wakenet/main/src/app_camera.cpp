@@ -1,5 +1,7 @@
 #include "app_camera.hpp"
 
+#include <assert.h>
+
 #include "esp_log.h"
 #include "esp_system.h"
 
@@ -13,8 +15,12 @@ AppCamera::AppCamera(const pixformat_t pixel_fromat,
                      const uint8_t fb_count,
                      QueueHandle_t queue_o) : Frame(nullptr, queue_o, nullptr)
 {
+    // every buffer of the camera may be in flight to the subscribers at the same time
+    assert(fb_count <= FRAME_REF_MAX);
+
     ESP_LOGI(TAG, "Camera module is %s", CAMERA_MODULE_NAME);
-    const camera_config_t camera_config = BSP_CAMERA_DEFAULT_CONFIG;
+    camera_config_t camera_config = BSP_CAMERA_DEFAULT_CONFIG;
+    camera_config.fb_count = fb_count;
     esp_err_t err = esp_camera_init(&camera_config);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "Camera Init Failed");
@@ -30,12 +36,12 @@ static void task(AppCamera *self)
     ESP_LOGD(TAG, "Start");
     while (true)
     {
-        if (self->queue_o == nullptr)
+        if (self->queue_o == nullptr && self->subscribers.empty())
             break;
 
         camera_fb_t *frame = esp_camera_fb_get();
         if (frame)
-            xQueueSend(self->queue_o, &frame, portMAX_DELAY);
+            self->publish(frame);
     }
     ESP_LOGD(TAG, "Stop");
     vTaskDelete(NULL);
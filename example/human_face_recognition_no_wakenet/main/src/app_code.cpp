@@ -0,0 +1,137 @@
+#include "app_code.hpp"
+
+#include "esp_log.h"
+#include "esp_camera.h"
+#include "esp_timer.h"
+
+static const char TAG[] = "App/Code";
+
+#define RGB565_LCD_GREEN 0xE007
+
+#define FRAME_DELAY_NUM 16
+#define STATS_INTERVAL_US (5 * 1000 * 1000)
+
+AppCode::AppCode(AppButton *key,
+                 AppSpeech *speech,
+                 QueueHandle_t queue_i,
+                 QueueHandle_t queue_o,
+                 void (*callback)(camera_fb_t *)) : Frame(queue_i, queue_o, callback),
+                                                    key(key),
+                                                    speech(speech),
+                                                    switch_on(false),
+                                                    engine(nullptr),
+                                                    overlay(fb_overlay_create(16, 64)),
+                                                    frame_count(0) {}
+
+void AppCode::update()
+{
+    // codes are scanned whenever the display is on
+    if (this->key->pressed > BUTTON_IDLE)
+    {
+        if (this->key->pressed == BUTTON_MENU)
+        {
+            this->switch_on = (this->key->menu == MENU_STOP_WORKING) ? false : true;
+            ESP_LOGD(TAG, "%s", this->switch_on ? "ON" : "OFF");
+        }
+    }
+
+    if (this->speech->command > COMMAND_NOT_DETECTED)
+    {
+        if (this->speech->command >= MENU_STOP_WORKING && this->speech->command <= MENU_MOTION_DETECTION)
+        {
+            this->switch_on = (this->speech->command == MENU_STOP_WORKING) ? false : true;
+            ESP_LOGD(TAG, "%s", this->switch_on ? "ON" : "OFF");
+        }
+    }
+}
+
+static void task(AppCode *self)
+{
+    ESP_LOGD(TAG, "Start");
+    int64_t stats_time = esp_timer_get_time();
+    code_stats_t stats_last = {};
+    int frame_pixels = 0;
+    while (true)
+    {
+        if (self->queue_i == nullptr)
+            break;
+
+        camera_fb_t *frame = NULL;
+        if (xQueueReceive(self->queue_i, &frame, portMAX_DELAY))
+        {
+            bool scan = false;
+            if (self->switch_on)
+            {
+                if (self->engine == nullptr)
+                    self->engine = new CodeEngine(frame->height, frame->width);
+
+                scan = self->engine->load((uint16_t *)frame->buf) > 0;
+            }
+
+            // scanning works on the luma copy, the frame goes back before it
+            int height = frame->height;
+            frame_pixels = frame->height * frame->width;
+            if (self->queue_o)
+                xQueueSend(self->queue_o, &frame, portMAX_DELAY);
+            else
+                self->callback(frame);
+
+            if (scan)
+            {
+                std::vector<code_result_t> &results = self->engine->scan();
+                if (!results.empty())
+                {
+                    fb_overlay_begin(self->overlay);
+                    int line = 0;
+                    for (auto &result : results)
+                    {
+                        if (!result.repeated)
+                            ESP_LOGI(TAG, "%s: %s", result.type.c_str(), result.data.c_str());
+
+                        fb_overlay_box(self->overlay, result.box[0], result.box[1], result.box[2], result.box[3], RGB565_LCD_GREEN, 2);
+                        fb_overlay_printf(self->overlay, 4, height - 24 - 20 * line++, RGB565_LCD_GREEN, "%.15s", result.data.c_str());
+                    }
+                    fb_overlay_commit(self->overlay);
+                    self->frame_count = FRAME_DELAY_NUM;
+                }
+            }
+
+            // the last codes stay shown for a while, a still code is not scanned every frame
+            if (self->frame_count && (--self->frame_count == 0 || !self->switch_on))
+            {
+                self->frame_count = 0;
+                fb_overlay_begin(self->overlay);
+                fb_overlay_commit(self->overlay);
+            }
+
+            if (self->engine == nullptr || !self->switch_on)
+            {
+                // rates are of the time switched on
+                stats_time = esp_timer_get_time();
+                if (self->engine)
+                    stats_last = self->engine->get_stats();
+            }
+            else if (esp_timer_get_time() - stats_time >= STATS_INTERVAL_US)
+            {
+                code_stats_t stats = self->engine->get_stats();
+                float seconds = (esp_timer_get_time() - stats_time) / 1000000.0f;
+                uint32_t frames = stats.frames - stats_last.frames;
+                ESP_LOGI(TAG, "%.1f frames/s, %.1f scans/s, %.1f%% of frames scanned, %d decoded",
+                         frames / seconds,
+                         (stats.scans - stats_last.scans) / seconds,
+                         frames ? 100.0f * (stats.pixels - stats_last.pixels) / ((uint64_t)frames * frame_pixels) : 0.0f,
+                         (int)(stats.decoded - stats_last.decoded));
+                stats_last = stats;
+                stats_time = esp_timer_get_time();
+            }
+        }
+    }
+    ESP_LOGD(TAG, "Stop");
+    vTaskDelete(NULL);
+}
+
+void AppCode::run()
+{
+    // on the core of motion, away from face detection, at a lower priority than the stages sharing it
+    xTaskCreatePinnedToCore((TaskFunction_t)task, TAG, 6 * 1024, this, 4, NULL, 0);
+}
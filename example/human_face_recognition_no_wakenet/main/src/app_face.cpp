@@ -1,56 +1,41 @@
 #include "app_face.hpp"
 
 #include <list>
+#include <algorithm>
 
 #include "esp_log.h"
 #include "esp_camera.h"
 
 #include "dl_image.hpp"
-#include "fb_gfx.h"
+#include "fb_overlay.h"
 
 #include "app_speech.hpp"
 
 #include "who_ai_utils.hpp"
+#include "who_face_id_log.hpp"
 
 static const char TAG[] = "App/Face";
 
-#define RGB565_MASK_RED 0xF800
-#define RGB565_MASK_GREEN 0x07E0
-#define RGB565_MASK_BLUE 0x001F
+#define RGB565_LCD_RED 0x00F8
+#define RGB565_LCD_GREEN 0xE007
+#define RGB565_LCD_BLUE 0x1F00
 
 #define FRAME_DELAY_NUM 16
 
-static void rgb_print(camera_fb_t *fb, uint32_t color, const char *str)
+static void rgb_print(fb_overlay_t *overlay, int width, uint16_t color, const char *str)
 {
-    fb_gfx_print(fb, (fb->width - (strlen(str) * 14)) / 2, 10, color, str);
+    fb_overlay_print(overlay, (width - (int)(strlen(str) * 14)) / 2, 10, color, str);
 }
 
-static int rgb_printf(camera_fb_t *fb, uint32_t color, const char *format, ...)
+static int rgb_printf(fb_overlay_t *overlay, int width, uint16_t color, const char *format, ...)
 {
-    char loc_buf[64];
-    char *temp = loc_buf;
-    int len;
+    // one line fits the width of frame, longer text is cut
+    char buf[32];
     va_list arg;
-    va_list copy;
     va_start(arg, format);
-    va_copy(copy, arg);
-    len = vsnprintf(loc_buf, sizeof(loc_buf), format, arg);
-    va_end(copy);
-    if (len >= sizeof(loc_buf))
-    {
-        temp = (char *)malloc(len + 1);
-        if (temp == NULL)
-        {
-            return 0;
-        }
-    }
-    vsnprintf(temp, len + 1, format, arg);
+    int len = vsnprintf(buf, sizeof(buf), format, arg);
     va_end(arg);
-    rgb_print(fb, color, temp);
-    if (len > 64)
-    {
-        free(temp);
-    }
+    rgb_print(overlay, width, color, buf);
     return len;
 }
 
@@ -61,8 +46,10 @@ AppFace::AppFace(AppButton *key,
                  void (*callback)(camera_fb_t *)) : Frame(queue_i, queue_o, callback),
                                                     key(key),
                                                     speech(speech),
-                                                    detector(0.3F, 0.3F, 10, 0.3F),
-                                                    detector2(0.4F, 0.3F, 10),
+                                                    detector(0.3F, 0.3F, 10, 0.3F, 0.4F, 0.3F, 1, 5),
+                                                    tracker(5),
+                                                    pipeline(nullptr),
+                                                    overlay(fb_overlay_create(64, 64)),
                                                     state(FACE_IDLE),
                                                     switch_on(false)
 {
@@ -75,12 +62,15 @@ AppFace::AppFace(AppButton *key,
 #endif
 
     this->recognizer->set_partition(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "fr");
-    this->recognizer->set_ids_from_flash();
+    register_face_id_log("fr", 512);
+    face_id_log_load(this->recognizer);
 }
 
 AppFace::~AppFace()
 {
+    delete this->pipeline;
     delete this->recognizer;
+    fb_overlay_destroy(this->overlay);
 }
 
 void AppFace::update()
@@ -138,6 +128,14 @@ static void task(AppFace *self)
     ESP_LOGD(TAG, "Start");
     camera_fb_t *frame = nullptr;
     bool audio_notify = false;
+    std::vector<int> in_flight; // track ids waiting for recognition
+    std::vector<int> unsaved_ids; // enrolled ids the log did not take yet
+
+    // kept across frames, so their capacity is reused and tracking known faces allocates nothing here
+    std::vector<int> shape;
+    std::vector<face_pipeline_result_t> results;
+    std::vector<int> ids;
+    std::vector<std::vector<int>> landmarks;
 
     while (true)
     {
@@ -146,43 +144,114 @@ static void task(AppFace *self)
 
         if (xQueueReceive(self->queue_i, &frame, portMAX_DELAY))
         {
+            // results are recorded for the display instead of drawn into the frame shared with other consumers
+            fb_overlay_begin(self->overlay);
             if (self->switch_on)
             {
-                std::list<dl::detect::result_t> &detect_candidates = self->detector.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3});
-                std::list<dl::detect::result_t> &detect_results = self->detector2.infer((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_candidates);
+                // full detection every few frames, the boxes predicted by tracker are only refined in between
+                shape.assign({(int)frame->height, (int)frame->width, 3});
+                bool full_detection = self->tracker.need_detection();
+                std::list<dl::detect::result_t> &predictions = self->tracker.predict();
+                std::list<dl::detect::result_t> &detections = full_detection ? self->detector.infer((uint16_t *)frame->buf, shape)
+                                                                             : self->detector.refine((uint16_t *)frame->buf, shape, predictions);
+                std::list<dl::detect::result_t> &detect_results = self->tracker.update(detections, full_detection);
+
+                // results of faces recognized on the other core since the last frame
+                results.clear();
+                if (self->pipeline->collect(results))
+                {
+                    for (auto &result : results)
+                    {
+                        for (auto &track : self->tracker.get_tracks())
+                        {
+                            if (track.id != result.id)
+                                continue;
+                            track.result = result.result;
+                            track.recognized = true;
+                            ESP_LOGI(TAG, "Track %d Match ID: %d", track.id, result.result.id);
+                        }
+                    }
+
+                    // the best matched face is shown
+                    self->recognize_result = {-1, "", -1.f};
+                    for (auto &track : self->tracker.get_tracks())
+                    {
+                        if (!track.missed && track.result.similarity > self->recognize_result.similarity)
+                            self->recognize_result = track.result;
+                    }
+                }
+                if (self->pipeline->get_pending() == 0)
+                    in_flight.clear();
+
+                // each track is recognized once, later presses reuse the result
+                // landmarks only grows, its first ids.size() entries are valid
+                ids.clear();
+                bool recognizing = (self->state == FACE_RECOGNIZE) || (self->frame_count && self->state_previous == FACE_RECOGNIZE);
+                if (recognizing)
+                {
+                    for (auto &track : self->tracker.get_tracks())
+                    {
+                        if (track.missed || track.recognized || std::find(in_flight.begin(), in_flight.end(), track.id) != in_flight.end())
+                            continue;
+                        if (landmarks.size() <= ids.size())
+                            landmarks.emplace_back();
+                        landmarks[ids.size()].assign(track.keypoint.begin(), track.keypoint.end());
+                        ids.push_back(track.id);
+                    }
+                }
+                if (self->pipeline->submit((uint16_t *)frame->buf, shape, ids, landmarks))
+                    in_flight.insert(in_flight.end(), ids.begin(), ids.end());
 
                 if (detect_results.size())
                 {
                     // print_detection_result(detect_results);
-                    draw_detection_result((uint16_t *)frame->buf, frame->height, frame->width, detect_results);
+                    draw_detection_result(self->overlay, detect_results);
                 }
 
                 if (self->state)
                 {
-                    if (detect_results.size() == 1)
+                    if (detect_results.size() == 1 && self->state == FACE_ENROLL)
                     {
-                        if (self->state == FACE_ENROLL)
+                        self->pipeline->lock();
+                        int id = self->recognizer->enroll_id((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_results.front().keypoint, "", false);
+                        self->pipeline->unlock();
+                        if (face_id_log_flush(self->recognizer, unsaved_ids) || !face_id_log_append(id, self->recognizer->get_face_emb(id)))
                         {
-                            self->recognizer->enroll_id((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_results.front().keypoint, "", true);
-                            ESP_LOGI(TAG, "Enroll ID %d", self->recognizer->get_enrolled_ids().back().id);
+                            unsaved_ids.push_back(id);
+                            ESP_LOGE(TAG, "ID %d is not saved yet, it is retried at next enrollment or deletion", id);
                         }
-                        else if (self->state == FACE_RECOGNIZE)
+                        self->pipeline->invalidate();
+                        in_flight.clear();
+                        self->tracker.clear_recognition();
+                        ESP_LOGI(TAG, "Enroll ID %d", id);
+                    }
+                    else if (self->state == FACE_RECOGNIZE)
+                    {
+                        print_detection_result(detect_results);
+                        self->pipeline->print_stats();
+
+                        // faces recognized before are shown at once, the others when their results come
+                        self->recognize_result = {-1, "", -1.f};
+                        for (auto &track : self->tracker.get_tracks())
                         {
-                            self->recognize_result = self->recognizer->recognize((uint16_t *)frame->buf, {(int)frame->height, (int)frame->width, 3}, detect_results.front().keypoint);
-                            print_detection_result(detect_results);
-                            // ESP_LOGI(TAG, "Similarity: %f", self->recognize_result.similarity);
-                            if (self->recognize_result.id > 0 && self->recognize_result.similarity > 0.97){
-                                ESP_LOGI(TAG, "Match ID: %d", self->recognize_result.id);
-                            } else {
-                                ESP_LOGI(TAG, "Match ID: %d", self->recognize_result.id);
-                            }
+                            if (!track.missed && track.result.similarity > self->recognize_result.similarity)
+                                self->recognize_result = track.result;
                         }
                     }
 
                     if (self->state == FACE_DELETE)
                     {
-                        vTaskDelay(10);
-                        self->recognizer->delete_id(true);
+                        if (self->recognizer->get_enrolled_id_num() > 0)
+                        {
+                            face_id_log_flush(self->recognizer, unsaved_ids);
+                            self->pipeline->lock();
+                            face_id_log_remove(self->recognizer->get_enrolled_ids().back().id);
+                            self->recognizer->delete_id(false);
+                            self->pipeline->unlock();
+                            self->pipeline->invalidate();
+                            in_flight.clear();
+                            self->tracker.clear_recognition();
+                        }
                         ESP_LOGI(TAG, "%d IDs left", self->recognizer->get_enrolled_id_num());
                     }
 
@@ -197,21 +266,23 @@ static void task(AppFace *self)
                     switch (self->state_previous)
                     {
                     case FACE_DELETE:
-                        rgb_printf(frame, RGB565_MASK_RED, "%d IDs left", self->recognizer->get_enrolled_id_num());
+                        rgb_printf(self->overlay, frame->width, RGB565_LCD_RED, "%d IDs left", self->recognizer->get_enrolled_id_num());
                         break;
 
                     case FACE_RECOGNIZE:
 
                         // ESP_LOGI(TAG, "Similarity: %f", self->recognize_result.similarity);
-                        if (self->recognize_result.similarity > 0.98) {
+                        if (self->recognize_result.similarity <= 0.98 && in_flight.size()) {
+                            rgb_print(self->overlay, frame->width, RGB565_LCD_BLUE, "...");
+                        } else if (self->recognize_result.similarity > 0.98) {
                         // if (self->recognize_result.id > 0) {
-                            rgb_printf(frame, RGB565_MASK_GREEN, "ID %d", self->recognize_result.id);
+                            rgb_printf(self->overlay, frame->width, RGB565_LCD_GREEN, "ID %d", self->recognize_result.id);
                             if (audio_notify == true) {
                                 self->get()->audio_play_success();
                                 audio_notify = false;
                             }
                         } else {
-                            rgb_print(frame, RGB565_MASK_RED, "who ?");
+                            rgb_print(self->overlay, frame->width, RGB565_LCD_RED, "who ?");
                             if (audio_notify == true) {
                                 self->get()->audio_play_error();
                                 audio_notify = false;
@@ -220,7 +291,7 @@ static void task(AppFace *self)
                         break;
 
                     case FACE_ENROLL:
-                        rgb_printf(frame, RGB565_MASK_BLUE, "Enroll: ID %d", self->recognizer->get_enrolled_ids().back().id);
+                        rgb_printf(self->overlay, frame->width, RGB565_LCD_BLUE, "Enroll: ID %d", self->recognizer->get_enrolled_ids().back().id);
                         break;
 
                     default:
@@ -236,6 +307,8 @@ static void task(AppFace *self)
                 }
             }
 
+            fb_overlay_commit(self->overlay);
+
             if (self->queue_o)
                 xQueueSend(self->queue_o, &frame, portMAX_DELAY);
             else
@@ -248,6 +321,13 @@ static void task(AppFace *self)
 
 void AppFace::run()
 {
+    // recognition runs on core 0 while detection of the next frames goes on in task on core 1
+    if (this->pipeline == nullptr)
+#if CONFIG_S8
+        this->pipeline = new FacePipeline<int8_t>(this->recognizer, this->queue_i, 2, 0);
+#elif CONFIG_S16
+        this->pipeline = new FacePipeline<int16_t>(this->recognizer, this->queue_i, 2, 0);
+#endif
     xTaskCreatePinnedToCore((TaskFunction_t)task, TAG, 5 * 1024, this, 5, NULL, 1);
 }
 
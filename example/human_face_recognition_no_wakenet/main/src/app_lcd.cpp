@@ -1,6 +1,7 @@
 #include "app_lcd.hpp"
 
 #include <string.h>
+#include <algorithm>
 
 #include "esp_log.h"
 #include "esp_camera.h"
@@ -17,8 +18,12 @@ AppLCD::AppLCD(AppButton *key,
                                                   key(key),
                                                   speech(speech),
                                                   panel_handle(NULL),
-                                                  switch_on(false)
+                                                  switch_on(false),
+                                                  band(NULL)
 {
+    // in PSRAM like the frames, so draw_bitmap() copies it the same way and it can be refilled at once
+    this->band = (uint16_t *)heap_caps_malloc(BOARD_LCD_H_RES * LCD_BAND_HEIGHT * sizeof(uint16_t), MALLOC_CAP_8BIT | MALLOC_CAP_SPIRAM);
+
     do
     {
         ESP_LOGI(TAG, "Initialize SPI bus");
@@ -116,6 +121,46 @@ void AppLCD::draw_color(int color)
     }
 }
 
+void AppLCD::add_overlay(fb_overlay_t *overlay)
+{
+    if (overlay)
+        this->overlays.push_back(overlay);
+}
+
+void AppLCD::draw_frame(camera_fb_t *frame)
+{
+    const int width = frame->width;
+    const int height = frame->height;
+    uint16_t *pixels = (uint16_t *)frame->buf;
+
+    // the latest results of each producer, kept until they commit again
+    for (auto overlay : this->overlays)
+        fb_overlay_latch(overlay);
+
+    // rows without overlay are sent from the frame as they are, the others through band
+    int sent = 0;
+    for (int y1 = 0; this->band && width <= BOARD_LCD_H_RES && y1 < height; y1 += LCD_BAND_HEIGHT)
+    {
+        int y2 = std::min(y1 + LCD_BAND_HEIGHT, height) - 1;
+        bool touched = false;
+        for (auto overlay : this->overlays)
+            touched |= fb_overlay_touches(overlay, y1, y2);
+        if (!touched)
+            continue;
+
+        if (sent < y1)
+            esp_lcd_panel_draw_bitmap(this->panel_handle, 0, sent, width, y1, pixels + sent * width);
+
+        memcpy(this->band, pixels + y1 * width, (y2 - y1 + 1) * width * sizeof(uint16_t));
+        for (auto overlay : this->overlays)
+            fb_overlay_draw(overlay, this->band, width, y1, y2);
+        esp_lcd_panel_draw_bitmap(this->panel_handle, 0, y1, width, y2 + 1, this->band);
+        sent = y2 + 1;
+    }
+    if (sent < height)
+        esp_lcd_panel_draw_bitmap(this->panel_handle, 0, sent, width, height, pixels + sent * width);
+}
+
 void AppLCD::update()
 {
     if (this->key->pressed > BUTTON_IDLE)
@@ -155,7 +200,7 @@ static void task(AppLCD *self)
         if (xQueueReceive(self->queue_i, &frame, portMAX_DELAY))
         {
             if (self->switch_on)
-                esp_lcd_panel_draw_bitmap(self->panel_handle, 0, 0, frame->width, frame->height, (uint16_t *)frame->buf);
+                self->draw_frame(frame);
             else if (self->paper_drawn == false)
                 self->draw_wallpaper();
 
@@ -3,7 +3,6 @@
 #include "esp_log.h"
 #include "esp_camera.h"
 
-#include "dl_image.hpp"
 
 static const char TAG[] = "App/Motion";
 
@@ -14,7 +13,9 @@ AppMotion::AppMotion(AppButton *key,
                      void (*callback)(camera_fb_t *)) : Frame(queue_i, queue_o, callback),
                                                         key(key),
                                                         speech(speech),
-                                                        switch_on(false) {}
+                                                        switch_on(false),
+                                                        engine(nullptr),
+                                                        overlay(fb_overlay_create(32, 0)) {}
 
 void AppMotion::update()
 {
@@ -45,29 +46,34 @@ static void task(AppMotion *self)
         if (self->queue_i == nullptr)
             break;
 
-        camera_fb_t *frame1 = NULL;
-        camera_fb_t *frame2 = NULL;
-        if (xQueueReceive(self->queue_i, &frame1, portMAX_DELAY))
+        camera_fb_t *frame = NULL;
+        if (xQueueReceive(self->queue_i, &frame, portMAX_DELAY))
         {
+            fb_overlay_begin(self->overlay);
             if (self->switch_on)
             {
-                if (xQueueReceive(self->queue_i, &frame2, portMAX_DELAY))
-                {
-                    uint32_t moving_point_number = dl::image::get_moving_point_number((uint16_t *)frame1->buf, (uint16_t *)frame2->buf, frame1->height, frame1->width, 8, 15);
-                    if (moving_point_number > 50)
-                    {
-                        ESP_LOGI(TAG, "Something moved!");
-                        dl::image::draw_filled_rectangle((uint16_t *)frame1->buf, frame1->height, frame1->width, 0, 0, 20, 20);
-                    }
+                if (self->engine == nullptr)
+                    self->engine = new MotionEngine(frame->height, frame->width);
 
-                    self->callback(frame2);
+                if (self->engine->detect((uint16_t *)frame->buf) > 0)
+                {
+                    ESP_LOGI(TAG, "Something moved!");
+                    for (auto &region : self->engine->get_regions())
+                        fb_overlay_box(self->overlay, region[0], region[1], region[2], region[3], 0b0001111100000000, 2);
                 }
             }
+            else if (self->engine)
+            {
+                // the background is out of date when switched on again
+                self->engine->reset();
+            }
+
+            fb_overlay_commit(self->overlay);
 
             if (self->queue_o)
-                xQueueSend(self->queue_o, &frame1, portMAX_DELAY);
+                xQueueSend(self->queue_o, &frame, portMAX_DELAY);
             else
-                self->callback(frame1);
+                self->callback(frame);
         }
     }
     ESP_LOGD(TAG, "Stop");
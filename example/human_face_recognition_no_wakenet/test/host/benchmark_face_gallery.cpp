@@ -0,0 +1,190 @@
+/**
+ * @file benchmark_face_gallery.cpp
+ * @brief FaceGallery against the float path of FaceRecognizer::recognize(Tensor<float> &), in matches per second.
+ *
+ * Random 512-d ids are enrolled in a stand-in recognizer, which matches one float id at a time by cos_distance() as
+ * the prebuilt one does, and copied into the gallery by set_ids() through get_face_emb(). Queries are noisy copies of
+ * enrolled ids and strangers, at 10 to 2000 ids:
+ *         - the gallery recognizes the same id as the float path, strangers included,
+ *         - its similarity is within 3e-3 of the float one,
+ *         - top_k() is sorted and starts with the recognized id,
+ *         - removing ids keeps the rest found,
+ *         - the int8 dot product equals the plain sum of products.
+ * Usage: benchmark_face_gallery [queries], 200 by default.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "host_test.hpp"
+#include "esp_timer.h"
+#include "face_gallery.hpp"
+
+#define EMB_SIZE 512
+#define THRESH 0.55f
+
+using namespace dl;
+
+static float random_normal()
+{
+    float u = (rand() + 1.f) / (RAND_MAX + 2.f), v = (rand() + 1.f) / (RAND_MAX + 2.f);
+    return sqrtf(-2.f * logf(u)) * cosf(6.2831853f * v);
+}
+
+static Tensor<float> *random_emb(const Tensor<float> *base = NULL, const float noise = 0.f)
+{
+    Tensor<float> *emb = new Tensor<float>;
+    emb->set_shape({EMB_SIZE}).malloc_element();
+    for (int i = 0; i < EMB_SIZE; i++)
+        emb->element[i] = (base ? base->element[i] : 0.f) + (base ? noise : 1.f) * random_normal() / sqrtf(EMB_SIZE);
+    face_recognition_tool::l2_norm(*emb);
+    return emb;
+}
+
+/**
+ * @brief Enrolled ids of a recognizer, matched one float id at a time.
+ */
+class Recognizer
+{
+public:
+    std::vector<int> ids;
+    std::vector<Tensor<float> *> embs;
+
+    ~Recognizer()
+    {
+        for (auto emb : this->embs)
+            delete emb;
+    }
+
+    std::vector<face_info_t> get_enrolled_ids()
+    {
+        std::vector<face_info_t> enrolled;
+        for (int id : this->ids)
+            enrolled.push_back({id, "", 0.f});
+        return enrolled;
+    }
+
+    Tensor<float> &get_face_emb(int id)
+    {
+        for (int i = 0; i < this->ids.size(); i++)
+        {
+            if (this->ids[i] == id)
+                return *this->embs[i];
+        }
+        return *this->embs.back();
+    }
+
+    face_info_t recognize(Tensor<float> &emb)
+    {
+        face_info_t result = {-1, "", -1.f};
+        for (int i = 0; i < this->ids.size(); i++)
+        {
+            float similarity = face_recognition_tool::cos_distance(*this->embs[i], emb);
+            if (similarity > result.similarity)
+                result = {this->ids[i], "", similarity};
+        }
+        if (result.similarity <= THRESH)
+            result.id = -1;
+        return result;
+    }
+};
+
+static void benchmark(const int n, const int query_num)
+{
+    srand(n);
+    Recognizer recognizer;
+    for (int i = 0; i < n; i++)
+    {
+        recognizer.ids.push_back(i + 1);
+        recognizer.embs.push_back(random_emb());
+    }
+    FaceGallery gallery(EMB_SIZE, 16, THRESH);
+    HOST_TEST_CHECK_EQUAL(n, gallery.set_ids(recognizer));
+
+    // every fourth query is a stranger
+    std::vector<Tensor<float> *> queries;
+    for (int i = 0; i < query_num; i++)
+        queries.push_back(i % 4 == 3 ? random_emb() : random_emb(recognizer.embs[rand() % n], 0.6f));
+
+    std::vector<face_info_t> expected(query_num), results(query_num);
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < query_num; i++)
+        expected[i] = recognizer.recognize(*queries[i]);
+    int64_t float_period = esp_timer_get_time() - start;
+    start = esp_timer_get_time();
+    for (int i = 0; i < query_num; i++)
+        results[i] = gallery.recognize(*queries[i]);
+    int64_t int8_period = esp_timer_get_time() - start;
+
+    int different = 0, unsorted = 0, strangers = 0;
+    float error = 0.f;
+    for (int i = 0; i < query_num; i++)
+    {
+        different += results[i].id != expected[i].id;
+        strangers += expected[i].id == -1;
+        error = DL_MAX(error, fabsf(results[i].similarity - expected[i].similarity));
+
+        std::vector<face_info_t> top = gallery.top_k(*queries[i], 5);
+        for (int j = 1; j < top.size(); j++)
+            unsorted += top[j].similarity > top[j - 1].similarity;
+        unsorted += top.empty() || (results[i].id != -1 && top[0].id != results[i].id);
+    }
+    HOST_TEST_CHECK_EQUAL(0, different);
+    HOST_TEST_CHECK_EQUAL(0, unsorted);
+    HOST_TEST_CHECK(error < 3e-3f);
+    HOST_TEST_CHECK(strangers > 0 && strangers < query_num);
+
+    printf("%5d ids: float %10.0f matches/s, int8 %10.0f matches/s, %5.1fx, max error %.4f\n", n,
+           float_period ? 1e6 * query_num / float_period : 0.0, int8_period ? 1e6 * query_num / int8_period : 0.0,
+           int8_period ? (double)float_period / int8_period : 0.0, error);
+
+    // the last row moves into the hole of a removed id
+    for (int i = 0; i < n / 2; i++)
+        HOST_TEST_CHECK(gallery.remove(2 * i + 1));
+    HOST_TEST_CHECK(!gallery.remove(1));
+    HOST_TEST_CHECK_EQUAL(n - n / 2, gallery.size());
+    int lost = 0;
+    for (int i = n / 2 * 2; i < n; i++)
+        lost += gallery.recognize(*recognizer.embs[i]).id != i + 1;
+    for (int i = 1; i < n; i += 2)
+        lost += gallery.recognize(*recognizer.embs[i]).id != i + 1;
+    HOST_TEST_CHECK_EQUAL(0, lost);
+
+    for (auto query : queries)
+        delete query;
+}
+
+static void test_dot()
+{
+    int8_t *a = (int8_t *)dl::tool::malloc_aligned_prefer(1024, 1, 16);
+    int8_t *b = (int8_t *)dl::tool::malloc_aligned_prefer(1024, 1, 16);
+    int wrong = 0;
+    for (int length = 16; length <= 1024; length += 16)
+    {
+        int32_t expected = 0;
+        for (int i = 0; i < length; i++)
+        {
+            // the extremes of both signs are covered
+            a[i] = i % 7 == 0 ? -128 : rand() % 255 - 127;
+            b[i] = i % 5 == 0 ? -128 : rand() % 255 - 127;
+            expected += a[i] * b[i];
+        }
+        wrong += FaceGallery::dot(a, b, length) != expected;
+    }
+    HOST_TEST_CHECK_EQUAL(0, wrong);
+    dl::tool::free_aligned_prefer(a);
+    dl::tool::free_aligned_prefer(b);
+}
+
+int main(int argc, char *argv[])
+{
+    int query_num = argc > 1 ? atoi(argv[1]) : 200;
+
+    test_dot();
+
+    const int sizes[] = {10, 100, 1000, 2000};
+    for (int n : sizes)
+        benchmark(n, query_num);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,77 @@
+/**
+ * @file benchmark_nn_reference.cpp
+ * @brief Throughput of dl::nn::reference on the host, in MAC per second.
+ *
+ * The reference is the yardstick of the SIMD kernels, not a replacement: the numbers tell how long a golden run over a
+ * model takes, e.g., 10000 inferences of a layer in a test. Usage: benchmark_nn_reference [repeat], 4 by default.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "host_test.hpp"
+#include "dl_nn_reference.hpp"
+
+using namespace dl;
+using namespace nn;
+
+template <typename T>
+static void fill(std::vector<T> &data, const int seed)
+{
+    srand(seed);
+    for (auto &value : data)
+        value = (T)(rand() % 128 - 64);
+}
+
+template <typename feature_t, typename bias_t>
+static void benchmark_conv2d(const char *name, const std::vector<int> &input_shape, const std::vector<int> &filter_shape, const bool depthwise, const bool per_channel, const int repeat)
+{
+    const int channel = depthwise ? input_shape[2] : filter_shape[3];
+    std::vector<feature_t> input_element(input_shape[0] * input_shape[1] * input_shape[2]);
+    std::vector<feature_t> filter_element(filter_shape[0] * filter_shape[1] * filter_shape[2] * filter_shape[3]);
+    std::vector<int8_t> channel_exponent(channel, -8);
+    std::vector<bias_t> bias_element(channel);
+    fill(input_element, 1);
+    fill(filter_element, 2);
+    fill(bias_element, 3);
+
+    Filter<feature_t> *filter = per_channel ? new Filter<feature_t>(filter_element.data(), channel_exponent.data(), channel, filter_shape)
+                                            : new Filter<feature_t>(filter_element.data(), -8, filter_shape);
+    Bias<bias_t> bias(bias_element.data(), -4, {channel});
+    Activation<feature_t> relu(ReLU);
+    Tensor<feature_t> input;
+    input.set_element(input_element.data()).set_exponent(-4).set_shape(input_shape);
+
+    int64_t checksum = 0;
+    int64_t macs = 0;
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < repeat; i++)
+    {
+        Tensor<feature_t> output;
+        if (depthwise)
+            reference::depthwise_conv2d(output, -4, input, *filter, 1, 1, PADDING_SAME_END, &bias, &relu);
+        else
+            reference::conv2d(output, -4, input, *filter, 1, 1, PADDING_SAME_END, &bias, &relu);
+        macs += (int64_t)output.get_size() * filter_shape[0] * filter_shape[1] * (depthwise ? 1 : filter_shape[2]);
+        for (int j = 0; j < output.get_size(); j++)
+            checksum += output.element[j];
+    }
+    int64_t period = esp_timer_get_time() - start;
+    delete filter;
+
+    printf("%-32s %8.1f us/inference %8.1f MMAC/s (checksum %lld)\n", name, (double)period / repeat, period ? (double)macs / period : 0.0, (long long)checksum);
+    HOST_TEST_CHECK(macs > 0);
+}
+
+int main(int argc, char *argv[])
+{
+    int repeat = argc > 1 ? atoi(argv[1]) : 4;
+
+    benchmark_conv2d<int16_t, int16_t>("conv2d int16 3x3 56x56x32->32", {56, 56, 32}, {3, 3, 32, 32}, false, false, repeat);
+    benchmark_conv2d<int16_t, int16_t>("conv2d int16 1x1 28x28x64->64", {28, 28, 64}, {1, 1, 64, 64}, false, false, repeat);
+    benchmark_conv2d<int16_t, int16_t>("depthwise int16 3x3 56x56x64", {56, 56, 64}, {3, 3, 64, 1}, true, false, repeat);
+    benchmark_conv2d<int8_t, int8_t>("conv2d int8 3x3 56x56x32->32", {56, 56, 32}, {3, 3, 32, 32}, false, false, repeat);
+    benchmark_conv2d<int8_t, int16_t>("conv2d int8 per-channel 3x3", {56, 56, 32}, {3, 3, 32, 32}, false, true, repeat);
+    benchmark_conv2d<int8_t, int16_t>("depthwise int8 per-channel 3x3", {56, 56, 64}, {3, 3, 64, 1}, true, true, repeat);
+    return HOST_TEST_RESULT();
+}
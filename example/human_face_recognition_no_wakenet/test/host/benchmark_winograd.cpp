@@ -0,0 +1,83 @@
+/**
+ * @file benchmark_winograd.cpp
+ * @brief dl::nn::conv2d_winograd() against the direct dl::nn::reference::conv2d() on the host, in MAC per second.
+ *
+ * MAC are those of the direct convolution for both, so the rates compare the time of the same layer. The direct one
+ * here is the portable reference, not the SIMD kernel of the chip: the ratio tells what the 16 instead of 36
+ * multiplications of a 2x2 tile buy in plain C++, the tutorial prints the cycles on the chip. Each layer must also
+ * drift 0 LSB from the direct result. Usage: benchmark_winograd [repeat], 4 by default.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "host_test.hpp"
+#include "dl_nn_reference.hpp"
+#include "dl_nn_winograd.hpp"
+
+using namespace dl;
+using namespace nn;
+
+template <typename T>
+static void fill(std::vector<T> &data, const int seed)
+{
+    srand(seed);
+    for (auto &value : data)
+        value = (T)(rand() % 128 - 64);
+}
+
+static void benchmark_conv2d(const char *name, const std::vector<int> &input_shape, const int output_channel, const int repeat)
+{
+    const std::vector<int> filter_shape = {3, 3, input_shape[2], output_channel};
+    std::vector<int16_t> input_element(input_shape[0] * input_shape[1] * input_shape[2]);
+    std::vector<int16_t> filter_element(9 * input_shape[2] * output_channel);
+    std::vector<int16_t> bias_element(output_channel);
+    fill(input_element, 1);
+    fill(filter_element, 2);
+    fill(bias_element, 3);
+
+    Filter<int16_t> filter(filter_element.data(), -8, filter_shape);
+    Bias<int16_t> bias(bias_element.data(), -4, {output_channel});
+    Activation<int16_t> relu(ReLU);
+    Tensor<int16_t> input;
+    input.set_element(input_element.data()).set_exponent(-4).set_shape(input_shape);
+
+    std::vector<int> output_hw, padding;
+    reference::get_output_shape_and_padding(output_hw, padding, input_shape[0], input_shape[1], 3, 3, 1, 1, PADDING_SAME_END);
+    Tensor<int16_t> direct, winograd;
+    direct.set_exponent(-4).set_shape({output_hw[0], output_hw[1], output_channel}).malloc_element();
+    winograd.set_exponent(-4).set_shape(direct.shape).malloc_element();
+    int32_t *transformed = winograd_transform_filter(filter, false);
+
+    int64_t start = esp_timer_get_time();
+    for (int i = 0; i < repeat; i++)
+        reference::conv2d(direct, input, padding, filter, 1, 1, &bias, &relu);
+    int64_t direct_period = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int i = 0; i < repeat; i++)
+        conv2d_winograd(winograd, input, padding, transformed, filter, &bias, &relu);
+    int64_t winograd_period = esp_timer_get_time() - start;
+    tool::free_aligned(transformed);
+
+    int drift = 0;
+    for (int i = 0; i < direct.get_size(); i++)
+        drift = DL_MAX(drift, DL_ABS(direct.element[i] - winograd.element[i]));
+    HOST_TEST_CHECK_EQUAL(0, drift);
+
+    int64_t macs = (int64_t)repeat * direct.get_size() * 9 * input_shape[2];
+    printf("%-32s direct %8.1f MMAC/s, winograd %8.1f MMAC/s, %4.2fx, drift %d LSB\n", name,
+           direct_period ? (double)macs / direct_period : 0.0, winograd_period ? (double)macs / winograd_period : 0.0,
+           winograd_period ? (double)direct_period / winograd_period : 0.0, drift);
+}
+
+int main(int argc, char *argv[])
+{
+    int repeat = argc > 1 ? atoi(argv[1]) : 4;
+
+    benchmark_conv2d("conv2d int16 3x3 56x56x32->32", {56, 56, 32}, 32, repeat);
+    benchmark_conv2d("conv2d int16 3x3 28x28x64->64", {28, 28, 64}, 64, repeat);
+    benchmark_conv2d("conv2d int16 3x3 14x14x128->128", {14, 14, 128}, 128, repeat);
+    benchmark_conv2d("conv2d int16 3x3 28x28x3->16", {28, 28, 3}, 16, repeat);
+    return HOST_TEST_RESULT();
+}
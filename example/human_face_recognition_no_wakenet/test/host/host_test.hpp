@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdio.h>
+
+/**
+ * @brief Checks of the host tests. A failed check is printed and counted, the test goes on. main() returns
+ * HOST_TEST_RESULT() so that ctest sees the failures.
+ */
+static int host_test_failures = 0;
+
+#define HOST_TEST_CHECK(condition)                                                 \
+    do                                                                             \
+    {                                                                              \
+        if (!(condition))                                                          \
+        {                                                                          \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            host_test_failures++;                                                  \
+        }                                                                          \
+    } while (0)
+
+#define HOST_TEST_CHECK_EQUAL(expected, actual)                                                                    \
+    do                                                                                                             \
+    {                                                                                                              \
+        long long _expected = (long long)(expected);                                                               \
+        long long _actual = (long long)(actual);                                                                   \
+        if (_expected != _actual)                                                                                  \
+        {                                                                                                          \
+            printf("%s:%d: %s = %lld, expected %lld\n", __FILE__, __LINE__, #actual, _actual, _expected);         \
+            host_test_failures++;                                                                                  \
+        }                                                                                                          \
+    } while (0)
+
+#define HOST_TEST_RESULT() (printf("%s\n", host_test_failures ? "FAIL" : "PASS"), host_test_failures ? 1 : 0)
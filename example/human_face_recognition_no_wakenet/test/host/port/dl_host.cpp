@@ -0,0 +1,124 @@
+/**
+ * @file dl_host.cpp
+ * @brief Host definitions of the esp-dl members which live in the prebuilt libraries.
+ *
+ * Only what the host tests touch is here. Filter keeps the element in the given sequence, i.e., the one of the .npy
+ * file, which is what dl::nn::reference expects.
+ */
+#include <assert.h>
+#include <string.h>
+
+#include "dl_constant.hpp"
+#include "dl_variable.hpp"
+#include "dl_tool_cache.hpp"
+
+namespace dl
+{
+    namespace tool
+    {
+        void set_zero(void *ptr, const int n)
+        {
+            memset(ptr, 0, n);
+        }
+
+        void copy_memory(void *dst, void *src, const int n)
+        {
+            memcpy(dst, src, n);
+        }
+
+        namespace cache
+        {
+            // no cache to load on the host
+            void preload_func(uint32_t addr, uint32_t size) {}
+            void autoload_func(uint32_t addr1, uint32_t size1, uint32_t addr2, uint32_t size2) {}
+            void autoload_func(uint32_t addr1, uint32_t size1) {}
+        } // namespace cache
+    } // namespace tool
+
+    template <typename T>
+    Constant<T>::Constant(const T *element, const int exponent, const std::vector<int> shape) : element(element),
+                                                                                              exponent(exponent),
+                                                                                              shape(shape) {}
+
+    template <typename T>
+    Filter<T>::Filter(const T *element, const int exponent, const std::vector<int> shape, const std::vector<int> dilation) : Constant<T>(element, exponent, shape),
+                                                                                                                             dilation(dilation),
+                                                                                                                             channel_exponent(NULL),
+                                                                                                                             channel_exponent_size(0)
+    {
+        this->shape_with_dilation = {(shape[0] - 1) * dilation[0] + 1, (shape[1] - 1) * dilation[1] + 1, shape[2], shape[3]};
+    }
+
+    template <typename T>
+    Filter<T>::Filter(const T *element, const int8_t *channel_exponent, const int channel_exponent_size, const std::vector<int> shape, const std::vector<int> dilation) : Constant<T>(element, 0, shape),
+                                                                                                                                                                         dilation(dilation),
+                                                                                                                                                                         channel_exponent(channel_exponent),
+                                                                                                                                                                         channel_exponent_size(channel_exponent_size)
+    {
+        this->shape_with_dilation = {(shape[0] - 1) * dilation[0] + 1, (shape[1] - 1) * dilation[1] + 1, shape[2], shape[3]};
+    }
+
+    template <typename T>
+    Activation<T>::Activation(const activation_type_t type, const T *element, const int exponent, const std::vector<int> shape) : Constant<T>(element, exponent, shape),
+                                                                                                                                type(type) {}
+
+    template <typename T>
+    Tensor<T> &Tensor<T>::set_shape(const std::vector<int> shape)
+    {
+        for (int i = 0; i < shape.size(); i++)
+            assert(shape[i] >= 0);
+
+        this->shape = shape;
+        this->size = 1;
+        for (int i = 0; i < shape.size(); i++)
+            this->size *= shape[i];
+
+        this->axis_offset.resize(shape.size());
+        int offset = 1;
+        for (int i = (int)shape.size() - 1; i >= 0; i--)
+        {
+            this->axis_offset[i] = offset;
+            offset *= shape[i];
+        }
+        return *this;
+    }
+
+    template <typename T>
+    Tensor<T> &Tensor<T>::flatten()
+    {
+        return this->set_shape({this->get_size()});
+    }
+
+    template <typename T>
+    Tensor<T> &Tensor<T>::reshape(std::vector<int> shape)
+    {
+        int known = 1, unknown = -1;
+        for (int i = 0; i < shape.size(); i++)
+        {
+            if (shape[i] == -1)
+                unknown = i;
+            else
+                known *= shape[i];
+        }
+        if (unknown >= 0)
+            shape[unknown] = this->get_size() / known;
+        assert(this->get_size() == (unknown >= 0 ? known * shape[unknown] : known));
+        return this->set_shape(shape);
+    }
+
+    template class Constant<int8_t>;
+    template class Constant<int16_t>;
+    template class Filter<int8_t>;
+    template class Filter<int16_t>;
+    template class Activation<int8_t>;
+    template class Activation<int16_t>;
+
+    template Tensor<uint8_t> &Tensor<uint8_t>::set_shape(const std::vector<int> shape);
+    template Tensor<int8_t> &Tensor<int8_t>::set_shape(const std::vector<int> shape);
+    template Tensor<int16_t> &Tensor<int16_t>::set_shape(const std::vector<int> shape);
+    template Tensor<float> &Tensor<float>::set_shape(const std::vector<int> shape);
+    template Tensor<int8_t> &Tensor<int8_t>::flatten();
+    template Tensor<int16_t> &Tensor<int16_t>::flatten();
+    template Tensor<int8_t> &Tensor<int8_t>::reshape(std::vector<int> shape);
+    template Tensor<int16_t> &Tensor<int16_t>::reshape(std::vector<int> shape);
+} // namespace dl
@@ -0,0 +1,105 @@
+/**
+ * @file dl_image_host.cpp
+ * @brief Host definitions of the dl::image functions which live in the prebuilt libraries.
+ *
+ * crop_and_resize() samples at the centers of the destination pixels and clamps to the edge of the source, in double,
+ * with bilinear rounded to the nearest. RGB565 sources give BGR, same as convert_pixel_rgb565_to_rgb888().
+ * IMAGE_RESIZE_MEAN is not ported.
+ */
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "dl_image.hpp"
+
+namespace dl
+{
+    namespace image
+    {
+        static inline void load_pixel(const uint16_t *image, const int width, const int channel, const int x, const int y, int *pixel)
+        {
+            convert_pixel_rgb565_to_rgb888(image[y * width + x], pixel);
+        }
+
+        static inline void load_pixel(const uint8_t *image, const int width, const int channel, const int x, const int y, int *pixel)
+        {
+            for (int c = 0; c < channel; c++)
+                pixel[c] = image[(y * width + x) * channel + c];
+        }
+
+        template <typename T, typename src_t>
+        static void crop_and_resize_host(T *dst_image, int dst_width, int dst_channel,
+                                         int dst_y_start, int dst_y_end, int dst_x_start, int dst_x_end,
+                                         const src_t *src_image, int src_height, int src_width, int src_channel,
+                                         int src_y_start, int src_y_end, int src_x_start, int src_x_end,
+                                         resize_type_t resize_type, int shift_left)
+        {
+            assert(resize_type != IMAGE_RESIZE_MEAN);
+            const double scale_y = (double)(src_y_end - src_y_start) / (dst_y_end - dst_y_start);
+            const double scale_x = (double)(src_x_end - src_x_start) / (dst_x_end - dst_x_start);
+            int pixel[4][4];
+
+            for (int y = dst_y_start; y < dst_y_end; y++)
+            {
+                double sy = src_y_start + (y - dst_y_start + 0.5) * scale_y - 0.5;
+                for (int x = dst_x_start; x < dst_x_end; x++)
+                {
+                    double sx = src_x_start + (x - dst_x_start + 0.5) * scale_x - 0.5;
+                    T *out = dst_image + (y * dst_width + x) * dst_channel;
+                    if (resize_type == IMAGE_RESIZE_NEAREST)
+                    {
+                        load_pixel(src_image, src_width, src_channel, DL_CLIP((int)(sx + 0.5), 0, src_width - 1), DL_CLIP((int)(sy + 0.5), 0, src_height - 1), pixel[0]);
+                        for (int c = 0; c < dst_channel; c++)
+                            out[c] = pixel[0][c] << shift_left;
+                        continue;
+                    }
+
+                    int x0 = (int)floor(sx), y0 = (int)floor(sy);
+                    double wx = sx - x0, wy = sy - y0;
+                    int x1 = DL_CLIP(x0 + 1, 0, src_width - 1), y1 = DL_CLIP(y0 + 1, 0, src_height - 1);
+                    x0 = DL_CLIP(x0, 0, src_width - 1);
+                    y0 = DL_CLIP(y0, 0, src_height - 1);
+                    load_pixel(src_image, src_width, src_channel, x0, y0, pixel[0]);
+                    load_pixel(src_image, src_width, src_channel, x1, y0, pixel[1]);
+                    load_pixel(src_image, src_width, src_channel, x0, y1, pixel[2]);
+                    load_pixel(src_image, src_width, src_channel, x1, y1, pixel[3]);
+                    for (int c = 0; c < dst_channel; c++)
+                    {
+                        double top = pixel[0][c] + (pixel[1][c] - pixel[0][c]) * wx;
+                        double bottom = pixel[2][c] + (pixel[3][c] - pixel[2][c]) * wx;
+                        out[c] = (int)floor(top + (bottom - top) * wy + 0.5) << shift_left;
+                    }
+                }
+            }
+        }
+
+        template <typename T>
+        void crop_and_resize(T *dst_image, int dst_width, int dst_channel,
+                             int dst_y_start, int dst_y_end, int dst_x_start, int dst_x_end,
+                             uint16_t *src_image, int src_height, int src_width, int src_channel,
+                             int src_y_start, int src_y_end, int src_x_start, int src_x_end,
+                             resize_type_t resize_type, int shift_left)
+        {
+            crop_and_resize_host(dst_image, dst_width, dst_channel, dst_y_start, dst_y_end, dst_x_start, dst_x_end,
+                                 src_image, src_height, src_width, src_channel, src_y_start, src_y_end, src_x_start, src_x_end,
+                                 resize_type, shift_left);
+        }
+
+        template <typename T>
+        void crop_and_resize(T *dst_image, int dst_width, int dst_channel,
+                             int dst_y_start, int dst_y_end, int dst_x_start, int dst_x_end,
+                             uint8_t *src_image, int src_height, int src_width, int src_channel,
+                             int src_y_start, int src_y_end, int src_x_start, int src_x_end,
+                             resize_type_t resize_type, int shift_left)
+        {
+            crop_and_resize_host(dst_image, dst_width, dst_channel, dst_y_start, dst_y_end, dst_x_start, dst_x_end,
+                                 src_image, src_height, src_width, src_channel, src_y_start, src_y_end, src_x_start, src_x_end,
+                                 resize_type, shift_left);
+        }
+
+        template void crop_and_resize(uint8_t *, int, int, int, int, int, int, uint16_t *, int, int, int, int, int, int, int, resize_type_t, int);
+        template void crop_and_resize(int16_t *, int, int, int, int, int, int, uint16_t *, int, int, int, int, int, int, int, resize_type_t, int);
+        template void crop_and_resize(uint8_t *, int, int, int, int, int, int, uint8_t *, int, int, int, int, int, int, int, resize_type_t, int);
+        template void crop_and_resize(int16_t *, int, int, int, int, int, int, uint8_t *, int, int, int, int, int, int, int, resize_type_t, int);
+    } // namespace image
+} // namespace dl
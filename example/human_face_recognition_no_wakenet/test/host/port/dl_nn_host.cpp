@@ -0,0 +1,164 @@
+/**
+ * @file dl_nn_host.cpp
+ * @brief Host definitions of the dl::nn kernels and dl::layer::Layer, which live in the prebuilt libraries.
+ *
+ * The kernels forward to dl::nn::reference, which matches the libraries bit by bit in the cases the layers built on
+ * them use, so a layer composing kernels, e.g., tiling or fusing them, can be checked against the unfused kernels.
+ * The SIMD kernels on the chip need 16-byte aligned element, calls breaking it are counted in host_misaligned_calls.
+ * Filters generated for the chip are in its own element order, a test maps them to reference ones in host_filters.
+ */
+#include <stdint.h>
+#include <string.h>
+
+#include "port/dl_nn_host.hpp"
+#include "dl_nn_reference.hpp"
+#include "dl_nn_conv2d.hpp"
+#include "dl_nn_depthwise_conv2d.hpp"
+#include "dl_nn_add2d.hpp"
+#include "dl_nn_concat.hpp"
+#include "dl_layer_base.hpp"
+
+namespace dl
+{
+    namespace nn
+    {
+        int host_misaligned_calls = 0;
+        std::map<const void *, const void *> host_filters;
+
+        template <typename T>
+        static const Filter<T> &host_filter(const Filter<T> &filter)
+        {
+            auto mapped = host_filters.find(&filter);
+            return mapped == host_filters.end() ? filter : *(const Filter<T> *)mapped->second;
+        }
+
+        template <typename feature_t>
+        static void check_aligned(std::initializer_list<const Tensor<feature_t> *> tensors)
+        {
+            for (const Tensor<feature_t> *tensor : tensors)
+            {
+                if ((uintptr_t)tensor->element & 15)
+                {
+                    host_misaligned_calls++;
+                    return;
+                }
+            }
+        }
+
+        template <typename feature_t>
+        static void add2d_host(Tensor<feature_t> &output, Tensor<feature_t> &input0, Tensor<feature_t> &input1, const Activation<feature_t> *const activation, const int output_exponent)
+        {
+            check_aligned<feature_t>({&output, &input0, &input1});
+
+            // inplace, output is input0 and keeps its exponent until the caller sets output_exponent
+            Tensor<feature_t> result;
+            result.set_element(output.element).set_exponent(output_exponent == INT_MIN ? output.exponent : output_exponent).set_shape(output.shape);
+            reference::add2d(result, input0, input1, activation);
+        }
+        std::vector<int> get_output_shape(const std::vector<int> &input_shape, const std::vector<int> &filter_shape, const int stride_y, const int stride_x, const padding_type_t pad_type, const bool is_conv2d, std::vector<int> padding)
+        {
+            std::vector<int> output_hw;
+            if (pad_type == PADDING_NOT_SET)
+                output_hw = reference::get_output_shape(input_shape[0], input_shape[1], filter_shape[0], filter_shape[1], stride_y, stride_x, padding);
+            else
+                reference::get_output_shape_and_padding(output_hw, padding, input_shape[0], input_shape[1], filter_shape[0], filter_shape[1], stride_y, stride_x, pad_type);
+            return {output_hw[0], output_hw[1], is_conv2d ? filter_shape[3] : input_shape[2]};
+        }
+
+        std::vector<int> get_pad_size(const std::vector<int> &output_shape, const std::vector<int> &input_shape, const std::vector<int> &filter_shape, const int stride_y, const int stride_x, const padding_type_t padding_type)
+        {
+            std::vector<int> output_hw, padding;
+            reference::get_output_shape_and_padding(output_hw, padding, input_shape[0], input_shape[1], filter_shape[0], filter_shape[1], stride_y, stride_x, padding_type);
+            return padding;
+        }
+
+        void conv2d(Tensor<int16_t> &output, Tensor<int16_t> &input, std::vector<int> &padding, const Filter<int16_t> &filter, const int stride_y, const int stride_x, const Bias<int16_t> *bias, const Activation<int16_t> *activation, const std::vector<int> &assign_core)
+        {
+            check_aligned<int16_t>({&output, &input});
+            reference::conv2d(output, input, padding, host_filter(filter), stride_y, stride_x, bias, activation);
+        }
+
+        void conv2d(Tensor<int8_t> &output, Tensor<int8_t> &input, std::vector<int> &padding, const Filter<int8_t> &filter, const int stride_y, const int stride_x, const Bias<int8_t> *bias, const Activation<int8_t> *activation, const std::vector<int> &assign_core)
+        {
+            check_aligned<int8_t>({&output, &input});
+            reference::conv2d(output, input, padding, host_filter(filter), stride_y, stride_x, bias, activation);
+        }
+
+        void conv2d(Tensor<int8_t> &output, Tensor<int8_t> &input, std::vector<int> &padding, const Filter<int8_t> &filter, const int stride_y, const int stride_x, const Bias<int16_t> *bias, const Activation<int8_t> *activation, const std::vector<int> &assign_core)
+        {
+            check_aligned<int8_t>({&output, &input});
+            reference::conv2d(output, input, padding, host_filter(filter), stride_y, stride_x, bias, activation);
+        }
+
+        void depthwise_conv2d(Tensor<int16_t> &output, Tensor<int16_t> &input, std::vector<int> &padding, const Filter<int16_t> &filter, const int stride_y, const int stride_x, const Bias<int16_t> *bias, const Activation<int16_t> *activation, const std::vector<int> &assign_core)
+        {
+            check_aligned<int16_t>({&output, &input});
+            reference::depthwise_conv2d(output, input, padding, host_filter(filter), stride_y, stride_x, bias, activation);
+        }
+
+        void depthwise_conv2d(Tensor<int8_t> &output, Tensor<int8_t> &input, std::vector<int> &padding, const Filter<int8_t> &filter, const int stride_y, const int stride_x, const Bias<int8_t> *bias, const Activation<int8_t> *activation, const std::vector<int> &assign_core)
+        {
+            check_aligned<int8_t>({&output, &input});
+            reference::depthwise_conv2d(output, input, padding, host_filter(filter), stride_y, stride_x, bias, activation);
+        }
+
+        void depthwise_conv2d(Tensor<int8_t> &output, Tensor<int8_t> &input, std::vector<int> &padding, const Filter<int8_t> &filter, const int stride_y, const int stride_x, const Bias<int16_t> *bias, const Activation<int8_t> *activation, const std::vector<int> &assign_core)
+        {
+            check_aligned<int8_t>({&output, &input});
+            reference::depthwise_conv2d(output, input, padding, host_filter(filter), stride_y, stride_x, bias, activation);
+        }
+
+        void add2d(Tensor<int16_t> &output, Tensor<int16_t> &input0, Tensor<int16_t> &input1, const Activation<int16_t> *const activation, const std::vector<int> &assign_core, const int output_exponent)
+        {
+            add2d_host(output, input0, input1, activation, output_exponent);
+        }
+
+        void add2d(Tensor<int8_t> &output, Tensor<int8_t> &input0, Tensor<int8_t> &input1, const Activation<int8_t> *const activation, const std::vector<int> &assign_core, const int output_exponent)
+        {
+            add2d_host(output, input0, input1, activation, output_exponent);
+        }
+
+        template <typename feature_t>
+        void concat(Tensor<feature_t> &output, std::vector<Tensor<feature_t> *> &inputs, int axis, bool free_inputs)
+        {
+            if (axis < 0)
+                axis += output.shape.size();
+
+            // each input is a sequence of blocks of shape[axis:], interleaved in output
+            int outer = 1;
+            for (int i = 0; i < axis; i++)
+                outer *= output.shape[i];
+            feature_t *dst = output.element;
+            for (int n = 0; n < outer; n++)
+            {
+                for (Tensor<feature_t> *input : inputs)
+                {
+                    int block = input->get_size() / outer;
+                    memcpy(dst, input->element + n * block, block * sizeof(feature_t));
+                    dst += block;
+                }
+            }
+            if (free_inputs)
+            {
+                for (Tensor<feature_t> *input : inputs)
+                    input->free_element();
+            }
+        }
+
+        template void concat(Tensor<int16_t> &output, std::vector<Tensor<int16_t> *> &inputs, int axis, bool free_inputs);
+        template void concat(Tensor<int8_t> &output, std::vector<Tensor<int8_t> *> &inputs, int axis, bool free_inputs);
+    } // namespace nn
+
+    namespace layer
+    {
+        Layer::Layer(const char *name)
+        {
+            this->name = name ? strdup(name) : NULL;
+        }
+
+        Layer::~Layer()
+        {
+            free(this->name);
+        }
+    } // namespace layer
+} // namespace dl
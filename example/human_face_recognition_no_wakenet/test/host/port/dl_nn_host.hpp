@@ -0,0 +1,21 @@
+#pragma once
+
+#include <map>
+
+namespace dl
+{
+    namespace nn
+    {
+        /**
+         * @brief Calls of the host kernels in port/dl_nn_host.cpp with an element not 16-byte aligned, which the SIMD
+         * kernels on the chip do not take.
+         */
+        extern int host_misaligned_calls;
+
+        /**
+         * @brief Filters in the element order of the chip, e.g., generated by the convert tool, mapped to the same
+         * filter in the order of dl::nn::reference. The host kernels run the mapped filter instead.
+         */
+        extern std::map<const void *, const void *> host_filters;
+    } // namespace nn
+} // namespace dl
@@ -0,0 +1,145 @@
+/**
+ * @file esp_partition_host.cpp
+ * @brief Data partitions backed by files, with NOR semantics and power loss injection.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "esp_partition.h"
+
+typedef struct
+{
+    esp_partition_t partition;
+    FILE *file;                /*<! backing file >*/
+    std::vector<uint8_t> data; /*<! content of file >*/
+} host_partition_t;
+
+static std::vector<host_partition_t *> partitions;
+static int power_budget = -1; /*<! bytes before the power loss, negative for no loss >*/
+
+static host_partition_t *find(const esp_partition_t *partition)
+{
+    for (auto p : partitions)
+    {
+        if (&p->partition == partition)
+            return p;
+    }
+    return NULL;
+}
+
+// write the changed range through to file
+static void sync(host_partition_t *p, size_t offset, size_t size)
+{
+    fseek(p->file, offset, SEEK_SET);
+    fwrite(p->data.data() + offset, 1, size, p->file);
+    fflush(p->file);
+}
+
+// bytes of an operation still powered, the budget is spent by them
+static size_t powered(size_t size)
+{
+    if (power_budget < 0)
+        return size;
+    size_t n = size < (size_t)power_budget ? size : (size_t)power_budget;
+    power_budget -= n;
+    return n;
+}
+
+const esp_partition_t *esp_partition_host_mount(const char *label, const char *path, uint32_t size, uint32_t erase_size)
+{
+    FILE *file = fopen(path, "r+b");
+    if (file == NULL)
+        file = fopen(path, "w+b");
+    if (file == NULL)
+        return NULL;
+
+    host_partition_t *p = new host_partition_t;
+    p->partition = {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, 0, size, erase_size, {0}};
+    strncpy(p->partition.label, label, sizeof(p->partition.label) - 1);
+    p->file = file;
+    p->data.assign(size, 0xFF);
+    size_t n = fread(p->data.data(), 1, size, file);
+    if (n != size)
+    {
+        memset(p->data.data() + n, 0xFF, size - n);
+        sync(p, n, size - n);
+    }
+
+    // a label mounted again replaces the old one, e.g., to reboot on the same file, the old one must not be used
+    for (auto &old : partitions)
+    {
+        if (strcmp(old->partition.label, label) == 0)
+        {
+            fclose(old->file);
+            delete old;
+            old = p;
+            return &p->partition;
+        }
+    }
+    partitions.push_back(p);
+    return &p->partition;
+}
+
+void esp_partition_host_power_loss(int bytes)
+{
+    power_budget = bytes;
+}
+
+bool esp_partition_host_powered()
+{
+    return power_budget != 0;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    for (auto p : partitions)
+    {
+        if ((type == ESP_PARTITION_TYPE_ANY || p->partition.type == type) &&
+            (subtype == ESP_PARTITION_SUBTYPE_ANY || p->partition.subtype == subtype) &&
+            (label == NULL || strcmp(p->partition.label, label) == 0))
+            return &p->partition;
+    }
+    return NULL;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    host_partition_t *p = find(partition);
+    if (p == NULL)
+        return ESP_ERR_INVALID_ARG;
+    if (src_offset + size > partition->size)
+        return ESP_ERR_INVALID_SIZE;
+    memcpy(dst, p->data.data() + src_offset, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    host_partition_t *p = find(partition);
+    if (p == NULL)
+        return ESP_ERR_INVALID_ARG;
+    if (dst_offset + size > partition->size)
+        return ESP_ERR_INVALID_SIZE;
+
+    const uint8_t *bytes = (const uint8_t *)src;
+    size_t n = powered(size);
+    for (size_t i = 0; i < n; i++)
+        p->data[dst_offset + i] &= bytes[i];
+    sync(p, dst_offset, n);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    host_partition_t *p = find(partition);
+    if (p == NULL)
+        return ESP_ERR_INVALID_ARG;
+    if (offset % partition->erase_size || size % partition->erase_size || offset + size > partition->size)
+        return ESP_ERR_INVALID_SIZE;
+
+    size_t n = powered(size);
+    memset(p->data.data() + offset, 0xFF, n);
+    sync(p, offset, n);
+    return ESP_OK;
+}
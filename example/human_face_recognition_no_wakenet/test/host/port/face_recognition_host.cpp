@@ -0,0 +1,38 @@
+/**
+ * @file face_recognition_host.cpp
+ * @brief Host definitions of the face_recognition_tool functions which live in the prebuilt libraries.
+ */
+#include <math.h>
+
+#include "face_recognition_tool.hpp"
+
+namespace face_recognition_tool
+{
+    void l2_norm(dl::Tensor<float> &feature)
+    {
+        float norm = 0.f;
+        for (int i = 0; i < feature.get_size(); i++)
+            norm += feature.element[i] * feature.element[i];
+        norm = sqrtf(norm);
+        for (int i = 0; i < feature.get_size(); i++)
+            feature.element[i] /= norm;
+    }
+
+    float cos_distance(dl::Tensor<float> &id_1, dl::Tensor<float> &id_2, bool normalized_ids, int8_t type)
+    {
+        assert(id_1.get_size() == id_2.get_size());
+        float dist = 0.f, norm_1 = 0.f, norm_2 = 0.f;
+        for (int i = 0; i < id_1.get_size(); i++)
+        {
+            dist += id_1.element[i] * id_2.element[i];
+            if (!normalized_ids)
+            {
+                norm_1 += id_1.element[i] * id_1.element[i];
+                norm_2 += id_2.element[i] * id_2.element[i];
+            }
+        }
+        if (!normalized_ids)
+            dist /= sqrtf(norm_1) * sqrtf(norm_2);
+        return type == 0 ? dist : (dist + 1.f) / 2.f;
+    }
+} // namespace face_recognition_tool
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_EXEC (1 << 0)
+#define MALLOC_CAP_32BIT (1 << 1)
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_DMA (1 << 3)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+/**
+ * @brief Host only: make every heap_caps allocation fail while set, as when memory runs out.
+ */
+inline bool &heap_caps_host_out_of_memory()
+{
+    static bool out_of_memory = false;
+    return out_of_memory;
+}
+
+static inline void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t caps)
+{
+    if (heap_caps_host_out_of_memory())
+        return NULL;
+    // aligned_alloc() needs size to be a multiple of alignment
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+static inline void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    if (heap_caps_host_out_of_memory())
+        return NULL;
+    return malloc(size);
+}
+
+static inline void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    if (heap_caps_host_out_of_memory())
+        return NULL;
+    return calloc(n, size);
+}
+
+static inline void heap_caps_free(void *ptr)
+{
+    free(ptr);
+}
+
+static inline size_t heap_caps_get_free_size(uint32_t caps)
+{
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdio.h>
+
+// errors and warnings are printed, the rest is compiled out to keep the test output short
+#define ESP_LOGE(tag, format, ...) printf("E %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) printf("W %s: " format "\n", tag, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) ((void)(tag))
+#define ESP_LOGD(tag, format, ...) ((void)(tag))
+#define ESP_LOGV(tag, format, ...) ((void)(tag))
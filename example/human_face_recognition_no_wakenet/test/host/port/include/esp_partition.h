@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERR_INVALID_ARG 0x102
+#define ESP_ERR_INVALID_SIZE 0x104
+
+typedef enum
+{
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+    ESP_PARTITION_TYPE_ANY = 0xff,
+} esp_partition_type_t;
+
+typedef enum
+{
+    ESP_PARTITION_SUBTYPE_DATA_SPIFFS = 0x82,
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef struct
+{
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    uint32_t erase_size;
+    char label[17];
+} esp_partition_t;
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label);
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size);
+
+/**
+ * @brief Host only. Back a data partition by a file, which is created erased if it does not exist. Like NOR flash,
+ *        a write clears bits only and an erased byte reads 0xFF, the file is updated at every write or erase.
+ *
+ * @param label      partition label, a mounted label is replaced
+ * @param path       backing file
+ * @param size       partition size in byte
+ * @param erase_size sector size in byte
+ * @return the partition, NULL if the file can not be opened
+ */
+const esp_partition_t *esp_partition_host_mount(const char *label, const char *path, uint32_t size, uint32_t erase_size);
+
+/**
+ * @brief Host only. Simulate a power loss: after another bytes byte are programmed or erased, the rest of the write or
+ *        erase in progress and all later ones are lost silently. A negative bytes powers the flash back.
+ *
+ * @param bytes bytes to program before the power loss
+ */
+void esp_partition_host_power_loss(int bytes);
+
+/**
+ * @brief Host only. Whether the power loss set by esp_partition_host_power_loss() has not happened yet.
+ */
+bool esp_partition_host_powered();
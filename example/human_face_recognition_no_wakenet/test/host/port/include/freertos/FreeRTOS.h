@@ -0,0 +1,235 @@
+#pragma once
+
+/**
+ * @brief FreeRTOS on std::thread for the host tests.
+ *
+ * A tick is a millisecond. Tasks are detached threads, the core id is ignored. Queues, semaphores and task
+ * notifications keep the FreeRTOS semantics the modules rely on: copy by value, bounded depth, timeouts in ticks.
+ */
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef uint32_t TickType_t;
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdFAIL pdFALSE
+#define pdPASS pdTRUE
+#define errQUEUE_FULL 0
+#define portMAX_DELAY (TickType_t)0xffffffffUL
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES 3
+#define portNUM_PROCESSORS 2
+
+typedef struct
+{
+    std::recursive_mutex mutex;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED \
+    {                                \
+    }
+#define portENTER_CRITICAL(mux) (mux)->mutex.lock()
+#define portEXIT_CRITICAL(mux) (mux)->mutex.unlock()
+
+namespace freertos_host
+{
+    template <typename P>
+    inline bool wait(std::unique_lock<std::mutex> &lock, std::condition_variable &cv, TickType_t ticks, P predicate)
+    {
+        if (ticks == portMAX_DELAY)
+        {
+            cv.wait(lock, predicate);
+            return true;
+        }
+        return cv.wait_for(lock, std::chrono::milliseconds(ticks), predicate);
+    }
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::vector<uint8_t>> items;
+        UBaseType_t length;
+        UBaseType_t item_size;
+    };
+
+    struct Task
+    {
+        std::mutex mutex;
+        std::condition_variable notified;
+        uint32_t value[configTASK_NOTIFICATION_ARRAY_ENTRIES] = {};
+    };
+
+    inline Task *&current()
+    {
+        static thread_local Task *task = nullptr;
+        return task;
+    }
+} // namespace freertos_host
+
+typedef freertos_host::Queue *QueueHandle_t;
+typedef freertos_host::Task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+inline TickType_t xTaskGetTickCount()
+{
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline void vTaskDelay(const TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    TaskHandle_t &task = freertos_host::current();
+    if (task == nullptr)
+        task = new freertos_host::Task; // a thread not created by xTaskCreate(), e.g., main()
+    return task;
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char *name, const uint32_t stack_depth, void *parameter, UBaseType_t priority, TaskHandle_t *created, const BaseType_t core)
+{
+    TaskHandle_t task = new freertos_host::Task;
+    if (created)
+        *created = task;
+    std::thread([function, parameter, task]()
+                {
+                    freertos_host::current() = task;
+                    function(parameter);
+                })
+        .detach();
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t function, const char *name, const uint32_t stack_depth, void *parameter, UBaseType_t priority, TaskHandle_t *created)
+{
+    return xTaskCreatePinnedToCore(function, name, stack_depth, parameter, priority, created, tskNO_AFFINITY);
+}
+
+/**
+ * @brief The thread can not be stopped from outside, a task deleting itself returns from its function right after.
+ */
+inline void vTaskDelete(TaskHandle_t task) {}
+
+inline BaseType_t xPortGetCoreID()
+{
+    return 0;
+}
+
+inline uint32_t ulTaskNotifyTakeIndexed(const UBaseType_t index, const BaseType_t clear, const TickType_t ticks)
+{
+    freertos_host::Task *task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    freertos_host::wait(lock, task->notified, ticks, [&]
+                        { return task->value[index] != 0; });
+    uint32_t value = task->value[index];
+    if (value)
+        task->value[index] = clear ? 0 : value - 1;
+    return value;
+}
+
+inline BaseType_t xTaskNotifyGiveIndexed(TaskHandle_t task, const UBaseType_t index)
+{
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->value[index]++;
+    task->notified.notify_all();
+    return pdPASS;
+}
+
+#define ulTaskNotifyTake(clear, ticks) ulTaskNotifyTakeIndexed(0, (clear), (ticks))
+#define xTaskNotifyGive(task) xTaskNotifyGiveIndexed((task), 0)
+
+inline QueueHandle_t xQueueCreate(const UBaseType_t length, const UBaseType_t item_size)
+{
+    freertos_host::Queue *queue = new freertos_host::Queue;
+    queue->length = length;
+    queue->item_size = item_size;
+    return queue;
+}
+
+inline void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t queue, const void *item, const TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!freertos_host::wait(lock, queue->changed, ticks, [&]
+                             { return queue->items.size() < queue->length; }))
+        return errQUEUE_FULL;
+    const uint8_t *bytes = (const uint8_t *)item;
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+#define xQueueSendToBack xQueueSend
+
+inline BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->items.clear();
+    const uint8_t *bytes = (const uint8_t *)item;
+    queue->items.emplace_back(bytes, bytes + queue->item_size);
+    queue->changed.notify_all();
+    return pdPASS;
+}
+
+inline BaseType_t xQueueReceive(QueueHandle_t queue, void *item, const TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!freertos_host::wait(lock, queue->changed, ticks, [&]
+                             { return !queue->items.empty(); }))
+        return pdFALSE;
+    if (queue->item_size)
+        memcpy(item, queue->items.front().data(), queue->item_size);
+    queue->items.pop_front();
+    queue->changed.notify_all();
+    return pdTRUE;
+}
+
+inline BaseType_t xQueuePeek(QueueHandle_t queue, void *item, const TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(queue->mutex);
+    if (!freertos_host::wait(lock, queue->changed, ticks, [&]
+                             { return !queue->items.empty(); }))
+        return pdFALSE;
+    if (queue->item_size)
+        memcpy(item, queue->items.front().data(), queue->item_size);
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->items.size();
+}
+
+inline UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    return queue->length - queue->items.size();
+}
+
+inline BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->items.clear();
+    queue->changed.notify_all();
+    return pdPASS;
+}
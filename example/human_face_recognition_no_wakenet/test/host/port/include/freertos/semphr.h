@@ -0,0 +1,39 @@
+#pragma once
+
+#include "FreeRTOS.h"
+
+// semaphores are queues of no item, as in FreeRTOS; a mutex here is not recursive and has no priority inheritance
+typedef QueueHandle_t SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateCounting(const UBaseType_t max_count, const UBaseType_t initial_count)
+{
+    SemaphoreHandle_t semaphore = xQueueCreate(max_count, 0);
+    for (UBaseType_t i = 0; i < initial_count; i++)
+        xQueueSend(semaphore, NULL, 0);
+    return semaphore;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, const TickType_t ticks)
+{
+    return xQueueReceive(semaphore, NULL, ticks);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    return xQueueSend(semaphore, NULL, 0);
+}
+
+inline void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    vQueueDelete(semaphore);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "esp_camera.h"
+
+/**
+ * @brief Defined by the test encoding frames, the stand-in of the esp32-camera converter.
+ */
+bool frame2jpg(camera_fb_t *fb, uint8_t quality, uint8_t **out, size_t *out_len);
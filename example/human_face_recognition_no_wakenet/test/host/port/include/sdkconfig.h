@@ -0,0 +1,4 @@
+#pragma once
+
+// host build: no target, no SPIRAM, one core
+#define CONFIG_FREERTOS_UNICORE 1
@@ -0,0 +1,319 @@
+/**
+ * @file test_color_engine.cpp
+ * @brief ColorEngine replaying RGB565 frames of the dice bitmaps of factory_demo_v1.
+ *
+ * Two dice slide over a green table with a blue marker, frame by frame, in the byte order of the camera. Colors are
+ * the standard ones of the color detection plus one learned from the marker by cal_color_thresh().
+ *         - the blobs of every frame equal a flood fill of the samples, in area, centroid, box and order,
+ *         - the marker and the red pip of die one are found where they are drawn,
+ *         - an engine without memory for its masks finds nothing and draws nothing.
+ */
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "host_test.hpp"
+#include "esp_heap_caps.h"
+#include "who_color_engine.hpp"
+
+#define WIDTH 240
+#define HEIGHT 240
+#define SCALE 3
+#define FRAMES 60
+#define DIE_SIZE 120
+#define AREA_THRESH 4
+
+static const std::vector<color_info_t> std_color_info = {{{156, 10, 70, 255, 90, 255}, 64, "red"},
+                                                         {{11, 22, 70, 255, 90, 255}, 64, "orange"},
+                                                         {{23, 33, 70, 255, 90, 255}, 64, "yellow"},
+                                                         {{34, 75, 70, 255, 90, 255}, 64, "green"},
+                                                         {{76, 96, 70, 255, 90, 255}, 64, "cyan"},
+                                                         {{97, 124, 70, 255, 90, 255}, 64, "blue"},
+                                                         {{125, 155, 70, 255, 90, 255}, 64, "purple"},
+                                                         {{0, 180, 0, 40, 220, 255}, 64, "white"},
+                                                         {{0, 180, 0, 50, 50, 219}, 64, "gray"}};
+
+static uint16_t rgb565(int red, int green, int blue)
+{
+    // byte swapped as the camera writes it
+    return (red & 0xF8) | (green >> 5) | (((green >> 2) & 0x7) << 13) | ((blue >> 3) << 8);
+}
+
+/**
+ * @brief A 24-bit bottom-up BMP as RGB565.
+ */
+static bool load_die(const int number, std::vector<uint16_t> &die)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "%s/dice%d.bmp", DICE_DIR, number);
+    FILE *file = fopen(path, "rb");
+    if (file == NULL)
+        return false;
+
+    uint8_t header[54];
+    std::vector<uint8_t> row(DIE_SIZE * 3);
+    bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) && header[28] == 24;
+    die.resize(DIE_SIZE * DIE_SIZE);
+    for (int y = DIE_SIZE - 1; ok && y >= 0; y--)
+    {
+        ok = fread(row.data(), 1, row.size(), file) == row.size();
+        for (int x = 0; ok && x < DIE_SIZE; x++)
+            die[y * DIE_SIZE + x] = rgb565(row[3 * x + 2], row[3 * x + 1], row[3 * x]);
+    }
+    fclose(file);
+    return ok;
+}
+
+typedef struct
+{
+    int die[2];       /*<! number of each die >*/
+    int origin[2][2]; /*<! [x, y] of each die >*/
+    int marker[4];    /*<! box of the blue marker >*/
+} scene_t;
+
+static scene_t render(const int index, const std::vector<uint16_t> *dice, uint16_t *frame)
+{
+    scene_t scene;
+    scene.die[0] = 1 + index % 6;
+    scene.die[1] = 1 + (index / 6 + 3) % 6;
+    scene.origin[0][0] = index * 2 % (WIDTH - DIE_SIZE);
+    scene.origin[0][1] = 0;
+    scene.origin[1][0] = WIDTH - DIE_SIZE - index % (WIDTH - DIE_SIZE);
+    scene.origin[1][1] = HEIGHT - DIE_SIZE;
+    scene.marker[0] = 10 + index * 3 % 180;
+    scene.marker[1] = DIE_SIZE + 5 + index % 10;
+    scene.marker[2] = scene.marker[0] + 35;
+    scene.marker[3] = scene.marker[1] + 20;
+
+    // felt with a little noise
+    uint32_t seed = index + 1;
+    for (int i = 0; i < WIDTH * HEIGHT; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        int noise = (seed >> 16) % 17 - 8;
+        frame[i] = rgb565(30 + noise, 110 + noise, 50 + noise);
+    }
+    for (int d = 0; d < 2; d++)
+    {
+        const std::vector<uint16_t> &die = dice[scene.die[d] - 1];
+        for (int y = 0; y < DIE_SIZE; y++)
+            memcpy(frame + (scene.origin[d][1] + y) * WIDTH + scene.origin[d][0], die.data() + y * DIE_SIZE, DIE_SIZE * sizeof(uint16_t));
+    }
+    for (int y = scene.marker[1]; y <= scene.marker[3]; y++)
+        for (int x = scene.marker[0]; x <= scene.marker[2]; x++)
+            frame[y * WIDTH + x] = rgb565(20, 60, 230);
+    return scene;
+}
+
+/**
+ * @brief HSV of ColorEngine, H in [0, 180).
+ */
+static void rgb565_to_hsv(uint16_t pixel, int &h, int &s, int &v)
+{
+    int blue = (pixel & 0x1F00) >> 5, green = ((pixel & 0x7) << 5) | ((pixel & 0xE000) >> 11), red = pixel & 0xF8;
+    int max = std::max(red, std::max(green, blue));
+    int delta = max - std::min(red, std::min(green, blue));
+    v = max;
+    s = max ? delta * 255 / max : 0;
+    if (delta == 0)
+        h = 0;
+    else if (max == red)
+        h = 30 * (green - blue) / delta;
+    else if (max == green)
+        h = 60 + 30 * (blue - red) / delta;
+    else
+        h = 120 + 30 * (red - green) / delta;
+    if (h < 0)
+        h += 180;
+}
+
+static bool inside(const std::vector<uint8_t> &thresh, int h, int s, int v)
+{
+    bool hue = thresh[0] <= thresh[1] ? (h >= thresh[0] && h <= thresh[1]) : (h >= thresh[0] || h <= thresh[1]);
+    return hue && s >= thresh[2] && s <= thresh[3] && v >= thresh[4] && v <= thresh[5];
+}
+
+/**
+ * @brief Blobs by flood fill of the samples of each color, 4-connected.
+ */
+static std::vector<color_blob_t> reference(const uint16_t *frame, const std::vector<color_info_t> &colors)
+{
+    const int grid_height = HEIGHT / SCALE, grid_width = WIDTH / SCALE, offset = SCALE / 2;
+    std::vector<color_blob_t> blobs;
+    for (int c = 0; c < colors.size(); c++)
+    {
+        std::vector<uint8_t> mask(grid_height * grid_width);
+        for (int y = 0; y < grid_height; y++)
+        {
+            for (int x = 0; x < grid_width; x++)
+            {
+                int h, s, v;
+                rgb565_to_hsv(frame[(y * SCALE + offset) * WIDTH + x * SCALE + offset], h, s, v);
+                mask[y * grid_width + x] = inside(colors[c].color_thresh, h, s, v);
+            }
+        }
+
+        for (int start = 0; start < mask.size(); start++)
+        {
+            if (mask[start] != 1)
+                continue;
+            int area = 0, sum_x = 0, sum_y = 0, x1 = grid_width, y1 = grid_height, x2 = 0, y2 = 0;
+            std::vector<int> stack = {start};
+            mask[start] = 2;
+            while (!stack.empty())
+            {
+                int i = stack.back(), x = i % grid_width, y = i / grid_width;
+                stack.pop_back();
+                area++;
+                sum_x += 2 * x;
+                sum_y += y;
+                x1 = std::min(x1, x), y1 = std::min(y1, y), x2 = std::max(x2, x), y2 = std::max(y2, y);
+                const int neighbors[4][2] = {{x - 1, y}, {x + 1, y}, {x, y - 1}, {x, y + 1}};
+                for (auto &n : neighbors)
+                {
+                    if (n[0] < 0 || n[0] >= grid_width || n[1] < 0 || n[1] >= grid_height || mask[n[1] * grid_width + n[0]] != 1)
+                        continue;
+                    mask[n[1] * grid_width + n[0]] = 2;
+                    stack.push_back(n[1] * grid_width + n[0]);
+                }
+            }
+            if (area < colors[c].area_thresh)
+                continue;
+
+            color_blob_t blob;
+            blob.color = c;
+            blob.area = area;
+            blob.center[0] = sum_x * SCALE / (2 * area) + offset;
+            blob.center[1] = sum_y * SCALE / area + offset;
+            blob.box[0] = x1 * SCALE;
+            blob.box[1] = y1 * SCALE;
+            blob.box[2] = std::min((x2 + 1) * SCALE, WIDTH) - 1;
+            blob.box[3] = std::min((y2 + 1) * SCALE, HEIGHT) - 1;
+            blobs.push_back(blob);
+        }
+    }
+    // blobs of a color with the same area are in any order
+    std::sort(blobs.begin(), blobs.end(), [](const color_blob_t &a, const color_blob_t &b)
+              { return a.color != b.color ? a.color < b.color : a.area != b.area ? a.area > b.area : a.box[1] != b.box[1] ? a.box[1] < b.box[1] : a.box[0] < b.box[0]; });
+    return blobs;
+}
+
+static bool equal(std::vector<color_blob_t> a, std::vector<color_blob_t> b)
+{
+    auto order = [](const color_blob_t &a, const color_blob_t &b)
+    { return a.color != b.color ? a.color < b.color : a.area != b.area ? a.area > b.area : a.box[1] != b.box[1] ? a.box[1] < b.box[1] : a.box[0] < b.box[0]; };
+    std::sort(a.begin(), a.end(), order);
+    if (a.size() != b.size())
+        return false;
+    for (int i = 0; i < a.size(); i++)
+    {
+        if (a[i].color != b[i].color || a[i].area != b[i].area || memcmp(a[i].center, b[i].center, sizeof(a[i].center)) || memcmp(a[i].box, b[i].box, sizeof(a[i].box)))
+            return false;
+    }
+    return true;
+}
+
+static bool ordered(const std::vector<color_blob_t> &blobs)
+{
+    for (int i = 1; i < blobs.size(); i++)
+    {
+        if (blobs[i - 1].color > blobs[i].color || (blobs[i - 1].color == blobs[i].color && blobs[i - 1].area < blobs[i].area))
+            return false;
+    }
+    return true;
+}
+
+static bool found(const std::vector<color_blob_t> &blobs, int color, const int *box)
+{
+    for (auto &blob : blobs)
+    {
+        if (blob.color == color && blob.box[0] <= box[0] + SCALE && blob.box[1] <= box[1] + SCALE && blob.box[2] >= box[2] - SCALE && blob.box[3] >= box[3] - SCALE &&
+            blob.box[0] >= box[0] - SCALE && blob.box[1] >= box[1] - SCALE && blob.box[2] <= box[2] + SCALE && blob.box[3] <= box[3] + SCALE)
+            return true;
+    }
+    return false;
+}
+
+static void test_replay(const std::vector<uint16_t> *dice)
+{
+    static uint16_t frame[WIDTH * HEIGHT];
+    ColorEngine engine(HEIGHT, WIDTH, SCALE);
+    for (auto &color : std_color_info)
+        engine.register_color(color.color_thresh, color.area_thresh, color.name);
+    engine.set_area_thresh(AREA_THRESH);
+
+    // learn the marker, inside its border
+    scene_t scene = render(0, dice, frame);
+    std::vector<int> box = {scene.marker[0] + 4, scene.marker[1] + 4, scene.marker[2] - 4, scene.marker[3] - 4};
+    const int marker = engine.register_color(frame, box, AREA_THRESH, "marker");
+    HOST_TEST_CHECK_EQUAL(std_color_info.size(), marker);
+
+    int mismatches = 0, unordered = 0, markers = 0, pips = 0, ones = 0;
+    for (int index = 0; index < FRAMES; index++)
+    {
+        scene = render(index, dice, frame);
+        std::vector<color_blob_t> &blobs = engine.detect(frame);
+        if (!equal(blobs, reference(frame, engine.get_colors())) && mismatches++ < 4)
+            printf("frame %d: blobs differ from flood fill\n", index);
+        unordered += !ordered(blobs);
+
+        markers += found(blobs, marker, scene.marker) && found(blobs, 5, scene.marker);
+        for (int d = 0; d < 2; d++)
+        {
+            if (scene.die[d] != 1)
+                continue;
+            ones++;
+            for (auto &blob : blobs)
+            {
+                int x = blob.center[0] - scene.origin[d][0], y = blob.center[1] - scene.origin[d][1];
+                if (blob.color == 0 && blob.area > 20 && abs(x - DIE_SIZE / 2) < 10 && abs(y - DIE_SIZE / 2) < 10)
+                {
+                    pips++;
+                    break;
+                }
+            }
+        }
+    }
+    HOST_TEST_CHECK_EQUAL(0, mismatches);
+    HOST_TEST_CHECK_EQUAL(0, unordered);
+    HOST_TEST_CHECK_EQUAL(FRAMES, markers);
+    HOST_TEST_CHECK(ones > 0);
+    HOST_TEST_CHECK_EQUAL(ones, pips);
+
+    // the marker is painted in its color
+    const std::vector<uint16_t> draw_colors = {0x00F8, 0xE007, 0x1F00};
+    engine.draw_segmentation(frame, draw_colors, false);
+    const int cx = (scene.marker[0] + scene.marker[2]) / 2 / SCALE * SCALE, cy = (scene.marker[1] + scene.marker[3]) / 2 / SCALE * SCALE;
+    HOST_TEST_CHECK_EQUAL(draw_colors[5 % draw_colors.size()], frame[cy * WIDTH + cx]);
+}
+
+static void test_out_of_memory(const std::vector<uint16_t> *dice)
+{
+    static uint16_t frame[WIDTH * HEIGHT];
+    heap_caps_host_out_of_memory() = true;
+    ColorEngine engine(HEIGHT, WIDTH, SCALE);
+    heap_caps_host_out_of_memory() = false;
+
+    for (auto &color : std_color_info)
+        engine.register_color(color.color_thresh, color.area_thresh, color.name);
+    render(0, dice, frame);
+    std::vector<uint16_t> copy(frame, frame + WIDTH * HEIGHT);
+    HOST_TEST_CHECK(engine.detect(frame).empty());
+    engine.draw_segmentation(frame, {0x00F8}, true, 0x0000);
+    HOST_TEST_CHECK(memcmp(copy.data(), frame, sizeof(frame)) == 0);
+    HOST_TEST_CHECK_EQUAL(std_color_info.size(), engine.get_colors().size());
+}
+
+int main()
+{
+    std::vector<uint16_t> dice[6];
+    for (int i = 0; i < 6; i++)
+        HOST_TEST_CHECK(load_die(i + 1, dice[i]));
+    if (host_test_failures)
+        return HOST_TEST_RESULT();
+
+    test_replay(dice);
+    test_out_of_memory(dice);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,134 @@
+/**
+ * @file test_conv2d_add2d.cpp
+ * @brief dl::layer::Conv2DAdd2D against Conv2D followed by Add2D.
+ *
+ * The kernels are dl::nn::reference on the host, so this checks what the layer adds: tiles of rows, the padding at
+ * the tile borders, the scratch between Conv2D and Add2D and the inplace output. Random shapes, strides, padding and
+ * scratch sizes, from one row per tile to the whole map, must give the unfused result bit by bit, and every tile
+ * handed to the kernels must start 16-byte aligned.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "host_test.hpp"
+#include "port/dl_nn_host.hpp"
+#include "dl_nn_reference.hpp"
+#include "dl_layer_conv2d_add2d.hpp"
+
+#define CASES 300
+
+using namespace dl;
+using namespace nn;
+
+static int random_int(int low, int high)
+{
+    return low + rand() % (high - low + 1);
+}
+
+template <typename T>
+static std::vector<T> random_vector(int size, int range)
+{
+    std::vector<T> data(size);
+    for (auto &value : data)
+        value = (T)random_int(-range, range);
+    return data;
+}
+
+/**
+ * @brief One random case, per_channel picks int8_t per-channel quantization of the filter.
+ *
+ * @return true: fused and unfused are equal
+ */
+template <typename feature_t, typename bias_t>
+static bool check(const int seed, const bool per_channel)
+{
+    srand(seed);
+    const int range = sizeof(feature_t) == 1 ? 127 : 2000;
+    const int filter_h = random_int(1, 5), filter_w = random_int(1, 5);
+    const int stride_y = random_int(1, 3), stride_x = random_int(1, 3);
+    const int height = random_int(filter_h, 24), width = random_int(filter_w, 24);
+    const int channel = random_int(1, 12), output_channel = random_int(1, 12);
+    const padding_type_t padding_type = (padding_type_t)random_int(PADDING_NOT_SET, PADDING_SAME_END);
+    std::vector<int> padding = {random_int(0, filter_h - 1), random_int(0, filter_h - 1), random_int(0, filter_w - 1), random_int(0, filter_w - 1)};
+    const int conv_exponent = random_int(-10, -6), output_exponent = random_int(-10, -6);
+    const bool inplace = rand() % 2;
+
+    std::vector<feature_t> input_element = random_vector<feature_t>(height * width * channel, range);
+    std::vector<feature_t> filter_element = random_vector<feature_t>(filter_h * filter_w * channel * output_channel, range);
+    std::vector<bias_t> bias_element = random_vector<bias_t>(output_channel, sizeof(bias_t) == 1 ? 127 : 2000);
+    std::vector<int8_t> channel_exponent(output_channel);
+    for (auto &exponent : channel_exponent)
+        exponent = random_int(-9, -6);
+
+    Filter<feature_t> *filter;
+    if (per_channel)
+        filter = new Filter<feature_t>(filter_element.data(), channel_exponent.data(), output_channel, {filter_h, filter_w, channel, output_channel});
+    else
+        filter = new Filter<feature_t>(filter_element.data(), -7, {filter_h, filter_w, channel, output_channel});
+    Bias<bias_t> bias(bias_element.data(), random_int(-10, -6), {output_channel});
+    Activation<feature_t> relu(ReLU);
+    Activation<feature_t> *conv_activation = rand() % 2 ? &relu : NULL;
+    Activation<feature_t> *activation = rand() % 2 ? &relu : NULL;
+
+    Tensor<feature_t> input;
+    input.set_element(input_element.data()).set_exponent(random_int(-8, -6)).set_shape({height, width, channel});
+
+    // unfused: the whole conv2d map, then add2d
+    std::vector<int> output_hw, conv_padding;
+    if (padding_type == PADDING_NOT_SET)
+    {
+        output_hw = reference::get_output_shape(height, width, filter_h, filter_w, stride_y, stride_x, padding);
+        conv_padding = padding;
+    }
+    else
+    {
+        reference::get_output_shape_and_padding(output_hw, conv_padding, height, width, filter_h, filter_w, stride_y, stride_x, padding_type);
+    }
+    Tensor<feature_t> residual;
+    residual.set_exponent(random_int(-8, -6)).set_shape({output_hw[0], output_hw[1], output_channel}).malloc_element();
+    std::vector<feature_t> residual_element = random_vector<feature_t>(residual.get_size(), range);
+    memcpy(residual.element, residual_element.data(), residual.get_size() * sizeof(feature_t));
+
+    Tensor<feature_t> conv;
+    conv.set_exponent(conv_exponent).set_shape(residual.shape).malloc_element();
+    reference::conv2d(conv, input, conv_padding, *filter, stride_y, stride_x, &bias, conv_activation);
+    Tensor<feature_t> expected;
+    expected.set_exponent(output_exponent).set_shape(residual.shape).malloc_element();
+    reference::add2d(expected, conv, residual, activation);
+
+    // fused: scratch from one row to the whole map
+    const int row_size = output_hw[1] * output_channel * sizeof(feature_t);
+    const int scratch_size = random_int(1, output_hw[0] + 1) * row_size - random_int(0, row_size - 1);
+    layer::Conv2DAdd2D<feature_t, bias_t> fused(conv_exponent, filter, &bias, conv_activation, padding_type, padding, stride_y, stride_x,
+                                                output_exponent, activation, "fused", inplace, scratch_size);
+    fused.build(input, residual);
+    Tensor<feature_t> &output = fused.call(input, residual);
+
+    bool equal = output.shape == expected.shape && output.exponent == expected.exponent && (&output == &residual) == inplace;
+    for (int i = 0; equal && i < output.get_size(); i++)
+        equal = output.element[i] == expected.element[i];
+    if (!equal)
+        printf("case %d: input %dx%dx%d, filter %dx%d, stride %dx%d, padding type %d, %d rows of scratch, inplace %d\n",
+               seed, height, width, channel, filter_h, filter_w, stride_y, stride_x, padding_type, scratch_size / row_size, inplace);
+
+    delete filter;
+    return equal;
+}
+
+int main()
+{
+    int failures[3] = {0, 0, 0};
+    for (int i = 0; i < CASES; i++)
+    {
+        failures[0] += !check<int16_t, int16_t>(i, false);
+        failures[1] += !check<int8_t, int8_t>(CASES + i, false);
+        failures[2] += !check<int8_t, int16_t>(2 * CASES + i, true);
+    }
+    HOST_TEST_CHECK_EQUAL(0, failures[0]);
+    HOST_TEST_CHECK_EQUAL(0, failures[1]);
+    HOST_TEST_CHECK_EQUAL(0, failures[2]);
+    HOST_TEST_CHECK_EQUAL(0, host_misaligned_calls);
+    return HOST_TEST_RESULT();
+}
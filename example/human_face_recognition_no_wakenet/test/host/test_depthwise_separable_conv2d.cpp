@@ -0,0 +1,140 @@
+/**
+ * @file test_depthwise_separable_conv2d.cpp
+ * @brief dl::layer::DepthwiseSeparableConv2D against DepthwiseConv2D followed by a 1x1 Conv2D.
+ *
+ * The kernels are dl::nn::reference on the host, so this checks what the layer adds: tiles of rows, the padding at
+ * the tile borders and the scratch between the two convolutions. Random shapes, strides, padding and scratch sizes,
+ * from one row per tile to the whole map, must give the unfused result bit by bit, and every tile handed to the
+ * kernels must start 16-byte aligned.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "host_test.hpp"
+#include "port/dl_nn_host.hpp"
+#include "dl_nn_reference.hpp"
+#include "dl_layer_depthwise_separable_conv2d.hpp"
+
+#define CASES 300
+
+using namespace dl;
+using namespace nn;
+
+static int random_int(int low, int high)
+{
+    return low + rand() % (high - low + 1);
+}
+
+template <typename T>
+static std::vector<T> random_vector(int size, int range)
+{
+    std::vector<T> data(size);
+    for (auto &value : data)
+        value = (T)random_int(-range, range);
+    return data;
+}
+
+/**
+ * @brief One random case, per_channel picks int8_t per-channel quantization of both filters.
+ *
+ * @return true: fused and unfused are equal
+ */
+template <typename feature_t, typename bias_t>
+static bool check(const int seed, const bool per_channel)
+{
+    srand(seed);
+    const int range = sizeof(feature_t) == 1 ? 127 : 2000;
+    const int filter_h = random_int(1, 5), filter_w = random_int(1, 5);
+    const int stride_y = random_int(1, 3), stride_x = random_int(1, 3);
+    const int height = random_int(filter_h, 24), width = random_int(filter_w, 24);
+    const int channel = random_int(1, 12), output_channel = random_int(1, 12);
+    const padding_type_t padding_type = (padding_type_t)random_int(PADDING_NOT_SET, PADDING_SAME_END);
+    std::vector<int> padding = {random_int(0, filter_h - 1), random_int(0, filter_h - 1), random_int(0, filter_w - 1), random_int(0, filter_w - 1)};
+    const int depthwise_exponent = random_int(-10, -6), output_exponent = random_int(-10, -6);
+
+    std::vector<feature_t> input_element = random_vector<feature_t>(height * width * channel, range);
+    std::vector<feature_t> depthwise_element = random_vector<feature_t>(filter_h * filter_w * channel, range);
+    std::vector<feature_t> pointwise_element = random_vector<feature_t>(channel * output_channel, range);
+    std::vector<bias_t> depthwise_bias_element = random_vector<bias_t>(channel, sizeof(bias_t) == 1 ? 127 : 2000);
+    std::vector<bias_t> pointwise_bias_element = random_vector<bias_t>(output_channel, sizeof(bias_t) == 1 ? 127 : 2000);
+    std::vector<int8_t> depthwise_channel_exponent(channel), pointwise_channel_exponent(output_channel);
+    for (auto &exponent : depthwise_channel_exponent)
+        exponent = random_int(-9, -6);
+    for (auto &exponent : pointwise_channel_exponent)
+        exponent = random_int(-9, -6);
+
+    Filter<feature_t> *depthwise_filter, *pointwise_filter;
+    if (per_channel)
+    {
+        depthwise_filter = new Filter<feature_t>(depthwise_element.data(), depthwise_channel_exponent.data(), channel, {filter_h, filter_w, channel, 1});
+        pointwise_filter = new Filter<feature_t>(pointwise_element.data(), pointwise_channel_exponent.data(), output_channel, {1, 1, channel, output_channel});
+    }
+    else
+    {
+        depthwise_filter = new Filter<feature_t>(depthwise_element.data(), -7, {filter_h, filter_w, channel, 1});
+        pointwise_filter = new Filter<feature_t>(pointwise_element.data(), -7, {1, 1, channel, output_channel});
+    }
+    Bias<bias_t> depthwise_bias(depthwise_bias_element.data(), random_int(-10, -6), {channel});
+    Bias<bias_t> pointwise_bias(pointwise_bias_element.data(), random_int(-10, -6), {output_channel});
+    Activation<feature_t> relu(ReLU);
+    Activation<feature_t> *depthwise_activation = rand() % 2 ? &relu : NULL;
+    Activation<feature_t> *pointwise_activation = rand() % 2 ? &relu : NULL;
+
+    Tensor<feature_t> input;
+    input.set_element(input_element.data()).set_exponent(random_int(-8, -6)).set_shape({height, width, channel});
+
+    // unfused: the whole depthwise map, then 1x1 conv2d
+    std::vector<int> depthwise_hw, depthwise_padding;
+    if (padding_type == PADDING_NOT_SET)
+    {
+        depthwise_hw = reference::get_output_shape(height, width, filter_h, filter_w, stride_y, stride_x, padding);
+        depthwise_padding = padding;
+    }
+    else
+    {
+        reference::get_output_shape_and_padding(depthwise_hw, depthwise_padding, height, width, filter_h, filter_w, stride_y, stride_x, padding_type);
+    }
+    Tensor<feature_t> depthwise;
+    depthwise.set_exponent(depthwise_exponent).set_shape({depthwise_hw[0], depthwise_hw[1], channel}).malloc_element();
+    reference::depthwise_conv2d(depthwise, input, depthwise_padding, *depthwise_filter, stride_y, stride_x, &depthwise_bias, depthwise_activation);
+    Tensor<feature_t> expected;
+    reference::conv2d(expected, output_exponent, depthwise, *pointwise_filter, 1, 1, PADDING_VALID, &pointwise_bias, pointwise_activation);
+
+    // fused: scratch from one row to the whole map
+    const int row_size = depthwise_hw[1] * channel * sizeof(feature_t);
+    const int scratch_size = random_int(1, depthwise_hw[0] + 1) * row_size - random_int(0, row_size - 1);
+    layer::DepthwiseSeparableConv2D<feature_t, bias_t> fused(depthwise_exponent, depthwise_filter, &depthwise_bias, depthwise_activation,
+                                                             padding_type, padding, stride_y, stride_x,
+                                                             output_exponent, pointwise_filter, &pointwise_bias, pointwise_activation,
+                                                             "fused", scratch_size);
+    fused.build(input);
+    Tensor<feature_t> &output = fused.call(input);
+
+    bool equal = output.shape == expected.shape && output.exponent == expected.exponent;
+    for (int i = 0; equal && i < output.get_size(); i++)
+        equal = output.element[i] == expected.element[i];
+    if (!equal)
+        printf("case %d: input %dx%dx%d, filter %dx%d, stride %dx%d, padding type %d, %d rows of scratch\n",
+               seed, height, width, channel, filter_h, filter_w, stride_y, stride_x, padding_type, scratch_size / row_size);
+
+    delete depthwise_filter;
+    delete pointwise_filter;
+    return equal;
+}
+
+int main()
+{
+    int failures[3] = {0, 0, 0};
+    for (int i = 0; i < CASES; i++)
+    {
+        failures[0] += !check<int16_t, int16_t>(i, false);
+        failures[1] += !check<int8_t, int8_t>(CASES + i, false);
+        failures[2] += !check<int8_t, int16_t>(2 * CASES + i, true);
+    }
+    HOST_TEST_CHECK_EQUAL(0, failures[0]);
+    HOST_TEST_CHECK_EQUAL(0, failures[1]);
+    HOST_TEST_CHECK_EQUAL(0, failures[2]);
+    HOST_TEST_CHECK_EQUAL(0, host_misaligned_calls);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,236 @@
+/**
+ * @file test_detect_alloc.cpp
+ * @brief Heap allocations of the code around the detectors, HumanFaceDetectCascade and FaceTracker, in steady state.
+ *
+ * The frame loop of AppFace runs 10000 frames on two faces moving across the frame, full detection every few frames
+ * and refining the predicted boxes in between. Stage one and two are prebuilt on the chip, here they are stand-ins
+ * that report the faces and keep their own results in a ResultPool, so what the prebuilt stages allocate inside is
+ * not measured. Every operator new is counted after warm up:
+ *         - the cascade and the tracker allocate nothing, the only allocations are the copies of input_shape, which the
+ *           prebuilt stages take by value,
+ *         - the pool of the cascade gets every result back,
+ *         - both faces are detected on every frame, with keypoints.
+ * Then stage two erases the candidate lent to it on every frame, the cascade allocates the lost result again and keeps
+ * detecting both faces. Last, a cascade with a confident_score keeps the candidates scoring above it as they are,
+ * without keypoints and without calling stage two for them, and still allocates nothing.
+ */
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+#include "host_test.hpp"
+#include "human_face_detect_cascade.hpp"
+#include "who_face_tracker.hpp"
+
+#define FRAMES 10000
+#define WARM_UP 100
+#define WIDTH 320
+#define HEIGHT 240
+#define FACE_SIZE 60
+
+static std::atomic<bool> tracing(false);
+static std::atomic<long> allocations(0);
+
+/**
+ * @brief Every form of operator new and delete goes through this pair, out of line, so no delete inlined at a call
+ * site is seen freeing what a new returned.
+ */
+__attribute__((noinline)) static void *allocate(size_t size)
+{
+    if (tracing)
+        allocations++;
+    void *p = malloc(size ? size : 1);
+    if (p == NULL)
+        throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) static void deallocate(void *p) noexcept
+{
+    free(p);
+}
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *p) noexcept { deallocate(p); }
+void operator delete[](void *p) noexcept { deallocate(p); }
+void operator delete(void *p, size_t size) noexcept { deallocate(p); }
+void operator delete[](void *p, size_t size) noexcept { deallocate(p); }
+
+static int frame_index = 0; /*<! frame being detected >*/
+static long stage_calls = 0; /*<! calls into the stages, each copies input_shape >*/
+static bool erase_candidate = false; /*<! stage two erases the candidate lent to it >*/
+
+/**
+ * @brief Box of face on the current frame, each face bounces in its own half, so they never overlap.
+ */
+static void face_box(const int face, int *box)
+{
+    const int range_x = WIDTH / 2 - FACE_SIZE, range_y = HEIGHT - FACE_SIZE;
+    int x = (frame_index * (face + 1) + face * 50) % (2 * range_x);
+    int y = (frame_index + face * 90) % (2 * range_y);
+    x = x < range_x ? x : 2 * range_x - x;
+    y = y < range_y ? y : 2 * range_y - y;
+    box[0] = face * WIDTH / 2 + x;
+    box[1] = y;
+    box[2] = box[0] + FACE_SIZE - 1;
+    box[3] = y + FACE_SIZE - 1;
+}
+
+typedef struct
+{
+    dl::detect::ResultPool pool;
+    std::list<dl::detect::result_t> results;
+    int top_k;
+} stage_t;
+
+HumanFaceDetectMSR01::HumanFaceDetectMSR01(const float score_threshold, const float nms_threshold, const int top_k, float resize_scale)
+{
+    this->model = new stage_t{dl::detect::ResultPool(top_k), {}, top_k};
+}
+
+HumanFaceDetectMSR01::~HumanFaceDetectMSR01()
+{
+    delete (stage_t *)this->model;
+}
+
+/**
+ * @brief Both faces, loose, and a second box on the first face.
+ */
+template <>
+std::list<dl::detect::result_t> &HumanFaceDetectMSR01::infer(uint16_t *input_element, std::vector<int> input_shape)
+{
+    stage_calls++;
+    stage_t *stage = (stage_t *)this->model;
+    stage->pool.clear(stage->results);
+    for (int i = 0; i < 3; i++)
+    {
+        dl::detect::result_t *result = stage->pool.take(stage->results);
+        int box[4];
+        face_box(i % 2, box);
+        result->category = 0;
+        result->score = 0.8f - i * 0.1f;
+        result->box.assign({box[0] - 4 + i, box[1] - 6, box[2] + 5, box[3] + 3 - i});
+        result->keypoint.clear();
+    }
+    return stage->results;
+}
+
+HumanFaceDetectMNP01::HumanFaceDetectMNP01(const float score_threshold, const float nms_threshold, const int top_k)
+{
+    this->model = new stage_t{dl::detect::ResultPool(top_k), {}, top_k};
+}
+
+HumanFaceDetectMNP01::~HumanFaceDetectMNP01()
+{
+    delete (stage_t *)this->model;
+}
+
+/**
+ * @brief The face under each candidate, with five keypoints.
+ */
+template <>
+std::list<dl::detect::result_t> &HumanFaceDetectMNP01::infer(uint16_t *input_element, std::vector<int> input_shape, std::list<dl::detect::result_t> &candidates)
+{
+    stage_calls++;
+    stage_t *stage = (stage_t *)this->model;
+    stage->pool.clear(stage->results);
+    for (auto &candidate : candidates)
+    {
+        for (int face = 0; face < 2; face++)
+        {
+            int box[4];
+            face_box(face, box);
+            int cx = (candidate.box[0] + candidate.box[2]) / 2, cy = (candidate.box[1] + candidate.box[3]) / 2;
+            if (cx < box[0] || cx > box[2] || cy < box[1] || cy > box[3])
+                continue;
+
+            dl::detect::result_t *result = stage->pool.take(stage->results);
+            if (result == NULL)
+                break;
+            result->category = 0;
+            result->score = 0.9f;
+            result->box.assign(box, box + 4);
+            result->keypoint.resize(10);
+            for (int i = 0; i < 10; i += 2)
+            {
+                result->keypoint[i] = box[0] + 10 + 10 * (i / 2);
+                result->keypoint[i + 1] = box[1] + 20 + 5 * (i / 2);
+            }
+        }
+    }
+    if (erase_candidate)
+        candidates.clear();
+    return stage->results;
+}
+
+/**
+ * @brief Run frames from frame_index on, count the frames missing a face or keypoints.
+ */
+static int run(HumanFaceDetectCascade &detector, FaceTracker &tracker, const int end)
+{
+    static uint16_t frame[WIDTH * HEIGHT];
+    static const std::vector<int> shape = {HEIGHT, WIDTH, 3};
+    int missed = 0;
+    for (; frame_index < end; frame_index++)
+    {
+        bool full_detection = tracker.need_detection();
+        std::list<dl::detect::result_t> &predictions = tracker.predict();
+        std::list<dl::detect::result_t> &detections = full_detection ? detector.infer(frame, shape)
+                                                                     : detector.refine(frame, shape, predictions);
+        std::list<dl::detect::result_t> &results = tracker.update(detections, full_detection);
+
+        bool keypoints = true;
+        for (auto &result : detections)
+            keypoints = keypoints && result.keypoint.size() == 10;
+        missed += detections.size() != 2 || results.size() != 2 || !keypoints;
+    }
+    return missed;
+}
+
+int main()
+{
+    HumanFaceDetectCascade detector(0.3F, 0.3F, 10, 0.3F, 0.4F, 0.3F, 1, 5);
+    FaceTracker tracker(5);
+
+    int missed = run(detector, tracker, WARM_UP);
+    long calls = stage_calls;
+    tracing = true;
+    missed += run(detector, tracker, WARM_UP + FRAMES);
+    tracing = false;
+    calls = stage_calls - calls;
+
+    HOST_TEST_CHECK_EQUAL(calls, allocations.load());
+    HOST_TEST_CHECK_EQUAL(0, missed);
+    printf("%d frames, %ld stage calls, %ld allocations\n", FRAMES, calls, allocations.load());
+
+    // far more erased candidates than the pool holds
+    erase_candidate = true;
+    HOST_TEST_CHECK_EQUAL(0, run(detector, tracker, WARM_UP + FRAMES + 100));
+    erase_candidate = false;
+
+    // candidates of stage one score 0.8 on face 0, 0.7 on face 1 and 0.6 on face 0, only the last goes to stage two,
+    // whose result on face 0 wins the nms over the first
+    static uint16_t frame[WIDTH * HEIGHT];
+    static const std::vector<int> shape = {HEIGHT, WIDTH, 3};
+    HumanFaceDetectCascade confident(0.3F, 0.3F, 10, 0.3F, 0.4F, 0.3F, 1, 5, 0.65F);
+    confident.infer(frame, shape);
+    calls = stage_calls;
+    allocations = 0;
+    tracing = true;
+    std::list<dl::detect::result_t> &results = confident.infer(frame, shape);
+    tracing = false;
+    calls = stage_calls - calls;
+    HOST_TEST_CHECK_EQUAL(2, (int)calls);
+    HOST_TEST_CHECK_EQUAL(calls, allocations.load());
+    HOST_TEST_CHECK_EQUAL(2, (int)results.size());
+    int skipped = 0, refined = 0;
+    for (auto &result : results)
+    {
+        skipped += result.keypoint.empty() && result.box[0] >= WIDTH / 2;
+        refined += result.keypoint.size() == 10 && result.box[0] < WIDTH / 2;
+    }
+    HOST_TEST_CHECK_EQUAL(1, skipped);
+    HOST_TEST_CHECK_EQUAL(1, refined);
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,277 @@
+/**
+ * @file test_face_id_log.cpp
+ * @brief FaceIDLog on a file-backed partition.
+ *
+ * - Enroll, re-enroll and delete survive a reboot, in the order of enrollment.
+ * - Power is cut after every byte programmed by a sequence of operations that compacts several times. After reboot
+ *   the ids must be those before or after the operation in flight, and the log must take new records.
+ * - Migration writes the new log without touching the ids of the old format at the start of the partition, whenever
+ *   power is cut.
+ * - The queued API of the example writes the records that it reports as queued.
+ */
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "host_test.hpp"
+#include "esp_partition.h"
+#include "who_face_id_log.hpp"
+
+#define EMB_SIZE 8
+#define LOG_FILE "test_face_id_log.bin"
+
+typedef FaceIDLog::face_record_t face_record_t;
+
+typedef struct
+{
+    bool remove; /*<! tombstone or enroll >*/
+    int id;      /*<! id index >*/
+} op_t;
+
+static std::vector<float> embedding(int id, int version)
+{
+    std::vector<float> emb(EMB_SIZE);
+    for (int i = 0; i < EMB_SIZE; i++)
+        emb[i] = id + version * 0.25f + i * 0.01f;
+    return emb;
+}
+
+static std::string name_of(int id)
+{
+    return std::string(id % 4, 'a' + id % 26);
+}
+
+/**
+ * @brief Live ids expected after the operations, in the order of enrollment.
+ */
+static void apply(std::vector<face_record_t> &model, const op_t &op, int version)
+{
+    for (int i = 0; i < model.size(); i++)
+    {
+        if (model[i].id == op.id)
+        {
+            model.erase(model.begin() + i);
+            break;
+        }
+    }
+    if (!op.remove)
+        model.push_back({op.id, name_of(op.id), embedding(op.id, version)});
+}
+
+static bool equal(const std::vector<face_record_t> &a, const std::vector<face_record_t> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (int i = 0; i < a.size(); i++)
+    {
+        if (a[i].id != b[i].id || a[i].name != b[i].name || a[i].emb != b[i].emb)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Power on: mount the file again and load the log.
+ */
+static bool boot(FaceIDLogPartition *&storage, FaceIDLog *&log, std::vector<face_record_t> &records, uint32_t size, uint32_t sector)
+{
+    delete log;
+    delete storage;
+    esp_partition_host_mount("fr", LOG_FILE, size, sector);
+    storage = new FaceIDLogPartition("fr");
+    log = new FaceIDLog(storage, EMB_SIZE);
+    return log->load(records);
+}
+
+static bool run(FaceIDLog *log, const op_t &op, int version)
+{
+    if (op.remove)
+        return log->remove(op.id);
+    std::vector<float> emb = embedding(op.id, version);
+    bool ret = log->append(op.id, emb.data(), name_of(op.id));
+    if (ret && log->need_compaction())
+        ret = log->compact();
+    return ret;
+}
+
+static void test_reboot()
+{
+    remove(LOG_FILE);
+    FaceIDLogPartition *storage = NULL;
+    FaceIDLog *log = NULL;
+    std::vector<face_record_t> records;
+    HOST_TEST_CHECK(!boot(storage, log, records, 8192, 4096));
+    HOST_TEST_CHECK(log->reset(records));
+
+    std::vector<face_record_t> model;
+    const op_t ops[] = {{false, 1}, {false, 2}, {false, 3}, {true, 2}, {false, 1}, {false, 4}, {true, 5}};
+    for (int i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+    {
+        HOST_TEST_CHECK(run(log, ops[i], i));
+        apply(model, ops[i], i);
+    }
+    HOST_TEST_CHECK_EQUAL(model.size(), log->size());
+
+    HOST_TEST_CHECK(boot(storage, log, records, 8192, 4096));
+    HOST_TEST_CHECK(equal(model, records));
+    HOST_TEST_CHECK_EQUAL(3, records.size());
+
+    delete log;
+    delete storage;
+}
+
+static void test_power_loss()
+{
+    // 2 areas of 512 bytes hold 8 records each, the sequence compacts every few operations
+    const uint32_t size = 1024, sector = 512;
+    std::vector<op_t> ops;
+    for (int i = 0; i < 24; i++)
+        ops.push_back({i % 3 == 2, 1 + i % 5});
+
+    int failures = 0;
+    int cuts = 0;
+    for (int budget = 0;; budget++)
+    {
+        remove(LOG_FILE);
+        FaceIDLogPartition *storage = NULL;
+        FaceIDLog *log = NULL;
+        std::vector<face_record_t> records;
+        boot(storage, log, records, size, sector);
+        log->reset(records);
+
+        // run until the power loss
+        esp_partition_host_power_loss(budget);
+        std::vector<face_record_t> before, after;
+        int cut = -1;
+        for (int i = 0; i < ops.size() && cut < 0; i++)
+        {
+            before = after;
+            apply(after, ops[i], i);
+            run(log, ops[i], i);
+            if (!esp_partition_host_powered())
+                cut = i;
+        }
+        esp_partition_host_power_loss(-1);
+        if (cut < 0)
+        {
+            // the whole sequence fits in budget, every cut has been tried
+            HOST_TEST_CHECK(boot(storage, log, records, size, sector));
+            HOST_TEST_CHECK(equal(after, records));
+            delete log;
+            delete storage;
+            break;
+        }
+        cuts++;
+
+        bool loaded = boot(storage, log, records, size, sector);
+        bool consistent = loaded && (equal(before, records) || equal(after, records));
+        if (consistent)
+        {
+            // recovered log takes new records, a torn area is compacted first
+            std::vector<face_record_t> expected = records;
+            op_t op = {false, 9};
+            apply(expected, op, 99);
+            consistent = run(log, op, 99) && boot(storage, log, records, size, sector) && equal(expected, records);
+        }
+        if (!consistent && failures++ < 4)
+            printf("power loss after %d bytes, in operation %d: %s\n", budget, cut, loaded ? "inconsistent ids" : "no log");
+        delete log;
+        delete storage;
+    }
+    HOST_TEST_CHECK_EQUAL(0, failures);
+    HOST_TEST_CHECK(cuts > 1000);
+    printf("%d power losses, %d not recovered\n", cuts, failures);
+}
+
+static void test_migration()
+{
+    // ids of FaceRecognizer::write_ids_to_flash() at the start of the partition
+    std::vector<uint8_t> legacy(1500);
+    for (int i = 0; i < legacy.size(); i++)
+        legacy[i] = i * 7 + 3;
+    std::vector<face_record_t> migrated;
+    for (int id = 1; id <= 3; id++)
+        migrated.push_back({id, name_of(id), embedding(id, 0)});
+
+    int failures = 0;
+    for (int budget = 0;; budget++)
+    {
+        remove(LOG_FILE);
+        esp_partition_host_mount("fr", LOG_FILE, 8192, 4096);
+        const esp_partition_t *partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "fr");
+        esp_partition_write(partition, 0, legacy.data(), legacy.size());
+
+        FaceIDLogPartition *storage = NULL;
+        FaceIDLog *log = NULL;
+        std::vector<face_record_t> records;
+        HOST_TEST_CHECK(!boot(storage, log, records, 8192, 4096));
+        esp_partition_host_power_loss(budget);
+        std::vector<face_record_t> copy = migrated;
+        log->reset(copy);
+        bool cut = !esp_partition_host_powered();
+        esp_partition_host_power_loss(-1);
+
+        bool loaded = boot(storage, log, records, 8192, 4096);
+        std::vector<uint8_t> left(legacy.size());
+        partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "fr");
+        esp_partition_read(partition, 0, left.data(), left.size());
+        if (left != legacy || (!cut && !(loaded && equal(migrated, records))) || (cut && loaded && !equal(migrated, records)))
+            failures++;
+        delete log;
+        delete storage;
+        if (!cut)
+            break;
+    }
+    HOST_TEST_CHECK_EQUAL(0, failures);
+}
+
+static void test_queued()
+{
+    remove(LOG_FILE);
+    esp_partition_host_mount("fr", LOG_FILE, 8192, 4096);
+    HOST_TEST_CHECK(register_face_id_log("fr", EMB_SIZE));
+
+    std::vector<face_record_t> records;
+    HOST_TEST_CHECK(!face_id_log_read(records));
+    HOST_TEST_CHECK(face_id_log_reset(records));
+
+    // burst faster than flash, whatever is reported as queued must reach the log
+    std::vector<face_record_t> model;
+    for (int i = 0; i < 32; i++)
+    {
+        op_t op = {i % 4 == 3, 1 + i % 6};
+        bool queued;
+        if (op.remove)
+        {
+            queued = face_id_log_remove(op.id);
+        }
+        else
+        {
+            std::vector<float> emb = embedding(op.id, i);
+            dl::Tensor<float> tensor;
+            tensor.set_element(emb.data()).set_shape({EMB_SIZE});
+            queued = face_id_log_append(op.id, tensor, name_of(op.id));
+        }
+        if (queued)
+            apply(model, op, i);
+    }
+
+    // the background task writes in order, the log is complete once it matches
+    bool done = false;
+    for (int i = 0; i < 200 && !done; i++)
+    {
+        vTaskDelay(pdMS_TO_TICKS(10));
+        done = face_id_log_read(records) && equal(model, records);
+    }
+    HOST_TEST_CHECK(done);
+}
+
+int main()
+{
+    test_reboot();
+    test_power_loss();
+    test_migration();
+    test_queued();
+    remove(LOG_FILE);
+    return HOST_TEST_RESULT();
+}
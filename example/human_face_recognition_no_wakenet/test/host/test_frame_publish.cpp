@@ -0,0 +1,119 @@
+/**
+ * @file test_frame_publish.cpp
+ * @brief Frame::publish() with a slow subscriber.
+ *
+ * The camera has 3 buffers as in app_main. One subscriber takes 20 ms a frame, the others release at once. The camera
+ * must keep running at its own pace, every buffer must come back to the driver exactly once, and none may be left in
+ * flight when the subscribers stop.
+ */
+#include <atomic>
+
+#include "host_test.hpp"
+#include "__base__.hpp"
+
+#define FB_COUNT 3
+#define FRAMES 200
+#define SLOW_MS 20
+
+static camera_fb_t buffers[FB_COUNT];
+static std::atomic<int> returned[FB_COUNT];
+static QueueHandle_t driver = xQueueCreate(FB_COUNT, sizeof(camera_fb_t *)); /*<! free buffers of the driver */
+
+void esp_camera_fb_return(camera_fb_t *fb)
+{
+    int index = fb - buffers;
+    HOST_TEST_CHECK(index >= 0 && index < FB_COUNT);
+    HOST_TEST_CHECK_EQUAL(0, returned[index]++); // returned twice before taken again
+    xQueueSend(driver, &fb, 0);
+}
+
+static camera_fb_t *esp_camera_fb_get()
+{
+    camera_fb_t *fb = nullptr;
+    if (xQueueReceive(driver, &fb, pdMS_TO_TICKS(1000)) != pdTRUE)
+        return nullptr;
+    returned[fb - buffers]--;
+    return fb;
+}
+
+struct Subscriber
+{
+    QueueHandle_t queue;
+    TickType_t delay;
+    std::atomic<int> received{0};
+    std::atomic<bool> running{true};
+    std::atomic<bool> stopped{false};
+};
+
+static void subscriber_task(void *arg)
+{
+    Subscriber *self = (Subscriber *)arg;
+    camera_fb_t *frame = nullptr;
+    while (self->running)
+    {
+        if (xQueueReceive(self->queue, &frame, pdMS_TO_TICKS(10)) != pdTRUE)
+            continue;
+        self->received++;
+        if (self->delay)
+            vTaskDelay(self->delay);
+        frame_release(frame);
+    }
+    self->stopped = true;
+    vTaskDelete(NULL);
+}
+
+int main()
+{
+    for (int i = 0; i < FB_COUNT; i++)
+    {
+        camera_fb_t *fb = &buffers[i];
+        returned[i] = 1;
+        xQueueSend(driver, &fb, 0);
+    }
+
+    Frame camera;
+    Subscriber subscribers[4];
+    for (int i = 0; i < 4; i++)
+    {
+        subscribers[i].queue = xQueueCreate(1, sizeof(camera_fb_t *));
+        subscribers[i].delay = i == 0 ? pdMS_TO_TICKS(SLOW_MS) : 0;
+        camera.subscribe(subscribers[i].queue);
+        xTaskCreatePinnedToCore(subscriber_task, "subscriber", 2 * 1024, &subscribers[i], 5, NULL, 0);
+    }
+
+    int published = 0;
+    TickType_t start = xTaskGetTickCount();
+    for (; published < FRAMES; published++)
+    {
+        camera_fb_t *fb = esp_camera_fb_get();
+        if (fb == nullptr)
+            break; // every buffer pinned
+        vTaskDelay(1);
+        camera.publish(fb);
+    }
+    TickType_t period = xTaskGetTickCount() - start;
+
+    // the camera is not paced by the slow subscriber
+    HOST_TEST_CHECK_EQUAL(FRAMES, published);
+    HOST_TEST_CHECK(period < FRAMES * SLOW_MS / 2);
+    HOST_TEST_CHECK(subscribers[0].received < FRAMES / 2);
+
+    for (auto &subscriber : subscribers)
+        subscriber.running = false;
+    for (auto &subscriber : subscribers)
+    {
+        while (!subscriber.stopped)
+            vTaskDelay(1);
+        camera_fb_t *frame = nullptr;
+        while (xQueueReceive(subscriber.queue, &frame, 0) == pdTRUE)
+            frame_release(frame);
+    }
+
+    for (int i = 0; i < FB_COUNT; i++)
+        HOST_TEST_CHECK_EQUAL(1, returned[i]);
+    for (int i = 0; i < FRAME_REF_MAX; i++)
+        HOST_TEST_CHECK(frame_refs()[i].frame == nullptr);
+
+    printf("published %d frames in %u ms, slow subscriber got %d\n", published, (unsigned)period, subscribers[0].received.load());
+    return HOST_TEST_RESULT();
+}
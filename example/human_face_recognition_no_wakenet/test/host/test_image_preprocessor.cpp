@@ -0,0 +1,141 @@
+/**
+ * @file test_image_preprocessor.cpp
+ * @brief dl::image::ImagePreprocessor against crop_and_resize() followed by normalize and quantize per channel.
+ *
+ * Random camera buffers in RGB565 and YUV422, crop boxes partly out of the frame, output sizes from downscaling to
+ * upscaling, nearest and bilinear, int8_t and int16_t output. The unfused path converts YUV422 by the float BT.601,
+ * resizes in double and quantizes in float, so each output may differ from it by the rounding of the fixed point
+ * math only:
+ *         - RGB565 nearest is equal bit by bit, except where an output pixel is centered right between two input
+ *           pixels, which either of them is right for,
+ *         - otherwise the output is what the unfused path gives for a pixel at most a few levels away.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits>
+#include <vector>
+
+#include "host_test.hpp"
+#include "dl_image.hpp"
+#include "dl_image_preprocessor.hpp"
+
+#define CASES 200
+
+using namespace dl;
+using namespace image;
+
+static int random_int(int low, int high)
+{
+    return low + rand() % (high - low + 1);
+}
+
+/**
+ * @brief YUV422 to BGR888 by the float BT.601.
+ */
+static std::vector<uint8_t> yuv422_to_bgr888(const std::vector<uint8_t> &yuv, const int height, const int width)
+{
+    std::vector<uint8_t> bgr(height * width * 3);
+    for (int i = 0; i < height * width; i++)
+    {
+        const uint8_t *pair = &yuv[(i & ~1) * 2];
+        float luma = pair[(i & 1) << 1], u = pair[1] - 128.f, v = pair[3] - 128.f;
+        float value[3] = {luma + 1.772f * u, luma - 0.344f * u - 0.714f * v, luma + 1.402f * v};
+        for (int c = 0; c < 3; c++)
+            bgr[i * 3 + c] = (uint8_t)DL_CLIP(lroundf(value[c]), 0, 255);
+    }
+    return bgr;
+}
+
+/**
+ * @brief One random case.
+ *
+ * @return number of output elements out of what the unfused path allows
+ */
+template <typename feature_t>
+static int check(const int seed, const image_format_t format, const resize_type_t resize_type)
+{
+    srand(seed);
+    const int height = random_int(2, 40), width = 2 * random_int(1, 20);
+    const int output_height = random_int(1, 48), output_width = random_int(1, 48);
+    const int y_start = random_int(-4, height - 1), x_start = random_int(-4, width - 1);
+    const int y_end = random_int(y_start + 1, height + 4), x_end = random_int(x_start + 1, width + 4);
+    std::vector<float> mean(3), std(3);
+    for (int c = 0; c < 3; c++)
+    {
+        mean[c] = random_int(0, 255);
+        std[c] = random_int(1, 1000) / 10.f;
+    }
+    const int exponent = sizeof(feature_t) == 1 ? random_int(-6, 0) : random_int(-12, -4);
+
+    // camera buffer and the same image in BGR888 for crop_and_resize()
+    std::vector<uint8_t> buffer(height * width * 2);
+    for (auto &byte : buffer)
+        byte = rand();
+    std::vector<uint8_t> bgr;
+    if (format == IMAGE_FORMAT_YUV422)
+        bgr = yuv422_to_bgr888(buffer, height, width);
+    std::vector<uint8_t> resized(output_height * output_width * 3);
+    if (format == IMAGE_FORMAT_RGB565)
+        crop_and_resize(resized.data(), output_width, 3, 0, output_height, 0, output_width,
+                        (uint16_t *)buffer.data(), height, width, 3, y_start, y_end, x_start, x_end, resize_type);
+    else
+        crop_and_resize(resized.data(), output_width, 3, 0, output_height, 0, output_width,
+                        bgr.data(), height, width, 3, y_start, y_end, x_start, x_end, resize_type);
+
+    ImagePreprocessor<feature_t> preprocessor(mean, std, exponent, format, resize_type);
+    preprocessor.set_crop(y_start, y_end, x_start, x_end, output_height, output_width);
+    Tensor<feature_t> output;
+    output.set_exponent(exponent).set_shape({output_height, output_width, 3}).malloc_element();
+    preprocessor(buffer.data(), {height, width, 3}, output);
+
+    // levels of pixel the fixed point math may be away from the unfused path
+    int tolerance = resize_type == IMAGE_RESIZE_BILINEAR ? 2 : 0;
+    if (format == IMAGE_FORMAT_YUV422)
+        tolerance += 2;
+    auto quantize = [&](int c, int pixel)
+    {
+        int value = (int)roundf((pixel - mean[c]) / std[c] * DL_SCALE(-exponent));
+        return DL_CLIP(value, std::numeric_limits<feature_t>::min(), std::numeric_limits<feature_t>::max());
+    };
+
+    // the center of an output pixel right between two input pixels goes to either of them, by float rounding
+    auto tie = [](int i, int start, int end, int n)
+    { return ((2 * i + 1) * (end - start)) % (2 * n) == 0; };
+
+    int wrong = 0;
+    for (int i = 0; i < output.get_size(); i++)
+    {
+        int c = i % 3, x = i / 3 % output_width, y = i / 3 / output_width;
+        if (resize_type == IMAGE_RESIZE_NEAREST && (tie(x, x_start, x_end, output_width) || tie(y, y_start, y_end, output_height)))
+            continue;
+        int low = quantize(c, DL_MAX(resized[i] - tolerance, 0));
+        int high = quantize(c, DL_MIN(resized[i] + tolerance, 255));
+        wrong += output.element[i] < low || output.element[i] > high;
+    }
+    if (wrong)
+        printf("case %d: format %d, resize %d, %dx%d box [%d, %d) x [%d, %d) to %dx%d, %d wrong\n", seed, format, resize_type,
+               height, width, y_start, y_end, x_start, x_end, output_height, output_width, wrong);
+    return wrong;
+}
+
+int main()
+{
+    const image_format_t formats[2] = {IMAGE_FORMAT_RGB565, IMAGE_FORMAT_YUV422};
+    const resize_type_t resize_types[2] = {IMAGE_RESIZE_NEAREST, IMAGE_RESIZE_BILINEAR};
+    for (int f = 0; f < 2; f++)
+    {
+        for (int r = 0; r < 2; r++)
+        {
+            int wrong = 0;
+            for (int i = 0; i < CASES; i++)
+            {
+                int seed = ((f * 2 + r) * 2) * CASES + i;
+                wrong += check<int8_t>(seed, formats[f], resize_types[r]);
+                wrong += check<int16_t>(seed + CASES, formats[f], resize_types[r]);
+            }
+            HOST_TEST_CHECK_EQUAL(0, wrong);
+        }
+    }
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,198 @@
+/**
+ * @file test_jpeg_cache.cpp
+ * @brief The JPEG cache of the web server, its intake and encoder tasks, with clients of every pace.
+ *
+ * The camera sends RGB565 frames faster than the encoder takes them. Two clients share a quality and scale, one asks
+ * for another, and one never takes a frame. frame2jpg() is a stand-in recording what it encodes, and every free() of
+ * an encoded buffer is seen through the linker, so the test knows which encoded frames are alive:
+ *         - each camera frame is encoded at most once per quality and scale, however many clients ask for it,
+ *         - every camera frame is returned to the driver, whether it is encoded or skipped,
+ *         - the client that never takes frames holds at most one jpeg_frame_t at any time,
+ *         - clients sharing a quality and scale get the same frames.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "host_test.hpp"
+#include "img_converters.h"
+#include "app_jpeg_cache.hpp"
+
+#define FRAMES 300
+#define WIDTH 32
+#define HEIGHT 24
+#define ENCODE_MS 3
+
+typedef std::tuple<int, int, int> encode_key_t; /*<! camera frame, quality, scale >*/
+
+static std::mutex lock;
+static std::map<encode_key_t, int> encodes;      /*<! times each camera frame is encoded per quality and scale >*/
+static std::map<uint8_t *, int> live;            /*<! encoded buffers not freed, with their quality >*/
+static int idle_quality = 0;                     /*<! quality of the client never taking frames >*/
+static int idle_live_max = 0;                    /*<! most encoded buffers of that quality held by clients >*/
+static std::atomic<int> returned(0);
+
+extern "C" void __real_free(void *p);
+
+/**
+ * @brief free() of the cache and the test, linked with --wrap=free.
+ */
+extern "C" void __wrap_free(void *p)
+{
+    if (p)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        live.erase((uint8_t *)p);
+    }
+    __real_free(p);
+}
+
+static int idle_live()
+{
+    int n = 0;
+    for (auto &buffer : live)
+        n += buffer.second == idle_quality;
+    return n;
+}
+
+bool frame2jpg(camera_fb_t *fb, uint8_t quality, uint8_t **out, size_t *out_len)
+{
+    vTaskDelay(pdMS_TO_TICKS(ENCODE_MS));
+
+    // each pixel of a camera frame holds its index, any nearest sample reads it
+    int index = ((uint16_t *)fb->buf)[0];
+    int scale = WIDTH / fb->width;
+    *out_len = 4;
+    *out = (uint8_t *)malloc(*out_len);
+    (*out)[0] = index & 0xFF;
+    (*out)[1] = index >> 8;
+    (*out)[2] = quality;
+    (*out)[3] = scale;
+
+    std::lock_guard<std::mutex> guard(lock);
+    encodes[encode_key_t(index, quality, scale)]++;
+    // what is alive before this one is held by clients
+    idle_live_max = std::max(idle_live_max, idle_live());
+    live[*out] = quality;
+    return true;
+}
+
+void esp_camera_fb_return(camera_fb_t *fb)
+{
+    free(fb->buf);
+    delete fb;
+    returned++;
+}
+
+typedef struct
+{
+    jpeg_client_t *client;
+    std::atomic<bool> running{true};
+    std::atomic<bool> stopped{false};
+    std::map<int, uint8_t *> received; /*<! camera frame index to the encoded buffer >*/
+    int wrong = 0;                     /*<! frames of another quality or scale >*/
+} client_t;
+
+static void client_task(void *arg)
+{
+    client_t *self = (client_t *)arg;
+    while (self->running)
+    {
+        jpeg_frame_t *jpeg = jpeg_cache_take(self->client, pdMS_TO_TICKS(10));
+        if (jpeg == NULL)
+            continue;
+
+        int index = jpeg->buf[0] | jpeg->buf[1] << 8;
+        self->wrong += jpeg->buf[2] != self->client->quality || jpeg->buf[3] != self->client->scale;
+        self->received[index] = jpeg->buf;
+        vTaskDelay(pdMS_TO_TICKS(index % 7));
+        jpeg_cache_release(jpeg);
+    }
+    self->stopped = true;
+}
+
+int main()
+{
+    QueueHandle_t camera = xQueueCreate(2, sizeof(camera_fb_t *));
+    jpeg_cache_init(camera, NULL, true);
+
+    client_t clients[3];
+    const int settings[3][2] = {{80, 1}, {80, 1}, {50, 2}};
+    for (int i = 0; i < 3; i++)
+    {
+        clients[i].client = jpeg_cache_open(settings[i][0], settings[i][1]);
+        xTaskCreatePinnedToCore(client_task, "client", 4 * 1024, &clients[i], 5, NULL, 1);
+    }
+    idle_quality = 30;
+    jpeg_client_t *idle = jpeg_cache_open(idle_quality, 4);
+
+    for (int index = 0; index < FRAMES; index++)
+    {
+        camera_fb_t *fb = new camera_fb_t();
+        fb->width = WIDTH;
+        fb->height = HEIGHT;
+        fb->format = PIXFORMAT_RGB565;
+        fb->len = WIDTH * HEIGHT * 2;
+        fb->buf = (uint8_t *)malloc(fb->len);
+        for (int i = 0; i < WIDTH * HEIGHT; i++)
+            ((uint16_t *)fb->buf)[i] = index;
+        xQueueSend(camera, &fb, portMAX_DELAY);
+        vTaskDelay(pdMS_TO_TICKS(1));
+    }
+
+    for (int i = 0; i < 200 && returned < FRAMES; i++)
+        vTaskDelay(pdMS_TO_TICKS(10));
+    vTaskDelay(pdMS_TO_TICKS(100)); // the encoder finishes the last copy
+    for (int i = 0; i < 3; i++)
+        clients[i].running = false;
+    for (int i = 0; i < 3; i++)
+    {
+        while (!clients[i].stopped)
+            vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    HOST_TEST_CHECK_EQUAL(FRAMES, returned.load());
+
+    lock.lock();
+    int repeated = 0;
+    for (auto &encode : encodes)
+        repeated += encode.second != 1;
+    HOST_TEST_CHECK_EQUAL(0, repeated);
+    HOST_TEST_CHECK(encodes.size() > 0);
+
+    // the frame waiting for the idle client is the only encoded buffer of its quality
+    HOST_TEST_CHECK_EQUAL(1, idle_live());
+    HOST_TEST_CHECK(idle_live_max <= 1);
+
+    // clients of the same quality and scale share buffers, each got frames of its own setting only
+    int shared = 0, different = 0;
+    for (auto &frame : clients[0].received)
+    {
+        auto other = clients[1].received.find(frame.first);
+        if (other == clients[1].received.end())
+            continue;
+        shared += other->second == frame.second;
+        different += other->second != frame.second;
+    }
+    HOST_TEST_CHECK(shared > 0);
+    HOST_TEST_CHECK_EQUAL(0, different);
+    for (int i = 0; i < 3; i++)
+    {
+        HOST_TEST_CHECK(clients[i].received.size() > 0);
+        HOST_TEST_CHECK_EQUAL(0, clients[i].wrong);
+    }
+    printf("%d frames, %d encoded, %d received by the clients at quality 80\n",
+           FRAMES, (int)encodes.size(), (int)clients[0].received.size());
+    lock.unlock();
+
+    // closing releases the waiting frame
+    jpeg_cache_close(idle);
+    lock.lock();
+    HOST_TEST_CHECK_EQUAL(0, idle_live());
+    lock.unlock();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,56 @@
+/**
+ * @file test_memory_planner.cpp
+ * @brief dl::layer::MemoryPlanner on the MNIST model of the convert tool tutorial.
+ *
+ * The model is built on the host, which plans its activations, and the plan is printed with the peak memory before
+ * and after planning:
+ *         - the arena is smaller than the sum of all activations, and not smaller than the maximum live set,
+ *         - every planned Tensor points into one arena at its offset,
+ *         - no two Tensors alive at the same step share a byte, judged by the addresses the Tensors really got.
+ */
+#include <stdint.h>
+#include <stdio.h>
+
+#include "host_test.hpp"
+#include "mnist_model.hpp"
+
+int main()
+{
+    MNIST model;
+    Tensor<int16_t> input;
+    input.set_exponent(0).set_shape({28, 28, 3});
+    model.build(input);
+
+    MemoryPlanner<int16_t> &planner = model.planner;
+    planner.print();
+    HOST_TEST_CHECK_EQUAL(18, planner.get_block_num());
+    HOST_TEST_CHECK(planner.get_planned_size() < planner.get_unplanned_size());
+    HOST_TEST_CHECK(planner.get_planned_size() >= planner.get_peak_live_size());
+
+    int first[2], last[2], offset[2], bytes[2];
+    uint8_t *arena = (uint8_t *)planner.get_block(0, first[0], last[0], offset[0], bytes[0])->element - offset[0];
+    int outside = 0, overlaps = 0;
+    for (int i = 0; i < planner.get_block_num(); i++)
+    {
+        Tensor<int16_t> *a = planner.get_block(i, first[0], last[0], offset[0], bytes[0]);
+        uint8_t *begin_a = (uint8_t *)a->element;
+        outside += begin_a != arena + offset[0] || offset[0] + bytes[0] > planner.get_planned_size() || a->get_size() * (int)sizeof(int16_t) > bytes[0];
+
+        for (int j = i + 1; j < planner.get_block_num(); j++)
+        {
+            Tensor<int16_t> *b = planner.get_block(j, first[1], last[1], offset[1], bytes[1]);
+            uint8_t *begin_b = (uint8_t *)b->element;
+            bool alive = first[0] <= last[1] && first[1] <= last[0];
+            bool shared = begin_a < begin_b + b->get_size() * sizeof(int16_t) && begin_b < begin_a + a->get_size() * sizeof(int16_t);
+            if (alive && shared)
+            {
+                printf("records %d and %d are alive at the same step and overlap\n", i, j);
+                overlaps++;
+            }
+        }
+    }
+    HOST_TEST_CHECK_EQUAL(0, outside);
+    HOST_TEST_CHECK_EQUAL(0, overlaps);
+    printf("MNIST activations: %d bytes without planning, %d bytes planned\n", planner.get_unplanned_size(), planner.get_planned_size());
+    return HOST_TEST_RESULT();
+}
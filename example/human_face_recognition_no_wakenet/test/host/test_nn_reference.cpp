@@ -0,0 +1,448 @@
+/**
+ * @file test_nn_reference.cpp
+ * @brief Golden vectors of dl::nn::reference.
+ *
+ * - MNIST of the convert tool tutorial replayed through the Tensor API, filters quantized from the .npy files, must
+ *   give the scores recorded on esp32, esp32s2, esp32s3 and esp32c3 bit by bit.
+ * - mnist_coefficient_model.hpp, the same model generated with the graph fixed at compile time, must give the same
+ *   scores from its static arena, in which no two outputs alive at the same time overlap.
+ * - The filters of mnist_coefficient.cpp, generated for ESP32-S3, are where winograd_filter_index() looks for them, and
+ *   the Winograd transform of l1 is the same from the generated filter as from the .npy one.
+ * - Small cases computed by hand cover int8_t per-channel quantization, mixed exponents, pooling and padding.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "host_test.hpp"
+#include "port/dl_nn_host.hpp"
+#include "dl_nn_reference.hpp"
+#include "dl_nn_winograd.hpp"
+#include "mnist_coefficient.hpp"
+#include "mnist_coefficient_model.hpp"
+#include "data/mnist_input.inc"
+
+using namespace dl;
+using namespace nn;
+using namespace mnist_coefficient;
+
+// recorded at the end of the tutorial app_main.cpp
+static const int16_t mnist_expected[10] = {-7170, -9792, -12301, -11416, -12349, -1350, -11715, -118, -11433, 7856};
+
+/**
+ * @brief Filters of the tutorial quantized from the .npy files, element in [filter_height, filter_width,
+ * input_channel, output_channel] as reference expects.
+ */
+class NpyFilters
+{
+private:
+    std::vector<std::vector<int16_t> *> elements;
+    std::vector<Filter<int16_t> *> filters;
+
+    static bool load(const std::string &path, std::vector<float> &data, std::vector<int> &shape)
+    {
+        FILE *f = fopen(path.c_str(), "rb");
+        if (f == NULL)
+            return false;
+
+        // magic, version 1.0, header length, header
+        char magic[8];
+        uint16_t header_len = 0;
+        bool ok = fread(magic, 1, 8, f) == 8 && memcmp(magic, "\x93NUMPY\x01\x00", 8) == 0 && fread(&header_len, 2, 1, f) == 1;
+        std::string header(header_len, '\0');
+        ok = ok && fread(&header[0], 1, header_len, f) == header_len;
+        ok = ok && header.find("'descr': '<f4'") != std::string::npos && header.find("'fortran_order': False") != std::string::npos;
+        if (ok)
+        {
+            shape.clear();
+            const char *p = header.c_str() + header.find("'shape': (") + 10;
+            while (*p != ')')
+            {
+                char *end;
+                shape.push_back(strtol(p, &end, 10));
+                p = end;
+                while (*p == ',' || *p == ' ')
+                    p++;
+            }
+
+            int size = 1;
+            for (int i : shape)
+                size *= i;
+            data.resize(size);
+            ok = fread(data.data(), sizeof(float), size, f) == size;
+        }
+        fclose(f);
+        return ok;
+    }
+
+public:
+    ~NpyFilters()
+    {
+        for (auto filter : this->filters)
+            delete filter;
+        for (auto element : this->elements)
+            delete element;
+    }
+
+    /**
+     * @brief Get the filter of a layer in the exponent and dilation the convert tool chose.
+     *
+     * @param name        layer name
+     * @param coefficient filter generated by the convert tool
+     * @return filter, the test exits if the .npy file can not be read
+     */
+    const Filter<int16_t> *get(const char *name, const Filter<int16_t> *coefficient)
+    {
+        std::vector<float> data;
+        std::vector<int> shape;
+        if (!load(std::string(MNIST_NPY_DIR "/") + name + "_filter.npy", data, shape) || shape != coefficient->shape)
+        {
+            printf("%s_filter.npy can not be read\n", name);
+            exit(1);
+        }
+
+        // the convert tool rounds half to even and saturates
+        std::vector<int16_t> *element = new std::vector<int16_t>(data.size());
+        for (int i = 0; i < data.size(); i++)
+            (*element)[i] = reference::saturate<int16_t>((int64_t)nearbyint(ldexp((double)data[i], -coefficient->exponent)));
+        this->elements.push_back(element);
+
+        Filter<int16_t> *filter = new Filter<int16_t>(element->data(), coefficient->exponent, shape, coefficient->dilation);
+        this->filters.push_back(filter);
+        return filter;
+    }
+};
+
+static void test_mnist()
+{
+    NpyFilters npy;
+    const Bias<int16_t> *no_bias = NULL;
+    const Activation<int16_t> *no_activation = NULL;
+
+    Tensor<int16_t> input;
+    input.set_element(example_element).set_exponent(0).set_shape({28, 28, 3}).set_auto_free(false);
+
+    // layers of mnist_model.hpp
+    Tensor<int16_t> l1;
+    reference::conv2d(l1, -2, input, *npy.get("l1", get_l1_filter()), 2, 2, PADDING_VALID, get_l1_bias(), get_l1_activation());
+    Tensor<int16_t> l2_depth;
+    reference::depthwise_conv2d(l2_depth, -1, l1, *npy.get("l2_depth", get_l2_depth_filter()), 2, 2, PADDING_SAME_END, no_bias, get_l2_depth_activation());
+    Tensor<int16_t> l2_compress;
+    reference::conv2d(l2_compress, -3, l2_depth, *npy.get("l2_compress", get_l2_compress_filter()), 1, 1, PADDING_SAME_END, get_l2_compress_bias(), no_activation);
+
+    Tensor<int16_t> l3_a_depth;
+    reference::depthwise_conv2d(l3_a_depth, -1, l2_compress, *npy.get("l3_a_depth", get_l3_a_depth_filter()), 1, 1, PADDING_VALID, no_bias, get_l3_a_depth_activation());
+    Tensor<int16_t> l3_a_compress;
+    reference::conv2d(l3_a_compress, -12, l3_a_depth, *npy.get("l3_a_compress", get_l3_a_compress_filter()), 1, 1, PADDING_VALID, get_l3_a_compress_bias(), no_activation);
+    Tensor<int16_t> l3_b_depth;
+    reference::depthwise_conv2d(l3_b_depth, -2, l2_compress, *npy.get("l3_b_depth", get_l3_b_depth_filter()), 1, 1, PADDING_VALID, no_bias, get_l3_b_depth_activation());
+    Tensor<int16_t> l3_b_compress;
+    reference::conv2d(l3_b_compress, -12, l3_b_depth, *npy.get("l3_b_compress", get_l3_b_compress_filter()), 1, 1, PADDING_VALID, get_l3_b_compress_bias(), no_activation);
+    Tensor<int16_t> l3_c_depth;
+    reference::depthwise_conv2d(l3_c_depth, -12, l3_b_compress, *npy.get("l3_c_depth", get_l3_c_depth_filter()), 1, 1, PADDING_SAME_END, no_bias, get_l3_c_depth_activation());
+    Tensor<int16_t> l3_c_compress;
+    reference::conv2d(l3_c_compress, -12, l3_c_depth, *npy.get("l3_c_compress", get_l3_c_compress_filter()), 1, 1, PADDING_SAME_END, get_l3_c_compress_bias(), no_activation);
+    Tensor<int16_t> l3_d_depth;
+    reference::depthwise_conv2d(l3_d_depth, -12, l3_b_compress, *npy.get("l3_d_depth", get_l3_d_depth_filter()), 1, 1, PADDING_SAME_END, no_bias, get_l3_d_depth_activation());
+    Tensor<int16_t> l3_d_compress;
+    reference::conv2d(l3_d_compress, -11, l3_d_depth, *npy.get("l3_d_compress", get_l3_d_compress_filter()), 1, 1, PADDING_SAME_END, get_l3_d_compress_bias(), no_activation);
+    Tensor<int16_t> l3_e_depth;
+    reference::depthwise_conv2d(l3_e_depth, -11, l3_d_compress, *npy.get("l3_e_depth", get_l3_e_depth_filter()), 1, 1, PADDING_SAME_END, no_bias, get_l3_e_depth_activation());
+    Tensor<int16_t> l3_e_compress;
+    reference::conv2d(l3_e_compress, -12, l3_e_depth, *npy.get("l3_e_compress", get_l3_e_compress_filter()), 1, 1, PADDING_SAME_END, get_l3_e_compress_bias(), no_activation);
+
+    // l3_concat, all inputs are in exponent -12
+    Tensor<int16_t> l3_concat;
+    std::vector<Tensor<int16_t> *> branches = {&l3_a_compress, &l3_c_compress, &l3_e_compress};
+    int channel = 0;
+    for (auto branch : branches)
+    {
+        HOST_TEST_CHECK_EQUAL(-12, branch->exponent);
+        HOST_TEST_CHECK(branch->shape[0] == l3_a_compress.shape[0] && branch->shape[1] == l3_a_compress.shape[1]);
+        channel += branch->shape[2];
+    }
+    l3_concat.set_exponent(-12).set_shape({l3_a_compress.shape[0], l3_a_compress.shape[1], channel}).malloc_element();
+    for (int i = 0, offset = 0; i < l3_a_compress.shape[0] * l3_a_compress.shape[1]; i++)
+    {
+        for (auto branch : branches)
+        {
+            memcpy(l3_concat.element + offset, branch->element + i * branch->shape[2], branch->shape[2] * sizeof(int16_t));
+            offset += branch->shape[2];
+        }
+    }
+
+    Tensor<int16_t> l4_depth;
+    reference::depthwise_conv2d(l4_depth, -12, l3_concat, *npy.get("l4_depth", get_l4_depth_filter()), 1, 1, PADDING_VALID, no_bias, get_l4_depth_activation());
+    Tensor<int16_t> l4_compress;
+    reference::conv2d(l4_compress, -11, l4_depth, *npy.get("l4_compress", get_l4_compress_filter()), 1, 1, PADDING_VALID, get_l4_compress_bias(), no_activation);
+    Tensor<int16_t> l5_depth;
+    reference::depthwise_conv2d(l5_depth, -10, l4_compress, *npy.get("l5_depth", get_l5_depth_filter()), 1, 1, PADDING_VALID, no_bias, get_l5_depth_activation());
+    Tensor<int16_t> l5_compress;
+    reference::conv2d(l5_compress, -9, l5_depth, *npy.get("l5_compress", get_l5_compress_filter()), 1, 1, PADDING_VALID, get_l5_compress_bias(), no_activation);
+
+    HOST_TEST_CHECK_EQUAL(10, l5_compress.get_size());
+    for (int i = 0; i < 10 && i < l5_compress.get_size(); i++)
+        HOST_TEST_CHECK_EQUAL(mnist_expected[i], l5_compress.element[i]);
+}
+
+static void test_mnist_coefficient_model()
+{
+    // the host kernels take the filters of mnist_coefficient.cpp in the order of reference
+    NpyFilters npy;
+    const struct
+    {
+        const char *name;
+        const Filter<int16_t> *(*get)();
+    } filters[] = {{"l1", get_l1_filter}, {"l2_depth", get_l2_depth_filter}, {"l2_compress", get_l2_compress_filter},
+                   {"l3_a_depth", get_l3_a_depth_filter}, {"l3_a_compress", get_l3_a_compress_filter},
+                   {"l3_b_depth", get_l3_b_depth_filter}, {"l3_b_compress", get_l3_b_compress_filter},
+                   {"l3_c_depth", get_l3_c_depth_filter}, {"l3_c_compress", get_l3_c_compress_filter},
+                   {"l3_d_depth", get_l3_d_depth_filter}, {"l3_d_compress", get_l3_d_compress_filter},
+                   {"l3_e_depth", get_l3_e_depth_filter}, {"l3_e_compress", get_l3_e_compress_filter},
+                   {"l4_depth", get_l4_depth_filter}, {"l4_compress", get_l4_compress_filter},
+                   {"l5_depth", get_l5_depth_filter}, {"l5_compress", get_l5_compress_filter}};
+    for (auto &filter : filters)
+        host_filters[filter.get()] = npy.get(filter.name, filter.get());
+
+    Tensor<int16_t> input;
+    input.set_element(example_element).set_exponent(0).set_shape({28, 28, 3}).set_auto_free(false);
+    MnistCoefficientModel model;
+    Tensor<int16_t> &output = model.call(input);
+    host_filters.clear();
+
+    HOST_TEST_CHECK(&output == &model.l5_compress);
+    HOST_TEST_CHECK_EQUAL(10, output.get_size());
+    for (int i = 0; i < 10 && i < output.get_size(); i++)
+        HOST_TEST_CHECK_EQUAL(mnist_expected[i], output.element[i]);
+
+    // outputs in execution order with the layers reading them, as in npy/graph.json
+    const struct
+    {
+        Tensor<int16_t> *tensor;
+        std::vector<int> readers;
+    } outputs[] = {{&model.l1, {1}}, {&model.l2_depth, {2}}, {&model.l2_compress, {3, 5}}, {&model.l3_a_depth, {4}},
+                   {&model.l3_a_compress, {13}}, {&model.l3_b_depth, {6}}, {&model.l3_b_compress, {7, 9}},
+                   {&model.l3_c_depth, {8}}, {&model.l3_c_compress, {13}}, {&model.l3_d_depth, {10}},
+                   {&model.l3_d_compress, {11}}, {&model.l3_e_depth, {12}}, {&model.l3_e_compress, {13}},
+                   {&model.l3_concat, {14}}, {&model.l4_depth, {15}}, {&model.l4_compress, {16}},
+                   {&model.l5_depth, {17}}, {&model.l5_compress, {18}}};
+    const int n = sizeof(outputs) / sizeof(outputs[0]);
+    int16_t *arena = MnistCoefficientModel::get_arena();
+    int total = 0, outside = 0, overlaps = 0;
+    for (int i = 0; i < n; i++)
+    {
+        Tensor<int16_t> *a = outputs[i].tensor;
+        total += a->get_size();
+        outside += a->element < arena || a->element + a->get_size() > arena + MnistCoefficientModel::arena_size || ((uintptr_t)a->element & 15);
+        for (int j = i + 1; j < n; j++)
+        {
+            // b is written at step j, a is alive until its last reader
+            Tensor<int16_t> *b = outputs[j].tensor;
+            bool alive = j <= outputs[i].readers.back();
+            bool shared = a->element < b->element + b->get_size() && b->element < a->element + a->get_size();
+            if (alive && shared)
+            {
+                printf("%d and %d are alive at the same step and overlap\n", i, j);
+                overlaps++;
+            }
+        }
+    }
+    HOST_TEST_CHECK_EQUAL(0, outside);
+    HOST_TEST_CHECK_EQUAL(0, overlaps);
+    HOST_TEST_CHECK(MnistCoefficientModel::arena_size < total);
+    printf("MnistCoefficientModel: arena of %d elements for %d elements of outputs\n", (int)MnistCoefficientModel::arena_size, total);
+}
+
+static void test_winograd_filter_order()
+{
+    NpyFilters npy;
+    const struct
+    {
+        const char *name;
+        const Filter<int16_t> *(*get)();
+    } filters[] = {{"l1", get_l1_filter}, {"l2_compress", get_l2_compress_filter}, {"l3_a_compress", get_l3_a_compress_filter},
+                   {"l3_b_compress", get_l3_b_compress_filter}, {"l4_compress", get_l4_compress_filter},
+                   {"l5_compress", get_l5_compress_filter}};
+    int wrong = 0;
+    for (auto &filter : filters)
+    {
+        // l5_compress has 10 output channels, 2 of them out of the blocks of 8
+        const Filter<int16_t> *chip = filter.get();
+        const Filter<int16_t> *original = npy.get(filter.name, chip);
+        const std::vector<int> &shape = chip->shape;
+        for (int y = 0; y < shape[0]; y++)
+            for (int x = 0; x < shape[1]; x++)
+                for (int c = 0; c < shape[2]; c++)
+                    for (int n = 0; n < shape[3]; n++)
+                        wrong += chip->element[winograd_filter_index(shape, y, x, c, n, true)] != original->element[winograd_filter_index(shape, y, x, c, n, false)];
+    }
+    HOST_TEST_CHECK_EQUAL(0, wrong);
+
+    int32_t *chip = winograd_transform_filter(*get_l1_filter(), true);
+    int32_t *original = winograd_transform_filter(*npy.get("l1", get_l1_filter()), false);
+    HOST_TEST_CHECK(chip != NULL && original != NULL);
+    if (chip && original)
+        HOST_TEST_CHECK_EQUAL(0, memcmp(chip, original, 16 * 3 * 16 * sizeof(int32_t)));
+    dl::tool::free_aligned(chip);
+    dl::tool::free_aligned(original);
+}
+
+static void test_conv2d_int8_per_channel()
+{
+    // 1x1 conv2d, per-channel exponent, int16_t bias in output exponent
+    int8_t input_element[] = {10, -3};
+    int8_t filter_element[] = {2, -1,
+                               5, 3};
+    int8_t channel_exponent[] = {-1, -2};
+    int16_t bias_element[] = {3, -2};
+    Filter<int8_t> filter(filter_element, channel_exponent, 2, {1, 1, 2, 2});
+    Bias<int16_t> bias(bias_element, -1, {2});
+
+    Tensor<int8_t> input;
+    input.set_element(input_element).set_exponent(0).set_shape({1, 1, 2});
+    Tensor<int8_t> output;
+    reference::conv2d(output, -1, input, filter, 1, 1, PADDING_VALID, &bias, (const Activation<int8_t> *)NULL);
+
+    // 10 * 2 - 3 * 5 = 5 in 2^-1, + 3
+    HOST_TEST_CHECK_EQUAL(8, output.element[0]);
+    // -10 - 9 = -19 in 2^-2 is -9.5 in 2^-1, rounded toward minus infinity, + -2
+    HOST_TEST_CHECK_EQUAL(-12, output.element[1]);
+}
+
+static void test_depthwise_conv2d_padding()
+{
+    // 3x3 depthwise of ones on [3, 3, 1], SAME_END with stride 2 pads one on each side
+    int16_t input_element[] = {1, 2, 3,
+                               4, 5, 6,
+                               7, 8, 9};
+    int16_t filter_element[] = {1, 1, 1, 1, 1, 1, 1, 1, 1};
+    Filter<int16_t> filter(filter_element, 0, {3, 3, 1, 1});
+
+    Tensor<int16_t> input;
+    input.set_element(input_element).set_exponent(0).set_shape({3, 3, 1});
+
+    Tensor<int16_t> same_end;
+    reference::depthwise_conv2d(same_end, 0, input, filter, 2, 2, PADDING_SAME_END, (const Bias<int16_t> *)NULL, (const Activation<int16_t> *)NULL);
+    HOST_TEST_CHECK(same_end.shape == std::vector<int>({2, 2, 1}));
+    HOST_TEST_CHECK_EQUAL(1 + 2 + 4 + 5, same_end.element[0]);
+    HOST_TEST_CHECK_EQUAL(2 + 3 + 5 + 6, same_end.element[1]);
+    HOST_TEST_CHECK_EQUAL(4 + 5 + 7 + 8, same_end.element[2]);
+    HOST_TEST_CHECK_EQUAL(5 + 6 + 8 + 9, same_end.element[3]);
+
+    std::vector<int> padding = {1, 1, 1, 1};
+    Tensor<int16_t> output;
+    output.set_exponent(0).set_shape({2, 2, 1}).malloc_element();
+    reference::depthwise_conv2d(output, input, padding, filter, 2, 2);
+    HOST_TEST_CHECK_EQUAL(1 + 2 + 4 + 5, output.element[0]);
+    HOST_TEST_CHECK_EQUAL(2 + 3 + 5 + 6, output.element[1]);
+    HOST_TEST_CHECK_EQUAL(4 + 5 + 7 + 8, output.element[2]);
+    HOST_TEST_CHECK_EQUAL(5 + 6 + 8 + 9, output.element[3]);
+}
+
+static void test_element_wise()
+{
+    // add2d of different exponents is aligned to the smallest one, 17 and -7 in 2^-2
+    int16_t a_element[] = {7, -5};
+    int16_t b_element[] = {3, 3};
+    Tensor<int16_t> a, b, output;
+    a.set_element(a_element).set_exponent(-1).set_shape({1, 1, 2});
+    b.set_element(b_element).set_exponent(-2).set_shape({1, 1, 2});
+    output.set_exponent(-1).set_shape({1, 1, 2}).malloc_element();
+    reference::add2d(output, a, b);
+    HOST_TEST_CHECK_EQUAL(8, output.element[0]);
+    HOST_TEST_CHECK_EQUAL(-4, output.element[1]);
+
+    // mul2d, 1500 and -21 in 2^-7
+    int16_t c_element[] = {300, -7};
+    int16_t d_element[] = {5, 3};
+    Tensor<int16_t> c, d;
+    c.set_element(c_element).set_exponent(-4).set_shape({1, 1, 2});
+    d.set_element(d_element).set_exponent(-3).set_shape({1, 1, 2});
+    output.set_exponent(-4);
+    reference::mul2d(output, c, d);
+    HOST_TEST_CHECK_EQUAL(187, output.element[0]);
+    HOST_TEST_CHECK_EQUAL(-3, output.element[1]);
+
+    // saturated
+    int16_t e_element[] = {32000, -32000};
+    Tensor<int16_t> e;
+    e.set_element(e_element).set_exponent(0).set_shape({1, 1, 2});
+    output.set_exponent(0);
+    reference::add2d(output, e, e);
+    HOST_TEST_CHECK_EQUAL(32767, output.element[0]);
+    HOST_TEST_CHECK_EQUAL(-32768, output.element[1]);
+
+    // leakyrelu with alpha 0.75
+    int8_t f_element[] = {-100, 50};
+    Tensor<int8_t> f, f_output;
+    f.set_element(f_element).set_exponent(-2).set_shape({1, 1, 2});
+    f_output.set_exponent(-2).set_shape({1, 1, 2}).malloc_element();
+    reference::leakyrelu(f_output, f, (int8_t)3, -2);
+    HOST_TEST_CHECK_EQUAL(-75, f_output.element[0]);
+    HOST_TEST_CHECK_EQUAL(50, f_output.element[1]);
+
+    reference::relu(f_output, f);
+    HOST_TEST_CHECK_EQUAL(0, f_output.element[0]);
+    HOST_TEST_CHECK_EQUAL(50, f_output.element[1]);
+}
+
+static void test_pool()
+{
+    int16_t input_element[] = {1, 2, 3,
+                               4, 5, 6,
+                               7, 8, 9};
+    Tensor<int16_t> input;
+    input.set_element(input_element).set_exponent(0).set_shape({3, 3, 1});
+
+    // SAME_END pads bottom and right
+    std::vector<int> padding = {0, 1, 0, 1};
+    std::vector<int> filter_shape = {2, 2};
+    Tensor<int16_t> output;
+    output.set_shape({2, 2, 1}).malloc_element();
+    reference::max_pool2d(output, input, padding, filter_shape, 2, 2);
+    HOST_TEST_CHECK_EQUAL(0, output.exponent);
+    HOST_TEST_CHECK_EQUAL(5, output.element[0]);
+    HOST_TEST_CHECK_EQUAL(6, output.element[1]);
+    HOST_TEST_CHECK_EQUAL(8, output.element[2]);
+    HOST_TEST_CHECK_EQUAL(9, output.element[3]);
+
+    // padding is excluded from the average, 12 / 4 = 3, 9 / 2 = 4.5, 15 / 2 = 7.5, 9 in 2^-1
+    output.set_exponent(-1);
+    reference::avg_pool2d(output, input, padding, filter_shape, 2, 2);
+    HOST_TEST_CHECK_EQUAL(6, output.element[0]);
+    HOST_TEST_CHECK_EQUAL(9, output.element[1]);
+    HOST_TEST_CHECK_EQUAL(15, output.element[2]);
+    HOST_TEST_CHECK_EQUAL(18, output.element[3]);
+
+    // 45 / 9 = 5 in 2^-2
+    Tensor<int16_t> global;
+    global.set_exponent(-2).set_shape({1, 1, 1}).malloc_element();
+    reference::global_avg_pool2d(global, input);
+    HOST_TEST_CHECK_EQUAL(20, global.element[0]);
+    reference::global_max_pool2d(global, input);
+    HOST_TEST_CHECK_EQUAL(0, global.exponent);
+    HOST_TEST_CHECK_EQUAL(9, global.element[0]);
+
+    // 11 / 4 = 2.75 is 5.5 in 2^-1, rounded toward minus infinity
+    int16_t odd_element[] = {1, 2, 3, 5};
+    Tensor<int16_t> odd;
+    odd.set_element(odd_element).set_exponent(0).set_shape({2, 2, 1});
+    global.set_exponent(-1);
+    reference::global_avg_pool2d(global, odd);
+    HOST_TEST_CHECK_EQUAL(5, global.element[0]);
+}
+
+int main()
+{
+    test_mnist();
+    test_mnist_coefficient_model();
+    test_winograd_filter_order();
+    test_conv2d_int8_per_channel();
+    test_depthwise_conv2d_padding();
+    test_element_wise();
+    test_pool();
+    return HOST_TEST_RESULT();
+}
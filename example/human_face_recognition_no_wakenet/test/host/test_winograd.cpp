@@ -0,0 +1,162 @@
+/**
+ * @file test_winograd.cpp
+ * @brief dl::nn::conv2d_winograd() and the Winograd path of dl::layer::Conv2D against dl::nn::reference::conv2d().
+ *
+ * Random int16_t 3x3 stride-1 cases, maps from 1x1 to odd and even sizes, every padding type, with and without bias,
+ * ReLU and PReLU:
+ *         - the output of conv2d_winograd() drifts 0 LSB from the direct reference, from the filter in the original
+ *           order and in the order the convert tool generates for ESP32-S3, output channels out of the blocks of 8
+ *           included,
+ *         - Conv2D built with DL_WINOGRAD runs the transformed filter where winograd_conv2d_supported() holds and the
+ *           output is at least 2x2, the direct kernel otherwise, and gives the direct result either way.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "host_test.hpp"
+#include "port/dl_nn_host.hpp"
+#include "dl_nn_reference.hpp"
+#include "dl_nn_winograd.hpp"
+#include "dl_layer_conv2d.hpp"
+
+#define CASES 300
+
+using namespace dl;
+using namespace nn;
+
+static int random_int(int low, int high)
+{
+    return low + rand() % (high - low + 1);
+}
+
+template <typename T>
+static std::vector<T> random_vector(int size, int range)
+{
+    std::vector<T> data(size);
+    for (auto &value : data)
+        value = (T)random_int(-range, range);
+    return data;
+}
+
+/**
+ * @brief Filter element from [3, 3, input_channel, output_channel] to the order of ESP32-S3, block by block.
+ */
+static std::vector<int16_t> to_esp32s3_order(const std::vector<int16_t> &element, const int input_channel, const int output_channel)
+{
+    const int kernel_size = 9 * input_channel;
+    std::vector<int16_t> reordered;
+    for (int block = 0; block < output_channel; block += 8)
+    {
+        // a whole block of 8 interleaves its channels, the channels left are one after another
+        const int lanes = output_channel - block >= 8 ? 8 : 1;
+        for (int n = block; n < block + 8 && n < output_channel; n += lanes)
+            for (int k = 0; k < kernel_size; k++)
+                for (int lane = 0; lane < lanes; lane++)
+                    reordered.push_back(element[k * output_channel + n + lane]);
+    }
+    return reordered;
+}
+
+/**
+ * @brief One random case.
+ *
+ * @return true: conv2d_winograd() and Conv2D are equal to the direct reference
+ */
+static bool check(const int seed)
+{
+    srand(seed);
+    const padding_type_t padding_type = (padding_type_t)random_int(PADDING_NOT_SET, PADDING_SAME_END);
+    const int min_size = padding_type == PADDING_VALID ? 3 : 1;
+    const int height = random_int(min_size, 17), width = random_int(min_size, 17);
+    const int channel = random_int(1, 20), output_channel = random_int(1, 20);
+    std::vector<int> padding = {random_int(0, 2), random_int(0, 2), random_int(0, 2), random_int(0, 2)};
+    const int output_exponent = random_int(-10, -4);
+
+    std::vector<int> output_hw, conv_padding;
+    if (padding_type == PADDING_NOT_SET)
+    {
+        if (height + padding[0] + padding[1] < 3 || width + padding[2] + padding[3] < 3)
+            padding = {1, 1, 1, 1};
+        output_hw = reference::get_output_shape(height, width, 3, 3, 1, 1, padding);
+        conv_padding = padding;
+    }
+    else
+    {
+        reference::get_output_shape_and_padding(output_hw, conv_padding, height, width, 3, 3, 1, 1, padding_type);
+    }
+
+    std::vector<int16_t> input_element = random_vector<int16_t>(height * width * channel, 2000);
+    std::vector<int16_t> filter_element = random_vector<int16_t>(9 * channel * output_channel, 2000);
+    std::vector<int16_t> esp32s3_element = to_esp32s3_order(filter_element, channel, output_channel);
+    std::vector<int16_t> bias_element = random_vector<int16_t>(output_channel, 2000);
+    std::vector<int16_t> alpha_element = random_vector<int16_t>(output_channel, 127);
+
+    Filter<int16_t> filter(filter_element.data(), random_int(-14, -10), {3, 3, channel, output_channel});
+    Filter<int16_t> esp32s3_filter(esp32s3_element.data(), filter.exponent, filter.shape);
+    Bias<int16_t> bias(bias_element.data(), random_int(-12, -4), {output_channel});
+    Activation<int16_t> relu(ReLU);
+    Activation<int16_t> prelu(PReLU, alpha_element.data(), -7, {output_channel});
+    const Bias<int16_t> *conv_bias = rand() % 2 ? &bias : NULL;
+    const int activation_index = random_int(0, 2);
+    const Activation<int16_t> *activation = activation_index == 0 ? NULL : (activation_index == 1 ? &relu : &prelu);
+
+    Tensor<int16_t> input;
+    input.set_element(input_element.data()).set_exponent(random_int(-8, -4)).set_shape({height, width, channel});
+
+    Tensor<int16_t> expected;
+    expected.set_exponent(output_exponent).set_shape({output_hw[0], output_hw[1], output_channel}).malloc_element();
+    reference::conv2d(expected, input, conv_padding, filter, 1, 1, conv_bias, activation);
+
+    // drift in LSB of each Winograd output
+    int drift = 0;
+    const Filter<int16_t> *orders[2] = {&filter, &esp32s3_filter};
+    for (int order = 0; order < 2; order++)
+    {
+        int32_t *transformed = winograd_transform_filter(*orders[order], order == 1);
+        Tensor<int16_t> winograd;
+        winograd.set_exponent(output_exponent).set_shape(expected.shape).malloc_element();
+        conv2d_winograd(winograd, input, conv_padding, transformed, *orders[order], conv_bias, activation);
+        for (int i = 0; i < expected.get_size(); i++)
+            drift = DL_MAX(drift, DL_ABS(winograd.element[i] - expected.element[i]));
+        tool::free_aligned(transformed);
+    }
+
+    // the direct kernel of the host runs a zero filter in place of the layer's, only the transformed filter gives the result
+    std::vector<int16_t> zero_element(filter_element.size(), 0);
+    Filter<int16_t> zero(zero_element.data(), filter.exponent, filter.shape);
+    const bool winograd_expected = winograd_conv2d_supported(filter, 1, 1) && output_hw[0] > 1 && output_hw[1] > 1;
+    if (winograd_expected)
+        host_filters[&filter] = &zero;
+    layer::Conv2D<int16_t> conv(output_exponent, &filter, conv_bias, activation, padding_type, padding, 1, 1, "winograd");
+    conv.build(input);
+    Tensor<int16_t> &output = conv.call(input);
+    host_filters.clear();
+
+    bool equal = drift == 0 && output.shape == expected.shape;
+    for (int i = 0; equal && i < output.get_size(); i++)
+        equal = output.element[i] == expected.element[i];
+    if (!equal)
+        printf("case %d: input %dx%dx%d to %d channels, padding type %d, drift %d LSB, Winograd layer %d\n",
+               seed, height, width, channel, output_channel, padding_type, drift, winograd_expected);
+    return equal;
+}
+
+int main()
+{
+    int wrong = 0;
+    for (int i = 0; i < CASES; i++)
+        wrong += !check(i);
+    HOST_TEST_CHECK_EQUAL(0, wrong);
+
+    // int8_t, dilation, per-channel exponent and stride 2 stay on the direct kernel
+    std::vector<int16_t> element(9 * 4 * 4);
+    std::vector<int8_t> element8(9 * 4 * 4);
+    std::vector<int8_t> channel_exponent(4, -8);
+    HOST_TEST_CHECK(winograd_conv2d_supported(Filter<int16_t>(element.data(), -8, {3, 3, 4, 4}), 1, 1));
+    HOST_TEST_CHECK(!winograd_conv2d_supported(Filter<int8_t>(element8.data(), -8, {3, 3, 4, 4}), 1, 1));
+    HOST_TEST_CHECK(!winograd_conv2d_supported(Filter<int16_t>(element.data(), -8, {3, 3, 4, 4}, {2, 2}), 1, 1));
+    HOST_TEST_CHECK(!winograd_conv2d_supported(Filter<int16_t>(element.data(), channel_exponent.data(), 4, {3, 3, 4, 4}), 1, 1));
+    HOST_TEST_CHECK(!winograd_conv2d_supported(Filter<int16_t>(element.data(), -8, {3, 3, 4, 4}), 2, 1));
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,157 @@
+/**
+ * @file test_worker_pool.cpp
+ * @brief dl::tool::WorkerPool on pthreads and dl::nn::parallel_rows.
+ *
+ * - Every part of a job runs once, part 0 on the caller and the others on workers.
+ * - Cores repeated in assign_core get one part, a nested job finds the pool busy and runs on its caller.
+ * - Many jobs in a row from several callers neither lose nor repeat a part.
+ * - Bands of parallel_rows start at 16-byte aligned rows of output and input and give the whole operation bit by bit.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
+
+#include "host_test.hpp"
+#include "dl_nn_reference.hpp"
+#include "dl_nn_parallel.hpp"
+
+using namespace dl;
+
+static void test_parts()
+{
+    tool::WorkerPool &pool = tool::WorkerPool::get_instance();
+    pthread_t caller = pthread_self();
+    pthread_t threads[2] = {0, 0};
+    int runs[2] = {0, 0};
+    auto job = [&](int index, int count)
+    {
+        HOST_TEST_CHECK_EQUAL(2, count);
+        threads[index] = pthread_self();
+        runs[index]++;
+    };
+    HOST_TEST_CHECK_EQUAL(2, pool.parallel_for(job, {0, 1}));
+    HOST_TEST_CHECK_EQUAL(1, runs[0]);
+    HOST_TEST_CHECK_EQUAL(1, runs[1]);
+    HOST_TEST_CHECK(pthread_equal(threads[0], caller));
+    HOST_TEST_CHECK(!pthread_equal(threads[1], caller));
+
+    // repeated cores, and the core of caller only
+    HOST_TEST_CHECK_EQUAL(2, pool.parallel_for(job, {1, 0, 1, 0}));
+    int alone = 0;
+    auto single = [&](int index, int count)
+    {
+        HOST_TEST_CHECK_EQUAL(1, count);
+        alone++;
+    };
+    HOST_TEST_CHECK_EQUAL(1, pool.parallel_for(single, {0}));
+    HOST_TEST_CHECK_EQUAL(1, alone);
+
+    // a part starting a job of its own runs it by itself
+    int nested = 0;
+    auto outer = [&](int index, int count)
+    {
+        if (index == 0)
+            nested = pool.parallel_for(single, {0, 1});
+    };
+    HOST_TEST_CHECK_EQUAL(2, pool.parallel_for(outer, {0, 1}));
+    HOST_TEST_CHECK_EQUAL(1, nested);
+}
+
+static void *caller_loop(void *arg)
+{
+    std::atomic<long> *sum = (std::atomic<long> *)arg;
+    for (int i = 0; i < 10000; i++)
+    {
+        auto job = [&](int index, int count)
+        { *sum += index + 1; };
+        int count = tool::WorkerPool::get_instance().parallel_for(job, {0, 1, 2});
+        *sum -= count * (count + 1) / 2; // what the parts should have added
+    }
+    return NULL;
+}
+
+static void test_stress()
+{
+    // callers racing for the pool, a caller finding it busy runs its job alone
+    std::atomic<long> sums[3];
+    pthread_t threads[3];
+    for (int i = 0; i < 3; i++)
+    {
+        sums[i] = 0;
+        pthread_create(&threads[i], NULL, caller_loop, &sums[i]);
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        pthread_join(threads[i], NULL);
+        HOST_TEST_CHECK_EQUAL(0, sums[i]);
+    }
+}
+
+static void test_parallel_rows()
+{
+    int failures = 0;
+    int misaligned = 0;
+    int split = 0;
+    for (int seed = 0; seed < 200; seed++)
+    {
+        srand(seed);
+        const int filter_h = 1 + rand() % 3, filter_w = 1 + rand() % 3;
+        const int stride = 1 + rand() % 2;
+        const int height = 8 + rand() % 40, width = 1 + rand() % 20;
+        const int channel = 1 + rand() % 6, output_channel = 1 + rand() % 6;
+        const padding_type_t padding_type = (padding_type_t)(PADDING_VALID + rand() % 3);
+
+        std::vector<int8_t> filter_element(filter_h * filter_w * channel * output_channel);
+        for (auto &value : filter_element)
+            value = rand() % 255 - 127;
+        Filter<int8_t> filter(filter_element.data(), -7, {filter_h, filter_w, channel, output_channel});
+
+        Tensor<int8_t> input;
+        input.set_exponent(-7).set_shape({height, width, channel}).malloc_element();
+        for (int i = 0; i < input.get_size(); i++)
+            input.element[i] = rand() % 255 - 127;
+
+        std::vector<int> output_hw, padding;
+        nn::reference::get_output_shape_and_padding(output_hw, padding, height, width, filter_h, filter_w, stride, stride, padding_type);
+        Tensor<int8_t> expected, output;
+        expected.set_exponent(-6).set_shape({output_hw[0], output_hw[1], output_channel}).malloc_element();
+        output.set_exponent(-6).set_shape({output_hw[0], output_hw[1], output_channel}).malloc_element();
+        nn::reference::conv2d(expected, input, padding, filter, stride, stride);
+
+        int bands = 0;
+        nn::parallel_rows(output, input, padding, filter_h, stride, {0, 1},
+                          [&](Tensor<int8_t> &output_band, Tensor<int8_t> &input_band, std::vector<int> &band_padding)
+                          {
+                              misaligned += ((uintptr_t)output_band.element & 15) || ((uintptr_t)input_band.element & 15);
+                              bands++;
+                              nn::reference::conv2d(output_band, input_band, band_padding, filter, stride, stride);
+                          },
+                          0);
+        split += bands > 1;
+
+        for (int i = 0; i < output.get_size(); i++)
+        {
+            if (output.element[i] != expected.element[i])
+            {
+                printf("case %d: input %dx%dx%d, filter %dx%d, stride %d, padding type %d, %d bands differ at %d\n",
+                       seed, height, width, channel, filter_h, filter_w, stride, padding_type, bands, i);
+                failures++;
+                break;
+            }
+        }
+    }
+    HOST_TEST_CHECK_EQUAL(0, failures);
+    HOST_TEST_CHECK_EQUAL(0, misaligned);
+    HOST_TEST_CHECK(split > 50); // odd row sizes may have no aligned border and run whole
+    printf("%d of 200 cases split into bands\n", split);
+}
+
+int main()
+{
+    test_parts();
+    test_stress();
+    test_parallel_rows();
+    return HOST_TEST_RESULT();
+}